@@ -19,6 +19,7 @@
 #include "UnigineMesh.h"
 #include "UnigineImage.h"
 #include "UnigineNode.h"
+#include "UnigineCallback.h"
 
 namespace Unigine
 {
@@ -81,6 +82,11 @@ public:
 	static int getNumLoadedNodes();
 	static int getNumLoadedResources();
 	static void *addCallback(AsyncQueue::CALLBACK_INDEX callback, Unigine::CallbackBase2< const char *, int > *func);
+	template <class Func, class = typename std::enable_if<!std::is_convertible<Func, Unigine::CallbackBase *>::value>::type>
+	static void *addCallback(AsyncQueue::CALLBACK_INDEX callback, Func &&func)
+	{
+		return addCallback(callback, new Unigine::FunctionCallback<void(const char *, int)>(Unigine::Function<void(const char *, int)>(std::forward<Func>(func))));
+	}
 	static bool removeCallback(AsyncQueue::CALLBACK_INDEX callback, void *id);
 	static void clearCallbacks(AsyncQueue::CALLBACK_INDEX callback);
 };
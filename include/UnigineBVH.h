@@ -0,0 +1,676 @@
+/* Copyright (C) 2005-2020, UNIGINE. All rights reserved.
+ *
+ * This file is a part of the UNIGINE 2 SDK.
+ *
+ * Your use and / or redistribution of this software in source and / or
+ * binary form, with or without modification, is subject to: (i) your
+ * ongoing acceptance of and compliance with the terms and conditions of
+ * the UNIGINE License Agreement; and (ii) your inclusion of this notice
+ * in any version of this software that you use or redistribute.
+ * A copy of the UNIGINE License Agreement is available by contacting
+ * UNIGINE. at http://unigine.com/
+ */
+
+
+#pragma once
+
+#include "UnigineBase.h"
+#include "UnigineVector.h"
+#include "UnigineBounds.h"
+#include "UnigineThread.h"
+
+namespace Unigine
+{
+
+//////////////////////////////////////////////////////////////////////////
+/// Bounding volume hierarchy over user objects.
+///
+/// Objects are identified by their index in the array passed to build().
+/// The tree is built with a binned SAH, large builds are split into
+/// independent subtrees which are processed by PoolCPUShaders threads.
+/// Nodes are stored in one flat array, children of a node are always
+/// adjacent and placed after their parent, so refit() is a single
+/// backward pass. All queries are const and may be run concurrently.
+//////////////////////////////////////////////////////////////////////////
+
+class BVH
+{
+public:
+	enum
+	{
+		NUM_BINS = 16,
+		MAX_DEPTH = 64,
+		DEFAULT_LEAF_SIZE = 4,
+		PARALLEL_THRESHOLD = 4096, // minimum number of objects for a threaded build
+	};
+
+	struct Node
+	{
+		float min[3];
+		int index; // internal node: index of the left child (right is index + 1), leaf: first item
+		float max[3];
+		int count; // 0 for internal nodes
+	};
+
+	BVH() = default;
+
+	// build
+	UNIGINE_INLINE void build(const BoundBox *bounds, int num, int leaf_size = DEFAULT_LEAF_SIZE)
+	{
+		items.resize(num);
+		for (int i = 0; i < num; i++)
+			set_item(items[i], bounds[i]);
+		build_items(leaf_size);
+	}
+	UNIGINE_INLINE void build(const BoundSphere *bounds, int num, int leaf_size = DEFAULT_LEAF_SIZE)
+	{
+		items.resize(num);
+		for (int i = 0; i < num; i++)
+			set_item(items[i], bounds[i]);
+		build_items(leaf_size);
+	}
+	UNIGINE_INLINE void build(const Vector<BoundBox> &bounds, int leaf_size = DEFAULT_LEAF_SIZE) { build(bounds.get(), bounds.size(), leaf_size); }
+	UNIGINE_INLINE void build(const Vector<BoundSphere> &bounds, int leaf_size = DEFAULT_LEAF_SIZE) { build(bounds.get(), bounds.size(), leaf_size); }
+
+	// refit for moving objects, the number of objects must match the last build()
+	// tree quality degrades with large motions, call build() again from time to time
+	UNIGINE_INLINE void refit(const BoundBox *bounds, int num)
+	{
+		assert(num == items.size() && "BVH::refit(): bad number of objects");
+		for (int i = 0; i < num; i++)
+			set_item(items[i], bounds[i]);
+		refit_nodes();
+	}
+	UNIGINE_INLINE void refit(const BoundSphere *bounds, int num)
+	{
+		assert(num == items.size() && "BVH::refit(): bad number of objects");
+		for (int i = 0; i < num; i++)
+			set_item(items[i], bounds[i]);
+		refit_nodes();
+	}
+	UNIGINE_INLINE void refit(const Vector<BoundBox> &bounds) { refit(bounds.get(), bounds.size()); }
+	UNIGINE_INLINE void refit(const Vector<BoundSphere> &bounds) { refit(bounds.get(), bounds.size()); }
+
+	// updates the bounds of a single object, call refit() without arguments afterwards
+	UNIGINE_INLINE void setBounds(int object, const BoundBox &bb) { set_item(items[object], bb); }
+	UNIGINE_INLINE void setBounds(int object, const BoundSphere &bs) { set_item(items[object], bs); }
+	UNIGINE_INLINE void refit() { refit_nodes(); }
+
+	UNIGINE_INLINE void clear()
+	{
+		nodes.clear();
+		items.clear();
+		indices.clear();
+	}
+
+	// statistics
+	UNIGINE_INLINE int getNumNodes() const { return nodes.size(); }
+	UNIGINE_INLINE int getNumObjects() const { return items.size(); }
+	UNIGINE_INLINE const Vector<Node> &getNodes() const { return nodes; }
+	UNIGINE_INLINE BoundBox getBoundBox() const
+	{
+		if (nodes.empty())
+			return BoundBox();
+		const Node &root = nodes[0];
+		return BoundBox(Math::vec3(root.min[0], root.min[1], root.min[2]), Math::vec3(root.max[0], root.max[1], root.max[2]));
+	}
+
+	// queries, found object indices are appended to the result vector
+	// segment from p0 to p1
+	UNIGINE_INLINE int getIntersection(const Math::vec3 &p0, const Math::vec3 &p1, Vector<int> &result) const
+	{
+		Ray ray(p0, p1);
+		int num = result.size();
+		traverse([&ray](const float *min, const float *max) { return ray.intersect(min, max); },
+			[&result](int object) { result.append(object); });
+		return result.size() - num;
+	}
+
+	// returns the object whose bounds are entered first along the segment or -1
+	UNIGINE_INLINE int getClosestIntersection(const Math::vec3 &p0, const Math::vec3 &p1, float *fraction = nullptr) const
+	{
+		Ray ray(p0, p1);
+		int ret = -1;
+		float best = 1.0f;
+		int stack[MAX_DEPTH];
+		int depth = 0;
+		if (!nodes.empty())
+			stack[depth++] = 0;
+		while (depth)
+		{
+			const Node &node = nodes[stack[--depth]];
+			float t = 0.0f;
+			if (!ray.intersect(node.min, node.max, t) || t > best)
+				continue;
+			if (node.count)
+			{
+				for (int i = 0; i < node.count; i++)
+				{
+					int object = indices[node.index + i];
+					const Item &item = items[object];
+					if (ray.intersect(item.min, item.max, t) && t <= best)
+					{
+						best = t;
+						ret = object;
+					}
+				}
+				continue;
+			}
+
+			// visit the nearest child first, the build keeps the depth below MAX_DEPTH - 1
+			assert(depth + 2 <= MAX_DEPTH && "BVH::getClosestIntersection(): stack overflow");
+			const Node &left = nodes[node.index];
+			const Node &right = nodes[node.index + 1];
+			float t0 = 0.0f, t1 = 0.0f;
+			int hit0 = ray.intersect(left.min, left.max, t0);
+			int hit1 = ray.intersect(right.min, right.max, t1);
+			if (hit0 && hit1)
+			{
+				if (t0 < t1)
+				{
+					stack[depth++] = node.index + 1;
+					stack[depth++] = node.index;
+				} else
+				{
+					stack[depth++] = node.index;
+					stack[depth++] = node.index + 1;
+				}
+			} else if (hit0)
+				stack[depth++] = node.index;
+			else if (hit1)
+				stack[depth++] = node.index + 1;
+		}
+		if (fraction)
+			*fraction = best;
+		return ret;
+	}
+
+	UNIGINE_INLINE int getIntersection(const BoundSphere &bs, Vector<int> &result) const
+	{
+		const Math::vec3 &center = bs.getCenter();
+		float c[3] = { center.x, center.y, center.z };
+		float radius2 = bs.getRadius() * bs.getRadius();
+		int num = result.size();
+		traverse([&c, radius2](const float *min, const float *max)
+			{
+				float distance = 0.0f;
+				for (int i = 0; i < 3; i++)
+				{
+					float d = c[i] < min[i] ? min[i] - c[i] : (c[i] > max[i] ? c[i] - max[i] : 0.0f);
+					distance += d * d;
+				}
+				return distance <= radius2;
+			},
+			[&result](int object) { result.append(object); });
+		return result.size() - num;
+	}
+
+	UNIGINE_INLINE int getIntersection(const BoundBox &bb, Vector<int> &result) const
+	{
+		const Math::vec3 &bmin = bb.getMin();
+		const Math::vec3 &bmax = bb.getMax();
+		float b0[3] = { bmin.x, bmin.y, bmin.z };
+		float b1[3] = { bmax.x, bmax.y, bmax.z };
+		int num = result.size();
+		traverse([&b0, &b1](const float *min, const float *max)
+			{
+				return min[0] <= b1[0] && max[0] >= b0[0] &&
+					min[1] <= b1[1] && max[1] >= b0[1] &&
+					min[2] <= b1[2] && max[2] >= b0[2];
+			},
+			[&result](int object) { result.append(object); });
+		return result.size() - num;
+	}
+
+	UNIGINE_INLINE int getIntersection(const BoundFrustum &bf, Vector<int> &result) const
+	{
+		int num = result.size();
+		traverse([&bf](const float *min, const float *max)
+			{
+				return bf.insideFast(Math::vec3(min[0], min[1], min[2]), Math::vec3(max[0], max[1], max[2])) != 0;
+			},
+			[&result](int object) { result.append(object); });
+		return result.size() - num;
+	}
+
+	// generic traversal
+	// Overlap is "bool (const float *min, const float *max)", Visitor is "void (int object)"
+	template <typename Overlap, typename Visitor>
+	UNIGINE_INLINE void traverse(Overlap overlap, Visitor visitor) const
+	{
+		if (nodes.empty())
+			return;
+
+		int stack[MAX_DEPTH];
+		int depth = 0;
+		stack[depth++] = 0;
+		while (depth)
+		{
+			const Node &node = nodes[stack[--depth]];
+			if (!overlap(node.min, node.max))
+				continue;
+			if (node.count)
+			{
+				for (int i = 0; i < node.count; i++)
+				{
+					int object = indices[node.index + i];
+					const Item &item = items[object];
+					if (node.count == 1 || overlap(item.min, item.max))
+						visitor(object);
+				}
+			} else
+			{
+				assert(depth + 2 <= MAX_DEPTH && "BVH::traverse(): stack overflow");
+				stack[depth++] = node.index + 1;
+				stack[depth++] = node.index;
+			}
+		}
+	}
+
+private:
+	struct Item
+	{
+		float min[3];
+		float max[3];
+	};
+
+	struct Bin
+	{
+		float min[3];
+		float max[3];
+		int count;
+	};
+
+	struct Ray
+	{
+		Ray(const Math::vec3 &p0, const Math::vec3 &p1)
+		{
+			float d[3] = { p1.x - p0.x, p1.y - p0.y, p1.z - p0.z };
+			origin[0] = p0.x;
+			origin[1] = p0.y;
+			origin[2] = p0.z;
+			for (int i = 0; i < 3; i++)
+				idirection[i] = 1.0f / (Math::abs(d[i]) > 1e-30f ? d[i] : 1e-30f);
+		}
+
+		UNIGINE_INLINE int intersect(const float *min, const float *max) const
+		{
+			float t;
+			return intersect(min, max, t);
+		}
+
+		UNIGINE_INLINE int intersect(const float *min, const float *max, float &t) const
+		{
+			float t0 = 0.0f;
+			float t1 = 1.0f;
+			for (int i = 0; i < 3; i++)
+			{
+				float near_t = (min[i] - origin[i]) * idirection[i];
+				float far_t = (max[i] - origin[i]) * idirection[i];
+				if (near_t > far_t)
+				{
+					float temp = near_t;
+					near_t = far_t;
+					far_t = temp;
+				}
+				t0 = near_t > t0 ? near_t : t0;
+				t1 = far_t < t1 ? far_t : t1;
+			}
+			t = t0;
+			return t0 <= t1;
+		}
+
+		float origin[3];
+		float idirection[3];
+	};
+
+	// subtree that is built independently by a worker thread
+	struct Task
+	{
+		int node;
+		int first;
+		int count;
+		int depth;
+		Vector<Node> nodes;
+	};
+
+	static UNIGINE_INLINE void set_item(Item &item, const BoundBox &bb)
+	{
+		const Math::vec3 &min = bb.getMin();
+		const Math::vec3 &max = bb.getMax();
+		item.min[0] = min.x;
+		item.min[1] = min.y;
+		item.min[2] = min.z;
+		item.max[0] = max.x;
+		item.max[1] = max.y;
+		item.max[2] = max.z;
+	}
+
+	static UNIGINE_INLINE void set_item(Item &item, const BoundSphere &bs)
+	{
+		const Math::vec3 &center = bs.getCenter();
+		float radius = bs.getRadius();
+		item.min[0] = center.x - radius;
+		item.min[1] = center.y - radius;
+		item.min[2] = center.z - radius;
+		item.max[0] = center.x + radius;
+		item.max[1] = center.y + radius;
+		item.max[2] = center.z + radius;
+	}
+
+	static UNIGINE_INLINE float get_area(const float *min, const float *max)
+	{
+		float x = max[0] - min[0];
+		float y = max[1] - min[1];
+		float z = max[2] - min[2];
+		return x * y + y * z + z * x;
+	}
+
+	static UNIGINE_INLINE void clear_bounds(float *min, float *max)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			min[i] = FLT_MAX;
+			max[i] = -FLT_MAX;
+		}
+	}
+
+	static UNIGINE_INLINE void expand_bounds(float *min, float *max, const float *other_min, const float *other_max)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			min[i] = other_min[i] < min[i] ? other_min[i] : min[i];
+			max[i] = other_max[i] > max[i] ? other_max[i] : max[i];
+		}
+	}
+
+	void compute_bounds(Node &node, int first, int count) const
+	{
+		clear_bounds(node.min, node.max);
+		for (int i = 0; i < count; i++)
+		{
+			const Item &item = items[indices[first + i]];
+			expand_bounds(node.min, node.max, item.min, item.max);
+		}
+	}
+
+	// binned SAH split, returns the number of objects in the left half or 0 if the node must be a leaf
+	int split(int first, int count, int leaf_size)
+	{
+		if (count <= leaf_size)
+			return 0;
+
+		// centroid bounds (doubled centroids, the scale does not matter)
+		float cmin[3], cmax[3];
+		clear_bounds(cmin, cmax);
+		for (int i = 0; i < count; i++)
+		{
+			const Item &item = items[indices[first + i]];
+			for (int j = 0; j < 3; j++)
+			{
+				float c = item.min[j] + item.max[j];
+				cmin[j] = c < cmin[j] ? c : cmin[j];
+				cmax[j] = c > cmax[j] ? c : cmax[j];
+			}
+		}
+
+		int best_axis = -1;
+		int best_bin = 0;
+		float best_cost = FLT_MAX;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float extent = cmax[axis] - cmin[axis];
+			if (extent <= 0.0f)
+				continue;
+
+			Bin bins[NUM_BINS];
+			for (int i = 0; i < NUM_BINS; i++)
+			{
+				clear_bounds(bins[i].min, bins[i].max);
+				bins[i].count = 0;
+			}
+
+			float scale = NUM_BINS * (1.0f - 1e-5f) / extent;
+			for (int i = 0; i < count; i++)
+			{
+				const Item &item = items[indices[first + i]];
+				int b = int((item.min[axis] + item.max[axis] - cmin[axis]) * scale);
+				Bin &bin = bins[b];
+				expand_bounds(bin.min, bin.max, item.min, item.max);
+				bin.count++;
+			}
+
+			// sweep from the right side to get the right areas
+			float right_area[NUM_BINS];
+			int right_count[NUM_BINS];
+			float rmin[3], rmax[3];
+			clear_bounds(rmin, rmax);
+			int rcount = 0;
+			for (int i = NUM_BINS - 1; i > 0; i--)
+			{
+				if (bins[i].count)
+					expand_bounds(rmin, rmax, bins[i].min, bins[i].max);
+				rcount += bins[i].count;
+				right_count[i] = rcount;
+				right_area[i] = rcount ? get_area(rmin, rmax) : 0.0f;
+			}
+
+			float lmin[3], lmax[3];
+			clear_bounds(lmin, lmax);
+			int lcount = 0;
+			for (int i = 0; i < NUM_BINS - 1; i++)
+			{
+				if (bins[i].count)
+					expand_bounds(lmin, lmax, bins[i].min, bins[i].max);
+				lcount += bins[i].count;
+				if (lcount == 0 || right_count[i + 1] == 0)
+					continue;
+				float cost = lcount * get_area(lmin, lmax) + right_count[i + 1] * right_area[i + 1];
+				if (cost < best_cost)
+				{
+					best_cost = cost;
+					best_axis = axis;
+					best_bin = i;
+				}
+			}
+		}
+
+		// all centroids are equal, just halve the range
+		if (best_axis == -1)
+			return count / 2;
+
+		// compare with the cost of a leaf
+		Node node;
+		compute_bounds(node, first, count);
+		float leaf_cost = count * get_area(node.min, node.max);
+		if (best_cost >= leaf_cost && count <= leaf_size * 4)
+			return 0;
+
+		// partition
+		float scale = NUM_BINS * (1.0f - 1e-5f) / (cmax[best_axis] - cmin[best_axis]);
+		int *left = indices.get() + first;
+		int *right = left + count - 1;
+		while (left <= right)
+		{
+			const Item &item = items[*left];
+			int b = int((item.min[best_axis] + item.max[best_axis] - cmin[best_axis]) * scale);
+			if (b <= best_bin)
+				left++;
+			else
+			{
+				int temp = *left;
+				*left = *right;
+				*right = temp;
+				right--;
+			}
+		}
+		int num_left = int(left - (indices.get() + first));
+		if (num_left == 0 || num_left == count)
+			return count / 2;
+		return num_left;
+	}
+
+	// recursive subtree build into the output array, the node is already allocated
+	void build_subtree(Vector<Node> &out, int node_index, int first, int count, int leaf_size, int depth)
+	{
+		compute_bounds(out[node_index], first, count);
+		int num_left = depth < MAX_DEPTH - 2 ? split(first, count, leaf_size) : 0;
+		if (num_left == 0)
+		{
+			out[node_index].index = first;
+			out[node_index].count = count;
+			return;
+		}
+
+		int child = out.size();
+		out.append();
+		out.append();
+		out[node_index].index = child;
+		out[node_index].count = 0;
+		build_subtree(out, child, first, num_left, leaf_size, depth + 1);
+		build_subtree(out, child + 1, first + num_left, count - num_left, leaf_size, depth + 1);
+	}
+
+	void build_items(int leaf_size)
+	{
+		int num = items.size();
+		nodes.clear();
+		indices.resize(num);
+		for (int i = 0; i < num; i++)
+			indices[i] = i;
+		if (num == 0)
+			return;
+
+		nodes.reserve(num * 2);
+		nodes.append();
+
+		int num_threads = PoolCPUShaders::isInitialized() ? PoolCPUShaders::getNumSyncThreads() : 1;
+		if (num < PARALLEL_THRESHOLD || num_threads < 2)
+		{
+			build_subtree(nodes, 0, 0, num, leaf_size, 0);
+			return;
+		}
+
+		// split the top of the tree on the calling thread until there are enough subtrees
+		Vector<Task> tasks;
+		int task_size = num / (num_threads * 4);
+		if (task_size < PARALLEL_THRESHOLD / 4)
+			task_size = PARALLEL_THRESHOLD / 4;
+
+		struct Range
+		{
+			int node;
+			int first;
+			int count;
+			int depth;
+		};
+		Vector<Range> queue;
+		queue.append({ 0, 0, num, 0 });
+		while (!queue.empty())
+		{
+			Range range = queue.takeLast();
+			if (range.count <= task_size)
+			{
+				Task &task = tasks.append();
+				task.node = range.node;
+				task.first = range.first;
+				task.count = range.count;
+				task.depth = range.depth;
+				continue;
+			}
+
+			compute_bounds(nodes[range.node], range.first, range.count);
+			int num_left = range.depth < MAX_DEPTH - 2 ? split(range.first, range.count, leaf_size) : 0;
+			if (num_left == 0)
+			{
+				nodes[range.node].index = range.first;
+				nodes[range.node].count = range.count;
+				continue;
+			}
+
+			int child = nodes.size();
+			nodes.append();
+			nodes.append();
+			nodes[range.node].index = child;
+			nodes[range.node].count = 0;
+			queue.append({ child, range.first, num_left, range.depth + 1 });
+			queue.append({ child + 1, range.first + num_left, range.count - num_left, range.depth + 1 });
+		}
+
+		// build subtrees in parallel, object ranges are disjoint
+		class BuildShader : public CPUShader
+		{
+		public:
+			BuildShader(BVH *bvh, Vector<Task> &tasks, int leaf_size)
+				: bvh(bvh), tasks(tasks), leaf_size(leaf_size), counter(0) {}
+
+			void process(int thread_num, int threads_count) override
+			{
+				UNIGINE_UNUSED(thread_num);
+				UNIGINE_UNUSED(threads_count);
+				for (;;)
+				{
+					int i = AtomicAdd(&counter, 1);
+					if (i >= tasks.size())
+						break;
+					Task &task = tasks[i];
+					task.nodes.reserve(task.count * 2);
+					task.nodes.append();
+					bvh->build_subtree(task.nodes, 0, task.first, task.count, leaf_size, task.depth);
+				}
+			}
+
+		private:
+			BVH *bvh;
+			Vector<Task> &tasks;
+			int leaf_size;
+			volatile int counter;
+		};
+
+		BuildShader shader(this, tasks, leaf_size);
+		shader.runSync();
+
+		// splice subtrees into the flat array, local node i > 0 goes to base + i - 1
+		for (int i = 0; i < tasks.size(); i++)
+		{
+			const Task &task = tasks[i];
+			int base = nodes.size();
+			for (int j = 0; j < task.nodes.size(); j++)
+			{
+				Node node = task.nodes[j];
+				if (node.count == 0)
+					node.index += base - 1;
+				if (j == 0)
+					nodes[task.node] = node;
+				else
+					nodes.append(node);
+			}
+		}
+	}
+
+	void refit_nodes()
+	{
+		for (int i = nodes.size() - 1; i >= 0; i--)
+		{
+			Node &node = nodes[i];
+			if (node.count)
+				compute_bounds(node, node.index, node.count);
+			else
+			{
+				const Node &left = nodes[node.index];
+				const Node &right = nodes[node.index + 1];
+				for (int j = 0; j < 3; j++)
+				{
+					node.min[j] = left.min[j] < right.min[j] ? left.min[j] : right.min[j];
+					node.max[j] = left.max[j] > right.max[j] ? left.max[j] : right.max[j];
+				}
+			}
+		}
+	}
+
+	Vector<Node> nodes;
+	Vector<Item> items; // object bounds in the user order
+	Vector<int> indices; // object indices in the leaf order
+};
+
+} // namespace Unigine
@@ -139,12 +139,12 @@
 /*
  */
 #define UNIGINE_DECLARE_USE_MEMORY \
-static UNIGINE_INLINE void *operator new(size_t size) { return Unigine::Memory::allocate(size); } \
-static UNIGINE_INLINE void *operator new[](size_t size) { return Unigine::Memory::allocate(size); } \
-static UNIGINE_INLINE void operator delete(void *ptr) { Unigine::Memory::deallocate(ptr); } \
-static UNIGINE_INLINE void operator delete[](void *ptr) { Unigine::Memory::deallocate(ptr); } \
-static UNIGINE_INLINE void operator delete(void *ptr,size_t size) { Unigine::Memory::deallocate(ptr,size); } \
-static UNIGINE_INLINE void operator delete[](void *ptr,size_t size) { Unigine::Memory::deallocate(ptr,size); }
+static UNIGINE_INLINE void *operator new(size_t size) { return UNIGINE_MEMORY_ALLOCATE(size); } \
+static UNIGINE_INLINE void *operator new[](size_t size) { return UNIGINE_MEMORY_ALLOCATE(size); } \
+static UNIGINE_INLINE void operator delete(void *ptr) { UNIGINE_MEMORY_DEALLOCATE(ptr); } \
+static UNIGINE_INLINE void operator delete[](void *ptr) { UNIGINE_MEMORY_DEALLOCATE(ptr); } \
+static UNIGINE_INLINE void operator delete(void *ptr,size_t size) { UNIGINE_MEMORY_DEALLOCATE_SIZE(ptr,size); } \
+static UNIGINE_INLINE void operator delete[](void *ptr,size_t size) { UNIGINE_MEMORY_DEALLOCATE_SIZE(ptr,size); }
 
 /*
  */
@@ -16,6 +16,8 @@
 
 #include "UnigineBase.h"
 #include <type_traits>
+#include <utility>
+#include <new>
 
 namespace Unigine
 {
@@ -884,4 +886,285 @@ CallbackBase *MakeCallback(Class *object, Ret (Class::*func)(A0, A1, A2, A3, A4)
 	return new CallbackObject5<CallbackBase, Class, Ret (Class::*)(A0, A1, A2, A3, A4) const, A0, A1, A2, A3, A4>(object, func, a0, a1, a2, a3, a4);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// Move-only type-erased function.
+///
+/// Callables up to BUFFER_SIZE bytes (free functions, object + member
+/// function pairs, small lambdas) are stored inline, larger ones go to the
+/// heap. A call is a single indirect jump to a typed thunk, there is no
+/// virtual dispatch and no arity switch.
+////////////////////////////////////////////////////////////////////////////////
+template <class Sig>
+class Function;
+
+template <class Ret, class... Args>
+class Function<Ret(Args...)>
+{
+	template <class F>
+	using EnableIfCallable = typename std::enable_if<
+		!std::is_same<typename std::decay<F>::type, Function>::value &&
+		!std::is_convertible<F, CallbackBase *>::value>::type;
+
+public:
+	enum
+	{
+		BUFFER_SIZE = 4 * sizeof(void *),
+	};
+
+	Function() {}
+	Function(std::nullptr_t) {}
+
+	template <class F, class = EnableIfCallable<F>>
+	Function(F &&func)
+	{
+		init(std::forward<F>(func));
+	}
+
+	template <class Class>
+	Function(Class *object, Ret (Class::*func)(Args...))
+	{
+		init(MemberCall<Class, Ret (Class::*)(Args...)>{object, func});
+	}
+
+	template <class Class>
+	Function(const Class *object, Ret (Class::*func)(Args...) const)
+	{
+		init(MemberCall<const Class, Ret (Class::*)(Args...) const>{object, func});
+	}
+
+	Function(Function &&f) { move_from(f); }
+	~Function() { clear(); }
+
+	Function &operator=(Function &&f)
+	{
+		if (this != &f)
+		{
+			clear();
+			move_from(f);
+		}
+		return *this;
+	}
+	Function &operator=(std::nullptr_t)
+	{
+		clear();
+		return *this;
+	}
+
+	Function(const Function &) = delete;
+	Function &operator=(const Function &) = delete;
+
+	UNIGINE_INLINE Ret operator()(Args... args) const
+	{
+		assert(invoke && "Function::operator(): empty function");
+		return invoke(const_cast<Storage *>(&storage), std::forward<Args>(args)...);
+	}
+
+	UNIGINE_INLINE explicit operator bool() const { return invoke != nullptr; }
+	UNIGINE_INLINE bool empty() const { return invoke == nullptr; }
+
+	void clear()
+	{
+		if (manage)
+			manage(DESTROY, &storage, nullptr);
+		invoke = nullptr;
+		manage = nullptr;
+	}
+
+private:
+	using Storage = typename std::aligned_storage<BUFFER_SIZE, alignof(void *) < alignof(double) ? alignof(double) : alignof(void *)>::type;
+
+	enum Operation
+	{
+		MOVE,
+		DESTROY,
+	};
+
+	using Invoke = Ret (*)(Storage *, Args...);
+	using Manage = void (*)(Operation, Storage *, Storage *);
+
+	template <class Class, class Method>
+	struct MemberCall
+	{
+		Class *object;
+		Method func;
+		UNIGINE_INLINE Ret operator()(Args... args) const { return (object->*func)(std::forward<Args>(args)...); }
+	};
+
+	template <class F>
+	struct IsInline
+	{
+		enum
+		{
+			value = sizeof(F) <= sizeof(Storage) && alignof(Storage) % alignof(F) == 0 &&
+				std::is_nothrow_move_constructible<F>::value,
+		};
+	};
+
+	// void results are dropped, so any callable with matching arguments fits Function<void(...)>
+	template <class F, class R = Ret>
+	static typename std::enable_if<std::is_void<R>::value>::type call(F &f, Args... args) { f(std::forward<Args>(args)...); }
+	template <class F, class R = Ret>
+	static typename std::enable_if<!std::is_void<R>::value, R>::type call(F &f, Args... args) { return f(std::forward<Args>(args)...); }
+
+	template <class F>
+	static Ret invoke_inline(Storage *s, Args... args) { return call(*reinterpret_cast<F *>(s), std::forward<Args>(args)...); }
+	template <class F>
+	static Ret invoke_heap(Storage *s, Args... args) { return call(**reinterpret_cast<F **>(s), std::forward<Args>(args)...); }
+
+	template <class F>
+	static void manage_inline(Operation op, Storage *dest, Storage *src)
+	{
+		if (op == MOVE)
+		{
+			F *f = reinterpret_cast<F *>(src);
+			new (dest) F(std::move(*f));
+			f->~F();
+		} else
+			reinterpret_cast<F *>(dest)->~F();
+	}
+	template <class F>
+	static void manage_heap(Operation op, Storage *dest, Storage *src)
+	{
+		if (op == MOVE)
+			memcpy(dest, src, sizeof(F *));
+		else
+			delete *reinterpret_cast<F **>(dest);
+	}
+
+	template <class F>
+	typename std::enable_if<IsInline<typename std::decay<F>::type>::value>::type init(F &&func)
+	{
+		using Type = typename std::decay<F>::type;
+		new (&storage) Type(std::forward<F>(func));
+		invoke = &invoke_inline<Type>;
+		// trivial callables are relocated with memcpy and need no destructor
+		if (!std::is_trivially_copyable<Type>::value)
+			manage = &manage_inline<Type>;
+	}
+
+	template <class F>
+	typename std::enable_if<!IsInline<typename std::decay<F>::type>::value>::type init(F &&func)
+	{
+		using Type = typename std::decay<F>::type;
+		Type *f = new Type(std::forward<F>(func));
+		memcpy(&storage, &f, sizeof(f));
+		invoke = &invoke_heap<Type>;
+		manage = &manage_heap<Type>;
+	}
+
+	void move_from(Function &f)
+	{
+		if (f.manage)
+			f.manage(MOVE, &storage, &f.storage);
+		else if (f.invoke)
+			memcpy(&storage, &f.storage, sizeof(storage));
+		invoke = f.invoke;
+		manage = f.manage;
+		f.invoke = nullptr;
+		f.manage = nullptr;
+	}
+
+	Storage storage;
+	Invoke invoke{nullptr};
+	Manage manage{nullptr};
+};
+
+template <class Class, class Ret, class... Args>
+Function<Ret(Args...)> MakeFunction(Class *object, Ret (Class::*func)(Args...))
+{
+	return Function<Ret(Args...)>(object, func);
+}
+
+template <class Class, class Ret, class... Args>
+Function<Ret(Args...)> MakeFunction(const Class *object, Ret (Class::*func)(Args...) const)
+{
+	return Function<Ret(Args...)>(object, func);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// Function adapters for the CallbackBase interfaces.
+///
+/// The adapter is a CallbackBase itself, so it can be stored by value next
+/// to its owner and passed where the engine expects a callback pointer.
+////////////////////////////////////////////////////////////////////////////////
+template <class Sig>
+class FunctionCallback;
+
+template <>
+class FunctionCallback<void()> : public CallbackBase
+{
+public:
+	FunctionCallback() {}
+	FunctionCallback(Function<void()> &&func) : func(std::move(func)) {}
+
+	void run() override { func(); }
+
+	Function<void()> func;
+};
+
+template <class A0>
+class FunctionCallback<void(A0)> : public CallbackBase1<A0>
+{
+public:
+	FunctionCallback() {}
+	FunctionCallback(Function<void(A0)> &&func) : func(std::move(func)) {}
+
+	using CallbackBase1<A0>::run;
+	void run(A0 a0) override { func(a0); }
+
+	Function<void(A0)> func;
+};
+
+template <class A0, class A1>
+class FunctionCallback<void(A0, A1)> : public CallbackBase2<A0, A1>
+{
+public:
+	FunctionCallback() {}
+	FunctionCallback(Function<void(A0, A1)> &&func) : func(std::move(func)) {}
+
+	using CallbackBase2<A0, A1>::run;
+	void run(A0 a0, A1 a1) override { func(a0, a1); }
+
+	Function<void(A0, A1)> func;
+};
+
+template <class A0, class A1, class A2>
+class FunctionCallback<void(A0, A1, A2)> : public CallbackBase3<A0, A1, A2>
+{
+public:
+	FunctionCallback() {}
+	FunctionCallback(Function<void(A0, A1, A2)> &&func) : func(std::move(func)) {}
+
+	using CallbackBase3<A0, A1, A2>::run;
+	void run(A0 a0, A1 a1, A2 a2) override { func(a0, a1, a2); }
+
+	Function<void(A0, A1, A2)> func;
+};
+
+template <class A0, class A1, class A2, class A3>
+class FunctionCallback<void(A0, A1, A2, A3)> : public CallbackBase4<A0, A1, A2, A3>
+{
+public:
+	FunctionCallback() {}
+	FunctionCallback(Function<void(A0, A1, A2, A3)> &&func) : func(std::move(func)) {}
+
+	using CallbackBase4<A0, A1, A2, A3>::run;
+	void run(A0 a0, A1 a1, A2 a2, A3 a3) override { func(a0, a1, a2, a3); }
+
+	Function<void(A0, A1, A2, A3)> func;
+};
+
+template <class A0, class A1, class A2, class A3, class A4>
+class FunctionCallback<void(A0, A1, A2, A3, A4)> : public CallbackBase5<A0, A1, A2, A3, A4>
+{
+public:
+	FunctionCallback() {}
+	FunctionCallback(Function<void(A0, A1, A2, A3, A4)> &&func) : func(std::move(func)) {}
+
+	using CallbackBase5<A0, A1, A2, A3, A4>::run;
+	void run(A0 a0, A1 a1, A2 a2, A3 a3, A4 a4) override { func(a0, a1, a2, a3, a4); }
+
+	Function<void(A0, A1, A2, A3, A4)> func;
+};
+
 } // namespace Unigine
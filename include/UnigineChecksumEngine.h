@@ -0,0 +1,1180 @@
+/* Copyright (C) 2005-2020, UNIGINE. All rights reserved.
+ *
+ * This file is a part of the UNIGINE 2 SDK.
+ *
+ * Your use and / or redistribution of this software in source and / or
+ * binary form, with or without modification, is subject to: (i) your
+ * ongoing acceptance of and compliance with the terms and conditions of
+ * the UNIGINE License Agreement; and (ii) your inclusion of this notice
+ * in any version of this software that you use or redistribute.
+ * A copy of the UNIGINE License Agreement is available by contacting
+ * UNIGINE. at http://unigine.com/
+ */
+
+
+#pragma once
+
+#include "UnigineBase.h"
+#include "UnigineChecksum.h"
+#include "UnigineThread.h"
+#include "UnigineVector.h"
+#include "UnigineString.h"
+#include "UnigineFormat.h"
+#include "UnigineConsole.h"
+#include "UnigineCallback.h"
+#include <chrono>
+
+#if defined(_M_X64) || defined(__x86_64__)
+	#define UNIGINE_CHECKSUM_ENGINE_X64 1
+	#ifdef _MSC_VER
+		#include <intrin.h>
+	#else
+		#include <cpuid.h>
+	#endif
+	#include <immintrin.h>
+#else
+	#define UNIGINE_CHECKSUM_ENGINE_X64 0
+#endif
+
+// instruction set extensions are enabled per function and selected at runtime
+#if UNIGINE_CHECKSUM_ENGINE_X64 && (defined(__GNUC__) || defined(__clang__))
+	#define UNIGINE_CHECKSUM_ENGINE_TARGET(TARGET) __attribute__((target(TARGET)))
+#else
+	#define UNIGINE_CHECKSUM_ENGINE_TARGET(TARGET)
+#endif
+
+// Checksum engine example
+/*
+	// one-shot
+	unsigned int crc = Unigine::CRC32C::hash(data, size);
+	Unigine::Hash128 digest = Unigine::XXH3::hash128(data, size);
+
+	// incremental, equal to the one-shot result
+	Unigine::XXH3 hasher;
+	hasher.update(chunk_0, size_0);
+	hasher.update(chunk_1, size_1);
+	unsigned long long h = hasher.final64();
+
+	// large buffers on PoolCPUShaders threads
+	unsigned int crc = Unigine::CRC32C::hashParallel(data, size);	// equal to CRC32C::hash()
+	Unigine::Hash128 digest = Unigine::ChecksumEngine::treeHash128(data, size);	// not equal to XXH3::hash128()
+*/
+
+namespace Unigine
+{
+
+struct Hash128
+{
+	unsigned long long low;
+	unsigned long long high;
+
+	UNIGINE_INLINE bool operator==(const Hash128 &h) const { return low == h.low && high == h.high; }
+	UNIGINE_INLINE bool operator!=(const Hash128 &h) const { return low != h.low || high != h.high; }
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// Runtime CPU features, parallel hashing and the benchmark.
+//////////////////////////////////////////////////////////////////////////
+
+class ChecksumEngine
+{
+public:
+	enum
+	{
+		DEFAULT_LEAF_SIZE = 1024 * 1024,
+	};
+
+	static UNIGINE_INLINE bool hasCRC32() { return get_features().crc32; }	// SSE4.2
+	static UNIGINE_INLINE bool hasCLMUL() { return get_features().clmul; }	// PCLMULQDQ
+	static UNIGINE_INLINE bool hasAVX2() { return get_features().avx2; }
+
+	// XXH3-128 of the XXH3-128 digests of leaf_size blocks hashed in parallel, the result
+	// depends on the leaf size but not on the number of threads
+	static Hash128 treeHash128(const void *data, size_t size, size_t leaf_size = DEFAULT_LEAF_SIZE);
+
+	// throughput of the hash functions in GB/s
+	static void getBenchmarkReport(String &ret, size_t size = 64 * 1024 * 1024);
+
+	// checksum_benchmark [size in MB]
+	static void addConsoleCommands()
+	{
+		Console::addCommand("checksum_benchmark", "prints the throughput of the checksum functions", MakeCallback(&ChecksumEngine::console_benchmark));
+	}
+	static void removeConsoleCommands() { Console::removeCommand("checksum_benchmark"); }
+
+	// runs func(index) for each index in [0, num) on PoolCPUShaders threads
+	template <class Func>
+	static void parallelFor(int num, const Func &func)
+	{
+		if (num > 1 && PoolCPUShaders::isInitialized() && PoolCPUShaders::getNumSyncThreads() > 1)
+		{
+			ParallelShader<Func> shader(num, func);
+			shader.runSync();
+		} else
+		{
+			for (int i = 0; i < num; i++)
+				func(i);
+		}
+	}
+
+private:
+	friend class CRC32C;
+	friend class XXH3;
+
+	struct Features
+	{
+		Features()
+		{
+#if UNIGINE_CHECKSUM_ENGINE_X64
+			unsigned int info[4] = {};
+			cpuid(info, 1, 0);
+			crc32 = (info[2] & (1 << 20)) != 0;
+			clmul = (info[2] & (1 << 1)) != 0;
+			bool osxsave = (info[2] & (1 << 27)) != 0;
+			bool avx = (info[2] & (1 << 28)) != 0;
+			cpuid(info, 7, 0);
+			avx2 = avx && osxsave && (info[1] & (1 << 5)) != 0 && (xgetbv() & 6) == 6;
+#endif
+		}
+
+#if UNIGINE_CHECKSUM_ENGINE_X64
+		static void cpuid(unsigned int *info, unsigned int leaf, unsigned int subleaf)
+		{
+	#ifdef _MSC_VER
+			__cpuidex(reinterpret_cast<int *>(info), int(leaf), int(subleaf));
+	#else
+			__cpuid_count(leaf, subleaf, info[0], info[1], info[2], info[3]);
+	#endif
+		}
+
+		static unsigned long long xgetbv()
+		{
+	#ifdef _MSC_VER
+			return _xgetbv(0);
+	#else
+			unsigned int lo, hi;
+			__asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+			return (unsigned long long)hi << 32 | lo;
+	#endif
+		}
+#endif
+
+		bool crc32{false};
+		bool clmul{false};
+		bool avx2{false};
+		bool force_scalar{false};	// benchmark only
+	};
+
+	static Features &get_features()
+	{
+		static Features features;
+		return features;
+	}
+
+	template <class Func>
+	class ParallelShader : public CPUShader
+	{
+	public:
+		ParallelShader(int num, const Func &func) : num(num), func(func) {}
+
+		void process(int thread_num, int threads_count) override
+		{
+			UNIGINE_UNUSED(thread_num);
+			UNIGINE_UNUSED(threads_count);
+			for (;;)
+			{
+				int i = AtomicAdd(&counter, 1);
+				if (i >= num)
+					break;
+				func(i);
+			}
+		}
+
+	private:
+		int num;
+		const Func &func;
+		volatile int counter{0};
+	};
+
+	static void console_benchmark(int argc, char **argv)
+	{
+		size_t size = 64;
+		if (argc > 1 && atoi(argv[1]) > 0)
+			size = size_t(atoi(argv[1]));
+		String report;
+		getBenchmarkReport(report, size * 1024 * 1024);
+		Log::message("%s", report.get());
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// CRC-32C (Castagnoli), as used by iSCSI, ext4 and SSE4.2.
+///
+/// With SSE4.2 three streams of the crc32 instruction are interleaved and
+/// merged with a carry-less multiply, otherwise slicing-by-8 tables are
+/// used. Passing the previous result as the seed continues the checksum.
+//////////////////////////////////////////////////////////////////////////
+
+class CRC32C
+{
+public:
+	CRC32C(unsigned int seed = 0) : crc(~seed) {}
+
+	UNIGINE_INLINE void reset(unsigned int seed = 0) { crc = ~seed; }
+	UNIGINE_INLINE void update(const void *data, size_t size) { crc = process(crc, static_cast<const unsigned char *>(data), size); }
+	UNIGINE_INLINE unsigned int final() const { return ~crc; }
+
+	static UNIGINE_INLINE unsigned int hash(const void *data, size_t size, unsigned int seed = 0)
+	{
+		return ~process(~seed, static_cast<const unsigned char *>(data), size);
+	}
+
+	// chunks are checksummed on PoolCPUShaders threads and combined, equal to hash()
+	static unsigned int hashParallel(const void *data, size_t size, unsigned int seed = 0)
+	{
+		enum
+		{
+			MIN_CHUNK_SIZE = 256 * 1024,
+		};
+
+		int num_threads = PoolCPUShaders::isInitialized() ? PoolCPUShaders::getNumSyncThreads() : 1;
+		size_t chunk_size = (size + num_threads * 4 - 1) / (num_threads * 4);
+		if (chunk_size < MIN_CHUNK_SIZE)
+			chunk_size = MIN_CHUNK_SIZE;
+		int num = int((size + chunk_size - 1) / chunk_size);
+		if (num <= 1)
+			return hash(data, size, seed);
+
+		const unsigned char *src = static_cast<const unsigned char *>(data);
+		Vector<unsigned int> crcs;
+		crcs.resize(num);
+		ChecksumEngine::parallelFor(num, [&](int i)
+		{
+			size_t offset = chunk_size * i;
+			crcs[i] = hash(src + offset, i == num - 1 ? size - offset : chunk_size, i == 0 ? seed : 0);
+		});
+
+		unsigned int ret = crcs[0];
+		unsigned int shift = x8nmodp(chunk_size);
+		for (int i = 1; i < num; i++)
+		{
+			if (i == num - 1)
+				shift = x8nmodp(size - chunk_size * i);
+			ret = multmodp(shift, ret) ^ crcs[i];
+		}
+		return ret;
+	}
+
+	// checksum of the concatenation, crc1 and crc2 are hash() results, size2 is the size of the second part
+	static UNIGINE_INLINE unsigned int combine(unsigned int crc1, unsigned int crc2, size_t size2)
+	{
+		return multmodp(x8nmodp(size2), crc1) ^ crc2;
+	}
+
+private:
+	friend class ChecksumEngine;
+
+	enum
+	{
+		POLY = 0x82f63b78,	// reflected
+		LONG_LANE = 4096,
+		SHORT_LANE = 256,
+	};
+
+	struct Tables
+	{
+		Tables()
+		{
+			for (unsigned int i = 0; i < 256; i++)
+			{
+				unsigned int c = i;
+				for (int j = 0; j < 8; j++)
+					c = c & 1 ? (c >> 1) ^ POLY : c >> 1;
+				slice[0][i] = c;
+			}
+			for (unsigned int i = 0; i < 256; i++)
+			{
+				for (int j = 1; j < 8; j++)
+					slice[j][i] = (slice[j - 1][i] >> 8) ^ slice[0][slice[j - 1][i] & 0xff];
+			}
+
+			x2n[0] = 1u << 30;	// x^1
+			for (int i = 1; i < 64; i++)
+				x2n[i] = multmodp(x2n[i - 1], x2n[i - 1]);
+
+			// shifts of the lanes for the carry-less multiply, x^(8n - 33)
+			long_shift[0] = xnmodp(LONG_LANE * 8 - 33);
+			long_shift[1] = xnmodp(LONG_LANE * 2 * 8 - 33);
+			short_shift[0] = xnmodp(SHORT_LANE * 8 - 33);
+			short_shift[1] = xnmodp(SHORT_LANE * 2 * 8 - 33);
+		}
+
+		unsigned int xnmodp(unsigned long long n) const
+		{
+			unsigned int p = 1u << 31;	// x^0
+			for (int k = 0; n; n >>= 1, k++)
+			{
+				if (n & 1)
+					p = multmodp(x2n[k & 63], p);
+			}
+			return p;
+		}
+
+		unsigned int slice[8][256];
+		unsigned int x2n[64];	// x^(2^n)
+		unsigned int long_shift[2];
+		unsigned int short_shift[2];
+	};
+
+	static const Tables &get_tables()
+	{
+		static Tables tables;
+		return tables;
+	}
+
+	// polynomial product modulo POLY, both reflected
+	static unsigned int multmodp(unsigned int a, unsigned int b)
+	{
+		unsigned int m = 1u << 31;
+		unsigned int p = 0;
+		for (;;)
+		{
+			if (a & m)
+			{
+				p ^= b;
+				if ((a & (m - 1)) == 0)
+					break;
+			}
+			m >>= 1;
+			b = b & 1 ? (b >> 1) ^ POLY : b >> 1;
+		}
+		return p;
+	}
+
+	// x^(8 * size) modulo POLY, shifts a checksum by size zero bytes
+	static UNIGINE_INLINE unsigned int x8nmodp(size_t size) { return get_tables().xnmodp((unsigned long long)size * 8); }
+
+	static UNIGINE_INLINE unsigned int process(unsigned int crc, const unsigned char *p, size_t size)
+	{
+#if UNIGINE_CHECKSUM_ENGINE_X64
+		const ChecksumEngine::Features &features = ChecksumEngine::get_features();
+		if (features.crc32 && features.clmul && !features.force_scalar)
+			return process_hw(crc, p, size);
+#endif
+		return process_sw(crc, p, size);
+	}
+
+	static unsigned int process_sw(unsigned int crc, const unsigned char *p, size_t size)
+	{
+		const Tables &t = get_tables();
+		while (size && (size_t(p) & 7))
+		{
+			crc = (crc >> 8) ^ t.slice[0][(crc ^ *p++) & 0xff];
+			size--;
+		}
+		while (size >= 8)
+		{
+			unsigned int lo;
+			unsigned int hi;
+			memcpy(&lo, p, 4);
+			memcpy(&hi, p + 4, 4);
+			lo ^= crc;
+			crc = t.slice[7][lo & 0xff] ^ t.slice[6][(lo >> 8) & 0xff] ^ t.slice[5][(lo >> 16) & 0xff] ^ t.slice[4][lo >> 24] ^
+				t.slice[3][hi & 0xff] ^ t.slice[2][(hi >> 8) & 0xff] ^ t.slice[1][(hi >> 16) & 0xff] ^ t.slice[0][hi >> 24];
+			p += 8;
+			size -= 8;
+		}
+		while (size--)
+			crc = (crc >> 8) ^ t.slice[0][(crc ^ *p++) & 0xff];
+		return crc;
+	}
+
+#if UNIGINE_CHECKSUM_ENGINE_X64
+	// crc * x^(8n) modulo POLY, k is x^(8n - 33)
+	UNIGINE_CHECKSUM_ENGINE_TARGET("sse4.2,pclmul")
+	static UNIGINE_INLINE unsigned long long shift_hw(unsigned int crc, unsigned int k)
+	{
+		__m128i product = _mm_clmulepi64_si128(_mm_cvtsi32_si128(int(crc)), _mm_cvtsi32_si128(int(k)), 0);
+		return _mm_crc32_u64(0, (unsigned long long)_mm_cvtsi128_si64(product));
+	}
+
+	template <int LANE>
+	UNIGINE_CHECKSUM_ENGINE_TARGET("sse4.2,pclmul")
+	static UNIGINE_INLINE unsigned long long lanes_hw(unsigned long long crc, const unsigned char *&p, size_t &size, const unsigned int *shift)
+	{
+		while (size >= LANE * 3)
+		{
+			unsigned long long crc1 = 0;
+			unsigned long long crc2 = 0;
+			for (int i = 0; i < LANE; i += 8)
+			{
+				unsigned long long v0, v1, v2;
+				memcpy(&v0, p + i, 8);
+				memcpy(&v1, p + i + LANE, 8);
+				memcpy(&v2, p + i + LANE * 2, 8);
+				crc = _mm_crc32_u64(crc, v0);
+				crc1 = _mm_crc32_u64(crc1, v1);
+				crc2 = _mm_crc32_u64(crc2, v2);
+			}
+			crc = shift_hw((unsigned int)crc, shift[1]) ^ shift_hw((unsigned int)crc1, shift[0]) ^ crc2;
+			p += LANE * 3;
+			size -= LANE * 3;
+		}
+		return crc;
+	}
+
+	UNIGINE_CHECKSUM_ENGINE_TARGET("sse4.2,pclmul")
+	static unsigned int process_hw(unsigned int crc32, const unsigned char *p, size_t size)
+	{
+		while (size && (size_t(p) & 7))
+		{
+			crc32 = _mm_crc32_u8(crc32, *p++);
+			size--;
+		}
+
+		// the crc32 instruction has a latency of 3 cycles and a throughput of 1
+		const Tables &t = get_tables();
+		unsigned long long crc = crc32;
+		crc = lanes_hw<LONG_LANE>(crc, p, size, t.long_shift);
+		crc = lanes_hw<SHORT_LANE>(crc, p, size, t.short_shift);
+
+		while (size >= 8)
+		{
+			unsigned long long v;
+			memcpy(&v, p, 8);
+			crc = _mm_crc32_u64(crc, v);
+			p += 8;
+			size -= 8;
+		}
+		crc32 = (unsigned int)crc;
+		while (size--)
+			crc32 = _mm_crc32_u8(crc32, *p++);
+		return crc32;
+	}
+#endif
+
+	unsigned int crc;
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// XXH3 64-bit and 128-bit hashes (xxHash 0.8).
+///
+/// Results are identical to the reference implementation for every seed.
+/// Inputs longer than 240 bytes are accumulated with AVX2 or SSE2. The
+/// incremental hasher gives the same result as the one-shot functions for
+/// any split of the input.
+//////////////////////////////////////////////////////////////////////////
+
+class XXH3
+{
+public:
+	XXH3(unsigned long long seed = 0) { reset(seed); }
+
+	void reset(unsigned long long s = 0)
+	{
+		seed = s;
+		init_acc(acc);
+		buffered_size = 0;
+		nb_stripes_acc = 0;
+		total_size = 0;
+		if (seed)
+			init_secret(secret, seed);
+		else
+			memcpy(secret, get_default_secret(), SECRET_SIZE);
+	}
+
+	void update(const void *data, size_t size)
+	{
+		const unsigned char *src = static_cast<const unsigned char *>(data);
+		total_size += size;
+
+		if (size + buffered_size <= BUFFER_SIZE)
+		{
+			if (size)
+				memcpy(buffer + buffered_size, src, size);
+			buffered_size += size;
+			return;
+		}
+
+		if (buffered_size)
+		{
+			size_t fill = BUFFER_SIZE - buffered_size;
+			memcpy(buffer + buffered_size, src, fill);
+			src += fill;
+			size -= fill;
+			nb_stripes_acc = consume_stripes(acc, BUFFER_STRIPES, nb_stripes_acc, buffer, secret);
+			buffered_size = 0;
+		}
+
+		if (size > BUFFER_SIZE)
+		{
+			do
+			{
+				nb_stripes_acc = consume_stripes(acc, BUFFER_STRIPES, nb_stripes_acc, src, secret);
+				src += BUFFER_SIZE;
+				size -= BUFFER_SIZE;
+			} while (size > BUFFER_SIZE);
+			// the last stripe is needed if the remaining input is shorter
+			memcpy(buffer + BUFFER_SIZE - STRIPE_SIZE, src - STRIPE_SIZE, STRIPE_SIZE);
+		}
+
+		memcpy(buffer, src, size);
+		buffered_size = size;
+	}
+
+	unsigned long long final64() const
+	{
+		if (total_size <= MID_SIZE_MAX)
+			return hash64(buffer, size_t(total_size), seed);
+		unsigned long long a[ACC_NB];
+		digest_long(a);
+		return merge_accs(a, secret + SECRET_MERGEACCS_START, total_size * PRIME64_1);
+	}
+
+	Hash128 final128() const
+	{
+		if (total_size <= MID_SIZE_MAX)
+			return hash128(buffer, size_t(total_size), seed);
+		unsigned long long a[ACC_NB];
+		digest_long(a);
+		Hash128 ret;
+		ret.low = merge_accs(a, secret + SECRET_MERGEACCS_START, total_size * PRIME64_1);
+		ret.high = merge_accs(a, secret + SECRET_SIZE - sizeof(a) - SECRET_MERGEACCS_START, ~(total_size * PRIME64_2));
+		return ret;
+	}
+
+	static unsigned long long hash64(const void *data, size_t size, unsigned long long seed = 0)
+	{
+		const unsigned char *p = static_cast<const unsigned char *>(data);
+		const unsigned char *s = get_default_secret();
+		if (size <= 16)
+			return len_0to16_64(p, size, s, seed);
+		if (size <= 128)
+			return len_17to128_64(p, size, s, seed);
+		if (size <= MID_SIZE_MAX)
+			return len_129to240_64(p, size, s, seed);
+
+		unsigned char custom[SECRET_SIZE];
+		if (seed)
+		{
+			init_secret(custom, seed);
+			s = custom;
+		}
+		unsigned long long a[ACC_NB];
+		hash_long(a, p, size, s);
+		return merge_accs(a, s + SECRET_MERGEACCS_START, size * PRIME64_1);
+	}
+
+	static Hash128 hash128(const void *data, size_t size, unsigned long long seed = 0)
+	{
+		const unsigned char *p = static_cast<const unsigned char *>(data);
+		const unsigned char *s = get_default_secret();
+		if (size <= 16)
+			return len_0to16_128(p, size, s, seed);
+		if (size <= 128)
+			return len_17to128_128(p, size, s, seed);
+		if (size <= MID_SIZE_MAX)
+			return len_129to240_128(p, size, s, seed);
+
+		unsigned char custom[SECRET_SIZE];
+		if (seed)
+		{
+			init_secret(custom, seed);
+			s = custom;
+		}
+		unsigned long long a[ACC_NB];
+		hash_long(a, p, size, s);
+		Hash128 ret;
+		ret.low = merge_accs(a, s + SECRET_MERGEACCS_START, size * PRIME64_1);
+		ret.high = merge_accs(a, s + SECRET_SIZE - sizeof(a) - SECRET_MERGEACCS_START, ~(size * PRIME64_2));
+		return ret;
+	}
+
+private:
+	friend class ChecksumEngine;
+
+	enum
+	{
+		STRIPE_SIZE = 64,
+		SECRET_CONSUME_RATE = 8,
+		ACC_NB = 8,
+		SECRET_SIZE = 192,
+		SECRET_SIZE_MIN = 136,
+		SECRET_MERGEACCS_START = 11,
+		SECRET_LASTACC_START = 7,
+		MID_SIZE_MAX = 240,
+		BUFFER_SIZE = 256,
+		BUFFER_STRIPES = BUFFER_SIZE / STRIPE_SIZE,
+		STRIPES_PER_BLOCK = (SECRET_SIZE - STRIPE_SIZE) / SECRET_CONSUME_RATE,
+	};
+
+	static const unsigned int PRIME32_1 = 0x9E3779B1U;
+	static const unsigned int PRIME32_2 = 0x85EBCA77U;
+	static const unsigned int PRIME32_3 = 0xC2B2AE3DU;
+	static const unsigned long long PRIME64_1 = 0x9E3779B185EBCA87ULL;
+	static const unsigned long long PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+	static const unsigned long long PRIME64_3 = 0x165667B19E3779F9ULL;
+	static const unsigned long long PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+	static const unsigned long long PRIME64_5 = 0x27D4EB2F165667C5ULL;
+	static const unsigned long long PRIME_MX1 = 0x165667919E3779F9ULL;
+	static const unsigned long long PRIME_MX2 = 0x9FB21C651E98DF25ULL;
+
+	static const unsigned char *get_default_secret()
+	{
+		alignas(64) static const unsigned char secret[SECRET_SIZE] = {
+			0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+			0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+			0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+			0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+			0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+			0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+			0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+			0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+			0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+			0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+			0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+			0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+		};
+		return secret;
+	}
+
+	// little-endian reads, x86 only
+	static UNIGINE_INLINE unsigned int read32(const unsigned char *p)
+	{
+		unsigned int ret;
+		memcpy(&ret, p, 4);
+		return ret;
+	}
+	static UNIGINE_INLINE unsigned long long read64(const unsigned char *p)
+	{
+		unsigned long long ret;
+		memcpy(&ret, p, 8);
+		return ret;
+	}
+	static UNIGINE_INLINE void write64(unsigned char *p, unsigned long long v) { memcpy(p, &v, 8); }
+
+	static UNIGINE_INLINE unsigned int swap32(unsigned int v)
+	{
+		return (v >> 24) | ((v >> 8) & 0xff00) | ((v << 8) & 0xff0000) | (v << 24);
+	}
+	static UNIGINE_INLINE unsigned long long swap64(unsigned long long v)
+	{
+		return (unsigned long long)swap32((unsigned int)v) << 32 | swap32((unsigned int)(v >> 32));
+	}
+	static UNIGINE_INLINE unsigned int rotl32(unsigned int v, int r) { return (v << r) | (v >> (32 - r)); }
+	static UNIGINE_INLINE unsigned long long rotl64(unsigned long long v, int r) { return (v << r) | (v >> (64 - r)); }
+
+	static UNIGINE_INLINE Hash128 mul128(unsigned long long a, unsigned long long b)
+	{
+		Hash128 ret;
+#if defined(_MSC_VER) && UNIGINE_CHECKSUM_ENGINE_X64
+		ret.low = _umul128(a, b, &ret.high);
+#elif defined(__SIZEOF_INT128__)
+		unsigned __int128 product = (unsigned __int128)a * b;
+		ret.low = (unsigned long long)product;
+		ret.high = (unsigned long long)(product >> 64);
+#else
+		unsigned long long lo_lo = (a & 0xffffffff) * (b & 0xffffffff);
+		unsigned long long hi_lo = (a >> 32) * (b & 0xffffffff);
+		unsigned long long lo_hi = (a & 0xffffffff) * (b >> 32);
+		unsigned long long hi_hi = (a >> 32) * (b >> 32);
+		unsigned long long cross = (lo_lo >> 32) + (hi_lo & 0xffffffff) + lo_hi;
+		ret.high = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+		ret.low = (cross << 32) | (lo_lo & 0xffffffff);
+#endif
+		return ret;
+	}
+	static UNIGINE_INLINE unsigned long long mul128_fold64(unsigned long long a, unsigned long long b)
+	{
+		Hash128 p = mul128(a, b);
+		return p.low ^ p.high;
+	}
+
+	static UNIGINE_INLINE unsigned long long xxh64_avalanche(unsigned long long h)
+	{
+		h ^= h >> 33;
+		h *= PRIME64_2;
+		h ^= h >> 29;
+		h *= PRIME64_3;
+		return h ^ (h >> 32);
+	}
+	static UNIGINE_INLINE unsigned long long avalanche(unsigned long long h)
+	{
+		h ^= h >> 37;
+		h *= PRIME_MX1;
+		return h ^ (h >> 32);
+	}
+	static UNIGINE_INLINE unsigned long long rrmxmx(unsigned long long h, unsigned long long size)
+	{
+		h ^= rotl64(h, 49) ^ rotl64(h, 24);
+		h *= PRIME_MX2;
+		h ^= (h >> 35) + size;
+		h *= PRIME_MX2;
+		return h ^ (h >> 28);
+	}
+
+	static void init_secret(unsigned char *s, unsigned long long seed)
+	{
+		const unsigned char *d = get_default_secret();
+		for (int i = 0; i < SECRET_SIZE / 16; i++)
+		{
+			write64(s + i * 16, read64(d + i * 16) + seed);
+			write64(s + i * 16 + 8, read64(d + i * 16 + 8) - seed);
+		}
+	}
+
+	static UNIGINE_INLINE void init_acc(unsigned long long *a)
+	{
+		a[0] = PRIME32_3;
+		a[1] = PRIME64_1;
+		a[2] = PRIME64_2;
+		a[3] = PRIME64_3;
+		a[4] = PRIME64_4;
+		a[5] = PRIME32_2;
+		a[6] = PRIME64_5;
+		a[7] = PRIME32_1;
+	}
+
+	// short inputs
+	static UNIGINE_INLINE unsigned long long mix16(const unsigned char *p, const unsigned char *s, unsigned long long seed)
+	{
+		return mul128_fold64(read64(p) ^ (read64(s) + seed), read64(p + 8) ^ (read64(s + 8) - seed));
+	}
+
+	static unsigned long long len_0to16_64(const unsigned char *p, size_t size, const unsigned char *s, unsigned long long seed)
+	{
+		if (size > 8)
+		{
+			unsigned long long flip1 = (read64(s + 24) ^ read64(s + 32)) + seed;
+			unsigned long long flip2 = (read64(s + 40) ^ read64(s + 48)) - seed;
+			unsigned long long lo = read64(p) ^ flip1;
+			unsigned long long hi = read64(p + size - 8) ^ flip2;
+			return avalanche(size + swap64(lo) + hi + mul128_fold64(lo, hi));
+		}
+		if (size >= 4)
+		{
+			seed ^= (unsigned long long)swap32((unsigned int)seed) << 32;
+			unsigned long long flip = (read64(s + 8) ^ read64(s + 16)) - seed;
+			unsigned long long input = read32(p + size - 4) + ((unsigned long long)read32(p) << 32);
+			return rrmxmx(input ^ flip, size);
+		}
+		if (size > 0)
+		{
+			unsigned int combined = ((unsigned int)p[0] << 16) | ((unsigned int)p[size >> 1] << 24) | p[size - 1] | ((unsigned int)size << 8);
+			unsigned long long flip = (read32(s) ^ read32(s + 4)) + seed;
+			return xxh64_avalanche(combined ^ flip);
+		}
+		return xxh64_avalanche(seed ^ read64(s + 56) ^ read64(s + 64));
+	}
+
+	static unsigned long long len_17to128_64(const unsigned char *p, size_t size, const unsigned char *s, unsigned long long seed)
+	{
+		unsigned long long acc = size * PRIME64_1;
+		if (size > 32)
+		{
+			if (size > 64)
+			{
+				if (size > 96)
+				{
+					acc += mix16(p + 48, s + 96, seed);
+					acc += mix16(p + size - 64, s + 112, seed);
+				}
+				acc += mix16(p + 32, s + 64, seed);
+				acc += mix16(p + size - 48, s + 80, seed);
+			}
+			acc += mix16(p + 16, s + 32, seed);
+			acc += mix16(p + size - 32, s + 48, seed);
+		}
+		acc += mix16(p, s, seed);
+		acc += mix16(p + size - 16, s + 16, seed);
+		return avalanche(acc);
+	}
+
+	static unsigned long long len_129to240_64(const unsigned char *p, size_t size, const unsigned char *s, unsigned long long seed)
+	{
+		unsigned long long acc = size * PRIME64_1;
+		int num = int(size / 16);
+		for (int i = 0; i < 8; i++)
+			acc += mix16(p + 16 * i, s + 16 * i, seed);
+		acc = avalanche(acc);
+		for (int i = 8; i < num; i++)
+			acc += mix16(p + 16 * i, s + 16 * (i - 8) + 3, seed);
+		acc += mix16(p + size - 16, s + SECRET_SIZE_MIN - 17, seed);
+		return avalanche(acc);
+	}
+
+	static UNIGINE_INLINE void mix32(unsigned long long &lo, unsigned long long &hi, const unsigned char *p0, const unsigned char *p1,
+		const unsigned char *s, unsigned long long seed)
+	{
+		lo += mix16(p0, s, seed);
+		lo ^= read64(p1) + read64(p1 + 8);
+		hi += mix16(p1, s + 16, seed);
+		hi ^= read64(p0) + read64(p0 + 8);
+	}
+
+	static Hash128 len_0to16_128(const unsigned char *p, size_t size, const unsigned char *s, unsigned long long seed)
+	{
+		Hash128 ret;
+		if (size > 8)
+		{
+			unsigned long long flip_lo = (read64(s + 32) ^ read64(s + 40)) - seed;
+			unsigned long long flip_hi = (read64(s + 48) ^ read64(s + 56)) + seed;
+			unsigned long long lo = read64(p);
+			unsigned long long hi = read64(p + size - 8);
+			Hash128 m = mul128(lo ^ hi ^ flip_lo, PRIME64_1);
+			m.low += (unsigned long long)(size - 1) << 54;
+			hi ^= flip_hi;
+			m.high += hi + (unsigned long long)(unsigned int)hi * (PRIME32_2 - 1);
+			m.low ^= swap64(m.high);
+			Hash128 h = mul128(m.low, PRIME64_2);
+			h.high += m.high * PRIME64_2;
+			ret.low = avalanche(h.low);
+			ret.high = avalanche(h.high);
+			return ret;
+		}
+		if (size >= 4)
+		{
+			seed ^= (unsigned long long)swap32((unsigned int)seed) << 32;
+			unsigned long long input = read32(p) + ((unsigned long long)read32(p + size - 4) << 32);
+			unsigned long long flip = (read64(s + 16) ^ read64(s + 24)) + seed;
+			Hash128 m = mul128(input ^ flip, PRIME64_1 + (size << 2));
+			m.high += m.low << 1;
+			m.low ^= m.high >> 3;
+			m.low ^= m.low >> 35;
+			m.low *= PRIME_MX2;
+			m.low ^= m.low >> 28;
+			m.high = avalanche(m.high);
+			return m;
+		}
+		if (size > 0)
+		{
+			unsigned int lo = ((unsigned int)p[0] << 16) | ((unsigned int)p[size >> 1] << 24) | p[size - 1] | ((unsigned int)size << 8);
+			unsigned int hi = rotl32(swap32(lo), 13);
+			unsigned long long flip_lo = (read32(s) ^ read32(s + 4)) + seed;
+			unsigned long long flip_hi = (read32(s + 8) ^ read32(s + 12)) - seed;
+			ret.low = xxh64_avalanche(lo ^ flip_lo);
+			ret.high = xxh64_avalanche(hi ^ flip_hi);
+			return ret;
+		}
+		ret.low = xxh64_avalanche(seed ^ read64(s + 64) ^ read64(s + 72));
+		ret.high = xxh64_avalanche(seed ^ read64(s + 80) ^ read64(s + 88));
+		return ret;
+	}
+
+	static UNIGINE_INLINE Hash128 finish_128(unsigned long long lo, unsigned long long hi, size_t size, unsigned long long seed)
+	{
+		Hash128 ret;
+		ret.low = avalanche(lo + hi);
+		ret.high = 0 - avalanche(lo * PRIME64_1 + hi * PRIME64_4 + (size - seed) * PRIME64_2);
+		return ret;
+	}
+
+	static Hash128 len_17to128_128(const unsigned char *p, size_t size, const unsigned char *s, unsigned long long seed)
+	{
+		unsigned long long lo = size * PRIME64_1;
+		unsigned long long hi = 0;
+		if (size > 32)
+		{
+			if (size > 64)
+			{
+				if (size > 96)
+					mix32(lo, hi, p + 48, p + size - 64, s + 96, seed);
+				mix32(lo, hi, p + 32, p + size - 48, s + 64, seed);
+			}
+			mix32(lo, hi, p + 16, p + size - 32, s + 32, seed);
+		}
+		mix32(lo, hi, p, p + size - 16, s, seed);
+		return finish_128(lo, hi, size, seed);
+	}
+
+	static Hash128 len_129to240_128(const unsigned char *p, size_t size, const unsigned char *s, unsigned long long seed)
+	{
+		unsigned long long lo = size * PRIME64_1;
+		unsigned long long hi = 0;
+		int num = int(size / 32);
+		for (int i = 0; i < 4; i++)
+			mix32(lo, hi, p + 32 * i, p + 32 * i + 16, s + 32 * i, seed);
+		lo = avalanche(lo);
+		hi = avalanche(hi);
+		for (int i = 4; i < num; i++)
+			mix32(lo, hi, p + 32 * i, p + 32 * i + 16, s + 3 + 32 * (i - 4), seed);
+		mix32(lo, hi, p + size - 16, p + size - 32, s + SECRET_SIZE_MIN - 17 - 16, 0 - seed);
+		return finish_128(lo, hi, size, seed);
+	}
+
+	// long inputs
+	static UNIGINE_INLINE void accumulate_512_scalar(unsigned long long *a, const unsigned char *p, const unsigned char *s)
+	{
+		for (int i = 0; i < ACC_NB; i++)
+		{
+			unsigned long long value = read64(p + i * 8);
+			unsigned long long key = value ^ read64(s + i * 8);
+			a[i ^ 1] += value;
+			a[i] += (key & 0xffffffff) * (key >> 32);
+		}
+	}
+
+	static void accumulate_scalar(unsigned long long *a, const unsigned char *p, const unsigned char *s, size_t num)
+	{
+		for (size_t i = 0; i < num; i++)
+			accumulate_512_scalar(a, p + i * STRIPE_SIZE, s + i * SECRET_CONSUME_RATE);
+	}
+
+	static void scramble_scalar(unsigned long long *a, const unsigned char *s)
+	{
+		for (int i = 0; i < ACC_NB; i++)
+			a[i] = (a[i] ^ (a[i] >> 47) ^ read64(s + i * 8)) * PRIME32_1;
+	}
+
+#if UNIGINE_CHECKSUM_ENGINE_X64
+	static void accumulate_sse2(unsigned long long *a, const unsigned char *p, const unsigned char *s, size_t num)
+	{
+		__m128i acc[4];
+		for (int j = 0; j < 4; j++)
+			acc[j] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a) + j);
+		for (size_t i = 0; i < num; i++)
+		{
+			const __m128i *data = reinterpret_cast<const __m128i *>(p + i * STRIPE_SIZE);
+			const __m128i *key = reinterpret_cast<const __m128i *>(s + i * SECRET_CONSUME_RATE);
+			for (int j = 0; j < 4; j++)
+			{
+				__m128i value = _mm_loadu_si128(data + j);
+				__m128i data_key = _mm_xor_si128(value, _mm_loadu_si128(key + j));
+				__m128i product = _mm_mul_epu32(data_key, _mm_shuffle_epi32(data_key, _MM_SHUFFLE(0, 3, 0, 1)));
+				__m128i swap = _mm_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2));
+				acc[j] = _mm_add_epi64(acc[j], _mm_add_epi64(product, swap));
+			}
+		}
+		for (int j = 0; j < 4; j++)
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(a) + j, acc[j]);
+	}
+
+	static void scramble_sse2(unsigned long long *a, const unsigned char *s)
+	{
+		const __m128i prime = _mm_set1_epi32(int(PRIME32_1));
+		for (int j = 0; j < 4; j++)
+		{
+			__m128i acc = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a) + j);
+			acc = _mm_xor_si128(acc, _mm_srli_epi64(acc, 47));
+			acc = _mm_xor_si128(acc, _mm_loadu_si128(reinterpret_cast<const __m128i *>(s) + j));
+			__m128i hi = _mm_shuffle_epi32(acc, _MM_SHUFFLE(0, 3, 0, 1));
+			__m128i product_lo = _mm_mul_epu32(acc, prime);
+			__m128i product_hi = _mm_mul_epu32(hi, prime);
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(a) + j, _mm_add_epi64(product_lo, _mm_slli_epi64(product_hi, 32)));
+		}
+	}
+
+	UNIGINE_CHECKSUM_ENGINE_TARGET("avx2")
+	static void accumulate_avx2(unsigned long long *a, const unsigned char *p, const unsigned char *s, size_t num)
+	{
+		__m256i acc0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a));
+		__m256i acc1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a) + 1);
+		for (size_t i = 0; i < num; i++)
+		{
+			const __m256i *data = reinterpret_cast<const __m256i *>(p + i * STRIPE_SIZE);
+			const __m256i *key = reinterpret_cast<const __m256i *>(s + i * SECRET_CONSUME_RATE);
+			__m256i value0 = _mm256_loadu_si256(data);
+			__m256i value1 = _mm256_loadu_si256(data + 1);
+			__m256i data_key0 = _mm256_xor_si256(value0, _mm256_loadu_si256(key));
+			__m256i data_key1 = _mm256_xor_si256(value1, _mm256_loadu_si256(key + 1));
+			__m256i product0 = _mm256_mul_epu32(data_key0, _mm256_srli_epi64(data_key0, 32));
+			__m256i product1 = _mm256_mul_epu32(data_key1, _mm256_srli_epi64(data_key1, 32));
+			acc0 = _mm256_add_epi64(acc0, _mm256_add_epi64(product0, _mm256_shuffle_epi32(value0, _MM_SHUFFLE(1, 0, 3, 2))));
+			acc1 = _mm256_add_epi64(acc1, _mm256_add_epi64(product1, _mm256_shuffle_epi32(value1, _MM_SHUFFLE(1, 0, 3, 2))));
+		}
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(a), acc0);
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(a) + 1, acc1);
+	}
+
+	UNIGINE_CHECKSUM_ENGINE_TARGET("avx2")
+	static void scramble_avx2(unsigned long long *a, const unsigned char *s)
+	{
+		const __m256i prime = _mm256_set1_epi32(int(PRIME32_1));
+		for (int j = 0; j < 2; j++)
+		{
+			__m256i acc = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a) + j);
+			acc = _mm256_xor_si256(acc, _mm256_srli_epi64(acc, 47));
+			acc = _mm256_xor_si256(acc, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s) + j));
+			__m256i product_lo = _mm256_mul_epu32(acc, prime);
+			__m256i product_hi = _mm256_mul_epu32(_mm256_srli_epi64(acc, 32), prime);
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(a) + j, _mm256_add_epi64(product_lo, _mm256_slli_epi64(product_hi, 32)));
+		}
+	}
+#endif
+
+	// num stripes starting from the secret, the accumulators are kept in registers inside
+	static UNIGINE_INLINE void accumulate(unsigned long long *a, const unsigned char *p, const unsigned char *s, size_t num)
+	{
+#if UNIGINE_CHECKSUM_ENGINE_X64
+		const ChecksumEngine::Features &features = ChecksumEngine::get_features();
+		if (features.force_scalar)
+			accumulate_scalar(a, p, s, num);
+		else if (features.avx2)
+			accumulate_avx2(a, p, s, num);
+		else
+			accumulate_sse2(a, p, s, num);
+#else
+		accumulate_scalar(a, p, s, num);
+#endif
+	}
+
+	static UNIGINE_INLINE void scramble(unsigned long long *a, const unsigned char *s)
+	{
+#if UNIGINE_CHECKSUM_ENGINE_X64
+		const ChecksumEngine::Features &features = ChecksumEngine::get_features();
+		if (features.force_scalar)
+			scramble_scalar(a, s);
+		else if (features.avx2)
+			scramble_avx2(a, s);
+		else
+			scramble_sse2(a, s);
+#else
+		scramble_scalar(a, s);
+#endif
+	}
+
+	static void hash_long(unsigned long long *a, const unsigned char *p, size_t size, const unsigned char *s)
+	{
+		init_acc(a);
+		size_t block_size = STRIPE_SIZE * STRIPES_PER_BLOCK;
+		size_t num_blocks = (size - 1) / block_size;
+		for (size_t i = 0; i < num_blocks; i++)
+		{
+			accumulate(a, p + i * block_size, s, STRIPES_PER_BLOCK);
+			scramble(a, s + SECRET_SIZE - STRIPE_SIZE);
+		}
+		size_t num_stripes = ((size - 1) - block_size * num_blocks) / STRIPE_SIZE;
+		accumulate(a, p + num_blocks * block_size, s, num_stripes);
+		accumulate(a, p + size - STRIPE_SIZE, s + SECRET_SIZE - STRIPE_SIZE - SECRET_LASTACC_START, 1);
+	}
+
+	static unsigned long long merge_accs(const unsigned long long *a, const unsigned char *s, unsigned long long start)
+	{
+		unsigned long long ret = start;
+		for (int i = 0; i < 4; i++)
+			ret += mul128_fold64(a[2 * i] ^ read64(s + 16 * i), a[2 * i + 1] ^ read64(s + 16 * i + 8));
+		return avalanche(ret);
+	}
+
+	// incremental state
+	static size_t consume_stripes(unsigned long long *a, size_t num, size_t num_acc, const unsigned char *p, const unsigned char *s)
+	{
+		if (STRIPES_PER_BLOCK - num_acc <= num)
+		{
+			size_t to_end = STRIPES_PER_BLOCK - num_acc;
+			size_t after_end = num - to_end;
+			accumulate(a, p, s + num_acc * SECRET_CONSUME_RATE, to_end);
+			scramble(a, s + SECRET_SIZE - STRIPE_SIZE);
+			accumulate(a, p + to_end * STRIPE_SIZE, s, after_end);
+			return after_end;
+		}
+		accumulate(a, p, s + num_acc * SECRET_CONSUME_RATE, num);
+		return num_acc + num;
+	}
+
+	void digest_long(unsigned long long *a) const
+	{
+		memcpy(a, acc, sizeof(acc));
+		const unsigned char *last_secret = secret + SECRET_SIZE - STRIPE_SIZE - SECRET_LASTACC_START;
+		if (buffered_size >= STRIPE_SIZE)
+		{
+			size_t num = (buffered_size - 1) / STRIPE_SIZE;
+			consume_stripes(a, num, nb_stripes_acc, buffer, secret);
+			accumulate(a, buffer + buffered_size - STRIPE_SIZE, last_secret, 1);
+		} else
+		{
+			// the last stripe is completed with the previous input
+			unsigned char last[STRIPE_SIZE];
+			size_t catchup = STRIPE_SIZE - buffered_size;
+			memcpy(last, buffer + BUFFER_SIZE - catchup, catchup);
+			memcpy(last + catchup, buffer, buffered_size);
+			accumulate(a, last, last_secret, 1);
+		}
+	}
+
+	alignas(32) unsigned long long acc[ACC_NB];
+	alignas(32) unsigned char secret[SECRET_SIZE];
+	alignas(32) unsigned char buffer[BUFFER_SIZE];
+	size_t buffered_size;
+	size_t nb_stripes_acc;
+	unsigned long long total_size;
+	unsigned long long seed;
+};
+
+inline Hash128 ChecksumEngine::treeHash128(const void *data, size_t size, size_t leaf_size)
+{
+	if (leaf_size < 1024)
+		leaf_size = 1024;
+	int num = int((size + leaf_size - 1) / leaf_size);
+	if (num <= 1)
+		return XXH3::hash128(data, size, size);
+
+	const unsigned char *src = static_cast<const unsigned char *>(data);
+	Vector<Hash128> leaves;
+	leaves.resize(num);
+	parallelFor(num, [&](int i)
+	{
+		size_t offset = leaf_size * i;
+		leaves[i] = XXH3::hash128(src + offset, i == num - 1 ? size - offset : leaf_size);
+	});
+
+	// the total size is the seed of the root
+	XXH3 root(size);
+	for (int i = 0; i < num; i++)
+	{
+		unsigned char digest[16];
+		XXH3::write64(digest, leaves[i].low);
+		XXH3::write64(digest + 8, leaves[i].high);
+		root.update(digest, sizeof(digest));
+	}
+	return root.final128();
+}
+
+inline void ChecksumEngine::getBenchmarkReport(String &ret, size_t size)
+{
+	Vector<unsigned char> data;
+	data.resize(int(size));
+	unsigned long long state = 0x9E3779B97F4A7C15ULL;
+	for (size_t i = 0; i < size; i++)
+	{
+		state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+		data[int(i)] = (unsigned char)(state >> 56);
+	}
+
+	volatile unsigned long long sink = 0;
+	auto run = [&](const char *name, const Function<unsigned long long()> &func)
+	{
+		// the best of several runs, the first one warms the caches up
+		double best = 1e30;
+		for (int i = 0; i < 4; i++)
+		{
+			auto begin = std::chrono::steady_clock::now();
+			sink = sink + func();
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+			if (seconds < best)
+				best = seconds;
+		}
+		Format::append(ret, "{:<28}{:8.2} GB/s\n", name, double(size) / best / 1e9);
+	};
+
+	const void *p = data.get();
+	int int_size = size > 0x7fffffff ? 0x7fffffff : int(size);
+	Features &features = get_features();
+
+	ret.clear();
+	Format::append(ret, "{} MB, sse4.2 {} pclmul {} avx2 {}\n", (unsigned long long)(size >> 20), int(features.crc32), int(features.clmul), int(features.avx2));
+	run("Checksum::CRC32", [=]() { return (unsigned long long)(unsigned int)Checksum::CRC32(p, int_size); });
+	run("Checksum::MD5", [=]() { unsigned int v[4]; Checksum::MD5(v, p, int_size); return (unsigned long long)v[0]; });
+	run("Checksum::SHA1", [=]() { unsigned int v[5]; Checksum::SHA1(v, p, int_size); return (unsigned long long)v[0]; });
+	features.force_scalar = true;
+	run("CRC32C scalar", [=]() { return (unsigned long long)CRC32C::hash(p, size); });
+	run("XXH3-64 scalar", [=]() { return XXH3::hash64(p, size); });
+	features.force_scalar = false;
+	run("CRC32C", [=]() { return (unsigned long long)CRC32C::hash(p, size); });
+	run("CRC32C parallel", [=]() { return (unsigned long long)CRC32C::hashParallel(p, size); });
+	run("XXH3-64", [=]() { return XXH3::hash64(p, size); });
+	run("XXH3-128", [=]() { return XXH3::hash128(p, size).low; });
+	run("XXH3-128 tree, parallel", [=]() { return treeHash128(p, size).low; });
+}
+
+} // namespace Unigine
@@ -0,0 +1,1159 @@
+/* Copyright (C) 2005-2020, UNIGINE. All rights reserved.
+ *
+ * This file is a part of the UNIGINE 2 SDK.
+ *
+ * Your use and / or redistribution of this software in source and / or
+ * binary form, with or without modification, is subject to: (i) your
+ * ongoing acceptance of and compliance with the terms and conditions of
+ * the UNIGINE License Agreement; and (ii) your inclusion of this notice
+ * in any version of this software that you use or redistribute.
+ * A copy of the UNIGINE License Agreement is available by contacting
+ * UNIGINE. at http://unigine.com/
+ */
+
+
+#pragma once
+
+#include "UnigineXmlStream.h"
+#include "UnigineUlon.h"
+#include "UnigineMappedFile.h"
+#include "UnigineChecksumEngine.h"
+#include "UnigineEngine.h"
+#include "UnigineDir.h"
+#include "UnigineVector.h"
+#include "UnigineString.h"
+#include "UnigineFormat.h"
+#include "UnigineConsole.h"
+#include "UnigineCallback.h"
+#include "UnigineLog.h"
+#include <chrono>
+#include <limits>
+#include <cmath>
+#include <stdlib.h>
+#include <string.h>
+
+// Compiled tree example
+/*
+	// the first run parses the text and writes the cache, the next runs map the cache
+	CompiledTree tree;
+	if (!tree.load("materials/tank.basemat"))
+		return 0;
+
+	CompiledNode root = tree.getRoot();
+	for (int i = 0; i < root.getNumChildren(); i++)
+	{
+		CompiledNode child = root.getChild(i);
+		if (!strcmp(child.getType(), "Slider"))
+			Log::message("%s %f [%f %f]\n", child.getName(), child.getFloatData(), child.getFloatArg("min"), child.getFloatArg("max"));
+	}
+
+	// Xml files are compiled the same way, elements become nodes with their name
+	tree.load("data/Models/Tank.node");
+	float transform[16];
+	tree.getRoot().find("node/transform").getFloatArrayData(transform, 16);
+*/
+
+namespace Unigine
+{
+
+class CompiledTree;
+
+//////////////////////////////////////////////////////////////////////////
+/// Node of a CompiledTree.
+///
+/// A lightweight handle into the compiled data, it is valid while the tree
+/// is loaded. Strings are null-terminated and point into the data, numbers
+/// are parsed at compile time so typed accessors do not parse text.
+//////////////////////////////////////////////////////////////////////////
+
+class CompiledNode
+{
+public:
+	CompiledNode() = default;
+
+	UNIGINE_INLINE bool isValid() const { return tree != nullptr; }
+
+	// Ulon node type, empty for Xml
+	const char *getType() const;
+	// Ulon node name or Xml element name
+	const char *getName() const;
+	// Ulon condition, empty for Xml
+	const char *getCondition() const;
+
+	CompiledNode getParent() const;
+	int getNumChildren() const;
+	CompiledNode getChild(int num) const;
+	int findChild(const char *name) const;
+	CompiledNode getChild(const char *name) const;
+	// first match of a "child/child/child" path
+	CompiledNode find(const char *path) const;
+
+	int getNumArgs() const;
+	const char *getArgName(int num) const;
+	const char *getArgValue(int num) const;
+	int findArg(const char *name) const;
+	UNIGINE_INLINE bool isArg(const char *name) const { return findArg(name) != -1; }
+	const char *getArg(const char *name, const char *value = "") const;
+
+	// typed args, the default is returned for missing and non-numeric ones
+	bool getBoolArg(const char *name, bool value = false) const;
+	int getIntArg(const char *name, int value = 0) const;
+	long long getLongArg(const char *name, long long value = 0) const;
+	float getFloatArg(const char *name, float value = 0.0f) const;
+	double getDoubleArg(const char *name, double value = 0.0) const;
+	// false if there are less than dest_size numbers
+	bool getIntArrayArg(const char *name, int *dest, int dest_size) const;
+	bool getFloatArrayArg(const char *name, float *dest, int dest_size) const;
+	bool getDoubleArrayArg(const char *name, double *dest, int dest_size) const;
+
+	// Ulon node value or Xml element text, Ulon arrays are joined with spaces
+	bool isData() const;
+	const char *getData() const;
+	bool getBoolData(bool value = false) const;
+	int getIntData(int value = 0) const;
+	long long getLongData(long long value = 0) const;
+	float getFloatData(float value = 0.0f) const;
+	double getDoubleData(double value = 0.0) const;
+	bool getIntArrayData(int *dest, int dest_size) const;
+	bool getFloatArrayData(float *dest, int dest_size) const;
+	bool getDoubleArrayData(double *dest, int dest_size) const;
+
+private:
+	friend class CompiledTree;
+
+	CompiledNode(const CompiledTree *tree, unsigned int index)
+		: tree(tree)
+		, index(index)
+	{}
+
+	// value index of the arg or CompiledTree::NONE
+	unsigned int get_arg_value(const char *name) const;
+	const char *get_string(unsigned int value) const;
+	long long get_long(unsigned int value, long long def) const;
+	template <class Type>
+	bool get_number(unsigned int value, Type &ret) const;
+	template <class Type>
+	bool get_array(unsigned int value, Type *dest, int dest_size) const;
+	// the conversion of an out of range double is undefined, such values keep the defaults
+	template <class Type>
+	static bool is_representable(double number);
+
+	const CompiledTree *tree{nullptr};
+	unsigned int index{0};
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// Binary compiled form of Ulon and Xml files.
+///
+/// The layout is read in place from a mapped file: nodes are stored in
+/// breadth-first order so the children of a node are consecutive, strings
+/// are interned and referenced by index, values keep their text and the
+/// numbers parsed from it. load() keys the compiled files in the cache
+/// directory by the XXH3 hash of the source, so a changed source is compiled
+/// again and an unchanged one is never parsed. All integers are
+/// little-endian.
+///
+///   header   "UCTR", u16 version, u16 format, u32 file size, u32 0, u64 source hash,
+///            u32 number and u32 offset of strings, nodes, args, values, numbers and chars
+///   string   u32 offset in chars, u32 length, u32 FNV-1a hash
+///   node     u32 type, name, condition strings, u32 value or ~0, u32 first arg, u32 number of args,
+///            u32 first child, u32 number of children, u32 parent or ~0
+///   arg      u32 name string, u32 value
+///   value    u32 string, u32 first number, u32 number of numbers
+///   numbers  f64 values, 8-byte aligned
+///   chars    null-terminated strings, string 0 is empty
+//////////////////////////////////////////////////////////////////////////
+
+class CompiledTree
+{
+public:
+	enum FORMAT
+	{
+		FORMAT_AUTO = 0,	// Xml when the first character is '<'
+		FORMAT_XML,
+		FORMAT_ULON,
+	};
+
+	enum
+	{
+		VERSION = 1,
+		HEADER_SIZE = 72,
+		NONE = 0xffffffffu,
+	};
+
+	CompiledTree() = default;
+	~CompiledTree() { clear(); }
+
+	CompiledTree(const CompiledTree &) = delete;
+	CompiledTree &operator=(const CompiledTree &) = delete;
+
+	// compiled data of the source from the cache, the source is compiled and
+	// the cache is written when there is no valid entry for its content
+	bool load(const char *path, FORMAT source_format = FORMAT_AUTO)
+	{
+		clear();
+		MappedFile source;
+		if (!source.open(path))
+			return false;
+		size_t source_size = source.getSize();
+		const char *source_data = source_size ? static_cast<const char *>(source.view(0, source_size)) : "";
+		if (source_data == nullptr)
+			return false;
+		source_format = get_format(source_data, source_size, source_format);
+		unsigned long long hash = get_source_hash(source_data, source_size, source_format);
+
+		String cache_path = getCachePath(hash);
+		if (Dir::isFile(cache_path.get()) && open(cache_path.get()) && source_hash == hash)
+		{
+			cache_hit = true;
+			return true;
+		}
+		clear();
+
+		if (!compile_source(path, source_data, source_size, source_format))
+			return false;
+		source_hash = hash;
+		set_header_hash(hash);
+		const char *directory = getCacheDirectory();
+		if (directory[0] && !Dir::isDir(directory))
+			Dir::mkdir(directory, true);
+		save(cache_path.get());
+		return true;
+	}
+
+	// compiles the source without the cache
+	bool compile(const char *path, FORMAT source_format = FORMAT_AUTO)
+	{
+		clear();
+		MappedFile source;
+		if (!source.open(path))
+			return false;
+		size_t source_size = source.getSize();
+		const char *source_data = source_size ? static_cast<const char *>(source.view(0, source_size)) : "";
+		if (source_data == nullptr)
+			return false;
+		source_format = get_format(source_data, source_size, source_format);
+		if (!compile_source(path, source_data, source_size, source_format))
+			return false;
+		source_hash = get_source_hash(source_data, source_size, source_format);
+		set_header_hash(source_hash);
+		return true;
+	}
+
+	// compiles an Xml tree or a Ulon node
+	bool compile(const XmlNode *root)
+	{
+		clear();
+		if (root == nullptr)
+			return false;
+		Builder builder;
+		builder.build(root);
+		return finish(builder, FORMAT_XML);
+	}
+
+	bool compile(const UlonNodePtr &root)
+	{
+		clear();
+		if (!root)
+			return false;
+		Builder builder;
+		builder.build(root);
+		return finish(builder, FORMAT_ULON);
+	}
+
+	// maps a compiled file
+	bool open(const char *path)
+	{
+		clear();
+		if (!file.open(path))
+			return false;
+		const unsigned char *file_data = file.getSize() ? static_cast<const unsigned char *>(file.view(0, file.getSize())) : nullptr;
+		if (file_data == nullptr || !set_data(file_data, file.getSize()))
+		{
+			Log::error("CompiledTree::open(): \"%s\" is not a compiled tree of version %d\n", path, int(VERSION));
+			clear();
+			return false;
+		}
+		return true;
+	}
+
+	// writes the compiled data, the file is replaced only when it is complete
+	bool save(const char *path) const
+	{
+		if (data == nullptr)
+			return false;
+		String temp_path = String::format("%s.tmp", path);
+		{
+			FilePtr f = File::create(temp_path.get(), "wb");
+			if (!f || !f->isOpened() || f->write(data, size) != size)
+			{
+				Log::error("CompiledTree::save(): can't write \"%s\" file\n", temp_path.get());
+				if (f)
+					f->close();
+				Dir::remove(temp_path.get());
+				return false;
+			}
+			f->close();
+		}
+		if (Dir::isFile(path))
+			Dir::remove(path);
+		if (!Dir::rename(temp_path.get(), path))
+		{
+			Log::error("CompiledTree::save(): can't rename \"%s\" file\n", temp_path.get());
+			Dir::remove(temp_path.get());
+			return false;
+		}
+		return true;
+	}
+
+	void clear()
+	{
+		file.close();
+		buffer.destroy();
+		data = nullptr;
+		size = 0;
+		source_hash = 0;
+		format = FORMAT_AUTO;
+		cache_hit = false;
+		strings = nullptr;
+		nodes = nullptr;
+		args = nullptr;
+		values = nullptr;
+		numbers = nullptr;
+		chars = nullptr;
+		num_strings = num_nodes = num_args = num_values = num_numbers = 0;
+		num_chars = 0;
+	}
+
+	UNIGINE_INLINE bool isLoaded() const { return data != nullptr; }
+	// the last load() mapped a cached file
+	UNIGINE_INLINE bool isCacheHit() const { return cache_hit; }
+	UNIGINE_INLINE int getFormat() const { return format; }
+	UNIGINE_INLINE unsigned long long getSourceHash() const { return source_hash; }
+	UNIGINE_INLINE const unsigned char *getData() const { return data; }
+	UNIGINE_INLINE size_t getSize() const { return size; }
+
+	UNIGINE_INLINE int getNumNodes() const { return int(num_nodes); }
+	UNIGINE_INLINE int getNumStrings() const { return int(num_strings); }
+	CompiledNode getRoot() const { return num_nodes ? CompiledNode(this, 0) : CompiledNode(); }
+
+	// the engine cache path by default
+	static void setCacheDirectory(const char *path) { get_cache_directory() = path; }
+	static const char *getCacheDirectory()
+	{
+		String &directory = get_cache_directory();
+		if (directory.empty() && Engine::isInitialized())
+			directory = String::format("%scompiled_trees/", Engine::get()->getCachePath());
+		return directory.get();
+	}
+	static String getCachePath(unsigned long long source_hash)
+	{
+		return String::format("%s%016llx.uctr", getCacheDirectory(), source_hash);
+	}
+
+	// FNV-1a of the strings
+	static UNIGINE_INLINE unsigned int getStringHash(const char *str, size_t length)
+	{
+		unsigned int hash = 2166136261u;
+		for (size_t i = 0; i < length; i++)
+			hash = (hash ^ (unsigned char)str[i]) * 16777619u;
+		return hash;
+	}
+
+	// compiled_tree_benchmark [file]
+	static void getBenchmarkReport(String &ret, const char *path = nullptr);
+
+	static void addConsoleCommands()
+	{
+		Console::addCommand("compiled_tree_benchmark", "prints the load times of text and compiled Xml and Ulon files", MakeCallback(&CompiledTree::console_benchmark));
+	}
+	static void removeConsoleCommands() { Console::removeCommand("compiled_tree_benchmark"); }
+
+private:
+	friend class CompiledNode;
+
+	struct StringEntry
+	{
+		unsigned int offset;
+		unsigned int length;
+		unsigned int hash;
+	};
+
+	struct Node
+	{
+		unsigned int type;
+		unsigned int name;
+		unsigned int condition;
+		unsigned int value;
+		unsigned int first_arg;
+		unsigned int num_args;
+		unsigned int first_child;
+		unsigned int num_children;
+		unsigned int parent;
+	};
+
+	struct Arg
+	{
+		unsigned int name;
+		unsigned int value;
+	};
+
+	struct Value
+	{
+		unsigned int string;
+		unsigned int first_number;
+		unsigned int num_numbers;
+	};
+
+	//////////////////////////////////////////////////////////////////////////
+	// compiler
+	//////////////////////////////////////////////////////////////////////////
+
+	class Builder
+	{
+	public:
+		Builder()
+		{
+			chars.append('\0');
+			StringEntry &empty = strings.append();
+			empty.offset = 0;
+			empty.length = 0;
+			empty.hash = getStringHash("", 0);
+		}
+
+		// nodes are visited breadth-first, so the children of a node are appended together
+		template <class Item>
+		void build(const Item &root)
+		{
+			Vector<Item> queue;
+			queue.append(root);
+			nodes.append().parent = NONE;
+			for (int i = 0; i < queue.size(); i++)
+			{
+				Item item = queue[i];
+				fill(i, item);
+				unsigned int first_child = (unsigned int)queue.size();
+				append_children(item, queue);
+				unsigned int num_children = (unsigned int)queue.size() - first_child;
+				for (unsigned int j = 0; j < num_children; j++)
+					nodes.append().parent = (unsigned int)i;
+				nodes[i].first_child = first_child;
+				nodes[i].num_children = num_children;
+			}
+		}
+
+		unsigned int add_string(const char *str, int length)
+		{
+			unsigned int hash = getStringHash(str, size_t(length));
+			if (strings.size() * 2 >= slots.size())
+				rehash();
+			unsigned int mask = (unsigned int)slots.size() - 1;
+			for (unsigned int i = hash & mask;; i = (i + 1) & mask)
+			{
+				unsigned int slot = slots[int(i)];
+				if (slot == 0)
+				{
+					unsigned int index = (unsigned int)strings.size();
+					StringEntry &entry = strings.append();
+					entry.offset = (unsigned int)chars.size();
+					entry.length = (unsigned int)length;
+					entry.hash = hash;
+					chars.append(str, length);
+					chars.append('\0');
+					slots[int(i)] = index + 1;
+					return index;
+				}
+				const StringEntry &entry = strings[int(slot - 1)];
+				if (entry.hash == hash && entry.length == (unsigned int)length && !memcmp(chars.get() + entry.offset, str, size_t(length)))
+					return slot - 1;
+			}
+		}
+
+		// numbers of the whitespace or comma separated tokens when all of them are numbers
+		unsigned int add_value(const char *str, int length)
+		{
+			unsigned int index = (unsigned int)values.size();
+			Value &value = values.append();
+			value.string = add_string(str, length);
+			value.first_number = (unsigned int)numbers.size();
+			value.num_numbers = 0;
+
+			const char *s = chars.get() + strings[value.string].offset;
+			const char *end = s + length;
+			for (;;)
+			{
+				while (s < end && (*s == ' ' || *s == '\t' || *s == '\n' || *s == '\r' || *s == ','))
+					s++;
+				if (s >= end)
+					break;
+				char *next = nullptr;
+				double number;
+				if (!strncmp(s, "true", 4) && is_token_end(s + 4, end))
+				{
+					number = 1.0;
+					next = const_cast<char *>(s + 4);
+				} else if (!strncmp(s, "false", 5) && is_token_end(s + 5, end))
+				{
+					number = 0.0;
+					next = const_cast<char *>(s + 5);
+				} else
+				{
+					next = const_cast<char *>(parse_number(s, number));
+					if (next == s || !is_token_end(next, end))
+					{
+						numbers.resize(int(value.first_number));
+						value.num_numbers = 0;
+						break;
+					}
+				}
+				numbers.append(number);
+				value.num_numbers++;
+				s = next;
+			}
+			return index;
+		}
+
+		Vector<char> chars;
+		Vector<StringEntry> strings;
+		Vector<Node> nodes;
+		Vector<Arg> args;
+		Vector<Value> values;
+		Vector<double> numbers;
+
+	private:
+		// short decimals are converted with one multiplication by an exact
+		// power of ten, the rest goes through strtod()
+		static const char *parse_number(const char *s, double &ret)
+		{
+			static const double powers[] = {
+				1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+				1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+			};
+
+			const char *p = s;
+			bool negative = *p == '-';
+			if (*p == '-' || *p == '+')
+				p++;
+			unsigned long long mantissa = 0;
+			int digits = 0;
+			int exponent = 0;
+			for (; *p >= '0' && *p <= '9'; p++, digits++)
+				mantissa = mantissa * 10 + unsigned(*p - '0');
+			if (*p == '.')
+			{
+				for (p++; *p >= '0' && *p <= '9'; p++, digits++, exponent--)
+					mantissa = mantissa * 10 + unsigned(*p - '0');
+			}
+			if (digits == 0 || digits > 15 || *p == 'e' || *p == 'E' || exponent < -22)
+			{
+				char *end = nullptr;
+				ret = strtod(s, &end);
+				return end;
+			}
+			ret = double(mantissa);
+			if (exponent)
+				ret /= powers[-exponent];
+			if (negative)
+				ret = -ret;
+			return p;
+		}
+
+		static UNIGINE_INLINE bool is_token_end(const char *s, const char *end)
+		{
+			return s >= end || *s == ' ' || *s == '\t' || *s == '\n' || *s == '\r' || *s == ',';
+		}
+
+		void fill(int index, const XmlNode *item)
+		{
+			Node &node = nodes[index];
+			node.type = 0;
+			node.name = add_string(item->getName().get(), item->getName().size());
+			node.condition = 0;
+			node.value = item->getData().empty() ? NONE : add_value(item->getData().get(), item->getData().size());
+			node.first_arg = (unsigned int)args.size();
+			node.num_args = (unsigned int)item->getNumArgs();
+			for (int i = 0; i < item->getNumArgs(); i++)
+			{
+				unsigned int name = add_string(item->getArgName(i).get(), item->getArgName(i).size());
+				unsigned int value = add_value(item->getArgValue(i).get(), item->getArgValue(i).size());
+				Arg &arg = args.append();
+				arg.name = name;
+				arg.value = value;
+			}
+		}
+
+		void append_children(const XmlNode *item, Vector<const XmlNode *> &queue)
+		{
+			for (int i = 0; i < item->getNumChildren(); i++)
+				queue.append(item->getChild(i));
+		}
+
+		unsigned int add_value(const UlonValuePtr &value)
+		{
+			if (!value->isArray())
+			{
+				const char *str = value->getStr();
+				return add_value(str, int(strlen(str)));
+			}
+			Vector<String> elements = value->getArray();
+			joined.clear();
+			for (int i = 0; i < elements.size(); i++)
+			{
+				if (i)
+					joined.append(' ');
+				joined.append(elements[i]);
+			}
+			return add_value(joined.get(), joined.size());
+		}
+
+		void fill(int index, const UlonNodePtr &item)
+		{
+			unsigned int type = add_string(item->getType(), int(strlen(item->getType())));
+			unsigned int name = add_string(item->getName(), int(strlen(item->getName())));
+			unsigned int condition = add_string(item->getCondition(), int(strlen(item->getCondition())));
+			UlonValuePtr item_value = item->getValue();
+			unsigned int value = item_value ? add_value(item_value) : NONE;
+			unsigned int first_arg = (unsigned int)args.size();
+			Vector<UlonArgPtr> item_args = item->getArgs();
+			for (int i = 0; i < item_args.size(); i++)
+			{
+				String arg_name = item_args[i]->getName();
+				UlonValuePtr arg_value = item_args[i]->getValue();
+				Arg arg;
+				arg.name = add_string(arg_name.get(), arg_name.size());
+				arg.value = arg_value ? add_value(arg_value) : add_value("", 0);
+				args.append(arg);
+			}
+			Node &node = nodes[index];
+			node.type = type;
+			node.name = name;
+			node.condition = condition;
+			node.value = value;
+			node.first_arg = first_arg;
+			node.num_args = (unsigned int)item_args.size();
+		}
+
+		void append_children(const UlonNodePtr &item, Vector<UlonNodePtr> &queue)
+		{
+			Vector<UlonNodePtr> children = item->getChildren();
+			for (int i = 0; i < children.size(); i++)
+				queue.append(children[i]);
+		}
+
+		// open addressing table of string indices plus one
+		void rehash()
+		{
+			int num_slots = slots.size() ? slots.size() * 2 : 1024;
+			slots.clear();
+			slots.resize(num_slots);
+			memset(slots.get(), 0, sizeof(unsigned int) * size_t(num_slots));
+			unsigned int mask = (unsigned int)num_slots - 1;
+			for (int i = 0; i < strings.size(); i++)
+			{
+				unsigned int j = strings[i].hash & mask;
+				while (slots[int(j)])
+					j = (j + 1) & mask;
+				slots[int(j)] = (unsigned int)i + 1;
+			}
+		}
+
+		Vector<unsigned int> slots;
+		String joined;
+	};
+
+	bool compile_source(const char *path, const char *source_data, size_t source_size, FORMAT source_format)
+	{
+		Builder builder;
+		if (source_format == FORMAT_XML)
+		{
+			XmlDocument document;
+			if (!document.parse(source_data, source_size))
+			{
+				Log::error("CompiledTree::compile(): can't parse \"%s\" file: %s at line %d\n", path, document.getError(), document.getErrorLine());
+				return false;
+			}
+			builder.build(document.getRoot());
+		} else
+		{
+			UlonNodePtr root = UlonNode::create();
+			if (!root->load(path))
+			{
+				Log::error("CompiledTree::compile(): can't parse \"%s\" file\n", path);
+				return false;
+			}
+			builder.build(root);
+		}
+		return finish(builder, source_format);
+	}
+
+	static FORMAT get_format(const char *source_data, size_t source_size, FORMAT source_format)
+	{
+		if (source_format != FORMAT_AUTO)
+			return source_format;
+		size_t i = 0;
+		if (source_size >= 3 && !memcmp(source_data, "\xef\xbb\xbf", 3))
+			i = 3;
+		while (i < source_size && (source_data[i] == ' ' || source_data[i] == '\t' || source_data[i] == '\n' || source_data[i] == '\r'))
+			i++;
+		return i < source_size && source_data[i] == '<' ? FORMAT_XML : FORMAT_ULON;
+	}
+
+	static FORMAT get_format_of(const char *path)
+	{
+		MappedFile source;
+		if (!source.open(path))
+			return FORMAT_AUTO;
+		size_t source_size = source.getSize() < 4096 ? source.getSize() : 4096;
+		const char *source_data = source_size ? static_cast<const char *>(source.view(0, source_size)) : "";
+		return source_data ? get_format(source_data, source_size, FORMAT_AUTO) : FORMAT_AUTO;
+	}
+
+	// the version and the format are a part of the key, so new versions do not read old entries
+	static unsigned long long get_source_hash(const char *source_data, size_t source_size, FORMAT source_format)
+	{
+		return XXH3::hash64(source_data, source_size, ((unsigned long long)VERSION << 8) | (unsigned long long)source_format);
+	}
+
+	static UNIGINE_INLINE void set_u32(unsigned char *d, unsigned int v) { memcpy(d, &v, 4); }
+	static UNIGINE_INLINE unsigned int get_u32(const unsigned char *s)
+	{
+		unsigned int v;
+		memcpy(&v, s, 4);
+		return v;
+	}
+
+	static UNIGINE_INLINE size_t align(size_t offset) { return (offset + 7) & ~size_t(7); }
+
+	bool finish(Builder &builder, FORMAT source_format)
+	{
+		size_t offsets[6];
+		size_t offset = HEADER_SIZE;
+		offsets[0] = offset;
+		offset = align(offset + sizeof(StringEntry) * size_t(builder.strings.size()));
+		offsets[1] = offset;
+		offset = align(offset + sizeof(Node) * size_t(builder.nodes.size()));
+		offsets[2] = offset;
+		offset = align(offset + sizeof(Arg) * size_t(builder.args.size()));
+		offsets[3] = offset;
+		offset = align(offset + sizeof(Value) * size_t(builder.values.size()));
+		offsets[4] = offset;
+		offset = align(offset + sizeof(double) * size_t(builder.numbers.size()));
+		offsets[5] = offset;
+		offset += size_t(builder.chars.size());
+		if (offset > 0xffffffffu)
+		{
+			Log::error("CompiledTree::compile(): the compiled tree is larger than 4 GB\n");
+			return false;
+		}
+
+		buffer.clear();
+		buffer.resize(int(offset));
+		memset(buffer.get(), 0, buffer.size());
+		unsigned char *d = buffer.get();
+		memcpy(d, "UCTR", 4);
+		d[4] = (unsigned char)VERSION;
+		d[5] = 0;
+		d[6] = (unsigned char)source_format;
+		d[7] = 0;
+		set_u32(d + 8, (unsigned int)offset);
+		unsigned int counts[6] = {
+			(unsigned int)builder.strings.size(),
+			(unsigned int)builder.nodes.size(),
+			(unsigned int)builder.args.size(),
+			(unsigned int)builder.values.size(),
+			(unsigned int)builder.numbers.size(),
+			(unsigned int)builder.chars.size(),
+		};
+		for (int i = 0; i < 6; i++)
+		{
+			set_u32(d + 24 + i * 8, counts[i]);
+			set_u32(d + 28 + i * 8, (unsigned int)offsets[i]);
+		}
+		memcpy(d + offsets[0], builder.strings.get(), sizeof(StringEntry) * counts[0]);
+		memcpy(d + offsets[1], builder.nodes.get(), sizeof(Node) * counts[1]);
+		memcpy(d + offsets[2], builder.args.get(), sizeof(Arg) * counts[2]);
+		memcpy(d + offsets[3], builder.values.get(), sizeof(Value) * counts[3]);
+		memcpy(d + offsets[4], builder.numbers.get(), sizeof(double) * counts[4]);
+		memcpy(d + offsets[5], builder.chars.get(), counts[5]);
+		return set_data(buffer.get(), buffer.size());
+	}
+
+	void set_header_hash(unsigned long long hash)
+	{
+		if (buffer.size() >= int(HEADER_SIZE))
+			memcpy(buffer.get() + 16, &hash, 8);
+		source_hash = hash;
+	}
+
+	// the tables are checked once, the accessors do not check the indices
+	bool set_data(const unsigned char *d, size_t s)
+	{
+		if (s < HEADER_SIZE || memcmp(d, "UCTR", 4) || d[4] != VERSION || get_u32(d + 8) != s)
+			return false;
+		const size_t sizes[6] = {sizeof(StringEntry), sizeof(Node), sizeof(Arg), sizeof(Value), sizeof(double), 1};
+		unsigned int counts[6];
+		const unsigned char *tables[6];
+		for (int i = 0; i < 6; i++)
+		{
+			counts[i] = get_u32(d + 24 + i * 8);
+			size_t offset = get_u32(d + 28 + i * 8);
+			if (offset < HEADER_SIZE || (i < 5 && (offset & 7)) || offset > s || counts[i] > (s - offset) / sizes[i])
+				return false;
+			tables[i] = d + offset;
+		}
+
+		const StringEntry *s_strings = reinterpret_cast<const StringEntry *>(tables[0]);
+		const Node *s_nodes = reinterpret_cast<const Node *>(tables[1]);
+		const Arg *s_args = reinterpret_cast<const Arg *>(tables[2]);
+		const Value *s_values = reinterpret_cast<const Value *>(tables[3]);
+		const char *s_chars = reinterpret_cast<const char *>(tables[5]);
+		if (counts[0] == 0 || counts[5] == 0)
+			return false;
+		for (unsigned int i = 0; i < counts[0]; i++)
+		{
+			const StringEntry &str = s_strings[i];
+			if (str.offset >= counts[5] || str.length >= counts[5] - str.offset || s_chars[str.offset + str.length] != '\0')
+				return false;
+		}
+		for (unsigned int i = 0; i < counts[3]; i++)
+		{
+			const Value &value = s_values[i];
+			if (value.string >= counts[0] || value.first_number > counts[4] || value.num_numbers > counts[4] - value.first_number)
+				return false;
+		}
+		for (unsigned int i = 0; i < counts[2]; i++)
+		{
+			if (s_args[i].name >= counts[0] || s_args[i].value >= counts[3])
+				return false;
+		}
+		for (unsigned int i = 0; i < counts[1]; i++)
+		{
+			const Node &node = s_nodes[i];
+			if (node.type >= counts[0] || node.name >= counts[0] || node.condition >= counts[0] ||
+				(node.value != NONE && node.value >= counts[3]) ||
+				node.first_arg > counts[2] || node.num_args > counts[2] - node.first_arg ||
+				node.first_child > counts[1] || node.num_children > counts[1] - node.first_child ||
+				(node.parent != NONE && node.parent >= i) || (i != 0 && node.parent == NONE))
+				return false;
+		}
+
+		data = d;
+		size = s;
+		format = d[6];
+		memcpy(&source_hash, d + 16, 8);
+		strings = s_strings;
+		nodes = s_nodes;
+		args = s_args;
+		values = s_values;
+		numbers = reinterpret_cast<const double *>(tables[4]);
+		chars = s_chars;
+		num_strings = counts[0];
+		num_nodes = counts[1];
+		num_args = counts[2];
+		num_values = counts[3];
+		num_numbers = counts[4];
+		num_chars = counts[5];
+		return true;
+	}
+
+	UNIGINE_INLINE const char *get_string(unsigned int index) const { return chars + strings[index].offset; }
+
+	static String &get_cache_directory()
+	{
+		static String directory;
+		return directory;
+	}
+
+	static void console_benchmark(int argc, char **argv)
+	{
+		String report;
+		getBenchmarkReport(report, argc > 1 ? argv[1] : nullptr);
+		Log::message("%s", report.get());
+	}
+
+	MappedFile file;
+	Vector<unsigned char> buffer;
+	const unsigned char *data{nullptr};
+	size_t size{0};
+	unsigned long long source_hash{0};
+	int format{FORMAT_AUTO};
+	bool cache_hit{false};
+
+	const StringEntry *strings{nullptr};
+	const Node *nodes{nullptr};
+	const Arg *args{nullptr};
+	const Value *values{nullptr};
+	const double *numbers{nullptr};
+	const char *chars{nullptr};
+	unsigned int num_strings{0};
+	unsigned int num_nodes{0};
+	unsigned int num_args{0};
+	unsigned int num_values{0};
+	unsigned int num_numbers{0};
+	unsigned int num_chars{0};
+};
+
+//////////////////////////////////////////////////////////////////////////
+// CompiledNode
+//////////////////////////////////////////////////////////////////////////
+
+inline const char *CompiledNode::getType() const { return tree->get_string(tree->nodes[index].type); }
+inline const char *CompiledNode::getName() const { return tree->get_string(tree->nodes[index].name); }
+inline const char *CompiledNode::getCondition() const { return tree->get_string(tree->nodes[index].condition); }
+
+inline CompiledNode CompiledNode::getParent() const
+{
+	unsigned int parent = tree->nodes[index].parent;
+	return parent != CompiledTree::NONE ? CompiledNode(tree, parent) : CompiledNode();
+}
+
+inline int CompiledNode::getNumChildren() const { return int(tree->nodes[index].num_children); }
+inline CompiledNode CompiledNode::getChild(int num) const { return CompiledNode(tree, tree->nodes[index].first_child + unsigned(num)); }
+
+inline int CompiledNode::findChild(const char *name) const
+{
+	size_t length = strlen(name);
+	unsigned int hash = CompiledTree::getStringHash(name, length);
+	const CompiledTree::Node &node = tree->nodes[index];
+	for (unsigned int i = 0; i < node.num_children; i++)
+	{
+		const CompiledTree::StringEntry &str = tree->strings[tree->nodes[node.first_child + i].name];
+		if (str.hash == hash && str.length == length && !memcmp(tree->chars + str.offset, name, length))
+			return int(i);
+	}
+	return -1;
+}
+
+inline CompiledNode CompiledNode::getChild(const char *name) const
+{
+	int num = findChild(name);
+	return num != -1 ? getChild(num) : CompiledNode();
+}
+
+inline CompiledNode CompiledNode::find(const char *path) const
+{
+	CompiledNode node = *this;
+	String name;
+	while (node.isValid() && *path)
+	{
+		const char *slash = strchr(path, '/');
+		size_t length = slash ? size_t(slash - path) : strlen(path);
+		name.copy(path, int(length));
+		node = node.getChild(name.get());
+		path += slash ? length + 1 : length;
+	}
+	return node;
+}
+
+inline int CompiledNode::getNumArgs() const { return int(tree->nodes[index].num_args); }
+inline const char *CompiledNode::getArgName(int num) const { return tree->get_string(tree->args[tree->nodes[index].first_arg + unsigned(num)].name); }
+inline const char *CompiledNode::getArgValue(int num) const { return get_string(tree->args[tree->nodes[index].first_arg + unsigned(num)].value); }
+
+inline int CompiledNode::findArg(const char *name) const
+{
+	size_t length = strlen(name);
+	unsigned int hash = CompiledTree::getStringHash(name, length);
+	const CompiledTree::Node &node = tree->nodes[index];
+	for (unsigned int i = 0; i < node.num_args; i++)
+	{
+		const CompiledTree::StringEntry &str = tree->strings[tree->args[node.first_arg + i].name];
+		if (str.hash == hash && str.length == length && !memcmp(tree->chars + str.offset, name, length))
+			return int(i);
+	}
+	return -1;
+}
+
+inline unsigned int CompiledNode::get_arg_value(const char *name) const
+{
+	int num = findArg(name);
+	return num != -1 ? tree->args[tree->nodes[index].first_arg + unsigned(num)].value : unsigned(CompiledTree::NONE);
+}
+
+inline const char *CompiledNode::get_string(unsigned int value) const
+{
+	return value != CompiledTree::NONE ? tree->get_string(tree->values[value].string) : "";
+}
+
+// 64-bit integers do not fit into the doubles, they are read from the text
+inline long long CompiledNode::get_long(unsigned int value, long long def) const
+{
+	if (value == CompiledTree::NONE || tree->values[value].num_numbers == 0)
+		return def;
+	const char *str = get_string(value);
+	char *end = nullptr;
+	long long ret = strtoll(str, &end, 10);
+	if (end != str)
+		return ret;
+	double number = tree->numbers[tree->values[value].first_number];
+	return is_representable<long long>(number) ? (long long)number : def;
+}
+
+template <class Type>
+inline bool CompiledNode::get_number(unsigned int value, Type &ret) const
+{
+	if (value == CompiledTree::NONE || tree->values[value].num_numbers == 0)
+		return false;
+	double number = tree->numbers[tree->values[value].first_number];
+	if (!is_representable<Type>(number))
+		return false;
+	ret = Type(number);
+	return true;
+}
+
+template <class Type>
+inline bool CompiledNode::get_array(unsigned int value, Type *dest, int dest_size) const
+{
+	if (value == CompiledTree::NONE)
+		return dest_size <= 0;
+	const CompiledTree::Value &v = tree->values[value];
+	int num = int(v.num_numbers) < dest_size ? int(v.num_numbers) : dest_size;
+	const double *src = tree->numbers + v.first_number;
+	for (int i = 0; i < num; i++)
+	{
+		if (!is_representable<Type>(src[i]))
+			return false;
+		dest[i] = Type(src[i]);
+	}
+	return num == dest_size;
+}
+
+template <class Type>
+inline bool CompiledNode::is_representable(double number)
+{
+	using Limits = std::numeric_limits<Type>;
+	// integers truncate, the bounds are powers of two and exact in double, NaN fails both comparisons
+	if (Limits::is_integer)
+		return number >= double(Limits::min()) && number < double(Limits::max() / 2 + 1) * 2.0;
+	return number != number || std::isinf(number) || std::fabs(number) <= double(Limits::max());
+}
+
+inline const char *CompiledNode::getArg(const char *name, const char *value) const
+{
+	unsigned int arg = get_arg_value(name);
+	return arg != CompiledTree::NONE ? get_string(arg) : value;
+}
+
+inline bool CompiledNode::getBoolArg(const char *name, bool value) const
+{
+	double ret;
+	return get_number(get_arg_value(name), ret) ? ret != 0.0 : value;
+}
+inline int CompiledNode::getIntArg(const char *name, int value) const { get_number(get_arg_value(name), value); return value; }
+inline long long CompiledNode::getLongArg(const char *name, long long value) const { return get_long(get_arg_value(name), value); }
+inline float CompiledNode::getFloatArg(const char *name, float value) const { get_number(get_arg_value(name), value); return value; }
+inline double CompiledNode::getDoubleArg(const char *name, double value) const { get_number(get_arg_value(name), value); return value; }
+inline bool CompiledNode::getIntArrayArg(const char *name, int *dest, int dest_size) const { return get_array(get_arg_value(name), dest, dest_size); }
+inline bool CompiledNode::getFloatArrayArg(const char *name, float *dest, int dest_size) const { return get_array(get_arg_value(name), dest, dest_size); }
+inline bool CompiledNode::getDoubleArrayArg(const char *name, double *dest, int dest_size) const { return get_array(get_arg_value(name), dest, dest_size); }
+
+inline bool CompiledNode::isData() const { return tree->nodes[index].value != CompiledTree::NONE; }
+inline const char *CompiledNode::getData() const { return get_string(tree->nodes[index].value); }
+inline bool CompiledNode::getBoolData(bool value) const
+{
+	double ret;
+	return get_number(tree->nodes[index].value, ret) ? ret != 0.0 : value;
+}
+inline int CompiledNode::getIntData(int value) const { get_number(tree->nodes[index].value, value); return value; }
+inline long long CompiledNode::getLongData(long long value) const { return get_long(tree->nodes[index].value, value); }
+inline float CompiledNode::getFloatData(float value) const { get_number(tree->nodes[index].value, value); return value; }
+inline double CompiledNode::getDoubleData(double value) const { get_number(tree->nodes[index].value, value); return value; }
+inline bool CompiledNode::getIntArrayData(int *dest, int dest_size) const { return get_array(tree->nodes[index].value, dest, dest_size); }
+inline bool CompiledNode::getFloatArrayData(float *dest, int dest_size) const { return get_array(tree->nodes[index].value, dest, dest_size); }
+inline bool CompiledNode::getDoubleArrayData(double *dest, int dest_size) const { return get_array(tree->nodes[index].value, dest, dest_size); }
+
+inline void CompiledTree::getBenchmarkReport(String &ret, const char *path)
+{
+	ret.clear();
+	String source_path;
+	if (path)
+		source_path = path;
+	else
+	{
+		// node files like data/Models/Tank.node
+		source_path = String::format("%scompiled_tree_benchmark.node", getCacheDirectory());
+		const char *directory = getCacheDirectory();
+		if (directory[0] && !Dir::isDir(directory))
+			Dir::mkdir(directory, true);
+		FilePtr f = File::create(source_path.get(), "wb");
+		if (!f || !f->isOpened())
+		{
+			ret = String::format("can't create \"%s\" file\n", source_path.get());
+			return;
+		}
+		unsigned int state = 1;
+		auto random = [&]() { state = state * 1664525u + 1013904223u; return state >> 8; };
+		f->puts("<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<nodes version=\"2.13.0.0\">\n");
+		for (int i = 0; i < 5000; i++)
+		{
+			f->puts(String::format("\t<node type=\"ObjectMeshStatic\" id=\"%u\" name=\"Part_%d\">\n"
+				"\t\t<mesh_name>guid://%08x%08x%08x</mesh_name>\n"
+				"\t\t<surface name=\"box\" material=\"401e90ccd85f4f2bb97c19ab9e1351325c4012eb\"/>\n"
+				"\t\t<transform>1 0 0 0.0 0 1 0 0.0 0 0 1 0.0 %u %u 0.%u 1.0</transform>\n"
+				"\t</node>\n", random(), i, random(), random(), random(), random() % 1000, random() % 1000, random() % 100).get());
+		}
+		f->puts("</nodes>\n");
+		f->close();
+	}
+
+	auto seconds = [](std::chrono::steady_clock::time_point begin) { return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count() * 1000.0; };
+	// the transforms of the top-level nodes are read the same way from all trees
+	float transform[16];
+	double sum = 0.0;
+
+	bool xml = path == nullptr || get_format_of(source_path.get()) == FORMAT_XML;
+	Format::append(ret, "{}\n", source_path.get());
+	if (xml)
+	{
+		auto begin = std::chrono::steady_clock::now();
+		XmlPtr root = Xml::create();
+		bool ok = root->load(source_path.get());
+		for (int i = 0; ok && i < root->getNumChildren(); i++)
+		{
+			XmlPtr child = root->getChild(i);
+			if (child->isChild("transform") && child->getChild("transform")->getFloatArrayData(transform, 16))
+				sum += transform[12];
+		}
+		Format::append(ret, "{:<28}{:8.2} ms{}\n", "Xml::load", seconds(begin), ok ? "" : "  failed");
+
+		begin = std::chrono::steady_clock::now();
+		XmlDocument document;
+		ok = document.load(source_path.get());
+		for (int i = 0; ok && i < document.getRoot()->getNumChildren(); i++)
+		{
+			const XmlNode *transform_node = document.getRoot()->getChild(i)->getChild("transform");
+			if (transform_node && transform_node->getFloatArrayData(transform, 16))
+				sum += transform[12];
+		}
+		Format::append(ret, "{:<28}{:8.2} ms{}\n", "XmlDocument::load", seconds(begin), ok ? "" : "  failed");
+	} else
+	{
+		auto begin = std::chrono::steady_clock::now();
+		UlonNodePtr root = UlonNode::create();
+		bool ok = root->load(source_path.get());
+		Format::append(ret, "{:<28}{:8.2} ms{}\n", "UlonNode::load", seconds(begin), ok ? "" : "  failed");
+	}
+
+	CompiledTree tree;
+	auto begin = std::chrono::steady_clock::now();
+	bool ok = tree.compile(source_path.get());
+	Format::append(ret, "{:<28}{:8.2} ms{}\n", "CompiledTree::compile", seconds(begin), ok ? "" : "  failed");
+
+	// the first load writes the cache, the second one maps it
+	Dir::remove(getCachePath(tree.getSourceHash()).get());
+	for (int i = 0; i < 2; i++)
+	{
+		begin = std::chrono::steady_clock::now();
+		ok = tree.load(source_path.get());
+		CompiledNode root = tree.getRoot();
+		for (int j = 0; ok && j < root.getNumChildren(); j++)
+		{
+			if (root.getChild(j).getChild("transform").isValid() && root.getChild(j).getChild("transform").getFloatArrayData(transform, 16))
+				sum += transform[12];
+		}
+		Format::append(ret, "{:<28}{:8.2} ms{}\n", i == 0 ? "CompiledTree::load (miss)" : "CompiledTree::load (hit)", seconds(begin), ok ? "" : "  failed");
+	}
+	Format::append(ret, "{:<28}{:8} KB, {} nodes, {} strings\n", "compiled", (unsigned long long)(tree.getSize() >> 10), tree.getNumNodes(), tree.getNumStrings());
+	UNIGINE_UNUSED(sum);
+}
+
+} // namespace Unigine
@@ -0,0 +1,982 @@
+/* Copyright (C) 2005-2020, UNIGINE. All rights reserved.
+ *
+ * This file is a part of the UNIGINE 2 SDK.
+ *
+ * Your use and / or redistribution of this software in source and / or
+ * binary form, with or without modification, is subject to: (i) your
+ * ongoing acceptance of and compliance with the terms and conditions of
+ * the UNIGINE License Agreement; and (ii) your inclusion of this notice
+ * in any version of this software that you use or redistribute.
+ * A copy of the UNIGINE License Agreement is available by contacting
+ * UNIGINE. at http://unigine.com/
+ */
+
+
+#pragma once
+
+#include "UnigineComponentSystem.h"
+#include "UnigineEngine.h"
+#include "UnigineConsole.h"
+#include "UnigineFormat.h"
+#include <chrono>
+
+// Batched component methods (.h file)
+/*
+#pragma once
+#include <UnigineComponentBatch.h>
+class Tank : public Unigine::ComponentBase
+{
+public:
+	COMPONENT_DEFINE(Tank, Unigine::ComponentBase);
+	COMPONENT_POOL();
+	COMPONENT_UPDATE_BATCH(updateBatch);
+
+	// called once per frame with all enabled and initialized tanks
+	static void updateBatch(Tank **tanks, int num);
+};
+
+class TankTrack : public Unigine::ComponentBase
+{
+public:
+	COMPONENT_DEFINE(TankTrack, Unigine::ComponentBase);
+	// runs on PoolCPUShaders threads, concurrently with other components that
+	// do not write Tank or TankTrack, and do not read TankTrack
+	COMPONENT_UPDATE_PARALLEL(update, Unigine::reads<Tank>, Unigine::writes<>);
+
+	void update();
+};
+*/
+
+////////////////////////////////////////////////////////////////////////////////////////
+// Macros
+////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __GNUC__
+#pragma region Macros
+#endif
+
+// allocate the components of this class from a per-type pool, so they are stored contiguously
+#define COMPONENT_POOL()																									\
+	static void *operator new(size_t size) { return Unigine::ComponentPool<__this_class>::get().allocate(size); }			\
+	static void operator delete(void *ptr, size_t size) { Unigine::ComponentPool<__this_class>::get().deallocate(ptr, size); }
+
+// register a static batch method "void NAME(Class **components, int num)"
+// optional arguments are the order and the invoke_disabled flag, like in COMPONENT_METHOD
+#define COMPONENT_BATCH_METHOD(STAGE, NAME, ...)																			\
+	template <typename T>																									\
+	class ComponentBatchRegistrator_##NAME																					\
+	{																														\
+	public:																													\
+		int index;																											\
+		ComponentBatchRegistrator_##NAME(T *c) { index = batch().add(c, &index); }											\
+		~ComponentBatchRegistrator_##NAME() { batch().remove(index); }														\
+		static Unigine::ComponentBatch<T> &batch()																			\
+		{																													\
+			static Unigine::ComponentBatch<T> b(Unigine::ComponentBatchSystem::STAGE, &T::NAME,								\
+				Unigine::String::format("%s::%s", T::getPropertyName(), #NAME), ##__VA_ARGS__);								\
+			return b;																										\
+		}																													\
+	};																														\
+	ComponentBatchRegistrator_##NAME<__this_class> __batch_registrator_##NAME{ this };
+
+#define COMPONENT_UPDATE_BATCH(NAME, ...)				COMPONENT_BATCH_METHOD(STAGE_UPDATE, NAME, ##__VA_ARGS__)
+#define COMPONENT_POST_UPDATE_BATCH(NAME, ...)			COMPONENT_BATCH_METHOD(STAGE_POST_UPDATE, NAME, ##__VA_ARGS__)
+#define COMPONENT_UPDATE_PHYSICS_BATCH(NAME, ...)		COMPONENT_BATCH_METHOD(STAGE_UPDATE_PHYSICS, NAME, ##__VA_ARGS__)
+
+// register a member method "void NAME()" that is called from PoolCPUShaders threads
+// the variadic arguments declare the component classes the method reads and writes
+// besides its own component: Unigine::reads<A, B>, Unigine::writes<C>
+#define COMPONENT_PARALLEL_METHOD(STAGE, NAME, ...)																		\
+	template <typename T>																									\
+	class ComponentParallelRegistrator_##NAME																				\
+	{																														\
+	public:																													\
+		int index;																											\
+		ComponentParallelRegistrator_##NAME(T *c) { index = job().add(c, &index); }											\
+		~ComponentParallelRegistrator_##NAME() { job().remove(index); }														\
+		static Unigine::ComponentParallelJob<T> &job()																		\
+		{																													\
+			static Unigine::ComponentParallelJob<T> j(Unigine::ComponentBatchSystem::STAGE,									\
+				Unigine::String::format("%s::%s", T::getPropertyName(), #NAME),												\
+				[](T *c) { c->NAME(); }, Unigine::ComponentAccess<__VA_ARGS__>());											\
+			return j;																										\
+		}																													\
+	};																														\
+	ComponentParallelRegistrator_##NAME<__this_class> __parallel_registrator_##NAME{ this };
+
+#define COMPONENT_UPDATE_PARALLEL(NAME, ...)			COMPONENT_PARALLEL_METHOD(STAGE_UPDATE, NAME, ##__VA_ARGS__)
+#define COMPONENT_POST_UPDATE_PARALLEL(NAME, ...)		COMPONENT_PARALLEL_METHOD(STAGE_POST_UPDATE, NAME, ##__VA_ARGS__)
+#define COMPONENT_UPDATE_PHYSICS_PARALLEL(NAME, ...)	COMPONENT_PARALLEL_METHOD(STAGE_UPDATE_PHYSICS, NAME, ##__VA_ARGS__)
+
+// checks that parallel methods do not modify components they have not declared in writes<>
+// only the sizeof(Class) bytes of each component are compared, changes made through pointers,
+// Vector storage or other heap memory the component owns are not detected
+#ifndef UNIGINE_COMPONENT_ACCESS_CHECK
+	#ifndef NDEBUG
+		#define UNIGINE_COMPONENT_ACCESS_CHECK 1
+	#else
+		#define UNIGINE_COMPONENT_ACCESS_CHECK 0
+	#endif
+#endif
+
+#ifndef __GNUC__
+#pragma endregion Macros
+#endif
+
+namespace Unigine
+{
+
+////////////////////////////////////////////////////////////////////////////////////////
+// Component Pool
+////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __GNUC__
+#pragma region Pool
+#endif
+
+// per-type allocator, components are placed in chunks of NUM_CHUNK_SLOTS slots
+// derived classes that do not declare their own pool fall back to Memory::allocate()
+template <class C>
+class ComponentPool
+{
+public:
+	static ComponentPool &get()
+	{
+		static ComponentPool pool;
+		return pool;
+	}
+
+	void *allocate(size_t size)
+	{
+		if (size != sizeof(C))
+			return Memory::allocate(size);
+		ScopedLock lock(mutex);
+		if (free_slots == nullptr)
+			allocate_chunk();
+		Slot *slot = free_slots;
+		free_slots = slot->next;
+		num_slots_used++;
+		return slot;
+	}
+
+	void deallocate(void *ptr, size_t size)
+	{
+		if (ptr == nullptr)
+			return;
+		if (size != sizeof(C))
+		{
+			Memory::deallocate(ptr);
+			return;
+		}
+		ScopedLock lock(mutex);
+		Slot *slot = static_cast<Slot *>(ptr);
+		slot->next = free_slots;
+		free_slots = slot;
+		num_slots_used--;
+	}
+
+	// statistics
+	UNIGINE_INLINE int getNumComponents() const { return num_slots_used; }
+	UNIGINE_INLINE int getNumChunks() const { return chunks.size(); }
+	UNIGINE_INLINE size_t getMemoryUsage() const { return chunks.size() * sizeof(Slot) * NUM_CHUNK_SLOTS; }
+
+private:
+	enum
+	{
+		NUM_CHUNK_SLOTS = 64,
+	};
+
+	union Slot
+	{
+		Slot *next;
+		typename std::aligned_storage<sizeof(C), alignof(C)>::type data;
+	};
+
+	ComponentPool() = default;
+	~ComponentPool()
+	{
+		// components still alive at exit keep their chunks
+		if (num_slots_used != 0)
+			return;
+		for (int i = 0; i < chunks.size(); i++)
+			Memory::deallocate(chunks[i]);
+	}
+
+	void allocate_chunk()
+	{
+		Slot *chunk = static_cast<Slot *>(Memory::allocate(sizeof(Slot) * NUM_CHUNK_SLOTS));
+		chunks.append(chunk);
+		// the first slot is handed out first, so consecutive components are adjacent in memory
+		for (int i = NUM_CHUNK_SLOTS - 1; i >= 0; i--)
+		{
+			chunk[i].next = free_slots;
+			free_slots = &chunk[i];
+		}
+	}
+
+	Vector<Slot *> chunks;
+	Slot *free_slots{nullptr};
+	int num_slots_used{0};
+	Mutex mutex;
+};
+
+#ifndef __GNUC__
+#pragma endregion Pool
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////
+// Component Access
+////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __GNUC__
+#pragma region Access
+#endif
+
+// sequential IDs of component classes
+class ComponentTypeIds
+{
+public:
+	static int allocate()
+	{
+		static volatile int counter = 0;
+		return AtomicAdd(&counter, 1);
+	}
+};
+
+template <class C>
+class ComponentTypeId
+{
+public:
+	static int get()
+	{
+		static int id = ComponentTypeIds::allocate();
+		return id;
+	}
+};
+
+// access declarations of parallel methods
+template <class... Types>
+struct reads {};
+
+template <class... Types>
+struct writes {};
+
+template <class... Sets>
+class ComponentAccess;
+
+template <>
+class ComponentAccess<>
+{
+public:
+	static void get(Vector<int> &reads_ids, Vector<int> &writes_ids)
+	{
+		UNIGINE_UNUSED(reads_ids);
+		UNIGINE_UNUSED(writes_ids);
+	}
+};
+
+template <class... Types, class... Sets>
+class ComponentAccess<reads<Types...>, Sets...>
+{
+public:
+	static void get(Vector<int> &reads_ids, Vector<int> &writes_ids)
+	{
+		int ids[] = { -1, ComponentTypeId<Types>::get()... };
+		for (int i = 1; i < int(sizeof(ids) / sizeof(ids[0])); i++)
+			reads_ids.append(ids[i]);
+		ComponentAccess<Sets...>::get(reads_ids, writes_ids);
+	}
+};
+
+template <class... Types, class... Sets>
+class ComponentAccess<writes<Types...>, Sets...>
+{
+public:
+	static void get(Vector<int> &reads_ids, Vector<int> &writes_ids)
+	{
+		int ids[] = { -1, ComponentTypeId<Types>::get()... };
+		for (int i = 1; i < int(sizeof(ids) / sizeof(ids[0])); i++)
+			writes_ids.append(ids[i]);
+		ComponentAccess<Sets...>::get(reads_ids, writes_ids);
+	}
+};
+
+#ifndef __GNUC__
+#pragma endregion Access
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////
+// Component Batch System
+////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __GNUC__
+#pragma region Batch
+#endif
+
+class ComponentBatchBase
+{
+public:
+	virtual ~ComponentBatchBase() {}
+	virtual void run() = 0;
+
+	UNIGINE_INLINE const char *getName() const { return name.get(); }
+	UNIGINE_INLINE int getNumComponents() const { return num_components; }
+
+protected:
+	String name; // example: "ClassName::functionName"
+	int num_components{0};
+};
+
+// parallel job interface used by the scheduler
+class ComponentParallelJobBase
+{
+public:
+	virtual ~ComponentParallelJobBase() {}
+
+	// collects the components to update this frame, called on the main thread
+	virtual int gather() = 0;
+	virtual int getNumGathered() const = 0;
+	// updates gathered components [begin, end), called from worker threads
+	virtual void run(int begin, int end) = 0;
+	// memory of all registered components for the access checker
+	virtual int getNumComponents() const = 0;
+	virtual const void *getComponentData(int num) const = 0;
+
+	UNIGINE_INLINE const char *getName() const { return name.get(); }
+	UNIGINE_INLINE int getTypeID() const { return type_id; }
+	UNIGINE_INLINE size_t getComponentSize() const { return component_size; }
+	UNIGINE_INLINE const Vector<int> &getReads() const { return reads_ids; }
+	UNIGINE_INLINE const Vector<int> &getWrites() const { return writes_ids; }
+
+	UNIGINE_INLINE bool isWriting(int type) const { return writes_ids.contains(type); }
+	UNIGINE_INLINE bool isAccessing(int type) const { return writes_ids.contains(type) || reads_ids.contains(type); }
+
+	// jobs conflict if one of them writes a class the other one accesses
+	UNIGINE_INLINE bool isConflicting(const ComponentParallelJobBase *job) const
+	{
+		for (int i = 0; i < writes_ids.size(); i++)
+			if (job->isAccessing(writes_ids[i]))
+				return true;
+		for (int i = 0; i < job->writes_ids.size(); i++)
+			if (isAccessing(job->writes_ids[i]))
+				return true;
+		return false;
+	}
+
+protected:
+	String name;
+	int type_id{-1};
+	size_t component_size{0};
+	Vector<int> reads_ids;
+	Vector<int> writes_ids; // includes the own class
+};
+
+// batched component methods are called once per class and order instead of once per component
+// they run from a separate WorldLogic after the per-component methods of the same stage,
+// the order sorts batches among themselves
+// parallel methods of a stage run before its batches: jobs are sorted into waves so that
+// no two jobs of a wave conflict, each wave is split across PoolCPUShaders threads
+class ComponentBatchSystem : private WorldLogic
+{
+public:
+	enum STAGE
+	{
+		STAGE_UPDATE = 0,
+		STAGE_POST_UPDATE,
+		STAGE_UPDATE_PHYSICS,
+		NUM_STAGES,
+	};
+
+	static ComponentBatchSystem *get()
+	{
+		static ComponentBatchSystem system;
+		return &system;
+	}
+
+	void addBatch(STAGE stage, int order, ComponentBatchBase *batch)
+	{
+		ScopedLock lock(mutex);
+		batches[stage][order].append(batch);
+		register_logic();
+	}
+
+	void addParallelJob(STAGE stage, ComponentParallelJobBase *job)
+	{
+		ScopedLock lock(mutex);
+		jobs[stage].append(job);
+		waves_dirty[stage] = true;
+		register_logic();
+	}
+
+	void removeParallelJob(STAGE stage, ComponentParallelJobBase *job)
+	{
+		ScopedLock lock(mutex);
+		jobs[stage].removeOne(job);
+		waves_dirty[stage] = true;
+	}
+
+	void removeBatch(STAGE stage, int order, ComponentBatchBase *batch)
+	{
+		ScopedLock lock(mutex);
+		auto it = batches[stage].find(order);
+		if (it == batches[stage].end())
+			return;
+		it->data.removeOne(batch);
+		if (it->data.empty())
+			batches[stage].remove(it);
+	}
+
+	UNIGINE_INLINE void run(STAGE stage)
+	{
+		if (jobs[stage].size())
+			run_parallel(stage);
+
+		// batch functions may create and delete components, so they are called without the lock
+		running.clear();
+		{
+			ScopedLock lock(mutex);
+			for (auto it = batches[stage].begin(); it != batches[stage].end(); ++it)
+				running.append(it->data);
+		}
+		for (int i = 0; i < running.size(); i++)
+			running[i]->run();
+	}
+
+	// statistics
+	UNIGINE_INLINE int getNumBatches(STAGE stage) const
+	{
+		int ret = 0;
+		for (auto it = batches[stage].begin(); it != batches[stage].end(); ++it)
+			ret += it->data.size();
+		return ret;
+	}
+	UNIGINE_INLINE int getNumParallelJobs(STAGE stage) const { return jobs[stage].size(); }
+	UNIGINE_INLINE int getNumParallelWaves(STAGE stage)
+	{
+		update_waves(stage);
+		return waves[stage].size();
+	}
+
+	// microseconds per frame of per-component callbacks against a batch for num tank-sized components
+	static void getBenchmarkReport(String &ret, int num = 10000, int num_frames = 1000);
+
+	// component_batch_benchmark [number of components] [number of frames]
+	static void addConsoleCommands()
+	{
+		Console::addCommand("component_batch_benchmark", "prints the update cost of per-component and batched methods", MakeCallback(&ComponentBatchSystem::console_benchmark));
+	}
+	static void removeConsoleCommands() { Console::removeCommand("component_batch_benchmark"); }
+
+private:
+	template <class C> friend class ComponentBatch;
+	template <class C> friend class ComponentParallelJob;
+
+	ComponentBatchSystem() = default;
+	~ComponentBatchSystem()
+	{
+		if (registered && Engine::get())
+			Engine::get()->removeWorldLogic(this);
+	}
+	ComponentBatchSystem(ComponentBatchSystem const &) = delete;
+	ComponentBatchSystem &operator=(ComponentBatchSystem const &) = delete;
+
+	int update() override { run(STAGE_UPDATE); return 1; }
+	int postUpdate() override { run(STAGE_POST_UPDATE); return 1; }
+	int updatePhysics() override { run(STAGE_UPDATE_PHYSICS); return 1; }
+
+	static void console_benchmark(int argc, char **argv)
+	{
+		int num = 10000;
+		int num_frames = 1000;
+		if (argc > 1 && atoi(argv[1]) > 0)
+			num = atoi(argv[1]);
+		if (argc > 2 && atoi(argv[2]) > 0)
+			num_frames = atoi(argv[2]);
+		String report;
+		getBenchmarkReport(report, num, num_frames);
+		Log::message("%s", report.get());
+	}
+
+	void register_logic()
+	{
+		// the batch system is added to the engine on the first registration
+		if (!registered && Engine::get())
+		{
+			Engine::get()->addWorldLogic(this);
+			registered = true;
+		}
+	}
+
+	// a job goes to the wave after the last earlier job it conflicts with
+	void update_waves(STAGE stage)
+	{
+		ScopedLock lock(mutex);
+		if (!waves_dirty[stage])
+			return;
+		waves_dirty[stage] = false;
+
+		const Vector<ComponentParallelJobBase *> &list = jobs[stage];
+		Vector<Vector<ComponentParallelJobBase *>> &ret = waves[stage];
+		ret.clear();
+		Vector<int> levels;
+		levels.resize(list.size());
+		for (int i = 0; i < list.size(); i++)
+		{
+			int level = 0;
+			for (int j = 0; j < i; j++)
+				if (levels[j] >= level && list[i]->isConflicting(list[j]))
+					level = levels[j] + 1;
+			levels[i] = level;
+			if (level == ret.size())
+				ret.append();
+			ret[level].append(list[i]);
+		}
+	}
+
+	struct WorkItem
+	{
+		ComponentParallelJobBase *job;
+		int begin;
+		int end;
+	};
+
+	class WaveShader : public CPUShader
+	{
+	public:
+		WaveShader(const Vector<WorkItem> &items) : items(items), counter(0) {}
+
+		void process(int thread_num, int threads_count) override
+		{
+			UNIGINE_UNUSED(thread_num);
+			UNIGINE_UNUSED(threads_count);
+			for (;;)
+			{
+				int i = AtomicAdd(&counter, 1);
+				if (i >= items.size())
+					break;
+				items[i].job->run(items[i].begin, items[i].end);
+			}
+		}
+
+	private:
+		const Vector<WorkItem> &items;
+		volatile int counter;
+	};
+
+	void run_parallel(STAGE stage)
+	{
+		enum
+		{
+			ITEMS_PER_THREAD = 4,
+			MIN_ITEM_SIZE = 16,
+		};
+
+		update_waves(stage);
+#if UNIGINE_COMPONENT_ACCESS_CHECK
+		current_stage = stage;
+#endif
+		// the jobs may look components up, nothing may be added or removed meanwhile
+		ComponentStorageNodes::ScopedRead read;
+		int num_threads = PoolCPUShaders::isInitialized() ? PoolCPUShaders::getNumSyncThreads() : 1;
+
+		for (int i = 0; i < waves[stage].size(); i++)
+		{
+			const Vector<ComponentParallelJobBase *> &wave = waves[stage][i];
+
+			int num_components = 0;
+			for (int j = 0; j < wave.size(); j++)
+				num_components += wave[j]->gather();
+			if (num_components == 0)
+				continue;
+
+			// split jobs into items of similar size, large jobs are spread over all threads
+			int item_size = Math::max(num_components / (num_threads * ITEMS_PER_THREAD), int(MIN_ITEM_SIZE));
+			work_items.clear();
+			for (int j = 0; j < wave.size(); j++)
+			{
+				int num = wave[j]->getNumGathered();
+				for (int begin = 0; begin < num; begin += item_size)
+				{
+					WorkItem &item = work_items.append();
+					item.job = wave[j];
+					item.begin = begin;
+					item.end = Math::min(begin + item_size, num);
+				}
+			}
+
+#if UNIGINE_COMPONENT_ACCESS_CHECK
+			check_begin(wave);
+#endif
+			if (num_threads > 1 && work_items.size() > 1)
+			{
+				WaveShader shader(work_items);
+				shader.runSync();
+			} else
+			{
+				for (int j = 0; j < work_items.size(); j++)
+					work_items[j].job->run(work_items[j].begin, work_items[j].end);
+			}
+#if UNIGINE_COMPONENT_ACCESS_CHECK
+			check_end(wave);
+#endif
+		}
+	}
+
+#if UNIGINE_COMPONENT_ACCESS_CHECK
+	// hashes the memory of components that no job of the wave may write,
+	// sizeof(Class) bytes per component, the heap memory it points to is not followed
+	static unsigned long long hash_memory(const void *data, size_t size)
+	{
+		const unsigned char *s = static_cast<const unsigned char *>(data);
+		unsigned long long ret = 14695981039346656037ull;
+		for (size_t i = 0; i < size; i++)
+			ret = (ret ^ s[i]) * 1099511628211ull;
+		return ret;
+	}
+
+	void check_hash(const Vector<ComponentParallelJobBase *> &wave, Vector<unsigned long long> &hashes)
+	{
+		ScopedLock lock(mutex);
+		const Vector<ComponentParallelJobBase *> &list = jobs[current_stage];
+		hashes.clear();
+		for (int i = 0; i < list.size(); i++)
+		{
+			const ComponentParallelJobBase *job = list[i];
+			bool written = false;
+			for (int j = 0; j < wave.size() && !written; j++)
+				written = wave[j]->isWriting(job->getTypeID());
+			unsigned long long hash = 0;
+			if (!written)
+			{
+				for (int j = 0; j < job->getNumComponents(); j++)
+					hash = hash * 31 + hash_memory(job->getComponentData(j), job->getComponentSize());
+			}
+			hashes.append(hash);
+		}
+	}
+
+	void check_begin(const Vector<ComponentParallelJobBase *> &wave)
+	{
+		check_hash(wave, check_hashes_begin);
+	}
+
+	void check_end(const Vector<ComponentParallelJobBase *> &wave)
+	{
+		check_hash(wave, check_hashes_end);
+		const Vector<ComponentParallelJobBase *> &list = jobs[current_stage];
+		for (int i = 0; i < list.size(); i++)
+		{
+			if (check_hashes_begin[i] == check_hashes_end[i])
+				continue;
+			String names;
+			for (int j = 0; j < wave.size(); j++)
+			{
+				if (j)
+					names += ", ";
+				names += wave[j]->getName();
+			}
+			Log::warning("ComponentBatchSystem: components of \"%s\" were modified by one of the parallel methods %s, "
+				"add the class to their writes<>\n", list[i]->getName(), names.get());
+		}
+	}
+
+	STAGE current_stage{STAGE_UPDATE};
+	Vector<unsigned long long> check_hashes_begin;
+	Vector<unsigned long long> check_hashes_end;
+#endif
+
+	Map<int, Vector<ComponentBatchBase *>> batches[NUM_STAGES]; // <order, batches in registration order>
+	Vector<ComponentParallelJobBase *> jobs[NUM_STAGES];
+	Vector<Vector<ComponentParallelJobBase *>> waves[NUM_STAGES];
+	bool waves_dirty[NUM_STAGES]{};
+	Vector<WorkItem> work_items;
+	Vector<ComponentBatchBase *> running;
+	bool registered{false};
+	Mutex mutex; // registration and the component lists of batches and jobs
+};
+
+// list of components of one class with a batch method
+template <class C>
+class ComponentBatch : public ComponentBatchBase
+{
+public:
+	using BatchFunction = void (*)(C **components, int num);
+
+	ComponentBatch(ComponentBatchSystem::STAGE stage, BatchFunction function, const char *name, int order = 0, bool invoke_disabled = false)
+		: stage(stage)
+		, order(order)
+		, invoke_disabled(invoke_disabled)
+		, function(function)
+	{
+		this->name = name;
+		ComponentBatchSystem::get()->addBatch(stage, order, this);
+	}
+
+	~ComponentBatch() override
+	{
+		ComponentBatchSystem::get()->removeBatch(stage, order, this);
+	}
+
+	// returns the position of the component in the list, it is kept up to date through the index pointer
+	// the list is guarded by the batch system lock, as the batch functions may add and remove components
+	int add(C *component, int *index)
+	{
+		ScopedLock lock(ComponentBatchSystem::get()->mutex);
+		Item &item = items.append();
+		item.component = component;
+		item.index = index;
+		num_components = items.size();
+		return items.size() - 1;
+	}
+
+	void remove(int index)
+	{
+		ScopedLock lock(ComponentBatchSystem::get()->mutex);
+		assert(index >= 0 && index < items.size() && "ComponentBatch::remove(): bad index");
+		Item &last = items.last();
+		*last.index = index;
+		items[index] = last;
+		items.removeLast();
+		num_components = items.size();
+	}
+
+	void run() override
+	{
+		active.clear();
+		{
+			ScopedLock lock(ComponentBatchSystem::get()->mutex);
+			for (int i = 0; i < items.size(); i++)
+			{
+				C *c = items[i].component;
+				if (invoke_disabled || (c->isEnabled() && c->isInitialized()))
+					active.append(c);
+			}
+		}
+		if (active.size())
+			function(active.get(), active.size());
+	}
+
+private:
+	struct Item
+	{
+		C *component;
+		int *index;
+	};
+
+	ComponentBatchSystem::STAGE stage;
+	int order;
+	bool invoke_disabled;
+	BatchFunction function;
+
+	Vector<Item> items;
+	Vector<C *> active;
+};
+
+// list of components of one class with a parallel method
+template <class C>
+class ComponentParallelJob : public ComponentParallelJobBase
+{
+public:
+	using JobFunction = void (*)(C *component);
+
+	template <class... Sets>
+	ComponentParallelJob(ComponentBatchSystem::STAGE stage, const char *name, JobFunction function, ComponentAccess<Sets...>)
+		: stage(stage)
+		, function(function)
+	{
+		this->name = name;
+		type_id = ComponentTypeId<C>::get();
+		component_size = sizeof(C);
+		writes_ids.append(type_id);
+		ComponentAccess<Sets...>::get(reads_ids, writes_ids);
+		ComponentBatchSystem::get()->addParallelJob(stage, this);
+	}
+
+	~ComponentParallelJob() override
+	{
+		ComponentBatchSystem::get()->removeParallelJob(stage, this);
+	}
+
+	int add(C *component, int *index)
+	{
+		ScopedLock lock(ComponentBatchSystem::get()->mutex);
+		Item &item = items.append();
+		item.component = component;
+		item.index = index;
+		return items.size() - 1;
+	}
+
+	void remove(int index)
+	{
+		ScopedLock lock(ComponentBatchSystem::get()->mutex);
+		assert(index >= 0 && index < items.size() && "ComponentParallelJob::remove(): bad index");
+		Item &last = items.last();
+		*last.index = index;
+		items[index] = last;
+		items.removeLast();
+	}
+
+	int gather() override
+	{
+		ScopedLock lock(ComponentBatchSystem::get()->mutex);
+		active.clear();
+		for (int i = 0; i < items.size(); i++)
+		{
+			C *c = items[i].component;
+			if (c->isEnabled() && c->isInitialized())
+				active.append(c);
+		}
+		return active.size();
+	}
+
+	int getNumGathered() const override { return active.size(); }
+
+	void run(int begin, int end) override
+	{
+		for (int i = begin; i < end; i++)
+			function(active[i]);
+	}
+
+	// read by the access checker under the batch system lock
+	int getNumComponents() const override { return items.size(); }
+	const void *getComponentData(int num) const override { return items[num].component; }
+
+private:
+	struct Item
+	{
+		C *component;
+		int *index;
+	};
+
+	ComponentBatchSystem::STAGE stage;
+	JobFunction function;
+
+	Vector<Item> items;
+	Vector<C *> active;
+};
+
+// stand-in for a tank component, the engine state of ComponentBase is replaced with padding
+struct ComponentBatchBenchmarkTank
+{
+	virtual ~ComponentBatchBenchmarkTank() {}
+
+	UNIGINE_INLINE bool isEnabled() const { return enabled; }
+	UNIGINE_INLINE bool isInitialized() const { return initialized; }
+
+	void update()
+	{
+		position = position + velocity * 0.016f;
+		fuel -= 0.01f;
+	}
+
+	static void updateBatch(ComponentBatchBenchmarkTank **tanks, int num)
+	{
+		for (int i = 0; i < num; i++)
+			tanks[i]->update();
+	}
+
+	bool enabled{true};
+	bool initialized{true};
+	unsigned char engine_state[200];
+	Math::vec3 position;
+	Math::vec3 velocity{1.0f, 0.0f, 0.0f};
+	float fuel{100.0f};
+	unsigned char data[64];
+};
+
+struct ComponentBatchBenchmarkPooledTank : public ComponentBatchBenchmarkTank
+{
+	static void *operator new(size_t size) { return ComponentPool<ComponentBatchBenchmarkPooledTank>::get().allocate(size); }
+	static void operator delete(void *ptr, size_t size) { ComponentPool<ComponentBatchBenchmarkPooledTank>::get().deallocate(ptr, size); }
+};
+
+inline void ComponentBatchSystem::getBenchmarkReport(String &ret, int num, int num_frames)
+{
+	using Tank = ComponentBatchBenchmarkTank;
+	using PooledTank = ComponentBatchBenchmarkPooledTank;
+
+	if (num < 1)
+		num = 1;
+	if (num_frames < 1)
+		num_frames = 1;
+
+	// the engine loop visits a component and its heap-allocated callback per method
+	struct Entry
+	{
+		Tank *component;
+		CallbackBase *callback;
+	};
+
+	// components are created between other allocations, as they are while a world loads
+	Vector<Tank *> heap_tanks;
+	Vector<Tank *> pool_tanks;
+	Vector<Entry> entries;
+	Vector<void *> garbage;
+	unsigned int state = 1;
+	for (int i = 0; i < num; i++)
+	{
+		Tank *tank = new Tank();
+		heap_tanks.append(tank);
+		entries.append({tank, MakeCallback(tank, &Tank::update)});
+		state = state * 1664525u + 1013904223u;
+		garbage.append(malloc(32 + (state >> 8) % 1024));
+		pool_tanks.append(new PooledTank());
+		state = state * 1664525u + 1013904223u;
+		garbage.append(malloc(32 + (state >> 8) % 1024));
+	}
+
+	ComponentBatch<Tank> heap_batch(STAGE_UPDATE, &Tank::updateBatch, "ComponentBatchBenchmark::heap");
+	ComponentBatch<Tank> pool_batch(STAGE_UPDATE, &Tank::updateBatch, "ComponentBatchBenchmark::pool");
+	Vector<int> heap_indices;
+	Vector<int> pool_indices;
+	heap_indices.resize(num);
+	pool_indices.resize(num);
+	for (int i = 0; i < num; i++)
+	{
+		heap_indices[i] = heap_batch.add(heap_tanks[i], &heap_indices[i]);
+		pool_indices[i] = pool_batch.add(pool_tanks[i], &pool_indices[i]);
+	}
+
+	auto run = [&](const char *name, const Function<void()> &func)
+	{
+		func();
+		auto begin = std::chrono::steady_clock::now();
+		for (int i = 0; i < num_frames; i++)
+			func();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+		Format::append(ret, "{:<44}{:8.1} us/frame\n", name, seconds * 1e6 / num_frames);
+	};
+
+	ret.clear();
+	Format::append(ret, "{} components, {} bytes, {} frames\n", num, int(sizeof(PooledTank)), num_frames);
+	run("per-component callbacks, heap components", [&]() {
+		for (int i = 0; i < entries.size(); i++)
+		{
+			const Entry &entry = entries[i];
+			if (entry.component->isEnabled() && entry.component->isInitialized())
+				entry.callback->run();
+		}
+	});
+	run("batch, heap components", [&]() { heap_batch.run(); });
+	run("batch, pooled components", [&]() { pool_batch.run(); });
+
+	for (int i = num - 1; i >= 0; i--)
+	{
+		heap_batch.remove(heap_indices[i]);
+		pool_batch.remove(pool_indices[i]);
+	}
+	for (int i = 0; i < num; i++)
+	{
+		delete entries[i].callback;
+		delete heap_tanks[i];
+		delete pool_tanks[i];
+	}
+	for (int i = 0; i < garbage.size(); i++)
+		free(garbage[i]);
+}
+
+#ifndef __GNUC__
+#pragma endregion Batch
+#endif
+
+} // namespace Unigine
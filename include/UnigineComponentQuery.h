@@ -0,0 +1,215 @@
+/* Copyright (C) 2005-2020, UNIGINE. All rights reserved.
+ *
+ * This file is a part of the UNIGINE 2 SDK.
+ *
+ * Your use and / or redistribution of this software in source and / or
+ * binary form, with or without modification, is subject to: (i) your
+ * ongoing acceptance of and compliance with the terms and conditions of
+ * the UNIGINE License Agreement; and (ii) your inclusion of this notice
+ * in any version of this software that you use or redistribute.
+ * A copy of the UNIGINE License Agreement is available by contacting
+ * UNIGINE. at http://unigine.com/
+ */
+
+
+#pragma once
+
+#include "UnigineComponentSystem.h"
+#include "UnigineHashSet.h"
+
+// Component query example
+/*
+class Tank : public Unigine::ComponentBase
+{
+public:
+	COMPONENT_DEFINE(Tank, Unigine::ComponentBase);
+	COMPONENT_INIT(init);
+	COMPONENT_UPDATE(update);
+
+private:
+	void init() { tracks.setNode(node); }
+	void update()
+	{
+		// walks a contiguous array, the hierarchy is not traversed
+		for (TankTrack *track : tracks)
+			track->...;
+
+		if (tracks.isChanged(tracks_version))
+			...
+	}
+
+	Unigine::ComponentQuery<TankTrack> tracks;
+	unsigned int tracks_version = 0;
+};
+*/
+
+namespace Unigine
+{
+
+//////////////////////////////////////////////////////////////////////////
+/// Persistent component query.
+///
+/// Holds the result of getComponentsInChildren() or getComponentsInParent()
+/// for one node and keeps it up to date as components of the class are
+/// created and destroyed, so reading it costs nothing per frame. The engine
+/// does not report hierarchy changes: call invalidate() after reparenting
+/// nodes in or out of the queried hierarchy, the query is rebuilt on the
+/// next access. The version is incremented every time the result changes.
+///
+/// Available for classes declared with the COMPONENT macro. Components are
+/// in hierarchy order after a rebuild, new components are appended.
+//////////////////////////////////////////////////////////////////////////
+
+template <class C>
+class ComponentQuery : private ComponentStorageListener<C>
+{
+public:
+	static_assert(HasComponentStorage<C>::value, "ComponentQuery: class has no component storage");
+
+	enum MODE
+	{
+		MODE_CHILDREN = 0,	// the node, its children and NodeReference contents
+		MODE_PARENT,		// the node and its parents up to the root
+	};
+
+	ComponentQuery() { ComponentStorage<C>::get().addListener(this); }
+	ComponentQuery(const NodePtr &node, MODE mode = MODE_CHILDREN) : ComponentQuery() { setNode(node, mode); }
+	~ComponentQuery() override { ComponentStorage<C>::get().removeListener(this); }
+
+	ComponentQuery(const ComponentQuery &) = delete;
+	ComponentQuery &operator=(const ComponentQuery &) = delete;
+
+	UNIGINE_INLINE void setNode(const NodePtr &n, MODE m = MODE_CHILDREN)
+	{
+		node = n;
+		mode = m;
+		invalidate();
+	}
+	UNIGINE_INLINE const NodePtr &getNode() const { return node; }
+	UNIGINE_INLINE MODE getMode() const { return mode; }
+
+	// the result is rebuilt on the next access
+	UNIGINE_INLINE void invalidate() { dirty = 1; }
+
+	// results
+	UNIGINE_INLINE int size() { refresh(); return components.size(); }
+	UNIGINE_INLINE bool empty() { refresh(); return components.empty(); }
+	UNIGINE_INLINE C *get(int index) { refresh(); return components[index]; }
+	UNIGINE_INLINE C *operator[](int index) { refresh(); return components[index]; }
+	UNIGINE_INLINE C *const *begin() { refresh(); return components.get(); }
+	UNIGINE_INLINE C *const *end() { refresh(); return components.get() + components.size(); }
+
+	// versions
+	UNIGINE_INLINE unsigned int getVersion() { refresh(); return version; }
+	UNIGINE_INLINE bool isChanged(unsigned int &last_version)
+	{
+		refresh();
+		if (last_version == version)
+			return false;
+		last_version = version;
+		return true;
+	}
+
+private:
+	void componentAdded(C *component, int node_id, const ComponentHandle<C> &handle) override
+	{
+		if (dirty || node.isDeleted())
+			return;
+
+		if (mode == MODE_CHILDREN)
+		{
+			int root_id = node->getID();
+			NodePtr n = component->getNode();
+			while (n && n->getID() != root_id)
+				n = n->getParent() ? n->getParent() : n->getPossessor();
+			if (!n)
+				return;
+		} else if (!ancestors.contains(node_id))
+			return;
+
+		indices.append(handle.index, components.size());
+		components.append(component);
+		handles.append(handle.index);
+		version++;
+	}
+
+	void componentRemoved(C *, int, const ComponentHandle<C> &handle) override
+	{
+		if (dirty)
+			return;
+
+		auto it = indices.find(handle.index);
+		if (it == indices.end())
+			return;
+
+		int index = it->data;
+		indices.remove(it);
+		int last = components.size() - 1;
+		if (index != last)
+		{
+			components[index] = components[last];
+			handles[index] = handles[last];
+			indices[handles[index]] = index;
+		}
+		components.removeLast();
+		handles.removeLast();
+		version++;
+	}
+
+	UNIGINE_INLINE void refresh()
+	{
+		if (dirty)
+			rebuild();
+	}
+
+	void rebuild()
+	{
+		dirty = 0;
+
+		Vector<C *> old_components;
+		old_components.swap(components);
+		indices.clear();
+		handles.clear();
+		ancestors.clear();
+
+		if (!node.isDeleted())
+		{
+			ComponentSystem *system = ComponentSystem::get();
+			if (mode == MODE_CHILDREN)
+				system->getComponentsInChildren<C>(node, components, 0);
+			else
+			{
+				system->getComponentsInParent<C>(node, components, 0);
+				NodePtr n = node;
+				while (n)
+				{
+					ancestors.append(n->getID());
+					n = n->getParent() ? n->getParent() : n->getPossessor();
+				}
+			}
+
+			handles.resize(components.size());
+			for (int i = 0; i < components.size(); i++)
+			{
+				handles[i] = system->getComponentHandle(components[i]).index;
+				indices.append(handles[i], i);
+			}
+		}
+
+		if (components.size() != old_components.size() ||
+			(components.size() && memcmp(components.get(), old_components.get(), components.size() * sizeof(C *)) != 0))
+			version++;
+	}
+
+	NodePtr node;
+	MODE mode{MODE_CHILDREN};
+	int dirty{1};
+	unsigned int version{0};
+
+	Vector<C *> components;
+	Vector<int> handles;		// handle indices, parallel to components
+	HashMap<int, int> indices;	// handle index -> index in components
+	HashSet<int> ancestors;		// node IDs, MODE_PARENT only
+};
+
+} // namespace Unigine
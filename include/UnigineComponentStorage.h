@@ -0,0 +1,399 @@
+/* Copyright (C) 2005-2020, UNIGINE. All rights reserved.
+ *
+ * This file is a part of the UNIGINE 2 SDK.
+ *
+ * Your use and / or redistribution of this software in source and / or
+ * binary form, with or without modification, is subject to: (i) your
+ * ongoing acceptance of and compliance with the terms and conditions of
+ * the UNIGINE License Agreement; and (ii) your inclusion of this notice
+ * in any version of this software that you use or redistribute.
+ * A copy of the UNIGINE License Agreement is available by contacting
+ * UNIGINE. at http://unigine.com/
+ */
+
+
+#pragma once
+
+#include "UnigineBase.h"
+#include "UnigineVector.h"
+#include "UnigineHashMap.h"
+#include "UnigineEngine.h"
+#include <type_traits>
+#include <atomic>
+
+namespace Unigine
+{
+
+////////////////////////////////////////////////////////////////////////////////////////
+// Component Storage
+//
+// Every class declared with the COMPONENT macro keeps a packed array of its live
+// components. Nodes with components get a slot in a shared table, each class maps
+// slots to its packed array through a sparse array, so a node-to-component lookup
+// is one hash lookup and two array reads. Removal swaps the last component into
+// the hole, handles stay valid through an indirection table with generations.
+//
+// There is no locking: components are added and removed, and listeners changed,
+// on the engine main thread only, which is where the ComponentSystem creates and
+// deletes them. Lookups from other threads (parallel component methods, jobs) are
+// safe only while no component of any class is added or removed: the node table
+// is shared by all classes and a change of one class may rehash it under the
+// lookups of another. Parallel readers hold a ComponentStorageNodes::ScopedRead,
+// the batch system does so for its parallel jobs. Debug builds assert the writer
+// thread and that no reader is active.
+////////////////////////////////////////////////////////////////////////////////////////
+
+// generational handle, stays valid while the component is alive
+template <class C>
+struct ComponentHandle
+{
+	int index{-1};
+	int generation{0};
+
+	UNIGINE_INLINE bool isNull() const { return index == -1; }
+	UNIGINE_INLINE bool operator==(const ComponentHandle &h) const { return index == h.index && generation == h.generation; }
+	UNIGINE_INLINE bool operator!=(const ComponentHandle &h) const { return !(*this == h); }
+};
+
+// true for classes that declare the COMPONENT macro themselves
+template <class C, class = void>
+struct HasComponentStorage : std::false_type {};
+
+template <class C>
+struct HasComponentStorage<C, typename std::enable_if<std::is_same<typename C::__this_class, C>::value>::type> : std::true_type {};
+
+// notified when components of the class are added or removed
+template <class C>
+class ComponentStorageListener
+{
+public:
+	virtual ~ComponentStorageListener() {}
+	virtual void componentAdded(C *component, int node_id, const ComponentHandle<C> &handle) = 0;
+	virtual void componentRemoved(C *component, int node_id, const ComponentHandle<C> &handle) = 0;
+};
+
+// node ID -> slot, slots are shared by all component classes
+class ComponentStorageNodes
+{
+public:
+	static ComponentStorageNodes &get()
+	{
+		static ComponentStorageNodes nodes;
+		return nodes;
+	}
+
+	// marks a parallel lookup phase, the node table must not change during it
+	class ScopedRead
+	{
+	public:
+		ScopedRead() { ComponentStorageNodes::get().readers.fetch_add(1, std::memory_order_relaxed); }
+		~ScopedRead() { ComponentStorageNodes::get().readers.fetch_sub(1, std::memory_order_relaxed); }
+		ScopedRead(const ScopedRead &) = delete;
+		ScopedRead &operator=(const ScopedRead &) = delete;
+	};
+
+	UNIGINE_INLINE bool isReading() const { return readers.load(std::memory_order_relaxed) != 0; }
+
+	UNIGINE_INLINE int find(int node_id) const { return slots.value(node_id, -1); }
+
+	int acquire(int node_id)
+	{
+		assert(!isReading() && "ComponentStorageNodes::acquire(): components are added during parallel lookups");
+		auto it = slots.find(node_id);
+		if (it != slots.end())
+		{
+			references[it->data]++;
+			return it->data;
+		}
+		int slot;
+		if (free_slots.size())
+		{
+			slot = free_slots.takeLast();
+			node_ids[slot] = node_id;
+			references[slot] = 1;
+		} else
+		{
+			slot = node_ids.size();
+			node_ids.append(node_id);
+			references.append(1);
+		}
+		slots.append(node_id, slot);
+		return slot;
+	}
+
+	void release(int slot)
+	{
+		assert(!isReading() && "ComponentStorageNodes::release(): components are removed during parallel lookups");
+		if (--references[slot] != 0)
+			return;
+		slots.remove(node_ids[slot]);
+		node_ids[slot] = -1;
+		free_slots.append(slot);
+	}
+
+	UNIGINE_INLINE int getNodeID(int slot) const { return node_ids[slot]; }
+	UNIGINE_INLINE int getNumSlots() const { return node_ids.size(); }
+	UNIGINE_INLINE int getNumNodes() const { return slots.size(); }
+
+private:
+	ComponentStorageNodes() = default;
+
+	HashMap<int, int> slots;
+	Vector<int> node_ids;
+	Vector<int> references; // number of registered components of all classes
+	Vector<int> free_slots;
+	std::atomic<int> readers{0};
+};
+
+template <class C>
+class ComponentStorage
+{
+public:
+	static ComponentStorage &get()
+	{
+		static ComponentStorage storage;
+		return storage;
+	}
+
+	ComponentHandle<C> add(C *component, int node_id)
+	{
+		assert(is_writer_thread() && "ComponentStorage::add(): components are added on the main thread only");
+		int slot = ComponentStorageNodes::get().acquire(node_id);
+		if (slot >= sparse.size())
+		{
+			int old_size = sparse.size();
+			sparse.resize(slot + 1);
+			for (int i = old_size; i < sparse.size(); i++)
+				sparse[i] = -1;
+		}
+
+		ComponentHandle<C> ret;
+		if (free_handles.size())
+			ret.index = free_handles.takeLast();
+		else
+		{
+			ret.index = handles.size();
+			handles.append().generation = 0;
+		}
+		ret.generation = handles[ret.index].generation;
+
+		int index = components.size();
+		components.append(component);
+		Entry &entry = entries.append();
+		entry.slot = slot;
+		entry.handle = ret.index;
+		entry.next = -1;
+		handles[ret.index].index = index;
+
+		// components of one node are chained in creation order
+		if (sparse[slot] == -1)
+			sparse[slot] = index;
+		else
+		{
+			int last = sparse[slot];
+			while (entries[last].next != -1)
+				last = entries[last].next;
+			entries[last].next = index;
+		}
+
+		revision++;
+		for (int i = 0; i < listeners.size(); i++)
+			listeners[i]->componentAdded(component, node_id, ret);
+		return ret;
+	}
+
+	void remove(const ComponentHandle<C> &handle)
+	{
+		assert(is_writer_thread() && "ComponentStorage::remove(): components are removed on the main thread only");
+		int index = get_index(handle);
+		assert(index != -1 && "ComponentStorage::remove(): bad handle");
+		int slot = entries[index].slot;
+
+		revision++;
+		if (listeners.size())
+		{
+			int node_id = ComponentStorageNodes::get().getNodeID(slot);
+			for (int i = 0; i < listeners.size(); i++)
+				listeners[i]->componentRemoved(components[index], node_id, handle);
+		}
+
+		unlink(index);
+		handles[handle.index].index = -1;
+		handles[handle.index].generation++;
+		free_handles.append(handle.index);
+
+		// swap-remove, the references to the last component are redirected
+		int last = components.size() - 1;
+		if (index != last)
+		{
+			relink(last, index);
+			components[index] = components[last];
+			entries[index] = entries[last];
+			handles[entries[index].handle].index = index;
+		}
+		components.removeLast();
+		entries.removeLast();
+
+		ComponentStorageNodes::get().release(slot);
+	}
+
+	// lookups
+	UNIGINE_INLINE C *get(const ComponentHandle<C> &handle) const
+	{
+		int index = get_index(handle);
+		return index != -1 ? components[index] : nullptr;
+	}
+
+	UNIGINE_INLINE C *getFirst(int node_id) const
+	{
+		int slot = ComponentStorageNodes::get().find(node_id);
+		if (slot == -1 || slot >= sparse.size() || sparse[slot] == -1)
+			return nullptr;
+		return components[sparse[slot]];
+	}
+
+	int getAll(int node_id, Vector<C *> &out) const
+	{
+		int slot = ComponentStorageNodes::get().find(node_id);
+		if (slot == -1 || slot >= sparse.size())
+			return 0;
+		int num = 0;
+		for (int i = sparse[slot]; i != -1; i = entries[i].next, num++)
+			out.append(components[i]);
+		return num;
+	}
+
+	// the num-th component of the node in creation order, nullptr if there is none
+	C *getNth(int node_id, int num) const
+	{
+		int slot = ComponentStorageNodes::get().find(node_id);
+		if (slot == -1 || slot >= sparse.size() || num < 0)
+			return nullptr;
+		int i = sparse[slot];
+		for (; i != -1 && num; i = entries[i].next)
+			num--;
+		return i != -1 ? components[i] : nullptr;
+	}
+
+	// all components of the class, the order changes on removal
+	UNIGINE_INLINE int size() const { return components.size(); }
+	UNIGINE_INLINE C *const *getComponents() const { return components.get(); }
+	UNIGINE_INLINE C *getComponent(int index) const { return components[index]; }
+	UNIGINE_INLINE ComponentHandle<C> getHandle(int index) const
+	{
+		ComponentHandle<C> ret;
+		ret.index = entries[index].handle;
+		ret.generation = handles[ret.index].generation;
+		return ret;
+	}
+	UNIGINE_INLINE int getNodeID(int index) const { return ComponentStorageNodes::get().getNodeID(entries[index].slot); }
+	// position among the components of the same node, stable on removal of other nodes' components
+	int getNodeIndex(int index) const
+	{
+		int num = 0;
+		for (int i = sparse[entries[index].slot]; i != index; i = entries[i].next)
+			num++;
+		return num;
+	}
+
+	// incremented on every add and remove
+	UNIGINE_INLINE unsigned int getRevision() const { return revision; }
+
+	// listeners
+	UNIGINE_INLINE void addListener(ComponentStorageListener<C> *listener)
+	{
+		assert(is_writer_thread() && "ComponentStorage::addListener(): listeners are changed on the main thread only");
+		listeners.append(listener);
+	}
+	UNIGINE_INLINE void removeListener(ComponentStorageListener<C> *listener)
+	{
+		assert(is_writer_thread() && "ComponentStorage::removeListener(): listeners are changed on the main thread only");
+		listeners.removeOne(listener);
+	}
+
+private:
+	struct Entry
+	{
+		int slot;	// node slot
+		int handle;	// index in the handle table
+		int next;	// next component of the same node
+	};
+
+	struct Handle
+	{
+		int index; // packed index, -1 for free handles
+		int generation;
+	};
+
+	ComponentStorage() = default;
+
+	// before the engine is created there is only one thread
+	static UNIGINE_INLINE bool is_writer_thread() { return Engine::get() == nullptr || Engine::get()->isMainThread(); }
+
+	UNIGINE_INLINE int get_index(const ComponentHandle<C> &handle) const
+	{
+		if (handle.index < 0 || handle.index >= handles.size())
+			return -1;
+		const Handle &h = handles[handle.index];
+		return h.generation == handle.generation ? h.index : -1;
+	}
+
+	// removes the component from its node chain
+	void unlink(int index)
+	{
+		int slot = entries[index].slot;
+		if (sparse[slot] == index)
+		{
+			sparse[slot] = entries[index].next;
+			return;
+		}
+		int prev = sparse[slot];
+		while (entries[prev].next != index)
+			prev = entries[prev].next;
+		entries[prev].next = entries[index].next;
+	}
+
+	// redirects the node chain reference from one packed index to another
+	void relink(int from, int to)
+	{
+		int slot = entries[from].slot;
+		if (sparse[slot] == from)
+		{
+			sparse[slot] = to;
+			return;
+		}
+		int prev = sparse[slot];
+		while (entries[prev].next != from)
+			prev = entries[prev].next;
+		entries[prev].next = to;
+	}
+
+	Vector<C *> components;		// packed
+	Vector<Entry> entries;		// parallel to components
+	Vector<int> sparse;			// node slot -> first packed index
+	Vector<Handle> handles;
+	Vector<int> free_handles;
+	Vector<ComponentStorageListener<C> *> listeners;
+	unsigned int revision{0};
+};
+
+// member of every class declared with the COMPONENT macro
+template <class C>
+class ComponentStorageRegistrator
+{
+public:
+	ComponentStorageRegistrator(C *component)
+	{
+		handle = ComponentStorage<C>::get().add(component, component->getNode()->getID());
+	}
+	~ComponentStorageRegistrator()
+	{
+		ComponentStorage<C>::get().remove(handle);
+	}
+	ComponentStorageRegistrator(const ComponentStorageRegistrator &) = delete;
+	ComponentStorageRegistrator &operator=(const ComponentStorageRegistrator &) = delete;
+
+	ComponentHandle<C> handle;
+};
+
+} // namespace Unigine
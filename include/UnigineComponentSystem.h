@@ -24,6 +24,7 @@
 #include "UnigineThread.h"
 #include "UnigineDir.h"
 #include "UnigineWorld.h"
+#include "UnigineComponentStorage.h"
 
 // Component example (.h file) 
 /*
@@ -92,7 +93,8 @@ class ComponentBase;
 		CLASS_NAME(const Unigine::NodePtr &node, int num) : PARENT_NAME(node, num) {}	\
 		virtual ~CLASS_NAME() {}														\
 		using __this_class = CLASS_NAME;												\
-		const char *getClassName() const override { return #CLASS_NAME; }
+		const char *getClassName() const override { return #CLASS_NAME; }				\
+		Unigine::ComponentStorageRegistrator<CLASS_NAME> __component_storage{ this };
 
 #define COMPONENT_DEFINE(CLASS_NAME, PARENT_NAME)\
 COMPONENT(CLASS_NAME, PARENT_NAME);\
@@ -120,19 +122,18 @@ PROP_NAME(#CLASS_NAME);
 	{																														\
 	public:																													\
 		Unigine::ComponentBase *component;																					\
-		Unigine::CallbackBase *func;																						\
+		Unigine::FunctionCallback<void()> func;																				\
 		Unigine::String name;																								\
 		ComponentMethodRegistrator_##NAME(T *c)																				\
 		{																													\
 			component = c;																									\
-			func = Unigine::MakeCallback(c, &T::NAME);																		\
+			func.func = [c]() { c->NAME(); };																				\
 			name = Unigine::String::format("%s::%s", c->getClassName(), #NAME);												\
-			Unigine::ComponentSystem::get()->addComponentMethod##TYPE(component, func, name.get(), #NAME, ##__VA_ARGS__);	\
+			Unigine::ComponentSystem::get()->addComponentMethod##TYPE(component, &func, name.get(), #NAME, ##__VA_ARGS__);	\
 		}																													\
 		~ComponentMethodRegistrator_##NAME()																				\
 		{																													\
-			Unigine::ComponentSystem::get()->removeComponentMethod##TYPE(component, func, name.get(), #NAME, ##__VA_ARGS__);\
-			delete func;																									\
+			Unigine::ComponentSystem::get()->removeComponentMethod##TYPE(component, &func, name.get(), #NAME, ##__VA_ARGS__);\
 		}																													\
 	};																														\
 	ComponentMethodRegistrator_##NAME<__this_class> __method_registrator_##NAME{ this };
@@ -255,6 +256,57 @@ private:
 #pragma region System
 #endif
 
+class ComponentSystem;
+
+// a method added through the Function overloads of ComponentSystem::addComponentMethod*(),
+// owns the callback and removes the method when it is destroyed or reset
+class ComponentMethod
+{
+public:
+	ComponentMethod() {}
+	ComponentMethod(ComponentMethod &&m) { swap(m); }
+	~ComponentMethod() { reset(); }
+
+	ComponentMethod &operator=(ComponentMethod &&m)
+	{
+		if (this != &m)
+		{
+			reset();
+			swap(m);
+		}
+		return *this;
+	}
+	ComponentMethod(const ComponentMethod &) = delete;
+	ComponentMethod &operator=(const ComponentMethod &) = delete;
+
+	UNIGINE_INLINE void reset();
+	UNIGINE_INLINE bool isValid() const { return callback != nullptr; }
+	UNIGINE_INLINE CallbackBase *getCallback() const { return callback; }
+
+private:
+	friend class ComponentSystem;
+	using RemoveFunc = void (ComponentSystem::*)(ComponentBase *, CallbackBase *, const char *, const char *, int, bool);
+
+	void swap(ComponentMethod &m)
+	{
+		std::swap(remove, m.remove);
+		std::swap(component, m.component);
+		std::swap(callback, m.callback);
+		name.swap(m.name);
+		func_name.swap(m.func_name);
+		std::swap(order, m.order);
+		std::swap(invoke_disabled, m.invoke_disabled);
+	}
+
+	RemoveFunc remove{nullptr};
+	ComponentBase *component{nullptr};
+	CallbackBase *callback{nullptr};
+	String name;
+	String func_name;
+	int order{0};
+	bool invoke_disabled{false};
+};
+
 class ComponentSystem : private WorldLogic
 {
 public:
@@ -325,20 +377,32 @@ public:
 	{
 		if (node.isDeleted())
 			return nullptr;
+		return get_component<C>(node->getID(), HasComponentStorage<C>());
+	}
 
-		auto it = components.find(node->getID());
-		if (it == components.end())
-			return nullptr;
+	// handles, only for classes declared with the COMPONENT macro
+	template <class C>
+	ComponentHandle<C> getComponentHandle(const C *component) const
+	{
+		static_assert(HasComponentStorage<C>::value, "ComponentSystem::getComponentHandle(): class has no component storage");
+		return component ? component->C::__component_storage.handle : ComponentHandle<C>();
+	}
 
-		String name = C::getPropertyName();
-		int count = it->data.size();
-		for (int i = 0; i < count; i++)
-		{
-			C *c = dynamic_cast<C*>(it->data[i]);
-			if (c)
-				return c;
-		}
-		return nullptr;
+	template <class C>
+	C *getComponent(const ComponentHandle<C> &handle) const
+	{
+		return ComponentStorage<C>::get().get(handle);
+	}
+
+	// all components of the class (including derived classes) in the world
+	template <class C>
+	void getComponents(Vector<C*> &out_components, int clear_vector = 1) const
+	{
+		static_assert(HasComponentStorage<C>::value, "ComponentSystem::getComponents(): class has no component storage");
+		if (clear_vector)
+			out_components.clear();
+		const ComponentStorage<C> &storage = ComponentStorage<C>::get();
+		out_components.append(storage.getComponents(), storage.size());
 	}
 
 	template <class C>
@@ -402,17 +466,7 @@ public:
 		if (node.isDeleted())
 			return;
 
-		auto it = components.find(node->getID());
-		if (it == components.end())
-			return;
-
-		int count = it->data.size();
-		for (int i = 0; i < count; i++)
-		{
-			C *c = dynamic_cast<C*>(it->data[i]);
-			if (c)
-				out_components.append(c);
-		}
+		get_components<C>(node->getID(), out_components, HasComponentStorage<C>());
 	}
 
 	template <class C>
@@ -463,7 +517,6 @@ public:
 		if (it == components.end())
 			return 0;
 
-		String name = C::getPropertyName();
 		int count = it->data.size();
 		for (int i = 0; i < count; i++)
 		{
@@ -492,11 +545,26 @@ public:
 	UNIGINE_INLINE int getWarningLevel() const { return warning_level; }
 
 	// method registators
+	// the Function overloads return a ComponentMethod, keep it while the method has to be called
 #define METHOD_REGISTRATOR(METHOD, METHOD_LOWCASE)																						\
 	UNIGINE_API void addComponentMethod##METHOD(ComponentBase *component,																\
 		CallbackBase *func, const char *name = nullptr, const char *func_name = nullptr, int order = 0, bool invoke_disabled = false);	\
 	UNIGINE_API void removeComponentMethod##METHOD(ComponentBase *component,															\
-		CallbackBase *func, const char *name = nullptr, const char *func_name = nullptr, int order = 0, bool invoke_disabled = false);
+		CallbackBase *func, const char *name = nullptr, const char *func_name = nullptr, int order = 0, bool invoke_disabled = false);	\
+	UNIGINE_INLINE ComponentMethod addComponentMethod##METHOD(ComponentBase *component,													\
+		Function<void()> &&func, const char *name = nullptr, const char *func_name = nullptr, int order = 0, bool invoke_disabled = false)\
+	{																																	\
+		ComponentMethod ret;																											\
+		ret.remove = &ComponentSystem::removeComponentMethod##METHOD;																	\
+		ret.component = component;																										\
+		ret.callback = new FunctionCallback<void()>(std::move(func));																	\
+		ret.name = name ? name : "";																									\
+		ret.func_name = func_name ? func_name : "";																						\
+		ret.order = order;																												\
+		ret.invoke_disabled = invoke_disabled;																							\
+		addComponentMethod##METHOD(component, ret.callback, name, func_name, order, invoke_disabled);									\
+		return ret;																														\
+	}
 	METHOD_REGISTRATOR(Init, init);
 	METHOD_REGISTRATOR(UpdateAsyncThread, updateAsyncThread);
 	METHOD_REGISTRATOR(UpdateSyncThread, updateSyncThread);
@@ -524,6 +592,52 @@ private:
 	ComponentSystem(ComponentSystem const&) = delete;
 	ComponentSystem& operator=(ComponentSystem const&) = delete;
 
+	// component lookups, the packed storage is used for classes declared with the COMPONENT macro
+	template <class C>
+	C *get_component(int node_id, std::true_type) const
+	{
+		return ComponentStorage<C>::get().getFirst(node_id);
+	}
+
+	template <class C>
+	C *get_component(int node_id, std::false_type) const
+	{
+		auto it = components.find(node_id);
+		if (it == components.end())
+			return nullptr;
+
+		int count = it->data.size();
+		for (int i = 0; i < count; i++)
+		{
+			C *c = dynamic_cast<C*>(it->data[i]);
+			if (c)
+				return c;
+		}
+		return nullptr;
+	}
+
+	template <class C>
+	void get_components(int node_id, Vector<C*> &out_components, std::true_type) const
+	{
+		ComponentStorage<C>::get().getAll(node_id, out_components);
+	}
+
+	template <class C>
+	void get_components(int node_id, Vector<C*> &out_components, std::false_type) const
+	{
+		auto it = components.find(node_id);
+		if (it == components.end())
+			return;
+
+		int count = it->data.size();
+		for (int i = 0; i < count; i++)
+		{
+			C *c = dynamic_cast<C*>(it->data[i]);
+			if (c)
+				out_components.append(c);
+		}
+	}
+
 	// call component methods
 	struct ComponentCallback;
 	UNIGINE_API void run_init_methods();
@@ -596,6 +710,16 @@ private:
 	Map<int, Vector<ComponentCallback>> component_functions_init_delayed;
 };
 
+UNIGINE_INLINE void ComponentMethod::reset()
+{
+	if (callback == nullptr)
+		return;
+	(ComponentSystem::get()->*remove)(component, callback, name.empty() ? nullptr : name.get(),
+		func_name.empty() ? nullptr : func_name.get(), order, invoke_disabled);
+	delete callback;
+	callback = nullptr;
+}
+
 #ifndef __GNUC__
 #pragma endregion System
 #endif
@@ -0,0 +1,743 @@
+/* Copyright (C) 2005-2020, UNIGINE. All rights reserved.
+ *
+ * This file is a part of the UNIGINE 2 SDK.
+ *
+ * Your use and / or redistribution of this software in source and / or
+ * binary form, with or without modification, is subject to: (i) your
+ * ongoing acceptance of and compliance with the terms and conditions of
+ * the UNIGINE License Agreement; and (ii) your inclusion of this notice
+ * in any version of this software that you use or redistribute.
+ * A copy of the UNIGINE License Agreement is available by contacting
+ * UNIGINE. at http://unigine.com/
+ */
+
+
+#pragma once
+
+#include "UnigineCompress.h"
+#include "UnigineStreams.h"
+#include "UnigineThread.h"
+#include "UnigineVector.h"
+#include "UnigineLog.h"
+
+// Compressed frame example
+/*
+	// save, blocks are compressed on PoolCPUShaders threads
+	Unigine::CompressFrameWriter writer;
+	writer.open(Unigine::File::create("replay.ucf", "wb"), Unigine::CompressFrame::METHOD_LZ4);
+	writer.write(data, size);
+	...
+	writer.finish();
+
+	// sequential load
+	Unigine::CompressFrameReader reader;
+	reader.open(Unigine::File::create("replay.ucf", "rb"));
+	while (size_t size = reader.read(buffer, sizeof(buffer)))
+		...
+
+	// random access, the stream must be a File or a Blob
+	reader.loadIndex();
+	Vector<unsigned char> block(reader.getBlockRawSize(42));
+	reader.readBlock(42, block.get());
+*/
+
+namespace Unigine
+{
+
+//////////////////////////////////////////////////////////////////////////
+/// Block compressed frame format.
+///
+/// The data is split into blocks compressed independently, so they are
+/// compressed and decompressed in parallel and any block can be
+/// decompressed alone. Blocks are written in order, followed by the block
+/// index and a fixed size footer, the writer never seeks and works over
+/// sockets. All integers are little-endian.
+///
+///   header   "UCF1", u8 version, u8 method, u16 0, u32 block size, u32 0
+///   block    u32 packed size (bit 31 set: stored uncompressed), u32 raw size, data
+///   end      u32 0, u32 0
+///   index    u64 offset, u32 packed size, u32 raw size per block
+///   footer   u64 index offset, u64 raw size, u32 number of blocks, "UCFI"
+//////////////////////////////////////////////////////////////////////////
+
+class CompressFrame
+{
+public:
+	enum METHOD
+	{
+		METHOD_LZ4 = 0,
+		METHOD_ZLIB,
+		NUM_METHODS,
+	};
+
+	enum
+	{
+		VERSION = 1,
+		HEADER_SIZE = 16,
+		BLOCK_HEADER_SIZE = 8,
+		INDEX_ENTRY_SIZE = 16,
+		FOOTER_SIZE = 24,
+		DEFAULT_BLOCK_SIZE = 1024 * 1024,
+		MIN_BLOCK_SIZE = 4 * 1024,
+		MAX_BLOCK_SIZE = 256 * 1024 * 1024,
+		MAX_BATCH_SIZE = 1024 * 1024 * 1024,	// raw bytes per batch, keeps the Vector buffers below 2 GB
+		STORED_FLAG = 0x80000000u,
+	};
+
+	struct Block
+	{
+		unsigned long long offset;	// of the block header in the stream
+		unsigned int packed_size;	// without the block header and STORED_FLAG
+		unsigned int raw_size;
+		int stored;
+	};
+
+	// compresses the buffer into the stream
+	static bool compress(const StreamPtr &dest, const void *src, size_t size, METHOD method = METHOD_LZ4,
+		bool quality = false, size_t block_size = DEFAULT_BLOCK_SIZE);
+	// decompresses the whole frame, returns the number of bytes written to dest
+	static size_t decompress(const StreamPtr &src, void *dest, size_t size);
+
+	static UNIGINE_INLINE size_t getBound(METHOD method, size_t size)
+	{
+		return method == METHOD_ZLIB ? Compress::zlibSize(size) : Compress::lz4Size(size);
+	}
+
+	static UNIGINE_INLINE int getNumThreads()
+	{
+		return PoolCPUShaders::isInitialized() ? PoolCPUShaders::getNumSyncThreads() : 1;
+	}
+
+	// blocks compressed or decompressed in parallel, two per thread within MAX_BATCH_SIZE
+	static UNIGINE_INLINE int getBatchBlocks(size_t block_size)
+	{
+		int num = getNumThreads() * 2;
+		int max_num = int(MAX_BATCH_SIZE / block_size);
+		return num < max_num ? num : max_num;
+	}
+
+	// little-endian integers
+	static UNIGINE_INLINE void setU32(unsigned char *d, unsigned int v)
+	{
+		for (int i = 0; i < 4; i++)
+			d[i] = (unsigned char)(v >> (i * 8));
+	}
+	static UNIGINE_INLINE void setU64(unsigned char *d, unsigned long long v)
+	{
+		for (int i = 0; i < 8; i++)
+			d[i] = (unsigned char)(v >> (i * 8));
+	}
+	static UNIGINE_INLINE unsigned int getU32(const unsigned char *s)
+	{
+		unsigned int ret = 0;
+		for (int i = 0; i < 4; i++)
+			ret |= (unsigned int)s[i] << (i * 8);
+		return ret;
+	}
+	static UNIGINE_INLINE unsigned long long getU64(const unsigned char *s)
+	{
+		unsigned long long ret = 0;
+		for (int i = 0; i < 8; i++)
+			ret |= (unsigned long long)s[i] << (i * 8);
+		return ret;
+	}
+
+	// compresses or decompresses the jobs on PoolCPUShaders threads
+	struct Job
+	{
+		const unsigned char *src;
+		unsigned char *dest;
+		size_t src_size;
+		size_t dest_size;	// capacity on input, result size on output
+		int stored;
+		int ok;
+	};
+
+	static void runJobs(Vector<Job> &jobs, METHOD method, bool quality, bool decompress)
+	{
+		JobShader shader(jobs, method, quality, decompress);
+		if (getNumThreads() > 1 && jobs.size() > 1)
+			shader.runSync();
+		else
+			shader.process(0, 1);
+	}
+
+private:
+	class JobShader : public CPUShader
+	{
+	public:
+		JobShader(Vector<Job> &jobs, METHOD method, bool quality, bool decompress)
+			: jobs(jobs), method(method), quality(quality), decompress(decompress) {}
+
+		void process(int thread_num, int threads_count) override
+		{
+			UNIGINE_UNUSED(thread_num);
+			UNIGINE_UNUSED(threads_count);
+			for (;;)
+			{
+				int i = AtomicAdd(&counter, 1);
+				if (i >= jobs.size())
+					break;
+				if (decompress)
+					run_decompress(jobs[i]);
+				else
+					run_compress(jobs[i]);
+			}
+		}
+
+	private:
+		void run_compress(Job &job)
+		{
+			size_t size = job.dest_size;
+			bool ret = method == METHOD_ZLIB
+				? Compress::zlibCompress(job.dest, size, job.src, job.src_size, quality)
+				: Compress::lz4Compress(job.dest, size, job.src, job.src_size, quality);
+			// incompressible blocks are stored
+			if (!ret || size >= job.src_size)
+			{
+				memcpy(job.dest, job.src, job.src_size);
+				size = job.src_size;
+				job.stored = 1;
+			} else
+				job.stored = 0;
+			job.dest_size = size;
+			job.ok = 1;
+		}
+
+		void run_decompress(Job &job)
+		{
+			if (job.stored)
+			{
+				job.ok = job.src_size == job.dest_size;
+				if (job.ok)
+					memcpy(job.dest, job.src, job.src_size);
+				return;
+			}
+			job.ok = method == METHOD_ZLIB
+				? Compress::zlibDecompress(job.dest, job.dest_size, job.src, job.src_size)
+				: Compress::lz4Decompress(job.dest, job.dest_size, job.src, job.src_size);
+		}
+
+		Vector<Job> &jobs;
+		METHOD method;
+		bool quality;
+		bool decompress;
+		volatile int counter{0};
+	};
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// Streaming frame compression.
+///
+/// Input is collected into a batch of two blocks per thread, the batch is
+/// compressed in parallel and written out in order, so the memory used does
+/// not depend on the data size. Writes of whole batches are compressed in
+/// place without copying.
+//////////////////////////////////////////////////////////////////////////
+
+class CompressFrameWriter
+{
+public:
+	CompressFrameWriter() {}
+	~CompressFrameWriter()
+	{
+		if (stream)
+			finish();
+	}
+
+	CompressFrameWriter(const CompressFrameWriter &) = delete;
+	CompressFrameWriter &operator=(const CompressFrameWriter &) = delete;
+
+	bool open(const StreamPtr &s, CompressFrame::METHOD m = CompressFrame::METHOD_LZ4, bool q = false,
+		size_t bs = CompressFrame::DEFAULT_BLOCK_SIZE)
+	{
+		if (stream)
+			finish();
+		if (!s || !s->isOpened())
+		{
+			Log::error("CompressFrameWriter::open(): stream is not opened\n");
+			return false;
+		}
+
+		stream = s;
+		method = m;
+		quality = q;
+		block_size = bs < CompressFrame::MIN_BLOCK_SIZE ? size_t(CompressFrame::MIN_BLOCK_SIZE) :
+			(bs > CompressFrame::MAX_BLOCK_SIZE ? size_t(CompressFrame::MAX_BLOCK_SIZE) : bs);
+		batch_blocks = CompressFrame::getBatchBlocks(block_size);
+		raw_size = 0;
+		offset = 0;
+		failed = 0;
+		input_size = 0;
+		blocks.clear();
+
+		unsigned char header[CompressFrame::HEADER_SIZE] = {'U', 'C', 'F', '1', CompressFrame::VERSION, (unsigned char)method};
+		CompressFrame::setU32(header + 8, (unsigned int)block_size);
+		return write_data(header, CompressFrame::HEADER_SIZE);
+	}
+
+	bool write(const void *data, size_t size)
+	{
+		if (!stream || failed)
+			return false;
+
+		const unsigned char *src = static_cast<const unsigned char *>(data);
+		size_t batch_size = block_size * batch_blocks;
+		while (size)
+		{
+			// whole batches are compressed from the source
+			if (input_size == 0 && size >= batch_size)
+			{
+				if (!flush(src, batch_size))
+					return false;
+				src += batch_size;
+				size -= batch_size;
+				continue;
+			}
+
+			if (input.size() < int(batch_size))
+				input.resize(int(batch_size));
+			size_t num = batch_size - input_size;
+			if (num > size)
+				num = size;
+			memcpy(input.get() + input_size, src, num);
+			input_size += num;
+			src += num;
+			size -= num;
+
+			if (input_size == batch_size)
+			{
+				input_size = 0;
+				if (!flush(input.get(), batch_size))
+					return false;
+			}
+		}
+		return true;
+	}
+
+	// writes the remaining data, the index and the footer, the stream is released
+	bool finish()
+	{
+		if (!stream)
+			return false;
+
+		if (input_size && !failed)
+			flush(input.get(), input_size);
+		input_size = 0;
+
+		unsigned char end[CompressFrame::BLOCK_HEADER_SIZE] = {};
+		write_data(end, sizeof(end));
+
+		unsigned long long index_offset = offset;
+		Vector<unsigned char> index;
+		index.resize(blocks.size() * CompressFrame::INDEX_ENTRY_SIZE);
+		for (int i = 0; i < blocks.size(); i++)
+		{
+			unsigned char *d = index.get() + i * CompressFrame::INDEX_ENTRY_SIZE;
+			const CompressFrame::Block &b = blocks[i];
+			CompressFrame::setU64(d, b.offset);
+			CompressFrame::setU32(d + 8, b.packed_size | (b.stored ? (unsigned int)CompressFrame::STORED_FLAG : 0u));
+			CompressFrame::setU32(d + 12, b.raw_size);
+		}
+		if (index.size())
+			write_data(index.get(), index.size());
+
+		unsigned char footer[CompressFrame::FOOTER_SIZE] = {};
+		CompressFrame::setU64(footer, index_offset);
+		CompressFrame::setU64(footer + 8, raw_size);
+		CompressFrame::setU32(footer + 16, (unsigned int)blocks.size());
+		memcpy(footer + 20, "UCFI", 4);
+		write_data(footer, CompressFrame::FOOTER_SIZE);
+
+		bool ret = !failed;
+		stream.clear();
+		input.destroy();
+		output.destroy();
+		jobs.destroy();
+		return ret;
+	}
+
+	UNIGINE_INLINE bool isOpened() const { return stream.isValid(); }
+	UNIGINE_INLINE size_t getRawSize() const { return size_t(raw_size); }
+	UNIGINE_INLINE size_t getCompressedSize() const { return size_t(offset); }
+	UNIGINE_INLINE int getNumBlocks() const { return blocks.size(); }
+
+private:
+	bool write_data(const void *data, size_t size)
+	{
+		if (failed)
+			return false;
+		if (stream->write(data, size) != size)
+		{
+			Log::error("CompressFrameWriter::write(): can't write %llu bytes\n", (unsigned long long)size);
+			failed = 1;
+			return false;
+		}
+		offset += size;
+		return true;
+	}
+
+	bool flush(const unsigned char *src, size_t size)
+	{
+		int num = int((size + block_size - 1) / block_size);
+		size_t bound = CompressFrame::getBound(method, block_size);
+		if (output.size() < int(bound * num))
+			output.resize(int(bound * num));
+
+		jobs.resize(num);
+		for (int i = 0; i < num; i++)
+		{
+			CompressFrame::Job &job = jobs[i];
+			job.src = src + block_size * i;
+			job.src_size = i == num - 1 ? size - block_size * i : block_size;
+			job.dest = output.get() + bound * i;
+			job.dest_size = bound;
+			job.stored = 0;
+			job.ok = 0;
+		}
+		CompressFrame::runJobs(jobs, method, quality, false);
+
+		for (int i = 0; i < num; i++)
+		{
+			const CompressFrame::Job &job = jobs[i];
+			CompressFrame::Block &b = blocks.append();
+			b.offset = offset;
+			b.packed_size = (unsigned int)job.dest_size;
+			b.raw_size = (unsigned int)job.src_size;
+			b.stored = job.stored;
+
+			unsigned char header[CompressFrame::BLOCK_HEADER_SIZE];
+			CompressFrame::setU32(header, b.packed_size | (b.stored ? (unsigned int)CompressFrame::STORED_FLAG : 0u));
+			CompressFrame::setU32(header + 4, b.raw_size);
+			if (!write_data(header, sizeof(header)) || !write_data(job.dest, job.dest_size))
+				return false;
+			raw_size += job.src_size;
+		}
+		return true;
+	}
+
+	StreamPtr stream;
+	CompressFrame::METHOD method{CompressFrame::METHOD_LZ4};
+	bool quality{false};
+	size_t block_size{CompressFrame::DEFAULT_BLOCK_SIZE};
+	int batch_blocks{2};
+	int failed{0};
+
+	unsigned long long raw_size{0};
+	unsigned long long offset{0};
+
+	Vector<unsigned char> input;
+	size_t input_size{0};
+	Vector<unsigned char> output;
+	Vector<CompressFrame::Job> jobs;
+	Vector<CompressFrame::Block> blocks;
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// Streaming frame decompression.
+///
+/// read() decompresses a batch of blocks in parallel and serves the data
+/// from it. Random access through the block index needs a File or a Blob
+/// stream, the stream position is changed by loadIndex() and readBlock().
+//////////////////////////////////////////////////////////////////////////
+
+class CompressFrameReader
+{
+public:
+	CompressFrameReader() {}
+
+	CompressFrameReader(const CompressFrameReader &) = delete;
+	CompressFrameReader &operator=(const CompressFrameReader &) = delete;
+
+	bool open(const StreamPtr &s)
+	{
+		close();
+		if (!s || !s->isOpened())
+		{
+			Log::error("CompressFrameReader::open(): stream is not opened\n");
+			return false;
+		}
+
+		unsigned char header[CompressFrame::HEADER_SIZE];
+		if (s->read(header, CompressFrame::HEADER_SIZE) != CompressFrame::HEADER_SIZE ||
+			memcmp(header, "UCF1", 4) != 0 || header[4] != CompressFrame::VERSION || header[5] >= CompressFrame::NUM_METHODS ||
+			CompressFrame::getU32(header + 8) < CompressFrame::MIN_BLOCK_SIZE || CompressFrame::getU32(header + 8) > CompressFrame::MAX_BLOCK_SIZE)
+		{
+			Log::error("CompressFrameReader::open(): bad frame header\n");
+			return false;
+		}
+
+		stream = s;
+		method = CompressFrame::METHOD(header[5]);
+		block_size = CompressFrame::getU32(header + 8);
+		batch_blocks = CompressFrame::getBatchBlocks(block_size);
+		return true;
+	}
+
+	void close()
+	{
+		stream.clear();
+		end = 0;
+		failed = 0;
+		output_size = 0;
+		output_position = 0;
+		blocks.clear();
+		raw_size = 0;
+	}
+
+	// sequential decompression, returns the number of bytes read
+	size_t read(void *data, size_t size)
+	{
+		unsigned char *dest = static_cast<unsigned char *>(data);
+		size_t ret = 0;
+		while (size)
+		{
+			if (output_position == output_size)
+			{
+				if (!stream || end || failed || !read_batch())
+					break;
+			}
+			size_t num = output_size - output_position;
+			if (num > size)
+				num = size;
+			memcpy(dest, output.get() + output_position, num);
+			output_position += num;
+			dest += num;
+			size -= num;
+			ret += num;
+		}
+		return ret;
+	}
+
+	UNIGINE_INLINE bool isOpened() const { return stream.isValid(); }
+	UNIGINE_INLINE bool isEnd() const { return end && output_position == output_size; }
+	UNIGINE_INLINE bool isFailed() const { return failed != 0; }
+	UNIGINE_INLINE CompressFrame::METHOD getMethod() const { return method; }
+	UNIGINE_INLINE size_t getBlockSize() const { return block_size; }
+
+	// random access
+	bool loadIndex()
+	{
+		if (!stream)
+			return false;
+		size_t size = get_stream_size();
+		unsigned char footer[CompressFrame::FOOTER_SIZE];
+		if (size < CompressFrame::HEADER_SIZE + CompressFrame::FOOTER_SIZE || !seek(size - CompressFrame::FOOTER_SIZE) ||
+			stream->read(footer, CompressFrame::FOOTER_SIZE) != CompressFrame::FOOTER_SIZE || memcmp(footer + 20, "UCFI", 4) != 0)
+		{
+			Log::error("CompressFrameReader::loadIndex(): the stream is not seekable or the frame is not finished\n");
+			return false;
+		}
+
+		unsigned long long index_offset = CompressFrame::getU64(footer);
+		unsigned int num = CompressFrame::getU32(footer + 16);
+		if (num > (size - CompressFrame::HEADER_SIZE - CompressFrame::FOOTER_SIZE) / CompressFrame::INDEX_ENTRY_SIZE)
+		{
+			Log::error("CompressFrameReader::loadIndex(): bad block index\n");
+			return false;
+		}
+		Vector<unsigned char> index;
+		index.resize(int(num * CompressFrame::INDEX_ENTRY_SIZE));
+		if (index_offset + index.size() + CompressFrame::FOOTER_SIZE != size || !seek(size_t(index_offset)) ||
+			stream->read(index.get(), index.size()) != size_t(index.size()))
+		{
+			Log::error("CompressFrameReader::loadIndex(): bad block index\n");
+			return false;
+		}
+
+		blocks.resize(int(num));
+		raw_offsets.resize(int(num) + 1);
+		raw_offsets[0] = 0;
+		for (int i = 0; i < blocks.size(); i++)
+		{
+			const unsigned char *s = index.get() + i * CompressFrame::INDEX_ENTRY_SIZE;
+			CompressFrame::Block &b = blocks[i];
+			b.offset = CompressFrame::getU64(s);
+			unsigned int packed = CompressFrame::getU32(s + 8);
+			b.packed_size = packed & ~CompressFrame::STORED_FLAG;
+			b.stored = (packed & CompressFrame::STORED_FLAG) != 0;
+			b.raw_size = CompressFrame::getU32(s + 12);
+			if (b.raw_size > block_size || b.packed_size > CompressFrame::getBound(method, block_size))
+			{
+				Log::error("CompressFrameReader::loadIndex(): bad block index\n");
+				blocks.clear();
+				return false;
+			}
+			raw_offsets[i + 1] = raw_offsets[i] + b.raw_size;
+		}
+		raw_size = CompressFrame::getU64(footer + 8);
+		return true;
+	}
+
+	UNIGINE_INLINE int getNumBlocks() const { return blocks.size(); }
+	UNIGINE_INLINE size_t getBlockRawSize(int block) const { return blocks[block].raw_size; }
+	UNIGINE_INLINE size_t getBlockRawOffset(int block) const { return size_t(raw_offsets[block]); }
+	UNIGINE_INLINE size_t getRawSize() const { return size_t(raw_size); }
+
+	// the block containing the uncompressed offset
+	int findBlock(size_t raw_offset) const
+	{
+		int left = 0;
+		int right = blocks.size();
+		while (left < right)
+		{
+			int middle = (left + right) / 2;
+			if (raw_offsets[middle + 1] <= raw_offset)
+				left = middle + 1;
+			else
+				right = middle;
+		}
+		return left < blocks.size() ? left : -1;
+	}
+
+	// dest must hold getBlockRawSize() bytes, loadIndex() must be called first
+	bool readBlock(int block, void *dest)
+	{
+		assert(block >= 0 && block < blocks.size() && "CompressFrameReader::readBlock(): bad block");
+		const CompressFrame::Block &b = blocks[block];
+		packed.resize(int(b.packed_size));
+		if (!seek(size_t(b.offset + CompressFrame::BLOCK_HEADER_SIZE)) || stream->read(packed.get(), b.packed_size) != b.packed_size)
+		{
+			Log::error("CompressFrameReader::readBlock(): can't read block %d\n", block);
+			return false;
+		}
+
+		jobs.resize(1);
+		CompressFrame::Job &job = jobs[0];
+		job.src = packed.get();
+		job.src_size = b.packed_size;
+		job.dest = static_cast<unsigned char *>(dest);
+		job.dest_size = b.raw_size;
+		job.stored = b.stored;
+		CompressFrame::runJobs(jobs, method, false, true);
+		if (!job.ok)
+			Log::error("CompressFrameReader::readBlock(): can't decompress block %d\n", block);
+		return job.ok != 0;
+	}
+
+private:
+	// reads up to batch_blocks blocks and decompresses them
+	bool read_batch()
+	{
+		packed.clear();
+		jobs.clear();
+		Vector<size_t> packed_offsets;
+		size_t raw = 0;
+
+		while (jobs.size() < batch_blocks)
+		{
+			unsigned char header[CompressFrame::BLOCK_HEADER_SIZE];
+			if (stream->read(header, sizeof(header)) != sizeof(header))
+				return fail("unexpected end of the stream");
+			unsigned int packed_size = CompressFrame::getU32(header);
+			unsigned int raw_size_block = CompressFrame::getU32(header + 4);
+			if (packed_size == 0 && raw_size_block == 0)
+			{
+				end = 1;
+				break;
+			}
+
+			unsigned int size = packed_size & ~CompressFrame::STORED_FLAG;
+			if (raw_size_block > block_size || size > CompressFrame::getBound(method, block_size))
+				return fail("bad block header");
+
+			size_t position = packed.size();
+			packed.resize(int(position + size));
+			if (stream->read(packed.get() + position, size) != size)
+				return fail("unexpected end of the stream");
+
+			CompressFrame::Job &job = jobs.append();
+			job.src_size = size;
+			job.dest_size = raw_size_block;
+			job.stored = (packed_size & CompressFrame::STORED_FLAG) != 0;
+			job.ok = 0;
+			packed_offsets.append(position);
+			raw += raw_size_block;
+		}
+
+		if (output.size() < int(raw))
+			output.resize(int(raw));
+		raw = 0;
+		for (int i = 0; i < jobs.size(); i++)
+		{
+			jobs[i].src = packed.get() + packed_offsets[i];
+			jobs[i].dest = output.get() + raw;
+			raw += jobs[i].dest_size;
+		}
+		CompressFrame::runJobs(jobs, method, false, true);
+		for (int i = 0; i < jobs.size(); i++)
+		{
+			if (!jobs[i].ok)
+				return fail("can't decompress a block");
+		}
+
+		output_size = raw;
+		output_position = 0;
+		return raw != 0;
+	}
+
+	bool fail(const char *error)
+	{
+		Log::error("CompressFrameReader::read(): %s\n", error);
+		failed = 1;
+		output_size = 0;
+		output_position = 0;
+		return false;
+	}
+
+	size_t get_stream_size() const
+	{
+		Stream *s = stream.get();
+		if (File::convertible(s))
+			return static_ptr_cast<File>(stream)->getSize();
+		if (Blob::convertible(s))
+			return static_ptr_cast<Blob>(stream)->getSize();
+		return 0;
+	}
+
+	bool seek(size_t position)
+	{
+		Stream *s = stream.get();
+		if (File::convertible(s))
+			return static_ptr_cast<File>(stream)->seekSet(position) != 0;
+		if (Blob::convertible(s))
+			return static_ptr_cast<Blob>(stream)->seekSet(position) != 0;
+		return false;
+	}
+
+	StreamPtr stream;
+	CompressFrame::METHOD method{CompressFrame::METHOD_LZ4};
+	size_t block_size{0};
+	int batch_blocks{2};
+	int end{0};
+	int failed{0};
+
+	Vector<unsigned char> packed;
+	Vector<unsigned char> output;
+	size_t output_size{0};
+	size_t output_position{0};
+	Vector<CompressFrame::Job> jobs;
+
+	Vector<CompressFrame::Block> blocks;
+	Vector<unsigned long long> raw_offsets;
+	unsigned long long raw_size{0};
+};
+
+inline bool CompressFrame::compress(const StreamPtr &dest, const void *src, size_t size, METHOD method, bool quality, size_t block_size)
+{
+	CompressFrameWriter writer;
+	if (!writer.open(dest, method, quality, block_size))
+		return false;
+	bool ret = writer.write(src, size);
+	return writer.finish() && ret;
+}
+
+inline size_t CompressFrame::decompress(const StreamPtr &src, void *dest, size_t size)
+{
+	CompressFrameReader reader;
+	if (!reader.open(src))
+		return 0;
+	return reader.read(dest, size);
+}
+
+} // namespace Unigine
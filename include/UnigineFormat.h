@@ -0,0 +1,1286 @@
+/* Copyright (C) 2005-2020, UNIGINE. All rights reserved.
+ *
+ * This file is a part of the UNIGINE 2 SDK.
+ *
+ * Your use and / or redistribution of this software in source and / or
+ * binary form, with or without modification, is subject to: (i) your
+ * ongoing acceptance of and compliance with the terms and conditions of
+ * the UNIGINE License Agreement; and (ii) your inclusion of this notice
+ * in any version of this software that you use or redistribute.
+ * A copy of the UNIGINE License Agreement is available by contacting
+ * UNIGINE. at http://unigine.com/
+ */
+
+
+#pragma once
+
+#include "UnigineBase.h"
+#include "UnigineString.h"
+#include "UnigineMathLib.h"
+#include "UnigineVector.h"
+#include "UnigineConsole.h"
+#include "UnigineCallback.h"
+#include "UnigineLog.h"
+
+#include <limits>
+#include <chrono>
+
+// Format example
+/*
+	char buffer[128];
+	Unigine::Format::print(buffer, sizeof(buffer), "{} tanks, {:.2} fps", num_tanks, fps);
+
+	Unigine::StringStack<> hud;
+	UNIGINE_FORMAT_ASSIGN(hud, "ammo: {:4}/{}", ammo, max_ammo); // argument count is checked at compile time
+*/
+
+// format strings with the argument count checked at compile time
+#define UNIGINE_FORMAT_PRINT(DEST, SIZE, FORMAT, ...) \
+	Unigine::Format::printChecked<Unigine::Format::countPlaceholders(FORMAT)>(DEST, SIZE, FORMAT, ##__VA_ARGS__)
+#define UNIGINE_FORMAT_APPEND(DEST, FORMAT, ...) \
+	Unigine::Format::appendChecked<Unigine::Format::countPlaceholders(FORMAT)>(DEST, FORMAT, ##__VA_ARGS__)
+#define UNIGINE_FORMAT_ASSIGN(DEST, FORMAT, ...) \
+	Unigine::Format::assignChecked<Unigine::Format::countPlaceholders(FORMAT)>(DEST, FORMAT, ##__VA_ARGS__)
+
+namespace Unigine
+{
+
+//////////////////////////////////////////////////////////////////////////
+/// Allocation-free formatting and number conversion.
+///
+/// Arguments are passed by type, not through varargs, and written into a
+/// caller-supplied buffer or String/StringStack. Placeholders are "{}" or
+/// "{:[<][0][width][.precision][x|X|e]}", "{{" and "}}" are escapes.
+/// Floating-point values are printed with the shortest representation
+/// that round-trips (Grisu3) unless a precision is given. Like JavaScript
+/// toFixed(), the precision applies to magnitudes below 1e21, larger ones
+/// keep the shortest exponent form so any result fits FLOAT_SIZE.
+//////////////////////////////////////////////////////////////////////////
+
+class Format
+{
+public:
+	enum
+	{
+		INT_SIZE = 24,		// enough for any 64-bit integer with a sign
+		FLOAT_SIZE = 64,	// enough for any float or double with precision <= MAX_PRECISION
+		MAX_PRECISION = 20,
+		STACK_SIZE = 256,	// String output is formatted on the stack first
+	};
+
+	//////////////////////////////////////////////////////////////////////////
+	// number to chars
+	// returns the number of written characters, no terminating zero is written
+	//////////////////////////////////////////////////////////////////////////
+
+	static UNIGINE_INLINE int utoa(char *dest, unsigned long long value)
+	{
+		char buffer[INT_SIZE];
+		char *end = buffer + INT_SIZE;
+		char *p = end;
+		const char *digits = get_digits();
+		while (value >= 0x100000000ULL)
+		{
+			unsigned int d = (unsigned int)(value % 100) * 2;
+			value /= 100;
+			*--p = digits[d + 1];
+			*--p = digits[d];
+		}
+		unsigned int v = (unsigned int)value;
+		while (v >= 100)
+		{
+			unsigned int d = (v % 100) * 2;
+			v /= 100;
+			*--p = digits[d + 1];
+			*--p = digits[d];
+		}
+		if (v >= 10)
+		{
+			*--p = digits[v * 2 + 1];
+			*--p = digits[v * 2];
+		} else
+			*--p = char('0' + v);
+		int length = int(end - p);
+		memcpy(dest, p, length);
+		return length;
+	}
+
+	static UNIGINE_INLINE int ltoa(char *dest, long long value)
+	{
+		if (value < 0)
+		{
+			*dest = '-';
+			return utoa(dest + 1, 0ULL - (unsigned long long)value) + 1;
+		}
+		return utoa(dest, (unsigned long long)value);
+	}
+
+	static UNIGINE_INLINE int itoa(char *dest, int value) { return ltoa(dest, value); }
+
+	static UNIGINE_INLINE int htoa(char *dest, unsigned long long value, bool upper = false)
+	{
+		const char *hex = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+		char buffer[INT_SIZE];
+		char *end = buffer + INT_SIZE;
+		char *p = end;
+		do
+		{
+			*--p = hex[value & 0x0f];
+			value >>= 4;
+		} while (value);
+		int length = int(end - p);
+		memcpy(dest, p, length);
+		return length;
+	}
+
+	// precision < 0 prints the shortest round-trip representation,
+	// otherwise fixed notation with the given number of fractional digits,
+	// values of 1e21 and above ignore the precision (1e21 -> "1e+21")
+	static int dtoa(char *dest, double value, int precision = -1)
+	{
+		char *p = dest;
+		if (handle_special(p, value))
+			return int(p - dest);
+
+		char digits[32];
+		int length = 0;
+		int exponent = 0;
+		if (value == 0.0)
+		{
+			digits[length++] = '0';
+		} else
+		{
+			DiyFp v(value);
+			if (!grisu3(v, DiyFp::getBoundaryPlus(v), DiyFp::getDoubleBoundaryMinus(value), digits, length, exponent))
+				shortest_digits(value, digits, length, exponent);
+		}
+		if (is_decimal_tie(digits, length, exponent, precision))
+			return int(p - dest) + snprintf(p, FLOAT_SIZE - 1, "%.*f", precision, value);
+		return int(p - dest) + write_decimal(p, digits, length, exponent, precision);
+	}
+
+	static int ftoa(char *dest, float value, int precision = -1)
+	{
+		char *p = dest;
+		if (handle_special(p, value))
+			return int(p - dest);
+
+		char digits[32];
+		int length = 0;
+		int exponent = 0;
+		if (value == 0.0f)
+		{
+			digits[length++] = '0';
+		} else
+		{
+			DiyFp v(value);
+			if (!grisu3(v, DiyFp::getBoundaryPlus(v), DiyFp::getFloatBoundaryMinus(value), digits, length, exponent))
+				shortest_digits(value, digits, length, exponent);
+		}
+		if (is_decimal_tie(digits, length, exponent, precision))
+			return int(p - dest) + snprintf(p, FLOAT_SIZE - 1, "%.*f", precision, double(value));
+		return int(p - dest) + write_decimal(p, digits, length, exponent, precision);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// chars to number
+	// returns the number of consumed characters, 0 on error (value is untouched)
+	// size -1 means a zero-terminated string
+	//////////////////////////////////////////////////////////////////////////
+
+	static int atol(const char *str, long long &value, int size = -1)
+	{
+		const char *p = str;
+		const char *end = size < 0 ? nullptr : str + size;
+		while (has_char(p, end) && is_space(*p))
+			p++;
+		bool negative = false;
+		if (has_char(p, end) && (*p == '-' || *p == '+'))
+			negative = (*p++ == '-');
+		unsigned long long ret = 0;
+		const char *digits = p;
+		while (has_char(p, end) && *p >= '0' && *p <= '9')
+		{
+			unsigned int d = unsigned(*p++ - '0');
+			if (ret > (ULLONG_MAX - d) / 10)
+				return 0;
+			ret = ret * 10 + d;
+		}
+		if (p == digits)
+			return 0;
+		if (negative ? ret > 0x8000000000000000ULL : ret > 0x7fffffffffffffffULL)
+			return 0;
+		value = negative ? (long long)(0ULL - ret) : (long long)ret;
+		return int(p - str);
+	}
+
+	static int atoi(const char *str, int &value, int size = -1)
+	{
+		long long ret = 0;
+		int length = atol(str, ret, size);
+		if (length == 0 || ret < INT_MIN || ret > INT_MAX)
+			return 0;
+		value = int(ret);
+		return length;
+	}
+
+	static int atod(const char *str, double &value, int size = -1) { return parse_float(str, value, size); }
+	static int atof(const char *str, float &value, int size = -1) { return parse_float(str, value, size); }
+
+	//////////////////////////////////////////////////////////////////////////
+	// formatting
+	//////////////////////////////////////////////////////////////////////////
+
+	// formats into a buffer of the given size, the result is always zero-terminated
+	// returns the length of the full result like snprintf(), which may exceed size - 1
+	template <typename ... Args>
+	static int print(char *dest, int size, const char *format, const Args & ... args)
+	{
+		const Arg list[sizeof...(Args) + 1] = { make_arg(args)..., Arg() };
+		Writer writer(dest, size > 0 ? size - 1 : 0);
+		vformat(writer, format, list, int(sizeof...(Args)));
+		if (size > 0)
+			dest[writer.length < size ? writer.length : size - 1] = '\0';
+		return writer.length;
+	}
+
+	// appends to a String or StringStack, allocates only when the string capacity is exceeded
+	template <typename ... Args>
+	static String &append(String &dest, const char *format, const Args & ... args)
+	{
+		const Arg list[sizeof...(Args) + 1] = { make_arg(args)..., Arg() };
+		char buffer[STACK_SIZE];
+		Writer writer(buffer, STACK_SIZE);
+		vformat(writer, format, list, int(sizeof...(Args)));
+		if (writer.length <= STACK_SIZE)
+			return dest.append(buffer, writer.length);
+
+		// too long for the stack, format again in place
+		int pos = dest.size();
+		dest.resize(pos + writer.length);
+		Writer direct(&dest[pos], writer.length);
+		vformat(direct, format, list, int(sizeof...(Args)));
+		return dest;
+	}
+
+	template <typename ... Args>
+	static String &assign(String &dest, const char *format, const Args & ... args)
+	{
+		dest.clear();
+		return append(dest, format, args...);
+	}
+
+	// compile-time checked versions, use UNIGINE_FORMAT_* macros
+	template <int Placeholders, typename ... Args>
+	static UNIGINE_INLINE int printChecked(char *dest, int size, const char *format, const Args & ... args)
+	{
+		static_assert(Placeholders >= 0, "Format: malformed format string");
+		static_assert(Placeholders == sizeof...(Args), "Format: the number of arguments does not match the format string");
+		return print(dest, size, format, args...);
+	}
+
+	template <int Placeholders, typename ... Args>
+	static UNIGINE_INLINE String &appendChecked(String &dest, const char *format, const Args & ... args)
+	{
+		static_assert(Placeholders >= 0, "Format: malformed format string");
+		static_assert(Placeholders == sizeof...(Args), "Format: the number of arguments does not match the format string");
+		return append(dest, format, args...);
+	}
+
+	template <int Placeholders, typename ... Args>
+	static UNIGINE_INLINE String &assignChecked(String &dest, const char *format, const Args & ... args)
+	{
+		static_assert(Placeholders >= 0, "Format: malformed format string");
+		static_assert(Placeholders == sizeof...(Args), "Format: the number of arguments does not match the format string");
+		return assign(dest, format, args...);
+	}
+
+	// number of placeholders in a format string, -1 if it is malformed
+	static constexpr int countPlaceholders(const char *format, int count = 0)
+	{
+		return *format == '\0' ? count :
+			(*format == '{' && format[1] == '{') || (*format == '}' && format[1] == '}') ? countPlaceholders(format + 2, count) :
+			*format == '}' ? -1 :
+			*format == '{' ? (is_closed(format + 1) ? countPlaceholders(skip_placeholder(format + 1), count + 1) : -1) :
+			countPlaceholders(format + 1, count);
+	}
+
+	// Format against the String and C library conversions
+	static void getBenchmarkReport(String &ret, int num = 100000);
+	// appends the best throughput of the runs in MB/s, "failed" when any run returns false
+	static void appendThroughput(String &ret, const char *name, size_t size, int runs, const Function<bool()> &func);
+
+	static void addConsoleCommands()
+	{
+		Console::addCommand("format_benchmark", "prints the Format, String and snprintf conversion times", MakeCallback(&Format::console_benchmark));
+	}
+	static void removeConsoleCommands() { Console::removeCommand("format_benchmark"); }
+
+private:
+	static constexpr bool is_closed(const char *s)
+	{
+		return *s == '\0' || *s == '{' ? false : (*s == '}' ? true : is_closed(s + 1));
+	}
+
+	static constexpr const char *skip_placeholder(const char *s)
+	{
+		return *s == '}' ? s + 1 : skip_placeholder(s + 1);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// type-erased arguments
+	//////////////////////////////////////////////////////////////////////////
+
+	struct Arg
+	{
+		enum TYPE
+		{
+			NONE,
+			BOOL,
+			CHAR,
+			INT,
+			UINT,
+			FLOAT,
+			DOUBLE,
+			STRING,
+			POINTER,
+			VEC,
+			DVEC,
+		};
+
+		UNIGINE_INLINE Arg() : type(NONE), size(0) { i = 0; }
+
+		TYPE type;
+		int size; // string length or number of vector components
+		union
+		{
+			long long i;
+			unsigned long long u;
+			double d;
+			const char *s;
+			const void *p;
+			const float *v;
+			const double *dv;
+		};
+	};
+
+	static UNIGINE_INLINE Arg make_arg(bool v) { Arg a; a.type = Arg::BOOL; a.i = v; return a; }
+	static UNIGINE_INLINE Arg make_arg(char v) { Arg a; a.type = Arg::CHAR; a.i = v; return a; }
+	static UNIGINE_INLINE Arg make_arg(signed char v) { Arg a; a.type = Arg::INT; a.i = v; return a; }
+	static UNIGINE_INLINE Arg make_arg(unsigned char v) { Arg a; a.type = Arg::UINT; a.u = v; return a; }
+	static UNIGINE_INLINE Arg make_arg(short v) { Arg a; a.type = Arg::INT; a.i = v; return a; }
+	static UNIGINE_INLINE Arg make_arg(unsigned short v) { Arg a; a.type = Arg::UINT; a.u = v; return a; }
+	static UNIGINE_INLINE Arg make_arg(int v) { Arg a; a.type = Arg::INT; a.i = v; return a; }
+	static UNIGINE_INLINE Arg make_arg(unsigned int v) { Arg a; a.type = Arg::UINT; a.u = v; return a; }
+	static UNIGINE_INLINE Arg make_arg(long v) { Arg a; a.type = Arg::INT; a.i = v; return a; }
+	static UNIGINE_INLINE Arg make_arg(unsigned long v) { Arg a; a.type = Arg::UINT; a.u = v; return a; }
+	static UNIGINE_INLINE Arg make_arg(long long v) { Arg a; a.type = Arg::INT; a.i = v; return a; }
+	static UNIGINE_INLINE Arg make_arg(unsigned long long v) { Arg a; a.type = Arg::UINT; a.u = v; return a; }
+	static UNIGINE_INLINE Arg make_arg(float v) { Arg a; a.type = Arg::FLOAT; a.d = v; return a; }
+	static UNIGINE_INLINE Arg make_arg(double v) { Arg a; a.type = Arg::DOUBLE; a.d = v; return a; }
+	static UNIGINE_INLINE Arg make_arg(const char *v) { Arg a; a.type = Arg::STRING; a.s = v ? v : "(null)"; a.size = int(strlen(a.s)); return a; }
+	static UNIGINE_INLINE Arg make_arg(const String &v) { Arg a; a.type = Arg::STRING; a.s = v.get(); a.size = v.size(); return a; }
+	static UNIGINE_INLINE Arg make_arg(const void *v) { Arg a; a.type = Arg::POINTER; a.p = v; return a; }
+	static UNIGINE_INLINE Arg make_arg(const Math::vec2 &v) { Arg a; a.type = Arg::VEC; a.v = &v.x; a.size = 2; return a; }
+	static UNIGINE_INLINE Arg make_arg(const Math::vec3 &v) { Arg a; a.type = Arg::VEC; a.v = &v.x; a.size = 3; return a; }
+	static UNIGINE_INLINE Arg make_arg(const Math::vec4 &v) { Arg a; a.type = Arg::VEC; a.v = &v.x; a.size = 4; return a; }
+	static UNIGINE_INLINE Arg make_arg(const Math::dvec3 &v) { Arg a; a.type = Arg::DVEC; a.dv = &v.x; a.size = 3; return a; }
+	static UNIGINE_INLINE Arg make_arg(const Math::dvec4 &v) { Arg a; a.type = Arg::DVEC; a.dv = &v.x; a.size = 4; return a; }
+
+	//////////////////////////////////////////////////////////////////////////
+	// output
+	//////////////////////////////////////////////////////////////////////////
+
+	// counts the full length, but never writes past the capacity
+	struct Writer
+	{
+		UNIGINE_INLINE Writer(char *d, int c) : data(d), capacity(c), length(0) {}
+
+		UNIGINE_INLINE void put(char c)
+		{
+			if (length < capacity)
+				data[length] = c;
+			length++;
+		}
+
+		UNIGINE_INLINE void put(const char *s, int size)
+		{
+			if (length < capacity)
+			{
+				int n = capacity - length;
+				memcpy(data + length, s, size < n ? size : n);
+			}
+			length += size;
+		}
+
+		UNIGINE_INLINE void fill(char c, int size)
+		{
+			for (int i = 0; i < size; i++)
+				put(c);
+		}
+
+		char *data;
+		int capacity;
+		int length;
+	};
+
+	struct Spec
+	{
+		int width;
+		int precision;
+		bool left;
+		bool zero;
+		char type;
+	};
+
+	static const char *parse_spec(const char *s, Spec &spec)
+	{
+		spec.width = 0;
+		spec.precision = -1;
+		spec.left = false;
+		spec.zero = false;
+		spec.type = 0;
+		if (*s == ':')
+		{
+			s++;
+			if (*s == '<')
+			{
+				spec.left = true;
+				s++;
+			} else if (*s == '>')
+				s++;
+			if (*s == '0')
+			{
+				spec.zero = true;
+				s++;
+			}
+			while (*s >= '0' && *s <= '9')
+				spec.width = spec.width * 10 + (*s++ - '0');
+			if (*s == '.')
+			{
+				s++;
+				spec.precision = 0;
+				while (*s >= '0' && *s <= '9')
+					spec.precision = spec.precision * 10 + (*s++ - '0');
+				if (spec.precision > MAX_PRECISION)
+					spec.precision = MAX_PRECISION;
+			}
+			if (*s && *s != '}')
+				spec.type = *s++;
+		}
+		while (*s && *s != '}')
+			s++;
+		return *s == '}' ? s + 1 : s;
+	}
+
+	static void write_padded(Writer &writer, const Spec &spec, const char *s, int size, bool numeric)
+	{
+		int pad = spec.width - size;
+		if (pad <= 0)
+		{
+			writer.put(s, size);
+			return;
+		}
+		if (spec.left)
+		{
+			writer.put(s, size);
+			writer.fill(' ', pad);
+		} else if (spec.zero && numeric)
+		{
+			// zeros go after the sign
+			if (size && (*s == '-' || *s == '+'))
+			{
+				writer.put(*s++);
+				size--;
+			}
+			writer.fill('0', pad);
+			writer.put(s, size);
+		} else
+		{
+			writer.fill(' ', pad);
+			writer.put(s, size);
+		}
+	}
+
+	static int write_double(char *dest, double value, const Spec &spec, bool is_float)
+	{
+		if (spec.type == 'e' || spec.type == 'E')
+		{
+			// scientific notation is delegated, it is rarely used in hot paths
+			char format[16];
+			int length = 0;
+			format[length++] = '%';
+			format[length++] = '.';
+			length += itoa(format + length, spec.precision < 0 ? 6 : spec.precision);
+			format[length++] = spec.type;
+			format[length] = '\0';
+			int ret = snprintf(dest, FLOAT_SIZE, format, value);
+			return ret < FLOAT_SIZE ? ret : FLOAT_SIZE - 1;
+		}
+		return is_float ? ftoa(dest, float(value), spec.precision) : dtoa(dest, value, spec.precision);
+	}
+
+	static void write_arg(Writer &writer, const Arg &arg, const Spec &spec)
+	{
+		char buffer[FLOAT_SIZE];
+		int length = 0;
+		switch (arg.type)
+		{
+			case Arg::NONE: writer.put("{?}", 3); return;
+			case Arg::BOOL:
+				if (arg.i)
+					write_padded(writer, spec, "true", 4, false);
+				else
+					write_padded(writer, spec, "false", 5, false);
+				return;
+			case Arg::CHAR:
+				buffer[0] = char(arg.i);
+				write_padded(writer, spec, buffer, 1, false);
+				return;
+			case Arg::INT:
+				if (spec.type == 'x' || spec.type == 'X')
+					length = htoa(buffer, arg.u, spec.type == 'X');
+				else
+					length = ltoa(buffer, arg.i);
+				write_padded(writer, spec, buffer, length, true);
+				return;
+			case Arg::UINT:
+				if (spec.type == 'x' || spec.type == 'X')
+					length = htoa(buffer, arg.u, spec.type == 'X');
+				else
+					length = utoa(buffer, arg.u);
+				write_padded(writer, spec, buffer, length, true);
+				return;
+			case Arg::FLOAT:
+			case Arg::DOUBLE:
+				length = write_double(buffer, arg.d, spec, arg.type == Arg::FLOAT);
+				write_padded(writer, spec, buffer, length, true);
+				return;
+			case Arg::STRING:
+				length = arg.size;
+				if (spec.precision >= 0 && spec.precision < length)
+					length = spec.precision;
+				write_padded(writer, spec, arg.s, length, false);
+				return;
+			case Arg::POINTER:
+				buffer[0] = '0';
+				buffer[1] = 'x';
+				length = htoa(buffer + 2, (unsigned long long)(uintptr_t)arg.p) + 2;
+				write_padded(writer, spec, buffer, length, false);
+				return;
+			case Arg::VEC:
+			case Arg::DVEC:
+				// components are separated by spaces, the width applies to each of them
+				for (int i = 0; i < arg.size; i++)
+				{
+					if (i)
+						writer.put(' ');
+					if (arg.type == Arg::VEC)
+						length = write_double(buffer, arg.v[i], spec, true);
+					else
+						length = write_double(buffer, arg.dv[i], spec, false);
+					write_padded(writer, spec, buffer, length, true);
+				}
+				return;
+		}
+	}
+
+	static void vformat(Writer &writer, const char *format, const Arg *args, int num_args)
+	{
+		int index = 0;
+		const char *s = format;
+		const char *literal = s;
+		while (*s)
+		{
+			if (*s != '{' && *s != '}')
+			{
+				s++;
+				continue;
+			}
+			writer.put(literal, int(s - literal));
+			if (s[0] == s[1])
+			{
+				writer.put(*s);
+				s += 2;
+				literal = s;
+				continue;
+			}
+			if (*s == '}')
+			{
+				// unmatched brace, keep it
+				writer.put(*s++);
+				literal = s;
+				continue;
+			}
+			Spec spec;
+			s = parse_spec(s + 1, spec);
+			if (index < num_args)
+				write_arg(writer, args[index], spec);
+			else
+				writer.put("{?}", 3);
+			index++;
+			literal = s;
+		}
+		writer.put(literal, int(s - literal));
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// Grisu3, shortest and closest round-trip digits
+	//////////////////////////////////////////////////////////////////////////
+
+	struct DiyFp
+	{
+		UNIGINE_INLINE DiyFp() : f(0), e(0) {}
+		UNIGINE_INLINE DiyFp(unsigned long long f, int e) : f(f), e(e) {}
+
+		explicit DiyFp(double d)
+		{
+			unsigned long long u;
+			memcpy(&u, &d, sizeof(u));
+			int biased_e = int((u >> 52) & 0x7ff);
+			unsigned long long significand = u & 0x000fffffffffffffULL;
+			if (biased_e)
+			{
+				f = significand | 0x0010000000000000ULL;
+				e = biased_e - 1075;
+			} else
+			{
+				f = significand;
+				e = -1074;
+			}
+		}
+
+		explicit DiyFp(float d)
+		{
+			unsigned int u;
+			memcpy(&u, &d, sizeof(u));
+			int biased_e = int((u >> 23) & 0xff);
+			unsigned int significand = u & 0x007fffff;
+			if (biased_e)
+			{
+				f = significand | 0x00800000;
+				e = biased_e - 150;
+			} else
+			{
+				f = significand;
+				e = -149;
+			}
+		}
+
+		UNIGINE_INLINE DiyFp operator-(const DiyFp &rhs) const { return DiyFp(f - rhs.f, e); }
+
+		UNIGINE_INLINE DiyFp operator*(const DiyFp &rhs) const
+		{
+			const unsigned long long M32 = 0xffffffffULL;
+			unsigned long long a = f >> 32;
+			unsigned long long b = f & M32;
+			unsigned long long c = rhs.f >> 32;
+			unsigned long long d = rhs.f & M32;
+			unsigned long long ac = a * c;
+			unsigned long long bc = b * c;
+			unsigned long long ad = a * d;
+			unsigned long long bd = b * d;
+			unsigned long long tmp = (bd >> 32) + (ad & M32) + (bc & M32);
+			tmp += 1ULL << 31; // round
+			return DiyFp(ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), e + rhs.e + 64);
+		}
+
+		UNIGINE_INLINE DiyFp normalize() const
+		{
+			DiyFp ret = *this;
+			while (!(ret.f & 0x8000000000000000ULL))
+			{
+				ret.f <<= 1;
+				ret.e--;
+			}
+			return ret;
+		}
+
+		// upper boundary m+ = v + ulp / 2, normalized
+		static DiyFp getBoundaryPlus(const DiyFp &v) { return DiyFp((v.f << 1) + 1, v.e - 1).normalize(); }
+
+		// lower boundary m- = v - ulp / 2, the gap is halved below powers of two
+		static DiyFp getDoubleBoundaryMinus(double d)
+		{
+			DiyFp v(d);
+			bool closer = v.f == 0x0010000000000000ULL && v.e > -1074;
+			return closer ? DiyFp((v.f << 2) - 1, v.e - 2) : DiyFp((v.f << 1) - 1, v.e - 1);
+		}
+		static DiyFp getFloatBoundaryMinus(float d)
+		{
+			DiyFp v(d);
+			bool closer = v.f == 0x00800000ULL && v.e > -149;
+			return closer ? DiyFp((v.f << 2) - 1, v.e - 2) : DiyFp((v.f << 1) - 1, v.e - 1);
+		}
+
+		unsigned long long f;
+		int e;
+	};
+
+	static DiyFp get_cached_power(int e, int &k)
+	{
+		static const unsigned long long powers_f[] =
+		{
+			0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL,
+			0xcf42894a5dce35eaULL, 0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL,
+			0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL, 0xbe5691ef416bd60cULL,
+			0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+			0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL,
+			0xc21094364dfb5637ULL, 0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL,
+			0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL, 0xb23867fb2a35b28eULL,
+			0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+			0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL,
+			0xb5b5ada8aaff80b8ULL, 0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL,
+			0x964e858c91ba2655ULL, 0xdff9772470297ebdULL, 0xa6dfbd9fb8e5b88fULL,
+			0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+			0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL,
+			0xaa242499697392d3ULL, 0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL,
+			0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL, 0x9c40000000000000ULL,
+			0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+			0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL,
+			0x9f4f2726179a2245ULL, 0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL,
+			0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL, 0x924d692ca61be758ULL,
+			0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+			0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL,
+			0x952ab45cfa97a0b3ULL, 0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL,
+			0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL, 0x88fcf317f22241e2ULL,
+			0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+			0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL,
+			0x8bab8eefb6409c1aULL, 0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL,
+			0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL, 0x80444b5e7aa7cf85ULL,
+			0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+			0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL
+		};
+		static const short powers_e[] =
+		{
+			-1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980,
+			-954, -927, -901, -874, -847, -821, -794, -768, -741, -715,
+			-688, -661, -635, -608, -582, -555, -529, -502, -475, -449,
+			-422, -396, -369, -343, -316, -289, -263, -236, -210, -183,
+			-157, -130, -103, -77, -50, -24, 3, 30, 56, 83,
+			109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+			375, 402, 428, 455, 481, 508, 534, 561, 588, 614,
+			641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+			907, 933, 960, 986, 1013, 1039, 1066
+		};
+
+		// the binary exponent of the scaled value must land in [-60, -32]
+		double dk = (-61 - e) * 0.30102999566398114 + 347;
+		int ik = int(dk);
+		if (dk - ik > 0.0)
+			ik++;
+		int index = (ik >> 3) + 1;
+		k = -(-348 + index * 8);
+		return DiyFp(powers_f[index], powers_e[index]);
+	}
+
+	// moves the last digit towards w, returns false when the digits can not be
+	// proven to be the shortest and closest ones within the scaling error (unit)
+	static UNIGINE_INLINE bool grisu_round_weed(char *buffer, int length, unsigned long long too_high_w,
+		unsigned long long unsafe_interval, unsigned long long rest, unsigned long long ten_kappa, unsigned long long unit)
+	{
+		unsigned long long small_distance = too_high_w - unit;
+		unsigned long long big_distance = too_high_w + unit;
+		while (rest < small_distance && unsafe_interval - rest >= ten_kappa &&
+			(rest + ten_kappa < small_distance || small_distance - rest >= rest + ten_kappa - small_distance))
+		{
+			buffer[length - 1]--;
+			rest += ten_kappa;
+		}
+		if (rest < big_distance && unsafe_interval - rest >= ten_kappa &&
+			(rest + ten_kappa < big_distance || big_distance - rest > rest + ten_kappa - big_distance))
+			return false;
+		return 2 * unit <= rest && rest <= unsafe_interval - 4 * unit;
+	}
+
+	static bool digit_gen(const DiyFp &low, const DiyFp &w, const DiyFp &high, char *buffer, int &length, int &k)
+	{
+		static const unsigned long long pow10[] =
+		{
+			1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL,
+			10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL, 100000000000000ULL,
+			1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL,
+		};
+
+		// the scaled boundaries are off by at most one unit, generate digits for the widened interval
+		unsigned long long unit = 1;
+		const DiyFp too_low(low.f - unit, low.e);
+		const DiyFp too_high(high.f + unit, high.e);
+		unsigned long long unsafe_interval = too_high.f - too_low.f;
+		const DiyFp one(1ULL << -w.e, w.e);
+		unsigned int p1 = (unsigned int)(too_high.f >> -one.e);
+		unsigned long long p2 = too_high.f & (one.f - 1);
+		int kappa = 1;
+		while (kappa < 10 && p1 >= pow10[kappa])
+			kappa++;
+		length = 0;
+		while (kappa > 0)
+		{
+			buffer[length++] = char('0' + p1 / pow10[kappa - 1]);
+			p1 = (unsigned int)(p1 % pow10[kappa - 1]);
+			kappa--;
+			unsigned long long rest = ((unsigned long long)p1 << -one.e) + p2;
+			if (rest < unsafe_interval)
+			{
+				k += kappa;
+				return grisu_round_weed(buffer, length, too_high.f - w.f, unsafe_interval, rest, pow10[kappa] << -one.e, unit);
+			}
+		}
+		for (;;)
+		{
+			// the scaling error grows with every fractional digit
+			p2 *= 10;
+			unit *= 10;
+			unsafe_interval *= 10;
+			buffer[length++] = char('0' + (p2 >> -one.e));
+			p2 &= one.f - 1;
+			kappa--;
+			if (p2 < unsafe_interval)
+			{
+				k += kappa;
+				return grisu_round_weed(buffer, length, (too_high.f - w.f) * unit, unsafe_interval, p2, one.f, unit);
+			}
+		}
+	}
+
+	// Grisu3, fails for about 0.5% of the values
+	static bool grisu3(const DiyFp &v, const DiyFp &plus, const DiyFp &minus, char *buffer, int &length, int &k)
+	{
+		DiyFp m = minus;
+		m.f <<= m.e - plus.e;
+		m.e = plus.e;
+		int mk = 0;
+		const DiyFp c_mk = get_cached_power(plus.e, mk);
+		const DiyFp w = v.normalize() * c_mk;
+		const DiyFp wp = plus * c_mk;
+		const DiyFp wm = m * c_mk;
+		k = mk;
+		return digit_gen(wm, w, wp, buffer, length, k);
+	}
+
+	// exact shortest digits for the values Grisu3 rejects, the C library rounds correctly
+	template <typename Type>
+	static void shortest_digits(Type value, char *buffer, int &length, int &k)
+	{
+		const int max_digits = std::numeric_limits<Type>::max_digits10;
+		char str[FLOAT_SIZE];
+		for (int precision = 0; precision < max_digits; precision++)
+		{
+			snprintf(str, sizeof(str), "%.*e", precision, double(value));
+			if (parse_exact(str, value) == value)
+				break;
+		}
+
+		// d.ddde+xx -> ddd * 10^(xx - 3)
+		const char *s = str;
+		length = 0;
+		for (; *s != 'e'; s++)
+		{
+			if (*s != '.')
+				buffer[length++] = *s;
+		}
+		k = ::atoi(s + 1) - (length - 1);
+		while (length > 1 && buffer[length - 1] == '0')
+		{
+			length--;
+			k++;
+		}
+	}
+	static UNIGINE_INLINE double parse_exact(const char *str, double) { return strtod(str, nullptr); }
+	static UNIGINE_INLINE float parse_exact(const char *str, float) { return strtof(str, nullptr); }
+
+	//////////////////////////////////////////////////////////////////////////
+	// decimal layout
+	//////////////////////////////////////////////////////////////////////////
+
+	template <typename Type>
+	static UNIGINE_INLINE bool handle_special(char *&p, Type &value)
+	{
+		if (value != value)
+		{
+			memcpy(p, "nan", 3);
+			p += 3;
+			return true;
+		}
+		if (value < 0 || (value == 0 && 1 / value < 0))
+		{
+			*p++ = '-';
+			value = -value;
+		}
+		if (value > std::numeric_limits<Type>::max())
+		{
+			memcpy(p, "inf", 3);
+			p += 3;
+			return true;
+		}
+		return false;
+	}
+
+	// the shortest digits end with 5 exactly at the rounding position, only the binary value can tell
+	// the direction (0.125 -> "0.12"), such rare cases are delegated to the C library
+	static UNIGINE_INLINE bool is_decimal_tie(const char *digits, int length, int exponent, int precision)
+	{
+		if (precision < 0 || precision > MAX_PRECISION || length + exponent > 21)
+			return false;
+		return length + exponent + precision == length - 1 && digits[length - 1] == '5';
+	}
+
+	// digits * 10^exponent, the sign is already written
+	// the precision is honored up to 21 integer digits, see dtoa()
+	static int write_decimal(char *dest, char *digits, int length, int exponent, int precision)
+	{
+		char *p = dest;
+		int point = length + exponent; // position of the decimal point relative to the first digit
+
+		if (precision >= 0 && point <= 21)
+		{
+			if (precision > MAX_PRECISION)
+				precision = MAX_PRECISION;
+
+			// round the shortest digits to the requested precision
+			int keep = point + precision;
+			if (keep < 0)
+			{
+				length = 0;
+			} else if (keep < length)
+			{
+				bool up = digits[keep] >= '5';
+				length = keep;
+				for (int i = length - 1; up && i >= 0; i--)
+				{
+					if (digits[i] == '9')
+						digits[i] = '0';
+					else
+					{
+						digits[i]++;
+						up = false;
+					}
+				}
+				if (up)
+				{
+					memmove(digits + 1, digits, length);
+					digits[0] = '1';
+					length++;
+					point++;
+				}
+			}
+
+			// integer part
+			if (point > 0)
+			{
+				for (int i = 0; i < point; i++)
+					*p++ = i < length ? digits[i] : '0';
+			} else
+				*p++ = '0';
+
+			// fraction
+			if (precision > 0)
+			{
+				*p++ = '.';
+				for (int i = 0; i < precision; i++)
+				{
+					int index = point + i;
+					*p++ = (index >= 0 && index < length) ? digits[index] : '0';
+				}
+			}
+			return int(p - dest);
+		}
+
+		if (point > 0 && point <= 21)
+		{
+			// 1234e7 -> 12340000000, 1234e-2 -> 12.34
+			if (point >= length)
+			{
+				memcpy(p, digits, length);
+				p += length;
+				for (int i = length; i < point; i++)
+					*p++ = '0';
+			} else
+			{
+				memcpy(p, digits, point);
+				p += point;
+				*p++ = '.';
+				memcpy(p, digits + point, length - point);
+				p += length - point;
+			}
+		} else if (point > -6 && point <= 0)
+		{
+			// 1234e-6 -> 0.001234
+			*p++ = '0';
+			*p++ = '.';
+			for (int i = point; i < 0; i++)
+				*p++ = '0';
+			memcpy(p, digits, length);
+			p += length;
+		} else
+		{
+			// 1234e30 -> 1.234e+33
+			*p++ = digits[0];
+			if (length > 1)
+			{
+				*p++ = '.';
+				memcpy(p, digits + 1, length - 1);
+				p += length - 1;
+			}
+			*p++ = 'e';
+			int exp = point - 1;
+			*p++ = exp < 0 ? '-' : '+';
+			p += utoa(p, (unsigned long long)(exp < 0 ? -exp : exp));
+		}
+		return int(p - dest);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// helpers
+	//////////////////////////////////////////////////////////////////////////
+
+	static UNIGINE_INLINE const char *get_digits()
+	{
+		static const char digits[] =
+			"0001020304050607080910111213141516171819202122232425262728293031323334353637383940414243444546474849"
+			"5051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+		return digits;
+	}
+
+	static UNIGINE_INLINE double get_pow10(int exponent)
+	{
+		static const double pow10[] =
+		{
+			1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+			1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+		};
+		return pow10[exponent];
+	}
+
+	static UNIGINE_INLINE bool has_char(const char *p, const char *end) { return end ? p < end : *p != '\0'; }
+	static UNIGINE_INLINE bool is_space(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+	// exact and correctly rounded for both types, float is not rounded through double
+	template <typename Type>
+	static int parse_float(const char *str, Type &value, int size)
+	{
+		const char *p = str;
+		const char *end = size < 0 ? nullptr : str + size;
+		while (has_char(p, end) && is_space(*p))
+			p++;
+		const char *start = p;
+		bool negative = false;
+		if (has_char(p, end) && (*p == '-' || *p == '+'))
+			negative = (*p++ == '-');
+
+		// significand, at most 19 significant digits are accumulated
+		const char *digits_begin = p;
+		unsigned long long mantissa = 0;
+		int num_digits = 0;
+		int exponent = 0;
+		bool truncated = false;
+		bool has_digits = false;
+		while (has_char(p, end) && *p >= '0' && *p <= '9')
+		{
+			has_digits = true;
+			if (num_digits < 19)
+			{
+				mantissa = mantissa * 10 + unsigned(*p - '0');
+				if (mantissa)
+					num_digits++;
+			} else
+			{
+				exponent++;
+				truncated |= (*p != '0');
+			}
+			p++;
+		}
+		if (has_char(p, end) && *p == '.')
+		{
+			p++;
+			while (has_char(p, end) && *p >= '0' && *p <= '9')
+			{
+				has_digits = true;
+				if (num_digits < 19)
+				{
+					mantissa = mantissa * 10 + unsigned(*p - '0');
+					if (mantissa)
+						num_digits++;
+					exponent--;
+				} else
+					truncated |= (*p != '0');
+				p++;
+			}
+		}
+		if (!has_digits)
+			return parse_special(str, start, end, value);
+		const char *digits_end = p;
+
+		int exp = 0;
+		if (has_char(p, end) && (*p == 'e' || *p == 'E'))
+		{
+			const char *e = p + 1;
+			bool exp_negative = false;
+			if (has_char(e, end) && (*e == '-' || *e == '+'))
+				exp_negative = (*e++ == '-');
+			if (has_char(e, end) && *e >= '0' && *e <= '9')
+			{
+				while (has_char(e, end) && *e >= '0' && *e <= '9')
+				{
+					if (exp < 100000)
+						exp = exp * 10 + (*e - '0');
+					e++;
+				}
+				if (exp_negative)
+					exp = -exp;
+				exponent += exp;
+				p = e;
+			}
+		}
+
+		// exact fast path: both the significand and the power of ten are exact in the type
+		Type ret;
+		if (!truncated && is_exact(mantissa, exponent, Type()))
+		{
+			ret = Type(mantissa);
+			if (exponent < 0)
+				ret /= Type(get_pow10(-exponent));
+			else
+				ret *= Type(get_pow10(exponent));
+		} else if (mantissa == 0)
+		{
+			ret = Type(0);
+		} else
+		{
+			// correctly rounded slow path on a canonical copy without the locale dependent '.',
+			// a truncated significand is copied whole, the dropped digits may decide the rounding
+			Vector<char> buffer;
+			if (!truncated)
+			{
+				buffer.resize(48);
+				int length = utoa(buffer.get(), mantissa);
+				buffer[length++] = 'e';
+				length += itoa(buffer.get() + length, exponent);
+				buffer[length] = '\0';
+			} else
+			{
+				buffer.reserve(int(digits_end - digits_begin) + 16);
+				int fraction = 0;
+				bool in_fraction = false;
+				for (const char *d = digits_begin; d < digits_end; d++)
+				{
+					if (*d == '.')
+						in_fraction = true;
+					else if (buffer.size() || *d != '0')
+						buffer.append(*d);
+					if (in_fraction && *d != '.')
+						fraction++;
+				}
+				char suffix[16];
+				int length = itoa(suffix + 1, exp - fraction);
+				suffix[0] = 'e';
+				buffer.append(suffix, length + 1);
+				buffer.append('\0');
+			}
+			ret = parse_exact(buffer.get(), Type());
+		}
+		value = negative ? -ret : ret;
+		return int(p - str);
+	}
+
+	static UNIGINE_INLINE bool is_exact(unsigned long long mantissa, int exponent, double) { return mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22; }
+	static UNIGINE_INLINE bool is_exact(unsigned long long mantissa, int exponent, float) { return mantissa <= (1ULL << 24) && exponent >= -10 && exponent <= 10; }
+
+	template <typename Type>
+	static int parse_special(const char *str, const char *p, const char *end, Type &value)
+	{
+		bool negative = false;
+		if (has_char(p, end) && (*p == '-' || *p == '+'))
+			negative = (*p++ == '-');
+		int available = 0;
+		while (available < 3 && has_char(p + available, end))
+			available++;
+		if (available < 3)
+			return 0;
+		if (String::toLower(p[0]) == 'i' && String::toLower(p[1]) == 'n' && String::toLower(p[2]) == 'f')
+			value = negative ? -std::numeric_limits<Type>::infinity() : std::numeric_limits<Type>::infinity();
+		else if (String::toLower(p[0]) == 'n' && String::toLower(p[1]) == 'a' && String::toLower(p[2]) == 'n')
+			value = std::numeric_limits<Type>::quiet_NaN();
+		else
+			return 0;
+		return int(p + 3 - str);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// benchmark
+	//////////////////////////////////////////////////////////////////////////
+
+	template <typename Func>
+	static double get_call_time(int num, Func func)
+	{
+		auto begin = std::chrono::steady_clock::now();
+		for (int i = 0; i < num; i++)
+			func(i);
+		return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / num;
+	}
+
+	static void console_benchmark(int argc, char **argv)
+	{
+		String report;
+		getBenchmarkReport(report, argc > 1 ? Math::max(::atoi(argv[1]), 1) : 100000);
+		Log::message("%s", report.get());
+	}
+};
+
+inline void Format::appendThroughput(String &ret, const char *name, size_t size, int runs, const Function<bool()> &func)
+{
+	double best = 1e30;
+	bool ok = true;
+	for (int i = 0; i < runs; i++)
+	{
+		auto begin = std::chrono::steady_clock::now();
+		ok &= func();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+		if (seconds < best)
+			best = seconds;
+	}
+	append(ret, "{:<28}{:8.1} MB/s{}\n", name, double(size) / best / 1e6, ok ? "" : "  failed");
+}
+
+inline void Format::getBenchmarkReport(String &ret, int num)
+{
+	unsigned int state = 1;
+	auto random = [&state]() { state = state * 1664525u + 1013904223u; return state; };
+
+	Vector<int> ints(num);
+	Vector<double> doubles(num);
+	for (int i = 0; i < num; i++)
+	{
+		ints[i] = int(random()) >> (random() % 24);
+		doubles[i] = double(random()) / double(random() | 1) * 1000.0;
+	}
+
+	// the sink keeps the results alive
+	char buffer[STACK_SIZE];
+	volatile int sink = 0;
+	auto row = [&](const char *name, double format_time, double string_time, double printf_time)
+	{
+		Format::append(ret, "{:<10}{:8.1} ns{:8.1} ns{:8.1} ns\n", name, format_time, string_time, printf_time);
+	};
+
+	ret.clear();
+	Format::append(ret, "{} values, ns per call\n{:<10}{:>11}{:>11}{:>11}\n", num, "", "Format", "String", "snprintf");
+	row("itoa",
+		get_call_time(num, [&](int i) { sink += itoa(buffer, ints[i]); }),
+		get_call_time(num, [&](int i) { sink += String::itoa(ints[i]).size(); }),
+		get_call_time(num, [&](int i) { sink += snprintf(buffer, sizeof(buffer), "%d", ints[i]); }));
+	row("dtoa",
+		get_call_time(num, [&](int i) { sink += dtoa(buffer, doubles[i]); }),
+		get_call_time(num, [&](int i) { sink += String::dtoa(doubles[i]).size(); }),
+		get_call_time(num, [&](int i) { sink += snprintf(buffer, sizeof(buffer), "%.17g", doubles[i]); }));
+	row("ftoa(2)",
+		get_call_time(num, [&](int i) { sink += ftoa(buffer, float(doubles[i]), 2); }),
+		get_call_time(num, [&](int i) { sink += String::ftoa(float(doubles[i]), 2).size(); }),
+		get_call_time(num, [&](int i) { sink += snprintf(buffer, sizeof(buffer), "%.2f", doubles[i]); }));
+	row("format",
+		get_call_time(num, [&](int i) { sink += print(buffer, sizeof(buffer), "{} tanks, {:.2} fps", ints[i], doubles[i]); }),
+		get_call_time(num, [&](int i) { sink += String::format("%d tanks, %.2f fps", ints[i], doubles[i]).size(); }),
+		get_call_time(num, [&](int i) { sink += snprintf(buffer, sizeof(buffer), "%d tanks, %.2f fps", ints[i], doubles[i]); }));
+}
+
+} // namespace Unigine
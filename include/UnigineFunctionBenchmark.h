@@ -0,0 +1,163 @@
+/* Copyright (C) 2005-2020, UNIGINE. All rights reserved.
+ *
+ * This file is a part of the UNIGINE 2 SDK.
+ *
+ * Your use and / or redistribution of this software in source and / or
+ * binary form, with or without modification, is subject to: (i) your
+ * ongoing acceptance of and compliance with the terms and conditions of
+ * the UNIGINE License Agreement; and (ii) your inclusion of this notice
+ * in any version of this software that you use or redistribute.
+ * A copy of the UNIGINE License Agreement is available by contacting
+ * UNIGINE. at http://unigine.com/
+ */
+
+
+#pragma once
+
+#include "UnigineBase.h"
+#include "UnigineCallback.h"
+#include "UnigineVector.h"
+#include "UnigineString.h"
+#include "UnigineFormat.h"
+#include "UnigineConsole.h"
+#include "UnigineLog.h"
+#include <chrono>
+
+namespace Unigine
+{
+
+//////////////////////////////////////////////////////////////////////////
+/// MakeCallback against Function dispatch.
+///
+/// Lives apart from UnigineCallback.h, which is included by the console.
+//////////////////////////////////////////////////////////////////////////
+
+class FunctionBenchmark
+{
+public:
+	// nanoseconds per call and per create / destroy for num callbacks
+	static void getBenchmarkReport(String &ret, int num = 100000);
+
+	// function_benchmark [number of callbacks]
+	static void addConsoleCommands()
+	{
+		Console::addCommand("function_benchmark", "prints the call cost of MakeCallback and Function", MakeCallback(&FunctionBenchmark::console_benchmark));
+	}
+	static void removeConsoleCommands() { Console::removeCommand("function_benchmark"); }
+
+private:
+	// a component-sized object with a cheap update
+	struct Component
+	{
+		void update() { counter += value; }
+
+		int counter{0};
+		int value{1};
+		unsigned char data[120];
+	};
+
+	static void console_benchmark(int argc, char **argv)
+	{
+		int num = 100000;
+		if (argc > 1 && atoi(argv[1]) > 0)
+			num = atoi(argv[1]);
+		String report;
+		getBenchmarkReport(report, num);
+		Log::message("%s", report.get());
+	}
+};
+
+inline void FunctionBenchmark::getBenchmarkReport(String &ret, int num)
+{
+	if (num < 1)
+		num = 1;
+
+	Component *components = new Component[num];
+
+	// MakeCallback objects are allocated one by one between other allocations,
+	// as they are when components are created at different times
+	Vector<CallbackBase *> callbacks;
+	Vector<void *> garbage;
+	callbacks.resize(num);
+	garbage.resize(num);
+	for (int i = 0; i < num; i++)
+	{
+		callbacks[i] = MakeCallback(&components[i], &Component::update);
+		garbage[i] = malloc(32 + (i * 7919) % 480);
+	}
+	for (int i = 0; i < num; i++)
+		free(garbage[i]);
+
+	Function<void()> *functions = new Function<void()>[num];
+	FunctionCallback<void()> *adapters = new FunctionCallback<void()>[num];
+	Vector<CallbackBase *> adapter_pointers;
+	adapter_pointers.resize(num);
+	for (int i = 0; i < num; i++)
+	{
+		functions[i] = Function<void()>(&components[i], &Component::update);
+		adapters[i].func = Function<void()>(&components[i], &Component::update);
+		adapter_pointers[i] = &adapters[i];
+	}
+
+	auto run = [&](const char *name, const Function<void()> &func)
+	{
+		// the best of several runs, the first one warms the caches up
+		double best = 1e30;
+		for (int i = 0; i < 8; i++)
+		{
+			auto begin = std::chrono::steady_clock::now();
+			func();
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+			if (seconds < best)
+				best = seconds;
+		}
+		Format::append(ret, "{:<36}{:8.2} ns\n", name, best * 1e9 / num);
+	};
+
+	ret.clear();
+	Format::append(ret, "{} callbacks, {} byte components\ncall:\n", num, int(sizeof(Component)));
+	run("direct member call", [&]() {
+		for (int i = 0; i < num; i++)
+			components[i].update();
+	});
+	run("MakeCallback, scattered heap", [&]() {
+		for (int i = 0; i < num; i++)
+			callbacks[i]->run();
+	});
+	run("Function, contiguous", [&]() {
+		for (int i = 0; i < num; i++)
+			functions[i]();
+	});
+	run("FunctionCallback via CallbackBase", [&]() {
+		for (int i = 0; i < num; i++)
+			adapter_pointers[i]->run();
+	});
+
+	ret += "create and destroy:\n";
+	run("MakeCallback", [&]() {
+		for (int i = 0; i < num; i++)
+			delete callbacks[i];
+		for (int i = 0; i < num; i++)
+			callbacks[i] = MakeCallback(&components[i], &Component::update);
+	});
+	run("Function", [&]() {
+		for (int i = 0; i < num; i++)
+			functions[i].clear();
+		for (int i = 0; i < num; i++)
+			functions[i] = Function<void()>(&components[i], &Component::update);
+	});
+
+	// keeps the updates alive
+	int sum = 0;
+	for (int i = 0; i < num; i++)
+		sum += components[i].counter;
+	Format::append(ret, "checksum {}\n", sum);
+
+	for (int i = 0; i < num; i++)
+		delete callbacks[i];
+	delete[] adapters;
+	delete[] functions;
+	delete[] components;
+}
+
+} // namespace Unigine
@@ -49,9 +49,9 @@ struct HashMapData
 		, data(std::forward<Args>(args)...)
 	{}
 
-	static UNIGINE_INLINE void *operator new(size_t size) { return Memory::allocate(size); }
-	static UNIGINE_INLINE void operator delete(void *ptr) { Memory::deallocate(ptr); }
-	static UNIGINE_INLINE void operator delete(void *ptr, size_t size) { Memory::deallocate(ptr,size); }
+	static UNIGINE_INLINE void *operator new(size_t size) { return UNIGINE_MEMORY_ALLOCATE(size); }
+	static UNIGINE_INLINE void operator delete(void *ptr) { UNIGINE_MEMORY_DEALLOCATE(ptr); }
+	static UNIGINE_INLINE void operator delete(void *ptr, size_t size) { UNIGINE_MEMORY_DEALLOCATE_SIZE(ptr,size); }
 
 };
 
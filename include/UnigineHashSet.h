@@ -33,9 +33,9 @@ struct HashSetData
 		, key(std::move(k))
 	{}
 
-	static UNIGINE_INLINE void *operator new(size_t size) { return Memory::allocate(size); }
-	static UNIGINE_INLINE void operator delete(void *ptr) { Memory::deallocate(ptr); }
-	static UNIGINE_INLINE void operator delete(void *ptr, size_t size) { Memory::deallocate(ptr,size); }
+	static UNIGINE_INLINE void *operator new(size_t size) { return UNIGINE_MEMORY_ALLOCATE(size); }
+	static UNIGINE_INLINE void operator delete(void *ptr) { UNIGINE_MEMORY_DEALLOCATE(ptr); }
+	static UNIGINE_INLINE void operator delete(void *ptr, size_t size) { UNIGINE_MEMORY_DEALLOCATE_SIZE(ptr,size); }
 
 };
 
@@ -0,0 +1,1115 @@
+/* Copyright (C) 2005-2020, UNIGINE. All rights reserved.
+ *
+ * This file is a part of the UNIGINE 2 SDK.
+ *
+ * Your use and / or redistribution of this software in source and / or
+ * binary form, with or without modification, is subject to: (i) your
+ * ongoing acceptance of and compliance with the terms and conditions of
+ * the UNIGINE License Agreement; and (ii) your inclusion of this notice
+ * in any version of this software that you use or redistribute.
+ * A copy of the UNIGINE License Agreement is available by contacting
+ * UNIGINE. at http://unigine.com/
+ */
+
+#pragma once
+
+#include "UnigineImage.h"
+#include "UnigineMathLib.h"
+#include "UnigineThread.h"
+#include "UnigineVector.h"
+#include "UnigineString.h"
+#include "UnigineFormat.h"
+#include "UnigineConsole.h"
+#include "UnigineCallback.h"
+#include "UnigineLog.h"
+#include <chrono>
+#include <math.h>
+#include <string.h>
+
+// Image kernels example
+/*
+	// same arguments and results as the Image methods, the work is split
+	// into tiles processed on PoolCPUShaders threads
+	ImagePtr image = Image::create("heightmap.dds");
+	ImageKernels::resize(image, 4096, 4096);
+	ImageKernels::blur(image, 2);
+
+	// resize and the whole mipmap chain in one pass over the source
+	ImageKernels::resizeWithMipmaps(image, 2048, 2048);
+
+	// formats the kernels don't handle are passed to the Image methods
+	ImageKernels::convertToFormat(image, Image::FORMAT_RGBA16F);
+*/
+
+namespace Unigine
+{
+
+//////////////////////////////////////////////////////////////////////////
+/// Tiled and multithreaded Image kernels.
+///
+/// Replacements for Image::resize(), blur(), createMipmaps(),
+/// convertToFormat(), normalize() and combine() that split the image into
+/// cache sized tiles or row bands and process them on PoolCPUShaders
+/// threads. 2D, cube, 2D array and cube array images of the raw formats
+/// (8 and 16-bit integer, 16 and 32-bit float, 1 to 4 channels) are
+/// handled here, other images are passed to the Image methods.
+///
+/// Pixels are decoded into float rows, filtered with SSE and encoded
+/// back, so all formats share the same kernels. Resize and blur are
+/// separable: a tile filters the source rows it needs horizontally, then
+/// sums the filtered rows vertically. Mipmaps are built per tile from the
+/// float tile while it is in the cache, down to the level where the tile
+/// is a single pixel, the few remaining levels are built afterwards.
+//////////////////////////////////////////////////////////////////////////
+
+class ImageKernels
+{
+public:
+	enum
+	{
+		TILE_SHIFT = 6,
+		TILE_SIZE = 1 << TILE_SHIFT,	// tile size in pixels, aligned with the mipmap chain
+		BAND_SIZE = 256 * 1024,	// row band size in bytes for the per-pixel kernels
+	};
+
+	// true if the kernels process the image, otherwise the Image methods are called
+	static bool isSupported(const ImagePtr &image)
+	{
+		return image && image->isLoaded() && get_num_planes(image) > 0 && get_type(image->getFormat()) != -1;
+	}
+
+	// FILTER_POINT takes the nearest pixel, FILTER_LINEAR is a tent filter
+	// which covers all source pixels when the image is minified.
+	// The mipmaps of the image are rebuilt for the new size.
+	static bool resize(const ImagePtr &image, int width, int height, int filter = Image::FILTER_LINEAR)
+	{
+		if (!isSupported(image) || width < 1 || height < 1)
+			return image && image->resize(width, height, filter);
+		int num_mipmaps = image->hasMipmaps() ? get_num_mipmaps(width, height) : 1;
+		return resize_image(image, width, height, filter, num_mipmaps, Image::FILTER_LINEAR, 1.0f);
+	}
+
+	// resize with the full mipmap chain built from the resized tiles
+	static bool resizeWithMipmaps(const ImagePtr &image, int width, int height, int filter = Image::FILTER_LINEAR, float gamma = 1.0f)
+	{
+		if (!isSupported(image) || width < 1 || height < 1)
+			return image && image->resize(width, height, filter) && image->createMipmaps(filter, gamma);
+		return resize_image(image, width, height, filter, get_num_mipmaps(width, height), filter, gamma);
+	}
+
+	// separable Gaussian blur, the kernel is 2 * size + 1 pixels wide
+	// with the sigma of size / 2, the mipmaps are rebuilt
+	static bool blur(const ImagePtr &image, int size)
+	{
+		if (size == 0)
+			return true;
+		if (!isSupported(image) || size < 0)
+			return image && image->blur(size);
+
+		int width = image->getWidth();
+		int height = image->getHeight();
+		float sigma = Math::max(float(size) * 0.5f, 0.5f);
+		float scale = -0.5f / (sigma * sigma);
+		auto gauss = [scale](float d) { return expf(d * d * scale); };
+		Axis x_axis;
+		Axis y_axis;
+		create_axis(x_axis, width, width, 1.0f, float(size) + 0.5f, gauss);
+		create_axis(y_axis, height, height, 1.0f, float(size) + 0.5f, gauss);
+		return filter_image(image, x_axis, y_axis, width, height, image->getNumMipmaps(), Image::FILTER_LINEAR, 1.0f);
+	}
+
+	// FILTER_POINT takes the top left pixel of each 2x2 block, FILTER_LINEAR
+	// averages them, color channels are averaged in the gamma space
+	static bool createMipmaps(const ImagePtr &image, int filter = Image::FILTER_LINEAR, float gamma = 1.0f)
+	{
+		if (!isSupported(image))
+			return image && image->createMipmaps(filter, gamma);
+
+		int width = image->getWidth();
+		int height = image->getHeight();
+		int format = image->getFormat();
+		int num_mipmaps = get_num_mipmaps(width, height);
+		ImagePtr dest = Image::create();
+		if (!create_image(dest, image, width, height, format, num_mipmaps))
+			return false;
+
+		Context context(image, dest, format, num_mipmaps, filter, gamma);
+		int num_src_mipmaps = image->getNumMipmaps();
+		int num_tiles_x = (width + TILE_SIZE - 1) >> TILE_SHIFT;
+		int num_tiles_y = (height + TILE_SIZE - 1) >> TILE_SHIFT;
+		int num_tiles = num_tiles_x * num_tiles_y;
+		run(context.num_planes * num_tiles, [&](int job, Scratch &scratch)
+		{
+			int plane = job / num_tiles;
+			int x0 = (job % num_tiles % num_tiles_x) << TILE_SHIFT;
+			int y0 = (job % num_tiles / num_tiles_x) << TILE_SHIFT;
+			int tw = Math::min(TILE_SIZE, width - x0);
+			int th = Math::min(TILE_SIZE, height - y0);
+			const Plane &src = context.src[plane * num_src_mipmaps];
+			const Plane &dest_level = context.dest[plane * num_mipmaps];
+			size_t row_size = size_t(tw) * context.pixel_size;
+			scratch.tile.resize(size_t(tw) * th * context.channels);
+			for (int y = 0; y < th; y++)
+			{
+				const unsigned char *s = src.data + size_t(y0 + y) * src.stride + size_t(x0) * context.pixel_size;
+				memcpy(dest_level.data + size_t(y0 + y) * dest_level.stride + size_t(x0) * context.pixel_size, s, row_size);
+				load_row(scratch.tile.get() + size_t(y) * tw * context.channels, s, context.type, tw * context.channels);
+			}
+			build_tile_mipmaps(context, scratch, plane, x0, y0, tw, th);
+		});
+		build_mipmaps(context);
+		image->swap(dest);
+		return true;
+	}
+
+	// conversions between the raw formats, missing color channels are
+	// set to zero and the missing alpha to one
+	static int convertToFormat(const ImagePtr &image, int new_format)
+	{
+		if (!isSupported(image) || get_type(new_format) == -1)
+			return image ? image->convertToFormat(new_format) : 0;
+		int format = image->getFormat();
+		if (format == new_format)
+			return 1;
+
+		int num_mipmaps = image->getNumMipmaps();
+		ImagePtr dest = Image::create();
+		if (!create_image(dest, image, image->getWidth(), image->getHeight(), new_format, num_mipmaps))
+			return 0;
+
+		Context context(image, dest, format, num_mipmaps, Image::FILTER_LINEAR, 1.0f);
+		int dest_type = get_type(new_format);
+		int dest_channels = get_num_channels(new_format);
+		Vector<Band> bands;
+		create_bands(bands, context);
+		run(bands.size(), [&](int job, Scratch &scratch)
+		{
+			const Band &band = bands[job];
+			const Plane &src = context.src[band.plane * num_mipmaps + band.level];
+			const Plane &dest_level = context.dest[band.plane * num_mipmaps + band.level];
+			scratch.row.resize(size_t(src.width) * 4);
+			scratch.tile.resize(size_t(src.width) * 4);
+			for (int y = band.y0; y < band.y1; y++)
+			{
+				load_row(scratch.row.get(), src.data + size_t(y) * src.stride, context.type, src.width * context.channels);
+				const float *s = scratch.row.get();
+				if (dest_channels != context.channels)
+				{
+					float *d = scratch.tile.get();
+					for (int x = 0; x < src.width; x++)
+					{
+						for (int c = 0; c < dest_channels; c++)
+							d[c] = c < context.channels ? s[c] : (c == 3 ? 1.0f : 0.0f);
+						s += context.channels;
+						d += dest_channels;
+					}
+					s = scratch.tile.get();
+				}
+				store_row(dest_level.data + size_t(y) * dest_level.stride, s, dest_type, src.width * dest_channels);
+			}
+		});
+		image->swap(dest);
+		return 1;
+	}
+
+	// normalizes the xyz vectors of 3 and 4-channel images in place, integer
+	// formats are unpacked from [0;1] to [-1;1], alpha is kept, zero vectors
+	// become (0, 0, 1), 1 and 2-channel images are passed to Image::normalize()
+	static bool normalize(const ImagePtr &image)
+	{
+		if (!isSupported(image) || image->getNumChannels() < 3)
+			return image && image->normalize();
+
+		int num_mipmaps = image->getNumMipmaps();
+		Context context(image, image, image->getFormat(), num_mipmaps, Image::FILTER_LINEAR, 1.0f);
+		bool unpack = context.type == TYPE_UCHAR || context.type == TYPE_USHORT;
+		Vector<Band> bands;
+		create_bands(bands, context);
+		run(bands.size(), [&](int job, Scratch &scratch)
+		{
+			const Band &band = bands[job];
+			const Plane &plane = context.src[band.plane * num_mipmaps + band.level];
+			scratch.row.resize(size_t(plane.width) * context.channels);
+			for (int y = band.y0; y < band.y1; y++)
+			{
+				unsigned char *data = plane.data + size_t(y) * plane.stride;
+				float *p = scratch.row.get();
+				load_row(p, data, context.type, plane.width * context.channels);
+				for (int x = 0; x < plane.width; x++, p += context.channels)
+				{
+					float vx = unpack ? p[0] * 2.0f - 1.0f : p[0];
+					float vy = unpack ? p[1] * 2.0f - 1.0f : p[1];
+					float vz = unpack ? p[2] * 2.0f - 1.0f : p[2];
+					float length = vx * vx + vy * vy + vz * vz;
+					if (length > 1e-12f)
+					{
+						float ilength = 1.0f / sqrtf(length);
+						vx *= ilength;
+						vy *= ilength;
+						vz *= ilength;
+					} else
+					{
+						vx = 0.0f;
+						vy = 0.0f;
+						vz = 1.0f;
+					}
+					p[0] = unpack ? vx * 0.5f + 0.5f : vx;
+					p[1] = unpack ? vy * 0.5f + 0.5f : vy;
+					p[2] = unpack ? vz * 0.5f + 0.5f : vz;
+				}
+				store_row(data, scratch.row.get(), context.type, plane.width * context.channels);
+			}
+		});
+		return true;
+	}
+
+	// RGB8 to RGB565, RGBA8 to RGBA4 or RGB5A1 (default), RGBA16 to RGB10A2.
+	// The 16-bit formats are packed from the high bits (red first), RGB10A2
+	// from the low bits (red in bits 0-9). Other conversions are passed to
+	// Image::combine().
+	static bool combine(const ImagePtr &image, int new_format = -1)
+	{
+		if (!isSupported(image))
+			return image && image->combine(new_format);
+		int format = image->getFormat();
+		if (new_format == -1)
+		{
+			if (format == Image::FORMAT_RGB8)
+				new_format = Image::FORMAT_RGB565;
+			else if (format == Image::FORMAT_RGBA8)
+				new_format = Image::FORMAT_RGB5A1;
+			else if (format == Image::FORMAT_RGBA16)
+				new_format = Image::FORMAT_RGB10A2;
+		}
+		bool supported = (format == Image::FORMAT_RGB8 && new_format == Image::FORMAT_RGB565) ||
+			(format == Image::FORMAT_RGBA8 && (new_format == Image::FORMAT_RGBA4 || new_format == Image::FORMAT_RGB5A1)) ||
+			(format == Image::FORMAT_RGBA16 && new_format == Image::FORMAT_RGB10A2);
+		if (!supported)
+			return image->combine(new_format);
+
+		int num_mipmaps = image->getNumMipmaps();
+		ImagePtr dest = Image::create();
+		if (!create_image(dest, image, image->getWidth(), image->getHeight(), new_format, num_mipmaps))
+			return false;
+
+		Context context(image, dest, format, num_mipmaps, Image::FILTER_LINEAR, 1.0f);
+		Vector<Band> bands;
+		create_bands(bands, context);
+		run(bands.size(), [&](int job, Scratch &scratch)
+		{
+			UNIGINE_UNUSED(scratch);
+			const Band &band = bands[job];
+			const Plane &src = context.src[band.plane * num_mipmaps + band.level];
+			const Plane &dest_level = context.dest[band.plane * num_mipmaps + band.level];
+			for (int y = band.y0; y < band.y1; y++)
+				combine_row(dest_level.data + size_t(y) * dest_level.stride, src.data + size_t(y) * src.stride, src.width, new_format);
+		});
+		image->swap(dest);
+		return true;
+	}
+
+	// image_kernels_benchmark [size]
+	static void getBenchmarkReport(String &ret, int size = 2048);
+
+	static void addConsoleCommands()
+	{
+		Console::addCommand("image_kernels_benchmark", "prints Image and ImageKernels times per operation and format", MakeCallback(&ImageKernels::console_benchmark));
+	}
+	static void removeConsoleCommands() { Console::removeCommand("image_kernels_benchmark"); }
+
+private:
+	enum
+	{
+		TYPE_UCHAR = 0,
+		TYPE_USHORT,
+		TYPE_HALF,
+		TYPE_FLOAT,
+	};
+
+	struct Plane
+	{
+		unsigned char *data;
+		int width;
+		int height;
+		size_t stride;
+	};
+
+	// rows [y0; y1) of a plane level
+	struct Band
+	{
+		int plane;
+		int level;
+		int y0;
+		int y1;
+	};
+
+	// source contribution to each destination pixel along one axis
+	struct Axis
+	{
+		Vector<int> first;
+		Vector<int> count;
+		Vector<float> weights;	// num_taps per destination pixel
+		int num_taps{0};
+	};
+
+	// per thread buffers, kept between the jobs of a thread
+	struct Scratch
+	{
+		Vector<float> row;
+		Vector<float> horizontal;
+		Vector<float> tile;
+		Vector<float> level[2];
+	};
+
+	struct Context
+	{
+		Context(const ImagePtr &src_image, const ImagePtr &dest_image, int format, int num_dest_mipmaps, int mipmap_filter, float mipmap_gamma)
+			: type(get_type(format))
+			, channels(get_num_channels(format))
+			, pixel_size(size_t(get_type_size(get_type(format)) * get_num_channels(format)))
+			, num_planes(get_num_planes(src_image))
+			, num_mipmaps(num_dest_mipmaps)
+			, filter(mipmap_filter)
+			, gamma(mipmap_gamma)
+		{
+			src.resize(size_t(num_planes) * src_image->getNumMipmaps());
+			for (int i = 0; i < num_planes; i++)
+				for (int j = 0; j < src_image->getNumMipmaps(); j++)
+					src[i * src_image->getNumMipmaps() + j] = get_plane(src_image, i, j);
+			dest.resize(size_t(num_planes) * num_mipmaps);
+			for (int i = 0; i < num_planes; i++)
+				for (int j = 0; j < num_mipmaps; j++)
+					dest[i * num_mipmaps + j] = get_plane(dest_image, i, j);
+		}
+
+		int type;
+		int channels;
+		size_t pixel_size;
+		int num_planes;
+		int num_mipmaps;	// of the destination
+		int filter;	// mipmap filter
+		float gamma;
+		Vector<Plane> src;	// plane * number of source mipmaps + level
+		Vector<Plane> dest;	// plane * num_mipmaps + level
+	};
+
+	template <class Func>
+	class JobShader : public CPUShader
+	{
+	public:
+		JobShader(const Func &func, int num_jobs)
+			: func(func), num_jobs(num_jobs), counter(0) {}
+
+		void process(int thread_num, int threads_count) override
+		{
+			UNIGINE_UNUSED(thread_num);
+			UNIGINE_UNUSED(threads_count);
+			Scratch scratch;
+			for (;;)
+			{
+				int i = AtomicAdd(&counter, 1);
+				if (i >= num_jobs)
+					break;
+				func(i, scratch);
+			}
+		}
+
+	private:
+		const Func &func;
+		int num_jobs;
+		volatile int counter;
+	};
+
+	// jobs are taken from a shared counter, so uneven tiles balance out
+	template <class Func>
+	static void run(int num_jobs, const Func &func)
+	{
+		int num_threads = PoolCPUShaders::isInitialized() ? PoolCPUShaders::getNumSyncThreads() : 1;
+		if (num_jobs < 2 || num_threads < 2)
+		{
+			Scratch scratch;
+			for (int i = 0; i < num_jobs; i++)
+				func(i, scratch);
+			return;
+		}
+		JobShader<Func> shader(func, num_jobs);
+		shader.runSync();
+	}
+
+	static int get_type(int format)
+	{
+		if (format >= Image::FORMAT_R8 && format <= Image::FORMAT_RGBA8)
+			return TYPE_UCHAR;
+		if (format >= Image::FORMAT_R16 && format <= Image::FORMAT_RGBA16)
+			return TYPE_USHORT;
+		if (format >= Image::FORMAT_R16F && format <= Image::FORMAT_RGBA16F)
+			return TYPE_HALF;
+		if (format >= Image::FORMAT_R32F && format <= Image::FORMAT_RGBA32F)
+			return TYPE_FLOAT;
+		return -1;
+	}
+
+	static UNIGINE_INLINE int get_type_size(int type) { return type == TYPE_UCHAR ? 1 : (type == TYPE_FLOAT ? 4 : 2); }
+	static UNIGINE_INLINE int get_num_channels(int format) { return (format - Image::FORMAT_R8) % 4 + 1; }
+
+	static int get_num_mipmaps(int width, int height)
+	{
+		int ret = 1;
+		while (width > 1 || height > 1)
+		{
+			width >>= 1;
+			height >>= 1;
+			ret++;
+		}
+		return ret;
+	}
+
+	// 3D images are passed to the Image methods
+	static int get_num_planes(const ImagePtr &image)
+	{
+		switch (image->getType())
+		{
+			case Image::IMAGE_2D: return 1;
+			case Image::IMAGE_CUBE: return 6;
+			case Image::IMAGE_2D_ARRAY: return image->getNumLayers();
+			case Image::IMAGE_CUBE_ARRAY: return 6 * image->getNumLayers();
+			default: return 0;
+		}
+	}
+
+	static Plane get_plane(const ImagePtr &image, int plane, int level)
+	{
+		Plane ret;
+		switch (image->getType())
+		{
+			case Image::IMAGE_CUBE: ret.data = image->getPixelsCube(plane, level); break;
+			case Image::IMAGE_2D_ARRAY: ret.data = image->getPixels2DArray(plane, level); break;
+			case Image::IMAGE_CUBE_ARRAY: ret.data = image->getPixelsCubeArray(plane % 6, plane / 6, level); break;
+			default: ret.data = image->getPixels2D(level); break;
+		}
+		ret.width = image->getWidth(level);
+		ret.height = image->getHeight(level);
+		ret.stride = image->getStride(level);
+		return ret;
+	}
+
+	static bool create_image(const ImagePtr &dest, const ImagePtr &src, int width, int height, int format, int num_mipmaps)
+	{
+		switch (src->getType())
+		{
+			case Image::IMAGE_2D: return dest->create2D(width, height, format, num_mipmaps, false);
+			case Image::IMAGE_CUBE: return dest->createCube(width, height, format, num_mipmaps, false);
+			case Image::IMAGE_2D_ARRAY: return dest->create2DArray(width, height, src->getNumLayers(), format, num_mipmaps, false);
+			case Image::IMAGE_CUBE_ARRAY: return dest->createCubeArray(width, height, src->getNumLayers(), format, num_mipmaps, false);
+			default: return false;
+		}
+	}
+
+	static void create_bands(Vector<Band> &bands, const Context &context)
+	{
+		bands.clear();
+		for (int i = 0; i < context.num_planes; i++)
+		{
+			for (int j = 0; j < context.num_mipmaps; j++)
+			{
+				const Plane &plane = context.dest[i * context.num_mipmaps + j];
+				size_t row_size = Math::max(plane.stride, size_t(1));
+				int num_rows = int(Math::clamp(size_t(BAND_SIZE) / row_size, size_t(1), size_t(plane.height)));
+				for (int y = 0; y < plane.height; y += num_rows)
+					bands.append({ i, j, y, Math::min(y + num_rows, plane.height) });
+			}
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// pixel conversion
+	//////////////////////////////////////////////////////////////////////////
+
+	static UNIGINE_INLINE float half_to_float(unsigned short h)
+	{
+		unsigned int sign = (unsigned int)(h & 0x8000) << 16;
+		unsigned int em = h & 0x7fff;
+		union
+		{
+			unsigned int i;
+			float f;
+		} value;
+		if (em >= 0x7c00)
+			value.i = sign | 0x7f800000 | ((em & 0x03ff) << 13);
+		else if (em >= 0x0400)
+			value.i = sign | ((em << 13) + ((127 - 15) << 23));
+		else
+		{
+			// denormals are exact multiples of 2^-24
+			value.f = float(em) * (1.0f / 16777216.0f);
+			value.i |= sign;
+		}
+		return value.f;
+	}
+
+	// rounds to the nearest, out of range values are clamped to 65504
+	static UNIGINE_INLINE unsigned short float_to_half(float f)
+	{
+		union
+		{
+			float f;
+			unsigned int i;
+		} value = {f};
+		unsigned int sign = (value.i >> 16) & 0x8000;
+		unsigned int i = value.i & 0x7fffffff;
+		if (i > 0x7f800000)
+			return (unsigned short)(sign | 0x7e00);
+		if (i >= 0x477ff000)
+			return (unsigned short)(sign | 0x7bff);
+		if (i < 0x38800000)
+		{
+			// denormals, the ulp of 0.5f is 2^-24, so the addition rounds to the nearest even
+			value.i = i;
+			value.f += 0.5f;
+			return (unsigned short)(sign | (value.i - 0x3f000000));
+		}
+		i += 0xc8000fff + ((i >> 13) & 1);
+		return (unsigned short)(sign | (i >> 13));
+	}
+
+	static void load_row(float *dest, const unsigned char *src, int type, int num)
+	{
+		int i = 0;
+		switch (type)
+		{
+			case TYPE_UCHAR:
+			{
+#ifdef USE_SSE2
+				const __m128i zero = _mm_setzero_si128();
+				const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+				for (; i + 16 <= num; i += 16)
+				{
+					__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+					__m128i lo = _mm_unpacklo_epi8(v, zero);
+					__m128i hi = _mm_unpackhi_epi8(v, zero);
+					_mm_storeu_ps(dest + i + 0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), scale));
+					_mm_storeu_ps(dest + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), scale));
+					_mm_storeu_ps(dest + i + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), scale));
+					_mm_storeu_ps(dest + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), scale));
+				}
+#endif
+				for (; i < num; i++)
+					dest[i] = float(src[i]) * (1.0f / 255.0f);
+				break;
+			}
+			case TYPE_USHORT:
+			{
+				const unsigned short *s = reinterpret_cast<const unsigned short *>(src);
+				for (; i < num; i++)
+					dest[i] = float(s[i]) * (1.0f / 65535.0f);
+				break;
+			}
+			case TYPE_HALF:
+			{
+				const unsigned short *s = reinterpret_cast<const unsigned short *>(src);
+#ifdef USE_SSE2
+				// the scalar conversion with masks instead of branches
+				const __m128i zero = _mm_setzero_si128();
+				const __m128i exponent_mask = _mm_set1_epi32(0x7c00 << 13);
+				const __m128i rebias = _mm_set1_epi32((127 - 15) << 23);
+				const __m128i denormal_magic = _mm_set1_epi32(113 << 23);
+				for (; i + 4 <= num; i += 4)
+				{
+					__m128i h = _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(s + i)), zero);
+					__m128i o = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x7fff)), 13);
+					__m128i exponent = _mm_and_si128(o, exponent_mask);
+					o = _mm_add_epi32(o, rebias);
+					o = _mm_add_epi32(o, _mm_and_si128(_mm_cmpeq_epi32(exponent, exponent_mask), rebias));
+					__m128i denormal = _mm_castps_si128(_mm_sub_ps(_mm_castsi128_ps(_mm_add_epi32(o, _mm_set1_epi32(1 << 23))), _mm_castsi128_ps(denormal_magic)));
+					__m128i is_denormal = _mm_cmpeq_epi32(exponent, zero);
+					o = _mm_or_si128(_mm_and_si128(is_denormal, denormal), _mm_andnot_si128(is_denormal, o));
+					o = _mm_or_si128(o, _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x8000)), 16));
+					_mm_storeu_ps(dest + i, _mm_castsi128_ps(o));
+				}
+#endif
+				for (; i < num; i++)
+					dest[i] = half_to_float(s[i]);
+				break;
+			}
+			default: memcpy(dest, src, sizeof(float) * size_t(num)); break;
+		}
+	}
+
+	static void store_row(unsigned char *dest, const float *src, int type, int num)
+	{
+		int i = 0;
+		switch (type)
+		{
+			case TYPE_UCHAR:
+			{
+#ifdef USE_SSE2
+				const __m128 zero = _mm_setzero_ps();
+				const __m128 scale = _mm_set1_ps(255.0f);
+				for (; i + 16 <= num; i += 16)
+				{
+					__m128i v0 = _mm_cvtps_epi32(_mm_max_ps(_mm_min_ps(_mm_mul_ps(_mm_loadu_ps(src + i + 0), scale), scale), zero));
+					__m128i v1 = _mm_cvtps_epi32(_mm_max_ps(_mm_min_ps(_mm_mul_ps(_mm_loadu_ps(src + i + 4), scale), scale), zero));
+					__m128i v2 = _mm_cvtps_epi32(_mm_max_ps(_mm_min_ps(_mm_mul_ps(_mm_loadu_ps(src + i + 8), scale), scale), zero));
+					__m128i v3 = _mm_cvtps_epi32(_mm_max_ps(_mm_min_ps(_mm_mul_ps(_mm_loadu_ps(src + i + 12), scale), scale), zero));
+					__m128i v = _mm_packus_epi16(_mm_packs_epi32(v0, v1), _mm_packs_epi32(v2, v3));
+					_mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i), v);
+				}
+#endif
+				for (; i < num; i++)
+					dest[i] = (unsigned char)(Math::clamp(src[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+				break;
+			}
+			case TYPE_USHORT:
+			{
+				unsigned short *d = reinterpret_cast<unsigned short *>(dest);
+				for (; i < num; i++)
+					d[i] = (unsigned short)(Math::clamp(src[i], 0.0f, 1.0f) * 65535.0f + 0.5f);
+				break;
+			}
+			case TYPE_HALF:
+			{
+				unsigned short *d = reinterpret_cast<unsigned short *>(dest);
+#ifdef USE_SSE2
+				const __m128i abs_mask = _mm_set1_epi32(0x7fffffff);
+				const __m128i infinity = _mm_set1_epi32(0x7f800000);
+				const __m128i overflow = _mm_set1_epi32(0x477ff000 - 1);
+				const __m128i normal = _mm_set1_epi32(0x38800000 - 1);
+				const __m128 half = _mm_set1_ps(0.5f);
+				for (; i + 4 <= num; i += 4)
+				{
+					__m128i f = _mm_castps_si128(_mm_loadu_ps(src + i));
+					__m128i a = _mm_and_si128(f, abs_mask);
+					__m128i sign = _mm_and_si128(_mm_srli_epi32(f, 16), _mm_set1_epi32(0x8000));
+					__m128i rounded = _mm_add_epi32(a, _mm_set1_epi32(0xc8000fff));
+					rounded = _mm_srli_epi32(_mm_add_epi32(rounded, _mm_and_si128(_mm_srli_epi32(a, 13), _mm_set1_epi32(1))), 13);
+					__m128i denormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(a), half)), _mm_castps_si128(half));
+					__m128i is_normal = _mm_cmpgt_epi32(a, normal);
+					__m128i o = _mm_or_si128(_mm_and_si128(is_normal, rounded), _mm_andnot_si128(is_normal, denormal));
+					__m128i is_overflow = _mm_cmpgt_epi32(a, overflow);
+					o = _mm_or_si128(_mm_and_si128(is_overflow, _mm_set1_epi32(0x7bff)), _mm_andnot_si128(is_overflow, o));
+					__m128i is_nan = _mm_cmpgt_epi32(a, infinity);
+					o = _mm_or_si128(_mm_and_si128(is_nan, _mm_set1_epi32(0x7e00)), _mm_andnot_si128(is_nan, o));
+					// sign extend, so the saturating pack keeps the bits
+					o = _mm_srai_epi32(_mm_slli_epi32(_mm_or_si128(o, sign), 16), 16);
+					_mm_storel_epi64(reinterpret_cast<__m128i *>(d + i), _mm_packs_epi32(o, o));
+				}
+#endif
+				for (; i < num; i++)
+					d[i] = float_to_half(src[i]);
+				break;
+			}
+			default: memcpy(dest, src, sizeof(float) * size_t(num)); break;
+		}
+	}
+
+	// color channels to and from the gamma space, alpha is linear
+	static void apply_gamma(float *data, int num_pixels, int channels, float gamma)
+	{
+		int num_colors = Math::min(channels, 3);
+		for (int i = 0; i < num_pixels; i++, data += channels)
+			for (int c = 0; c < num_colors; c++)
+				data[c] = powf(Math::max(data[c], 0.0f), gamma);
+	}
+
+	static void combine_row(unsigned char *dest, const unsigned char *src, int width, int format)
+	{
+		unsigned short *d = reinterpret_cast<unsigned short *>(dest);
+		auto pack = [](unsigned int v, unsigned int max) { return (v * max + 127) / 255; };
+		switch (format)
+		{
+			case Image::FORMAT_RGB565:
+				for (int x = 0; x < width; x++, src += 3)
+					d[x] = (unsigned short)((pack(src[0], 31) << 11) | (pack(src[1], 63) << 5) | pack(src[2], 31));
+				break;
+			case Image::FORMAT_RGBA4:
+				for (int x = 0; x < width; x++, src += 4)
+					d[x] = (unsigned short)((pack(src[0], 15) << 12) | (pack(src[1], 15) << 8) | (pack(src[2], 15) << 4) | pack(src[3], 15));
+				break;
+			case Image::FORMAT_RGB5A1:
+				for (int x = 0; x < width; x++, src += 4)
+					d[x] = (unsigned short)((pack(src[0], 31) << 11) | (pack(src[1], 31) << 6) | (pack(src[2], 31) << 1) | (src[3] >> 7));
+				break;
+			case Image::FORMAT_RGB10A2:
+			{
+				const unsigned short *s = reinterpret_cast<const unsigned short *>(src);
+				unsigned int *d32 = reinterpret_cast<unsigned int *>(dest);
+				auto pack16 = [](unsigned int v, unsigned int max) { return (v * max + 32767) / 65535; };
+				for (int x = 0; x < width; x++, s += 4)
+					d32[x] = pack16(s[0], 1023) | (pack16(s[1], 1023) << 10) | (pack16(s[2], 1023) << 20) | (pack16(s[3], 3) << 30);
+				break;
+			}
+			default: break;
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// separable filters
+	//////////////////////////////////////////////////////////////////////////
+
+	// taps outside of the source are clamped to the edge pixels
+	template <class Weight>
+	static void create_axis(Axis &axis, int src_size, int dest_size, float scale, float support, const Weight &weight)
+	{
+		axis.num_taps = int(ceilf(support * 2.0f)) + 2;
+		axis.first.resize(dest_size);
+		axis.count.resize(dest_size);
+		axis.weights.resize(size_t(dest_size) * axis.num_taps);
+		for (int i = 0; i < dest_size; i++)
+		{
+			float center = (float(i) + 0.5f) * scale - 0.5f;
+			int lo = int(floorf(center - support)) + 1;
+			int hi = Math::max(int(floorf(center + support)), lo);
+			int first = Math::clamp(lo, 0, src_size - 1);
+			int last = Math::clamp(hi, 0, src_size - 1);
+			float *w = axis.weights.get() + size_t(i) * axis.num_taps;
+			memset(w, 0, sizeof(float) * axis.num_taps);
+			float sum = 0.0f;
+			for (int j = lo; j <= hi; j++)
+			{
+				float v = weight(float(j) - center);
+				w[Math::clamp(j, 0, src_size - 1) - first] += v;
+				sum += v;
+			}
+			if (sum > 0.0f)
+			{
+				for (int j = 0; j <= last - first; j++)
+					w[j] /= sum;
+			} else
+				w[0] = 1.0f;
+			axis.first[i] = first;
+			axis.count[i] = last - first + 1;
+		}
+	}
+
+	static void create_resize_axis(Axis &axis, int src_size, int dest_size, int filter)
+	{
+		float scale = float(src_size) / float(dest_size);
+		if (filter == Image::FILTER_POINT)
+		{
+			create_axis(axis, src_size, dest_size, scale, 0.5f, [](float) { return 1.0f; });
+			return;
+		}
+		float support = Math::max(scale, 1.0f);
+		float isupport = 1.0f / support;
+		create_axis(axis, src_size, dest_size, scale, support, [isupport](float d) { return Math::max(1.0f - fabsf(d) * isupport, 0.0f); });
+	}
+
+	// dest[i] += src[i] * weight
+	static UNIGINE_INLINE void accumulate(float *dest, const float *src, float weight, int num)
+	{
+		int i = 0;
+#ifdef USE_SSE
+		__m128 w = _mm_set1_ps(weight);
+		for (; i + 8 <= num; i += 8)
+		{
+			_mm_storeu_ps(dest + i + 0, _mm_add_ps(_mm_loadu_ps(dest + i + 0), _mm_mul_ps(_mm_loadu_ps(src + i + 0), w)));
+			_mm_storeu_ps(dest + i + 4, _mm_add_ps(_mm_loadu_ps(dest + i + 4), _mm_mul_ps(_mm_loadu_ps(src + i + 4), w)));
+		}
+#endif
+		for (; i < num; i++)
+			dest[i] += src[i] * weight;
+	}
+
+	// filters destination pixels [x0; x0 + num) of a source row starting at pixel src_x0
+	static void filter_row(float *dest, const float *src, int src_x0, const Axis &axis, int x0, int num, int channels)
+	{
+		for (int x = x0; x < x0 + num; x++)
+		{
+			const float *w = axis.weights.get() + size_t(x) * axis.num_taps;
+			const float *s = src + size_t(axis.first[x] - src_x0) * channels;
+			int count = axis.count[x];
+#ifdef USE_SSE
+			if (channels == 4)
+			{
+				__m128 sum = _mm_setzero_ps();
+				for (int k = 0; k < count; k++)
+					sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(s + k * 4), _mm_set1_ps(w[k])));
+				_mm_storeu_ps(dest, sum);
+				dest += 4;
+				continue;
+			}
+#endif
+			for (int c = 0; c < channels; c++)
+			{
+				float sum = 0.0f;
+				for (int k = 0; k < count; k++)
+					sum += s[k * channels + c] * w[k];
+				dest[c] = sum;
+			}
+			dest += channels;
+		}
+	}
+
+	// a destination tile from the source rows it covers, filtered horizontally and then vertically
+	static void filter_tile(Scratch &scratch, const Plane &src, const Axis &x_axis, const Axis &y_axis, int type, int channels, size_t pixel_size, int x0, int y0, int tw, int th)
+	{
+		int sx0 = x_axis.first[x0];
+		int sx1 = x_axis.first[x0 + tw - 1] + x_axis.count[x0 + tw - 1];
+		int sy0 = y_axis.first[y0];
+		int sy1 = y_axis.first[y0 + th - 1] + y_axis.count[y0 + th - 1];
+		int row_size = tw * channels;
+		scratch.row.resize(size_t(sx1 - sx0) * channels);
+		scratch.horizontal.resize(size_t(sy1 - sy0) * row_size);
+		for (int y = sy0; y < sy1; y++)
+		{
+			load_row(scratch.row.get(), src.data + size_t(y) * src.stride + size_t(sx0) * pixel_size, type, (sx1 - sx0) * channels);
+			filter_row(scratch.horizontal.get() + size_t(y - sy0) * row_size, scratch.row.get(), sx0, x_axis, x0, tw, channels);
+		}
+		scratch.tile.resize(size_t(th) * row_size);
+		for (int y = 0; y < th; y++)
+		{
+			float *d = scratch.tile.get() + size_t(y) * row_size;
+			const float *w = y_axis.weights.get() + size_t(y0 + y) * y_axis.num_taps;
+			int first = y_axis.first[y0 + y] - sy0;
+			memset(d, 0, sizeof(float) * row_size);
+			for (int k = 0; k < y_axis.count[y0 + y]; k++)
+				accumulate(d, scratch.horizontal.get() + size_t(first + k) * row_size, w[k], row_size);
+		}
+	}
+
+	static bool resize_image(const ImagePtr &image, int width, int height, int filter, int num_mipmaps, int mipmap_filter, float gamma)
+	{
+		Axis x_axis;
+		Axis y_axis;
+		create_resize_axis(x_axis, image->getWidth(), width, filter);
+		create_resize_axis(y_axis, image->getHeight(), height, filter);
+		return filter_image(image, x_axis, y_axis, width, height, num_mipmaps, mipmap_filter, gamma);
+	}
+
+	static bool filter_image(const ImagePtr &image, const Axis &x_axis, const Axis &y_axis, int width, int height, int num_mipmaps, int mipmap_filter, float gamma)
+	{
+		int format = image->getFormat();
+		ImagePtr dest = Image::create();
+		if (!create_image(dest, image, width, height, format, num_mipmaps))
+			return false;
+
+		Context context(image, dest, format, num_mipmaps, mipmap_filter, gamma);
+		int num_src_mipmaps = image->getNumMipmaps();
+		int num_tiles_x = (width + TILE_SIZE - 1) >> TILE_SHIFT;
+		int num_tiles_y = (height + TILE_SIZE - 1) >> TILE_SHIFT;
+		int num_tiles = num_tiles_x * num_tiles_y;
+		run(context.num_planes * num_tiles, [&](int job, Scratch &scratch)
+		{
+			int plane = job / num_tiles;
+			int x0 = (job % num_tiles % num_tiles_x) << TILE_SHIFT;
+			int y0 = (job % num_tiles / num_tiles_x) << TILE_SHIFT;
+			int tw = Math::min(TILE_SIZE, width - x0);
+			int th = Math::min(TILE_SIZE, height - y0);
+			filter_tile(scratch, context.src[plane * num_src_mipmaps], x_axis, y_axis, context.type, context.channels, context.pixel_size, x0, y0, tw, th);
+			const Plane &dest_level = context.dest[plane * num_mipmaps];
+			for (int y = 0; y < th; y++)
+				store_row(dest_level.data + size_t(y0 + y) * dest_level.stride + size_t(x0) * context.pixel_size, scratch.tile.get() + size_t(y) * tw * context.channels, context.type, tw * context.channels);
+			build_tile_mipmaps(context, scratch, plane, x0, y0, tw, th);
+		});
+		build_mipmaps(context);
+		image->swap(dest);
+		return true;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// mipmaps
+	//////////////////////////////////////////////////////////////////////////
+
+	// level pixels [x0; x0 + w) x [y0; y0 + h) from the previous level pixels
+	// starting at (src_x0, src_y0), src_width and src_height are of the whole previous level
+	static void downsample(float *dest, int x0, int y0, int w, int h, const float *src, int src_x0, int src_y0, int src_row, int src_width, int src_height, int channels, int filter)
+	{
+		for (int y = y0; y < y0 + h; y++)
+		{
+			const float *s0 = src + size_t(y * 2 - src_y0) * src_row * channels;
+			const float *s1 = src + size_t(Math::min(y * 2 + 1, src_height - 1) - src_y0) * src_row * channels;
+			for (int x = x0; x < x0 + w; x++)
+			{
+				int sx0 = (x * 2 - src_x0) * channels;
+				if (filter == Image::FILTER_POINT)
+				{
+					for (int c = 0; c < channels; c++)
+						dest[c] = s0[sx0 + c];
+					dest += channels;
+					continue;
+				}
+				int sx1 = (Math::min(x * 2 + 1, src_width - 1) - src_x0) * channels;
+#ifdef USE_SSE
+				if (channels == 4)
+				{
+					__m128 sum = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(s0 + sx0), _mm_loadu_ps(s0 + sx1)), _mm_add_ps(_mm_loadu_ps(s1 + sx0), _mm_loadu_ps(s1 + sx1)));
+					_mm_storeu_ps(dest, _mm_mul_ps(sum, _mm_set1_ps(0.25f)));
+					dest += 4;
+					continue;
+				}
+#endif
+				for (int c = 0; c < channels; c++)
+					dest[c] = (s0[sx0 + c] + s0[sx1 + c] + s1[sx0 + c] + s1[sx1 + c]) * 0.25f;
+				dest += channels;
+			}
+		}
+	}
+
+	static void store_level(const Context &context, Scratch &scratch, const Plane &plane, const float *data, int x0, int y0, int w, int h)
+	{
+		int row_size = w * context.channels;
+		if (context.gamma != 1.0f)
+		{
+			scratch.row.resize(size_t(h) * row_size);
+			memcpy(scratch.row.get(), data, sizeof(float) * size_t(h) * row_size);
+			apply_gamma(scratch.row.get(), w * h, context.channels, 1.0f / context.gamma);
+			data = scratch.row.get();
+		}
+		for (int y = 0; y < h; y++)
+			store_row(plane.data + size_t(y0 + y) * plane.stride + size_t(x0) * context.pixel_size, data + size_t(y) * row_size, context.type, row_size);
+	}
+
+	// the levels of a level 0 tile in scratch.tile that lie inside the tile,
+	// down to TILE_SHIFT where the tile is a single pixel
+	static void build_tile_mipmaps(const Context &context, Scratch &scratch, int plane, int x0, int y0, int tw, int th)
+	{
+		int last = Math::min(context.num_mipmaps - 1, int(TILE_SHIFT));
+		if (last < 1)
+			return;
+		const Plane *levels = context.dest.get() + plane * context.num_mipmaps;
+		if (context.gamma != 1.0f)
+			apply_gamma(scratch.tile.get(), tw * th, context.channels, context.gamma);
+
+		const float *src = scratch.tile.get();
+		int src_x0 = x0;
+		int src_y0 = y0;
+		int src_row = tw;
+		for (int level = 1; level <= last; level++)
+		{
+			int lx0 = x0 >> level;
+			int ly0 = y0 >> level;
+			int lx1 = Math::min((x0 + TILE_SIZE) >> level, levels[level].width);
+			int ly1 = Math::min((y0 + TILE_SIZE) >> level, levels[level].height);
+			if (lx0 >= lx1 || ly0 >= ly1)
+				break;
+			Vector<float> &dest = scratch.level[level & 1];
+			dest.resize(size_t(lx1 - lx0) * (ly1 - ly0) * context.channels);
+			downsample(dest.get(), lx0, ly0, lx1 - lx0, ly1 - ly0, src, src_x0, src_y0, src_row, levels[level - 1].width, levels[level - 1].height, context.channels, context.filter);
+			store_level(context, scratch, levels[level], dest.get(), lx0, ly0, lx1 - lx0, ly1 - ly0);
+			src = dest.get();
+			src_x0 = lx0;
+			src_y0 = ly0;
+			src_row = lx1 - lx0;
+		}
+	}
+
+	// levels past TILE_SHIFT, 1/64 of the size and smaller, one job per plane
+	static void build_mipmaps(const Context &context)
+	{
+		if (context.num_mipmaps <= TILE_SHIFT + 1)
+			return;
+		run(context.num_planes, [&](int plane, Scratch &scratch)
+		{
+			const Plane *levels = context.dest.get() + plane * context.num_mipmaps;
+			const Plane &start = levels[TILE_SHIFT];
+			scratch.tile.resize(size_t(start.width) * start.height * context.channels);
+			for (int y = 0; y < start.height; y++)
+				load_row(scratch.tile.get() + size_t(y) * start.width * context.channels, start.data + size_t(y) * start.stride, context.type, start.width * context.channels);
+			if (context.gamma != 1.0f)
+				apply_gamma(scratch.tile.get(), start.width * start.height, context.channels, context.gamma);
+			const float *src = scratch.tile.get();
+			for (int level = TILE_SHIFT + 1; level < context.num_mipmaps; level++)
+			{
+				const Plane &prev = levels[level - 1];
+				const Plane &dest_level = levels[level];
+				Vector<float> &dest = scratch.level[level & 1];
+				dest.resize(size_t(dest_level.width) * dest_level.height * context.channels);
+				downsample(dest.get(), 0, 0, dest_level.width, dest_level.height, src, 0, 0, prev.width, prev.width, prev.height, context.channels, context.filter);
+				store_level(context, scratch, dest_level, dest.get(), 0, 0, dest_level.width, dest_level.height);
+				src = dest.get();
+			}
+		});
+	}
+
+	static void console_benchmark(int argc, char **argv)
+	{
+		String report;
+		getBenchmarkReport(report, argc > 1 ? Math::max(atoi(argv[1]), 16) : 2048);
+		Log::message("%s", report.get());
+	}
+};
+
+inline void ImageKernels::getBenchmarkReport(String &ret, int size)
+{
+	// largest channel difference between the Image and ImageKernels results
+	auto difference = [](const ImagePtr &a, const ImagePtr &b) -> float
+	{
+		if (a->getFormat() != b->getFormat() || a->getWidth() != b->getWidth() || a->getHeight() != b->getHeight() || get_type(a->getFormat()) == -1)
+			return -1.0f;
+		int type = get_type(a->getFormat());
+		int num = a->getWidth() * a->getNumChannels();
+		Vector<float> row_a(num);
+		Vector<float> row_b(num);
+		float max_difference = 0.0f;
+		for (int y = 0; y < a->getHeight(); y++)
+		{
+			load_row(row_a.get(), a->getPixels2D() + size_t(y) * a->getStride(), type, num);
+			load_row(row_b.get(), b->getPixels2D() + size_t(y) * b->getStride(), type, num);
+			for (int i = 0; i < num; i++)
+				max_difference = Math::max(max_difference, fabsf(row_a[i] - row_b[i]));
+		}
+		return max_difference;
+	};
+
+	const int formats[] = { Image::FORMAT_RGBA8, Image::FORMAT_RGBA16F, Image::FORMAT_R32F };
+	int num_threads = PoolCPUShaders::isInitialized() ? PoolCPUShaders::getNumSyncThreads() : 1;
+
+	ret.clear();
+	Format::append(ret, "{}x{}, {} threads\n", size, size, num_threads);
+	Format::append(ret, "{:<28}{:>10}{:>14}{:>9}{:>11}\n", "", "Image", "ImageKernels", "speedup", "max diff");
+	for (int format : formats)
+	{
+		// smooth noise, so the filters have something to average
+		ImagePtr source = Image::create();
+		source->create2D(size, size, format, 1, false);
+		int type = get_type(format);
+		int num = size * Image::getNumChannels(format);
+		Vector<float> row(num);
+		unsigned int state = 1;
+		for (int y = 0; y < size; y++)
+		{
+			for (int i = 0; i < num; i++)
+			{
+				state = state * 1664525u + 1013904223u;
+				row[i] = float(state >> 8) * (1.0f / 16777216.0f) * 0.25f + 0.5f + 0.25f * sinf(float(i + y) * 0.01f);
+			}
+			store_row(source->getPixels2D() + size_t(y) * source->getStride(), row.get(), type, num);
+		}
+
+		auto run_operation = [&](const char *name, const Function<bool(const ImagePtr &)> &image_func, const Function<bool(const ImagePtr &)> &kernels_func)
+		{
+			ImagePtr a = Image::create(source);
+			ImagePtr b = Image::create(source);
+			auto begin = std::chrono::steady_clock::now();
+			bool ok = image_func(a);
+			double image_time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+			begin = std::chrono::steady_clock::now();
+			ok &= kernels_func(b);
+			double kernels_time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+			String label = String::format("%s %s", Image::getFormatName(format), name);
+			Format::append(ret, "{:<28}{:7.1} ms{:11.1} ms{:8.2}x{:11.4}{}\n", label.get(), image_time, kernels_time, image_time / Math::max(kernels_time, 1e-3),
+				double(difference(a, b)), ok ? "" : "  failed");
+		};
+
+		int half_size = Math::max(size / 2, 1);
+		run_operation("resize", [=](const ImagePtr &image) { return image->resize(half_size, half_size); },
+			[=](const ImagePtr &image) { return ImageKernels::resize(image, half_size, half_size); });
+		run_operation("blur", [](const ImagePtr &image) { return image->blur(4); },
+			[](const ImagePtr &image) { return ImageKernels::blur(image, 4); });
+		run_operation("createMipmaps", [](const ImagePtr &image) { return image->createMipmaps(); },
+			[](const ImagePtr &image) { return ImageKernels::createMipmaps(image); });
+		run_operation("resize + mipmaps", [=](const ImagePtr &image) { return image->resize(half_size, half_size) && image->createMipmaps(); },
+			[=](const ImagePtr &image) { return ImageKernels::resizeWithMipmaps(image, half_size, half_size); });
+		int new_format = format == Image::FORMAT_RGBA8 ? Image::FORMAT_RGBA16F : (format == Image::FORMAT_RGBA16F ? Image::FORMAT_RGBA8 : Image::FORMAT_R16F);
+		run_operation("convertToFormat", [=](const ImagePtr &image) { return image->convertToFormat(new_format) != 0; },
+			[=](const ImagePtr &image) { return ImageKernels::convertToFormat(image, new_format) != 0; });
+		if (Image::getNumChannels(format) >= 3)
+			run_operation("normalize", [](const ImagePtr &image) { return image->normalize(); },
+				[](const ImagePtr &image) { return ImageKernels::normalize(image); });
+		if (format == Image::FORMAT_RGBA8)
+			run_operation("combine", [](const ImagePtr &image) { return image->combine(); },
+				[](const ImagePtr &image) { return ImageKernels::combine(image); });
+	}
+}
+
+} // namespace Unigine
@@ -0,0 +1,1099 @@
+/* Copyright (C) 2005-2020, UNIGINE. All rights reserved.
+ *
+ * This file is a part of the UNIGINE 2 SDK.
+ *
+ * Your use and / or redistribution of this software in source and / or
+ * binary form, with or without modification, is subject to: (i) your
+ * ongoing acceptance of and compliance with the terms and conditions of
+ * the UNIGINE License Agreement; and (ii) your inclusion of this notice
+ * in any version of this software that you use or redistribute.
+ * A copy of the UNIGINE License Agreement is available by contacting
+ * UNIGINE. at http://unigine.com/
+ */
+
+
+#pragma once
+
+#include "UnigineJson.h"
+#include "UnigineStreamBuffer.h"
+#include "UnigineMathLib.h"
+#include "UnigineVector.h"
+#include "UnigineString.h"
+#include "UnigineFormat.h"
+#include "UnigineConsole.h"
+#include "UnigineCallback.h"
+#include "UnigineLog.h"
+#include <chrono>
+#include <cmath>
+#include <type_traits>
+#include <stdlib.h>
+
+#ifdef _MSC_VER
+	#include <intrin.h>
+#endif
+
+// Json stream example
+/*
+	// callbacks, strings are views into the source and valid during the call
+	struct Counter : JsonHandler
+	{
+		bool key(const StringView &name) { keys += name.equal("velocity"); return true; }
+		bool number(double value) { sum += value; return true; }
+		int keys = 0;
+		double sum = 0.0;
+	};
+	Counter counter;
+	JsonReader reader;
+	reader.parse(data, size, counter);
+
+	// or the Json DOM in one pass
+	JsonPtr json = Json::create();
+	reader.parse(data, size, json);
+
+	// writing
+	JsonWriter writer(File::create("telemetry.json", "wb"));
+	writer.startObject();
+	writer.key("frame");
+	writer.integer(Game::getFrame());
+	writer.key("positions");
+	writer.startArray();
+	...
+	writer.endArray();
+	writer.endObject();
+	writer.close();
+*/
+
+namespace Unigine
+{
+
+//////////////////////////////////////////////////////////////////////////
+/// Callbacks of JsonReader::parse().
+///
+/// Handlers derive from it and hide the methods they need, the calls are
+/// resolved at compile time. Returning false stops the parsing.
+//////////////////////////////////////////////////////////////////////////
+
+class JsonHandler
+{
+public:
+	UNIGINE_INLINE bool startObject() { return true; }
+	UNIGINE_INLINE bool endObject() { return true; }
+	UNIGINE_INLINE bool startArray() { return true; }
+	UNIGINE_INLINE bool endArray() { return true; }
+	UNIGINE_INLINE bool key(const StringView &name) { UNIGINE_UNUSED(name); return true; }
+	UNIGINE_INLINE bool string(const StringView &value) { UNIGINE_UNUSED(value); return true; }
+	UNIGINE_INLINE bool number(double value) { UNIGINE_UNUSED(value); return true; }
+	// numbers without a fraction and an exponent that fit into 64 bits
+	UNIGINE_INLINE bool integer(long long value) { UNIGINE_UNUSED(value); return true; }
+	UNIGINE_INLINE bool boolean(bool value) { UNIGINE_UNUSED(value); return true; }
+	UNIGINE_INLINE bool null() { return true; }
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// Streaming Json writer.
+///
+/// The events of JsonHandler write the text into a stream, so a JsonWriter
+/// can be passed to JsonReader::parse() to reformat a document.
+//////////////////////////////////////////////////////////////////////////
+
+class JsonWriter : public JsonHandler
+{
+public:
+	JsonWriter() = default;
+	JsonWriter(const StreamPtr &stream, bool formatted = false) { open(stream, formatted); }
+	~JsonWriter() { close(); }
+
+	JsonWriter(const JsonWriter &) = delete;
+	JsonWriter &operator=(const JsonWriter &) = delete;
+
+	bool open(const StreamPtr &stream, bool formatted = false)
+	{
+		close();
+		this->formatted = formatted;
+		first = true;
+		after_key = false;
+		depth.clear();
+		return writer.open(stream);
+	}
+
+	// flushes the text, false if any write failed
+	bool close() { return writer.close(); }
+
+	UNIGINE_INLINE bool isFailed() const { return writer.isFailed(); }
+	// bytes written since open()
+	UNIGINE_INLINE size_t tell() const { return writer.tell(); }
+
+	bool startObject() { return start('{'); }
+	bool endObject() { return end('}'); }
+	bool startArray() { return start('['); }
+	bool endArray() { return end(']'); }
+
+	bool key(const StringView &name)
+	{
+		separate();
+		write_string(name);
+		writer.writeChar(':');
+		if (formatted)
+			writer.writeChar(' ');
+		after_key = true;
+		return !writer.isFailed();
+	}
+
+	bool string(const StringView &value)
+	{
+		separate();
+		write_string(value);
+		return !writer.isFailed();
+	}
+
+	bool number(double value)
+	{
+		separate();
+		if (!std::isfinite(value))
+		{
+			writer.write("null", 4);
+			return !writer.isFailed();
+		}
+		char buffer[Format::FLOAT_SIZE];
+		int length = Format::dtoa(buffer, value);
+		writer.write(buffer, size_t(length));
+		return !writer.isFailed();
+	}
+
+	bool integer(long long value)
+	{
+		separate();
+		char buffer[24];
+		char *end = buffer + sizeof(buffer);
+		char *s = end;
+		unsigned long long v = value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+		do
+		{
+			*--s = char('0' + v % 10);
+			v /= 10;
+		} while (v);
+		if (value < 0)
+			*--s = '-';
+		writer.write(s, size_t(end - s));
+		return !writer.isFailed();
+	}
+
+	bool boolean(bool value)
+	{
+		separate();
+		writer.write(value ? "true" : "false", value ? 4 : 5);
+		return !writer.isFailed();
+	}
+
+	bool null()
+	{
+		separate();
+		writer.write("null", 4);
+		return !writer.isFailed();
+	}
+
+	// the tree of the Json node
+	bool write(const JsonPtr &json)
+	{
+		if (json->isObject())
+		{
+			startObject();
+			for (int i = 0; i < json->getNumChildren(); i++)
+			{
+				JsonPtr child = json->getChild(i);
+				key(child->getName());
+				write(child);
+			}
+			return endObject();
+		}
+		if (json->isArray())
+		{
+			startArray();
+			for (int i = 0; i < json->getNumChildren(); i++)
+				write(json->getChild(i));
+			return endArray();
+		}
+		if (json->isString())
+			return string(json->getString());
+		if (json->isNumber())
+		{
+			double value = json->getNumber();
+			if (value == double((long long)value) && value > -9.2e18 && value < 9.2e18)
+				return integer((long long)value);
+			return number(value);
+		}
+		if (json->isBool())
+			return boolean(json->getBool() != 0);
+		return null();
+	}
+
+private:
+	bool start(char c)
+	{
+		separate();
+		writer.writeChar(c);
+		depth.append(0);
+		first = true;
+		return !writer.isFailed();
+	}
+
+	bool end(char c)
+	{
+		bool empty = first;
+		depth.removeLast();
+		first = false;
+		if (formatted && !empty)
+			indent();
+		writer.writeChar(c);
+		return !writer.isFailed();
+	}
+
+	// comma and indentation before a key or a value
+	void separate()
+	{
+		if (after_key)
+		{
+			after_key = false;
+			return;
+		}
+		if (!first)
+			writer.writeChar(',');
+		first = false;
+		if (formatted && depth.size())
+			indent();
+	}
+
+	void indent()
+	{
+		writer.writeChar('\n');
+		for (int i = 0; i < depth.size(); i++)
+			writer.writeChar('\t');
+	}
+
+	void write_string(const StringView &s)
+	{
+		static const char hex[] = "0123456789abcdef";
+		writer.writeChar('"');
+		const char *data = s.get();
+		int begin = 0;
+		for (int i = 0; i < s.size(); i++)
+		{
+			unsigned char c = (unsigned char)data[i];
+			if (c >= 0x20 && c != '"' && c != '\\')
+				continue;
+			writer.write(data + begin, size_t(i - begin));
+			begin = i + 1;
+			char escape[6] = {'\\', 0, 0, 0, 0, 0};
+			size_t length = 2;
+			switch (c)
+			{
+				case '"': escape[1] = '"'; break;
+				case '\\': escape[1] = '\\'; break;
+				case '\n': escape[1] = 'n'; break;
+				case '\r': escape[1] = 'r'; break;
+				case '\t': escape[1] = 't'; break;
+				case '\b': escape[1] = 'b'; break;
+				case '\f': escape[1] = 'f'; break;
+				default:
+					escape[1] = 'u';
+					escape[2] = '0';
+					escape[3] = '0';
+					escape[4] = hex[c >> 4];
+					escape[5] = hex[c & 15];
+					length = 6;
+					break;
+			}
+			writer.write(escape, length);
+		}
+		writer.write(data + begin, size_t(s.size() - begin));
+		writer.writeChar('"');
+	}
+
+	StreamBufferWriter writer;
+	Vector<char> depth;
+	bool formatted{false};
+	bool first{true};
+	bool after_key{false};
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// Streaming Json reader.
+///
+/// The source is indexed in chunks: 64 bytes at a time are classified with
+/// SSE2 into bit masks of quotes, backslashes, operators and whitespace,
+/// escaped quotes and string contents are masked out with carry-less bit
+/// arithmetic, and the positions of the structural characters and value
+/// starts are written to a small index. The parser walks the index and
+/// calls the handler, so the memory does not grow with the document.
+///
+/// Strings without escapes are views into the source, strings with escapes
+/// are decoded into an internal buffer, both are valid during the call.
+//////////////////////////////////////////////////////////////////////////
+
+class JsonReader
+{
+public:
+	enum
+	{
+		MAX_DEPTH = 1024,
+		CHUNK_SIZE = 64 * 1024,	// bytes indexed at a time
+	};
+
+	// false with an error message at the offset of a malformed document
+	template <class Handler, class = typename std::enable_if<std::is_base_of<JsonHandler, Handler>::value>::type>
+	bool parse(const char *data, size_t size, Handler &handler)
+	{
+		if (size >= 0xffffffffULL)
+		{
+			Log::error("JsonReader::parse(): the document is larger than 4 GB\n");
+			return false;
+		}
+		begin(data, size);
+
+		enum STATE
+		{
+			STATE_VALUE = 0,
+			STATE_OBJECT_KEY,
+			STATE_AFTER_VALUE,
+		};
+
+		const char *src = data;
+		size_t p = next();
+		STATE state = STATE_VALUE;
+		while (true)
+		{
+			if (p == END)
+				return fail(size, "unexpected end of the document");
+			char c = src[p];
+
+			if (state == STATE_VALUE)
+			{
+				state = STATE_AFTER_VALUE;
+				switch (c)
+				{
+					case '{':
+						if (stack.size() >= MAX_DEPTH)
+							return fail(p, "the document is nested too deep");
+						if (!handler.startObject())
+							return fail(p, "stopped by the handler");
+						p = next();
+						if (p != END && src[p] == '}')
+						{
+							if (!handler.endObject())
+								return fail(p, "stopped by the handler");
+							break;
+						}
+						stack.append(1);
+						state = STATE_OBJECT_KEY;
+						continue;
+					case '[':
+						if (stack.size() >= MAX_DEPTH)
+							return fail(p, "the document is nested too deep");
+						if (!handler.startArray())
+							return fail(p, "stopped by the handler");
+						p = next();
+						if (p != END && src[p] == ']')
+						{
+							if (!handler.endArray())
+								return fail(p, "stopped by the handler");
+							break;
+						}
+						stack.append(0);
+						state = STATE_VALUE;
+						continue;
+					case '"':
+					{
+						StringView value;
+						if (!parse_string(p, value))
+							return false;
+						if (!handler.string(value))
+							return fail(p, "stopped by the handler");
+						break;
+					}
+					case 't':
+						if (!parse_literal(p, "true", 4) || !handler.boolean(true))
+							return fail(p, "bad literal");
+						break;
+					case 'f':
+						if (!parse_literal(p, "false", 5) || !handler.boolean(false))
+							return fail(p, "bad literal");
+						break;
+					case 'n':
+						if (!parse_literal(p, "null", 4) || !handler.null())
+							return fail(p, "bad literal");
+						break;
+					default:
+					{
+						long long integer = 0;
+						double number = 0.0;
+						int type = parse_number(p, integer, number);
+						if (type == NUMBER_NONE)
+							return fail(p, "bad value");
+						if (type == NUMBER_INTEGER ? !handler.integer(integer) : !handler.number(number))
+							return fail(p, "stopped by the handler");
+						break;
+					}
+				}
+			} else if (state == STATE_OBJECT_KEY)
+			{
+				if (c != '"')
+					return fail(p, "expected a key");
+				StringView name;
+				if (!parse_string(p, name))
+					return false;
+				if (!handler.key(name))
+					return fail(p, "stopped by the handler");
+				p = next();
+				if (p == END || src[p] != ':')
+					return fail(p == END ? size : p, "expected ':'");
+				p = next();
+				state = STATE_VALUE;
+				continue;
+			} else
+			{
+				// STATE_AFTER_VALUE, c is the character after the value
+				if (stack.size() == 0)
+					return fail(p, "unexpected data after the document");
+				bool object = stack.last() != 0;
+				if (c == ',')
+				{
+					p = next();
+					state = object ? STATE_OBJECT_KEY : STATE_VALUE;
+					continue;
+				}
+				if (c != (object ? '}' : ']'))
+					return fail(p, object ? "expected ',' or '}'" : "expected ',' or ']'");
+				stack.removeLast();
+				if (!(object ? handler.endObject() : handler.endArray()))
+					return fail(p, "stopped by the handler");
+			}
+
+			// state is STATE_AFTER_VALUE
+			p = next();
+			if (p == END && stack.size() == 0)
+				return !in_string || fail(size, "unterminated string");
+		}
+	}
+
+	// the Json DOM in one pass, json becomes the root value
+	bool parse(const char *data, size_t size, const JsonPtr &json)
+	{
+		DomHandler handler(json);
+		return parse(data, size, handler);
+	}
+
+	UNIGINE_INLINE const char *getError() const { return error.get(); }
+	UNIGINE_INLINE size_t getErrorOffset() const { return error_offset; }
+
+	// json_stream_benchmark [size in MB]
+	static void getBenchmarkReport(String &ret, size_t size = 16 * 1024 * 1024);
+
+	static void addConsoleCommands()
+	{
+		Console::addCommand("json_stream_benchmark", "prints the throughput of JsonReader, JsonWriter and Json::parse()", MakeCallback(&JsonReader::console_benchmark));
+	}
+	static void removeConsoleCommands() { Console::removeCommand("json_stream_benchmark"); }
+
+private:
+	static constexpr size_t END = ~size_t(0);
+
+	enum
+	{
+		NUMBER_NONE = 0,
+		NUMBER_INTEGER,
+		NUMBER_DOUBLE,
+	};
+
+	//////////////////////////////////////////////////////////////////////////
+	// structural index
+	//////////////////////////////////////////////////////////////////////////
+
+	void begin(const char *d, size_t s)
+	{
+		data = d;
+		size = s;
+		indexed = 0;
+		index_pos = 0;
+		index.resize(CHUNK_SIZE + 64);
+		index_end = 0;
+		prev_escaped = 0;
+		prev_in_string = 0;
+		prev_scalar = 0;
+		in_string = false;
+		stack.clear();
+		error.clear();
+		error_offset = 0;
+	}
+
+	// position of the next structural character or value
+	UNIGINE_INLINE size_t next()
+	{
+		while (index_pos == index_end)
+		{
+			if (indexed >= size)
+				return END;
+			index_chunk();
+		}
+		return index[index_pos++];
+	}
+
+	static UNIGINE_INLINE int trailing_zeros(unsigned long long v)
+	{
+#ifdef _MSC_VER
+		unsigned long i;
+		_BitScanForward64(&i, v);
+		return int(i);
+#else
+		return __builtin_ctzll(v);
+#endif
+	}
+
+	// bit i of the result is the xor of the bits [0, i]
+	static UNIGINE_INLINE unsigned long long prefix_xor(unsigned long long v)
+	{
+		v ^= v << 1;
+		v ^= v << 2;
+		v ^= v << 4;
+		v ^= v << 8;
+		v ^= v << 16;
+		v ^= v << 32;
+		return v;
+	}
+
+	struct Masks
+	{
+		unsigned long long quote;
+		unsigned long long backslash;
+		unsigned long long op;
+		unsigned long long whitespace;
+	};
+
+	static UNIGINE_INLINE void classify(const unsigned char *s, Masks &m)
+	{
+#ifdef USE_SSE2
+		m.quote = m.backslash = m.op = m.whitespace = 0;
+		const __m128i quote = _mm_set1_epi8('"');
+		const __m128i backslash = _mm_set1_epi8('\\');
+		const __m128i lower = _mm_set1_epi8(0x20);
+		const __m128i open = _mm_set1_epi8('{');
+		const __m128i close = _mm_set1_epi8('}');
+		const __m128i colon = _mm_set1_epi8(':');
+		const __m128i comma = _mm_set1_epi8(',');
+		const __m128i space = _mm_set1_epi8(' ');
+		const __m128i tab = _mm_set1_epi8('\t');
+		const __m128i line = _mm_set1_epi8('\n');
+		const __m128i ret = _mm_set1_epi8('\r');
+		for (int i = 0; i < 4; i++)
+		{
+			__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i * 16));
+			// '[' and ']' become '{' and '}'
+			__m128i v_lower = _mm_or_si128(v, lower);
+			__m128i op = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v_lower, open), _mm_cmpeq_epi8(v_lower, close)),
+				_mm_or_si128(_mm_cmpeq_epi8(v, colon), _mm_cmpeq_epi8(v, comma)));
+			__m128i ws = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(v, tab)),
+				_mm_or_si128(_mm_cmpeq_epi8(v, line), _mm_cmpeq_epi8(v, ret)));
+			int shift = i * 16;
+			m.quote |= (unsigned long long)(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(v, quote)) << shift;
+			m.backslash |= (unsigned long long)(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(v, backslash)) << shift;
+			m.op |= (unsigned long long)(unsigned int)_mm_movemask_epi8(op) << shift;
+			m.whitespace |= (unsigned long long)(unsigned int)_mm_movemask_epi8(ws) << shift;
+		}
+#else
+		m.quote = m.backslash = m.op = m.whitespace = 0;
+		for (int i = 0; i < 64; i++)
+		{
+			unsigned long long bit = 1ULL << i;
+			switch (s[i])
+			{
+				case '"': m.quote |= bit; break;
+				case '\\': m.backslash |= bit; break;
+				case '{': case '}': case '[': case ']': case ':': case ',': m.op |= bit; break;
+				case ' ': case '\t': case '\n': case '\r': m.whitespace |= bit; break;
+				default: break;
+			}
+		}
+#endif
+	}
+
+	// characters escaped by an odd number of backslashes
+	UNIGINE_INLINE unsigned long long find_escaped(unsigned long long backslash)
+	{
+		const unsigned long long even_bits = 0x5555555555555555ULL;
+		if (!backslash)
+		{
+			unsigned long long escaped = prev_escaped;
+			prev_escaped = 0;
+			return escaped;
+		}
+		backslash &= ~prev_escaped;
+		unsigned long long follows_escape = (backslash << 1) | prev_escaped;
+		unsigned long long odd_starts = backslash & ~even_bits & ~follows_escape;
+		unsigned long long sequences_on_even = odd_starts + backslash;
+		prev_escaped = sequences_on_even < odd_starts ? 1 : 0;
+		unsigned long long invert_mask = sequences_on_even << 1;
+		return (even_bits ^ invert_mask) & follows_escape;
+	}
+
+	void index_chunk()
+	{
+		const unsigned char *src = reinterpret_cast<const unsigned char *>(data);
+		size_t chunk_end = indexed + CHUNK_SIZE < size ? indexed + CHUNK_SIZE : size;
+		unsigned int *out = index.get();
+		index_pos = 0;
+
+		for (size_t base = indexed; base < chunk_end; base += 64)
+		{
+			// the tail is padded with spaces
+			const unsigned char *block = src + base;
+			unsigned char padded[64];
+			if (base + 64 > size)
+			{
+				memset(padded, ' ', sizeof(padded));
+				memcpy(padded, block, size - base);
+				block = padded;
+			}
+
+			Masks m;
+			classify(block, m);
+			unsigned long long escaped = find_escaped(m.backslash);
+			unsigned long long quote = m.quote & ~escaped;
+			unsigned long long string = prefix_xor(quote) ^ prev_in_string;
+			prev_in_string = (unsigned long long)((long long)string >> 63);
+			unsigned long long string_tail = string ^ quote;
+
+			// first characters of scalars and strings, the operators
+			unsigned long long scalar = ~(m.op | m.whitespace);
+			unsigned long long nonquote_scalar = scalar & ~quote;
+			unsigned long long follows_scalar = (nonquote_scalar << 1) | prev_scalar;
+			prev_scalar = nonquote_scalar >> 63;
+			unsigned long long structurals = (m.op | (scalar & ~follows_scalar)) & ~string_tail;
+			if (base + 64 > size)
+				structurals &= (1ULL << (size - base)) - 1;
+
+			while (structurals)
+			{
+				*out++ = (unsigned int)(base + trailing_zeros(structurals));
+				structurals &= structurals - 1;
+			}
+		}
+
+		indexed = chunk_end;
+		in_string = prev_in_string != 0;
+		index_end = int(out - index.get());
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// values
+	//////////////////////////////////////////////////////////////////////////
+
+	UNIGINE_INLINE bool is_delimiter(size_t p) const
+	{
+		if (p >= size)
+			return true;
+		char c = data[p];
+		return c == ',' || c == '}' || c == ']' || c == ':' || c == ' ' || c == '\t' || c == '\n' || c == '\r';
+	}
+
+	bool parse_literal(size_t p, const char *literal, size_t length) const
+	{
+		return p + length <= size && memcmp(data + p, literal, length) == 0 && is_delimiter(p + length);
+	}
+
+	static UNIGINE_INLINE int hex_value(char c)
+	{
+		if (c >= '0' && c <= '9')
+			return c - '0';
+		if (c >= 'a' && c <= 'f')
+			return c - 'a' + 10;
+		if (c >= 'A' && c <= 'F')
+			return c - 'A' + 10;
+		return -1;
+	}
+
+	bool parse_hex4(size_t p, unsigned int &code)
+	{
+		if (p + 4 > size)
+			return false;
+		code = 0;
+		for (int i = 0; i < 4; i++)
+		{
+			int v = hex_value(data[p + i]);
+			if (v < 0)
+				return false;
+			code = (code << 4) | unsigned(v);
+		}
+		return true;
+	}
+
+	// string starting with the quote at p
+	bool parse_string(size_t p, StringView &ret)
+	{
+		const unsigned char *src = reinterpret_cast<const unsigned char *>(data);
+		size_t begin = p + 1;
+		size_t i = begin;
+
+		// views for strings without escapes
+#ifdef USE_SSE2
+		const __m128i quote = _mm_set1_epi8('"');
+		const __m128i backslash = _mm_set1_epi8('\\');
+		const __m128i control = _mm_set1_epi8(0x1f);
+		for (; i + 16 <= size; i += 16)
+		{
+			__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+			__m128i special = _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash));
+			special = _mm_or_si128(special, _mm_cmpeq_epi8(_mm_min_epu8(v, control), v));
+			int mask = _mm_movemask_epi8(special);
+			if (mask)
+			{
+				i += trailing_zeros((unsigned long long)(unsigned int)mask);
+				break;
+			}
+		}
+#endif
+		for (; i < size; i++)
+		{
+			unsigned char c = src[i];
+			if (c == '"' || c == '\\' || c < 0x20)
+				break;
+		}
+		if (i >= size)
+			return fail(p, "unterminated string");
+		if (src[i] == '"')
+		{
+			ret = StringView(data + begin, int(i - begin));
+			return true;
+		}
+		if (src[i] != '\\')
+			return fail(i, "control character in a string");
+
+		// escapes are decoded into the scratch buffer
+		scratch.clear();
+		scratch.append(data + begin, int(i - begin));
+		while (true)
+		{
+			if (i >= size)
+				return fail(p, "unterminated string");
+			unsigned char c = src[i];
+			if (c == '"')
+				break;
+			if (c < 0x20)
+				return fail(i, "control character in a string");
+			if (c != '\\')
+			{
+				scratch.append(char(c));
+				i++;
+				continue;
+			}
+			if (i + 1 >= size)
+				return fail(p, "unterminated string");
+			char e = data[i + 1];
+			i += 2;
+			switch (e)
+			{
+				case '"': scratch.append('"'); break;
+				case '\\': scratch.append('\\'); break;
+				case '/': scratch.append('/'); break;
+				case 'b': scratch.append('\b'); break;
+				case 'f': scratch.append('\f'); break;
+				case 'n': scratch.append('\n'); break;
+				case 'r': scratch.append('\r'); break;
+				case 't': scratch.append('\t'); break;
+				case 'u':
+				{
+					unsigned int code;
+					if (!parse_hex4(i, code))
+						return fail(i, "bad unicode escape");
+					i += 4;
+					if (code >= 0xd800 && code < 0xdc00)
+					{
+						unsigned int low;
+						if (i + 2 > size || data[i] != '\\' || data[i + 1] != 'u' || !parse_hex4(i + 2, low) || low < 0xdc00 || low >= 0xe000)
+							return fail(i, "bad surrogate pair");
+						i += 6;
+						code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+					} else if (code >= 0xdc00 && code < 0xe000)
+						return fail(i, "bad surrogate pair");
+					append_utf8(code);
+					break;
+				}
+				default:
+					return fail(i - 1, "bad escape");
+			}
+		}
+		ret = StringView(scratch.get(), scratch.size());
+		return true;
+	}
+
+	void append_utf8(unsigned int code)
+	{
+		if (code < 0x80)
+			scratch.append(char(code));
+		else if (code < 0x800)
+		{
+			scratch.append(char(0xc0 | (code >> 6)));
+			scratch.append(char(0x80 | (code & 0x3f)));
+		} else if (code < 0x10000)
+		{
+			scratch.append(char(0xe0 | (code >> 12)));
+			scratch.append(char(0x80 | ((code >> 6) & 0x3f)));
+			scratch.append(char(0x80 | (code & 0x3f)));
+		} else
+		{
+			scratch.append(char(0xf0 | (code >> 18)));
+			scratch.append(char(0x80 | ((code >> 12) & 0x3f)));
+			scratch.append(char(0x80 | ((code >> 6) & 0x3f)));
+			scratch.append(char(0x80 | (code & 0x3f)));
+		}
+	}
+
+	// integers up to 64 bits are exact, short decimals are converted with
+	// one multiplication by an exact power of ten
+	int parse_number(size_t p, long long &integer, double &number)
+	{
+		static const double powers[] = {
+			1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+			1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+		};
+
+		size_t i = p;
+		bool negative = false;
+		if (i < size && data[i] == '-')
+		{
+			negative = true;
+			i++;
+		}
+		if (i >= size || data[i] < '0' || data[i] > '9')
+			return NUMBER_NONE;
+
+		unsigned long long mantissa = 0;
+		int digits = 0;
+		size_t int_begin = i;
+		for (; i < size && data[i] >= '0' && data[i] <= '9'; i++)
+		{
+			if (mantissa == 0 && data[i] == '0')
+				continue;
+			if (digits < 19)
+				mantissa = mantissa * 10 + unsigned(data[i] - '0');
+			digits++;
+		}
+		if (data[int_begin] == '0' && i - int_begin > 1)
+			return NUMBER_NONE;
+		int exponent = digits > 19 ? digits - 19 : 0;
+
+		bool fraction = false;
+		if (i < size && data[i] == '.')
+		{
+			fraction = true;
+			i++;
+			size_t fraction_begin = i;
+			for (; i < size && data[i] >= '0' && data[i] <= '9'; i++)
+			{
+				// leading zeros of 0.000123 only move the decimal point
+				if (mantissa == 0 && data[i] == '0')
+				{
+					exponent--;
+					continue;
+				}
+				if (digits < 19)
+				{
+					mantissa = mantissa * 10 + unsigned(data[i] - '0');
+					exponent--;
+				}
+				digits++;
+			}
+			if (i == fraction_begin)
+				return NUMBER_NONE;
+		}
+		if (i < size && (data[i] == 'e' || data[i] == 'E'))
+		{
+			fraction = true;
+			i++;
+			bool exponent_negative = false;
+			if (i < size && (data[i] == '+' || data[i] == '-'))
+				exponent_negative = data[i++] == '-';
+			size_t exponent_begin = i;
+			int value = 0;
+			for (; i < size && data[i] >= '0' && data[i] <= '9'; i++)
+			{
+				if (value < 100000)
+					value = value * 10 + (data[i] - '0');
+			}
+			if (i == exponent_begin)
+				return NUMBER_NONE;
+			exponent += exponent_negative ? -value : value;
+		}
+		if (!is_delimiter(i))
+			return NUMBER_NONE;
+
+		if (!fraction && digits <= 19 && mantissa <= (negative ? 0x8000000000000000ULL : 0x7fffffffffffffffULL))
+		{
+			integer = negative ? (long long)(0ULL - mantissa) : (long long)mantissa;
+			return NUMBER_INTEGER;
+		}
+		if (mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22)
+		{
+			number = double(mantissa);
+			number = exponent < 0 ? number / powers[-exponent] : number * powers[exponent];
+			if (negative)
+				number = -number;
+			return NUMBER_DOUBLE;
+		}
+
+		// long mantissas and large exponents
+		scratch.clear();
+		scratch.append(data + p, int(i - p));
+		scratch.append('\0');
+		number = strtod(scratch.get(), nullptr);
+		return NUMBER_DOUBLE;
+	}
+
+	bool fail(size_t offset, const char *message)
+	{
+		error = message;
+		error_offset = offset;
+		Log::error("JsonReader::parse(): %s at offset %llu\n", message, (unsigned long long)offset);
+		return false;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// Json DOM
+	//////////////////////////////////////////////////////////////////////////
+
+	class DomHandler : public JsonHandler
+	{
+	public:
+		DomHandler(const JsonPtr &root) : root(root) { root->clear(); }
+
+		bool startObject() { add()->setObject(); nodes.append(node); objects.append(1); return true; }
+		bool endObject() { nodes.removeLast(); objects.removeLast(); return true; }
+		bool startArray() { add()->setArray(); nodes.append(node); objects.append(0); return true; }
+		bool endArray() { nodes.removeLast(); objects.removeLast(); return true; }
+		bool key(const StringView &name) { name_buffer.clear(); name_buffer.append(name.get(), name.size()); return true; }
+		bool string(const StringView &value) { add()->setString(StringStack<>(value.get(), value.size()).get()); return true; }
+		bool number(double value) { add()->setNumber(value); return true; }
+		bool integer(long long value)
+		{
+			if (value >= -0x7fffffffLL - 1 && value <= 0x7fffffffLL)
+				add()->setNumber(int(value));
+			else
+				add()->setNumber(double(value));
+			return true;
+		}
+		bool boolean(bool value) { add()->setBool(value ? 1 : 0); return true; }
+		bool null() { add()->setNull(); return true; }
+
+	private:
+		const JsonPtr &add()
+		{
+			if (nodes.size() == 0)
+				node = root;
+			else if (objects.last())
+				node = nodes.last()->addChild(name_buffer.get());
+			else
+				node = nodes.last()->addChild(Json::create());
+			return node;
+		}
+
+		JsonPtr root;
+		JsonPtr node;
+		Vector<JsonPtr> nodes;
+		Vector<char> objects;
+		String name_buffer;
+	};
+
+	static void console_benchmark(int argc, char **argv)
+	{
+		size_t size = 16;
+		if (argc > 1 && atoi(argv[1]) > 0)
+			size = size_t(atoi(argv[1]));
+		String report;
+		getBenchmarkReport(report, size * 1024 * 1024);
+		Log::message("%s", report.get());
+	}
+
+	const char *data{nullptr};
+	size_t size{0};
+	size_t indexed{0};
+	Vector<unsigned int> index;
+	int index_pos{0};
+	int index_end{0};
+	unsigned long long prev_escaped{0};
+	unsigned long long prev_in_string{0};
+	unsigned long long prev_scalar{0};
+	bool in_string{false};
+
+	Vector<char> stack;
+	Vector<char> scratch;
+	String error;
+	size_t error_offset{0};
+};
+
+inline void JsonReader::getBenchmarkReport(String &ret, size_t size)
+{
+	// telemetry-like records
+	BlobPtr source = Blob::create();
+	{
+		JsonWriter writer(source);
+		writer.startArray();
+		unsigned int state = 1;
+		auto random = [&]() { state = state * 1664525u + 1013904223u; return state >> 8; };
+		for (int i = 0; writer.tell() < size; i++)
+		{
+			writer.startObject();
+			writer.key("frame");
+			writer.integer(i);
+			writer.key("player");
+			writer.string(String::format("tank_%u", random() % 64).get());
+			writer.key("position");
+			writer.startArray();
+			for (int j = 0; j < 3; j++)
+				writer.number(double(random() % 100000) * 0.01);
+			writer.endArray();
+			writer.key("health");
+			writer.number(double(random() % 1000) * 0.1);
+			writer.key("alive");
+			writer.boolean((random() & 1) != 0);
+			writer.key("event");
+			if (random() % 4)
+				writer.null();
+			else
+				writer.string("hit \"turret\"\n");
+			writer.endObject();
+		}
+		writer.endArray();
+		writer.close();
+	}
+	source->writeUChar(0);
+	const char *data = reinterpret_cast<const char *>(source->getData());
+	size_t length = source->getSize() - 1;
+
+	ret.clear();
+	Format::append(ret, "{} MB of telemetry records\n", (unsigned long long)(length >> 20));
+	JsonReader reader;
+	Format::appendThroughput(ret, "JsonReader", length, 4, [&]() { JsonHandler handler; return reader.parse(data, length, handler); });
+	Format::appendThroughput(ret, "JsonReader -> JsonWriter", length, 2, [&]() { JsonWriter writer(Blob::create()); return reader.parse(data, length, writer) && writer.close(); });
+	Format::appendThroughput(ret, "JsonReader -> Json", length, 1, [&]() { JsonPtr json = Json::create(); return reader.parse(data, length, json); });
+	Format::appendThroughput(ret, "Json::parse", length, 1, [&]() { JsonPtr json = Json::create(); return json->parse(data) != 0; });
+
+	// numbers that take the exact and the strtod paths, long runs of leading zeros keep their digits
+	struct NumberHandler : public JsonHandler
+	{
+		bool number(double v) { value = v; return true; }
+		double value{0.0};
+	};
+	static const char *numbers[] =
+	{
+		"[0.00000000000000000001234]", "[0.0000000000000000000000000000005]", "[-0.000000000000000000000000123e-3]",
+		"[0.1]", "[1.5e300]", "[123456789012345678901234567890.5]", "[0.0]",
+	};
+	int num_failed = 0;
+	for (const char *number : numbers)
+	{
+		NumberHandler handler;
+		if (!reader.parse(number, strlen(number), handler) || handler.value != strtod(number + 1, nullptr))
+			num_failed++;
+	}
+	Format::append(ret, "{:<28}{} of {} failed\n", "number parsing", num_failed, int(sizeof(numbers) / sizeof(numbers[0])));
+}
+
+} // namespace Unigine
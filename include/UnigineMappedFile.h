@@ -0,0 +1,382 @@
+/* Copyright (C) 2005-2020, UNIGINE. All rights reserved.
+ *
+ * This file is a part of the UNIGINE 2 SDK.
+ *
+ * Your use and / or redistribution of this software in source and / or
+ * binary form, with or without modification, is subject to: (i) your
+ * ongoing acceptance of and compliance with the terms and conditions of
+ * the UNIGINE License Agreement; and (ii) your inclusion of this notice
+ * in any version of this software that you use or redistribute.
+ * A copy of the UNIGINE License Agreement is available by contacting
+ * UNIGINE. at http://unigine.com/
+ */
+
+
+#pragma once
+
+#include "UnigineBase.h"
+#include "UnigineStreams.h"
+#include "UnigineFileSystem.h"
+#include "UnigineVector.h"
+#include "UnigineString.h"
+#include "UnigineLog.h"
+
+#ifdef _WIN32
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+		#define UNIGINE_MAPPED_FILE_LEAN
+	#endif
+	#include <windows.h>
+	#ifdef UNIGINE_MAPPED_FILE_LEAN
+		#undef WIN32_LEAN_AND_MEAN
+		#undef UNIGINE_MAPPED_FILE_LEAN
+	#endif
+	#ifdef min
+		#undef min
+	#endif
+	#ifdef max
+		#undef max
+	#endif
+#elif _LINUX
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+// Mapped file example
+/*
+	MappedFile file;
+	if (!file.open("levels/level_0.bin"))
+		return 0;
+
+	// zero-copy access, the pointer is valid until close()
+	file.setAdvice(MappedFile::ADVICE_SEQUENTIAL);
+	const Header *header = static_cast<const Header *>(file.view(0, sizeof(Header)));
+	file.prefetch(header->data_offset, header->data_size);
+	const float *data = static_cast<const float *>(file.view(header->data_offset, header->data_size));
+
+	// or as a stream, the MappedFile must outlive it
+	StreamPtr stream = file.getStream();
+	StreamBufferReader reader(stream);
+*/
+
+namespace Unigine
+{
+
+//////////////////////////////////////////////////////////////////////////
+/// Read-only memory-mapped file.
+///
+/// Disk files are mapped as a whole, view() returns pointers into the
+/// mapping without copying. Files from packages and other non-disk
+/// sources fall back to buffered File reads: view() then copies into an
+/// internal buffer that is valid until the next view() call.
+//////////////////////////////////////////////////////////////////////////
+
+class MappedFile : public StreamBase
+{
+public:
+	enum ADVICE
+	{
+		ADVICE_NORMAL = 0,
+		ADVICE_SEQUENTIAL,	// aggressive read-ahead, pages are dropped early
+		ADVICE_RANDOM,	// no read-ahead
+	};
+
+	MappedFile() = default;
+	MappedFile(const char *path) { open(path); }
+	~MappedFile() override { close(); }
+
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	// path is resolved through FileSystem when it is initialized
+	bool open(const char *path)
+	{
+		close();
+
+		String absolute_path = path;
+		bool disk = true;
+		if (FileSystem::isInitialized())
+		{
+			disk = FileSystem::isDiskFile(path) && !FileSystem::isPackageFile(path);
+			if (disk)
+				absolute_path = FileSystem::getAbsolutePath(path);
+		}
+
+		if (disk && map(absolute_path.get()))
+		{
+			name = path;
+			return true;
+		}
+
+		// packages and files the platform can't map
+		file = File::create(path, "rb");
+		if (!file || !file->isOpened())
+		{
+			Log::error("MappedFile::open(): can't open \"%s\" file\n", path);
+			file.clear();
+			return false;
+		}
+		size = file->getSize();
+		position = 0;
+		name = path;
+		return true;
+	}
+
+	void close()
+	{
+		unmap();
+		file.clear();
+		fallback.destroy();
+		name.clear();
+		size = 0;
+		position = 0;
+	}
+
+	UNIGINE_INLINE bool isMapped() const { return mapped; }
+	UNIGINE_INLINE const char *getName() const { return name.get(); }
+	UNIGINE_INLINE size_t getSize() const { return size; }
+	UNIGINE_INLINE size_t tell() const { return position; }
+
+	bool seekSet(size_t offset)
+	{
+		if (offset > size)
+			return false;
+		position = offset;
+		return true;
+	}
+
+	// pointer to size bytes at offset or nullptr if the range is out of the file
+	const void *view(size_t offset, size_t view_size)
+	{
+		if (offset > size || view_size > size - offset)
+			return nullptr;
+		if (mapped)
+			return data + offset;
+		if (!file)
+			return nullptr;
+		fallback.resize(int(view_size));
+		if (!file->seekSet(offset) || file->read(fallback.get(), view_size) != view_size)
+		{
+			Log::error("MappedFile::view(): can't read %llu bytes from \"%s\" file\n", (unsigned long long)view_size, name.get());
+			return nullptr;
+		}
+		return fallback.get();
+	}
+
+	// whole mapping, nullptr for the fallback
+	UNIGINE_INLINE const unsigned char *getData() const { return mapped ? data : nullptr; }
+
+	// asynchronous read of the range into the page cache
+	void prefetch(size_t offset, size_t prefetch_size)
+	{
+		if (!mapped || !get_range(offset, prefetch_size))
+			return;
+#ifdef _WIN32
+		struct RangeEntry
+		{
+			void *address;
+			SIZE_T size;
+		};
+		using PrefetchFunc = BOOL(WINAPI *)(HANDLE, ULONG_PTR, RangeEntry *, ULONG);
+		static PrefetchFunc prefetch_func = reinterpret_cast<PrefetchFunc>(
+			reinterpret_cast<void *>(GetProcAddress(GetModuleHandleA("kernel32.dll"), "PrefetchVirtualMemory")));
+		if (prefetch_func)
+		{
+			RangeEntry range = {const_cast<unsigned char *>(data) + offset, prefetch_size};
+			prefetch_func(GetCurrentProcess(), 1, &range, 0);
+		}
+#elif _LINUX
+		madvise(const_cast<unsigned char *>(data) + offset, prefetch_size, MADV_WILLNEED);
+#endif
+	}
+
+	// drops the pages of the range, they are read again on access
+	void evict(size_t offset, size_t evict_size)
+	{
+		if (!mapped || !get_range(offset, evict_size))
+			return;
+#ifdef _WIN32
+		// unlocking pages that are not locked removes them from the working set
+		VirtualUnlock(const_cast<unsigned char *>(data) + offset, evict_size);
+#elif _LINUX
+		madvise(const_cast<unsigned char *>(data) + offset, evict_size, MADV_DONTNEED);
+#endif
+	}
+
+	// access pattern hint for the whole file, Windows takes the hint from the
+	// sequential reads themselves
+	void setAdvice(ADVICE advice)
+	{
+		if (!mapped || size == 0)
+			return;
+#ifdef _LINUX
+		int value = advice == ADVICE_SEQUENTIAL ? MADV_SEQUENTIAL : advice == ADVICE_RANDOM ? MADV_RANDOM : MADV_NORMAL;
+		madvise(const_cast<unsigned char *>(data), size, value);
+#else
+		UNIGINE_UNUSED(advice);
+#endif
+	}
+
+	// StreamBase
+	int isOpened() override { return mapped || file.isValid(); }
+	int isAvailable() override { return isOpened() && position < size; }
+
+	size_t read(void *ptr, size_t element_size, size_t nmemb) override
+	{
+		if (element_size == 0 || position >= size)
+			return 0;
+		size_t num = nmemb;
+		if (num > (size - position) / element_size)
+			num = (size - position) / element_size;
+		size_t bytes = num * element_size;
+		if (mapped)
+		{
+			memcpy(ptr, data + position, bytes);
+		} else
+		{
+			if (!file->seekSet(position))
+				return 0;
+			bytes = file->read(ptr, bytes);
+			num = bytes / element_size;
+		}
+		position += bytes;
+		return num;
+	}
+
+	size_t write(const void *ptr, size_t element_size, size_t nmemb) override
+	{
+		UNIGINE_UNUSED(ptr);
+		UNIGINE_UNUSED(element_size);
+		UNIGINE_UNUSED(nmemb);
+		Log::error("MappedFile::write(): \"%s\" file is read-only\n", name.get());
+		return 0;
+	}
+
+private:
+	// page-aligned range inside the mapping
+	bool get_range(size_t &offset, size_t &range_size) const
+	{
+		if (offset >= size)
+			return false;
+		if (range_size > size - offset)
+			range_size = size - offset;
+		size_t page = get_page_size();
+		size_t begin = offset & ~(page - 1);
+		range_size += offset - begin;
+		offset = begin;
+		return range_size != 0;
+	}
+
+	static size_t get_page_size()
+	{
+#ifdef _WIN32
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		return info.dwPageSize;
+#elif _LINUX
+		return size_t(sysconf(_SC_PAGESIZE));
+#else
+		return 4096;
+#endif
+	}
+
+	bool map(const char *path)
+	{
+#ifdef _WIN32
+		int length = MultiByteToWideChar(CP_UTF8, 0, path, -1, nullptr, 0);
+		if (length <= 0)
+			return false;
+		Vector<wchar_t> wide_path;
+		wide_path.resize(length);
+		MultiByteToWideChar(CP_UTF8, 0, path, -1, wide_path.get(), length);
+
+		HANDLE handle = CreateFileW(wide_path.get(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (handle == INVALID_HANDLE_VALUE)
+			return false;
+		LARGE_INTEGER file_size;
+		if (!GetFileSizeEx(handle, &file_size))
+		{
+			CloseHandle(handle);
+			return false;
+		}
+		size = size_t(file_size.QuadPart);
+		if (size)
+		{
+			mapping = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (mapping)
+				data = static_cast<const unsigned char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		}
+		CloseHandle(handle);
+		if (size && !data)
+		{
+			if (mapping)
+				CloseHandle(mapping);
+			mapping = nullptr;
+			size = 0;
+			return false;
+		}
+#elif _LINUX
+		int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+		if (fd < 0)
+			return false;
+		struct stat info;
+		if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode))
+		{
+			::close(fd);
+			return false;
+		}
+		size = size_t(info.st_size);
+		if (size)
+		{
+			void *ptr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+			data = ptr != MAP_FAILED ? static_cast<const unsigned char *>(ptr) : nullptr;
+		}
+		::close(fd);
+		if (size && !data)
+		{
+			size = 0;
+			return false;
+		}
+#else
+		UNIGINE_UNUSED(path);
+		return false;
+#endif
+		mapped = true;
+		position = 0;
+		return true;
+	}
+
+	void unmap()
+	{
+		if (!mapped)
+			return;
+#ifdef _WIN32
+		if (data)
+			UnmapViewOfFile(data);
+		if (mapping)
+			CloseHandle(mapping);
+		mapping = nullptr;
+#elif _LINUX
+		if (data)
+			munmap(const_cast<unsigned char *>(data), size);
+#endif
+		data = nullptr;
+		mapped = false;
+	}
+
+	String name;
+	const unsigned char *data{nullptr};
+	size_t size{0};
+	size_t position{0};
+	bool mapped{false};
+#ifdef _WIN32
+	HANDLE mapping{nullptr};
+#endif
+
+	FilePtr file;
+	Vector<unsigned char> fallback;
+};
+
+} // namespace Unigine
@@ -51,6 +51,27 @@ public:
 	static UNIGINE_API int getNumFrameAllocations();
 };
 
+} // namespace
+
+// allocation hooks for the header code, define UNIGINE_MEMORY_TRACKER for the whole project to track them
+#ifdef UNIGINE_MEMORY_TRACKER
+	#include "UnigineMemoryTracker.h"
+	#define UNIGINE_MEMORY_ALLOCATE(SIZE)				Unigine::MemoryTracker::allocate(SIZE)
+	#define UNIGINE_MEMORY_DEALLOCATE(PTR)				Unigine::MemoryTracker::deallocate(PTR)
+	#define UNIGINE_MEMORY_DEALLOCATE_SIZE(PTR, SIZE)	Unigine::MemoryTracker::deallocate(PTR, SIZE)
+	#define UNIGINE_MEMORY_SCOPE(NAME)					Unigine::MemoryTrackerScope UNIGINE_MEMORY_SCOPE_NAME(__LINE__)(NAME)
+	#define UNIGINE_MEMORY_SCOPE_NAME(LINE)				UNIGINE_MEMORY_SCOPE_CONCAT(unigine_memory_scope_, LINE)
+	#define UNIGINE_MEMORY_SCOPE_CONCAT(A, B)			A ## B
+#else
+	#define UNIGINE_MEMORY_ALLOCATE(SIZE)				Unigine::Memory::allocate(SIZE)
+	#define UNIGINE_MEMORY_DEALLOCATE(PTR)				Unigine::Memory::deallocate(PTR)
+	#define UNIGINE_MEMORY_DEALLOCATE_SIZE(PTR, SIZE)	Unigine::Memory::deallocate(PTR, SIZE)
+	#define UNIGINE_MEMORY_SCOPE(NAME)
+#endif
+
+namespace Unigine
+{
+
 /// Unigine Base class; managed using Unigine allocator by default
 class Base
 {
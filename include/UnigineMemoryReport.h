@@ -0,0 +1,215 @@
+/* Copyright (C) 2005-2020, UNIGINE. All rights reserved.
+ *
+ * This file is a part of the UNIGINE 2 SDK.
+ *
+ * Your use and / or redistribution of this software in source and / or
+ * binary form, with or without modification, is subject to: (i) your
+ * ongoing acceptance of and compliance with the terms and conditions of
+ * the UNIGINE License Agreement; and (ii) your inclusion of this notice
+ * in any version of this software that you use or redistribute.
+ * A copy of the UNIGINE License Agreement is available by contacting
+ * UNIGINE. at http://unigine.com/
+ */
+
+
+#pragma once
+
+#include "UnigineBase.h"
+#include "UnigineString.h"
+#include "UnigineVector.h"
+#include "UnigineSort.h"
+#include "UnigineFormat.h"
+#include "UnigineStreams.h"
+#include "UnigineConsole.h"
+#include "UnigineCallback.h"
+
+#ifndef UNIGINE_MEMORY_TRACKER
+	#error "UnigineMemoryReport.h: define UNIGINE_MEMORY_TRACKER for the whole project"
+#endif
+
+// Memory report example
+/*
+	// AppSystemLogic::init()
+	Unigine::MemoryTracker::setEnabled(true);
+	Unigine::MemoryReport::addConsoleCommands();
+
+	// AppSystemLogic::update()
+	Unigine::MemoryTracker::update();
+
+	// anywhere, UNIGINE_PROFILER_SCOPED names the allocations as well
+	UNIGINE_MEMORY_SCOPE("Tank::spawnShells");
+
+	// AppSystemLogic::shutdown(), live allocations are reported as leaks
+	Unigine::MemoryReport::saveReport("memory_report.txt");
+	Unigine::MemoryReport::removeConsoleCommands();
+*/
+
+namespace Unigine
+{
+
+//////////////////////////////////////////////////////////////////////////
+/// Text reports of MemoryTracker statistics.
+//////////////////////////////////////////////////////////////////////////
+
+class MemoryReport
+{
+public:
+	// share of the reserved allocator heap not used by live allocations, an upper bound of the fragmentation
+	static float getFragmentation()
+	{
+		const MemoryStats &stats = Memory::getStats();
+		long long reserved = stats.total_bytes - stats.system_bytes;
+		if (reserved <= 0)
+			return 0.0f;
+		double used = double(stats.heap_used_bytes) / double(reserved);
+		return used < 1.0 ? float(1.0 - used) : 0.0f;
+	}
+
+	// sites sorted by the bytes allocated during the last frame
+	static void getFrameReport(String &ret, int max_sites = 16)
+	{
+		Sites sites;
+		get_sites(sites);
+		quickSort(sites.get(), sites.size(), [](const MemoryTracker::Site &s0, const MemoryTracker::Site &s1)
+		{
+			return s0.last_frame_bytes > s1.last_frame_bytes;
+		});
+
+		const MemoryStats &stats = Memory::getStats();
+		Format::append(ret, "last frame: {} engine allocations\n", stats.frame_allocs);
+		ret.append("   allocs        bytes  scope\n");
+		for (int i = 0; i < sites.size() && i < max_sites; i++)
+		{
+			const MemoryTracker::Site &s = sites[i];
+			if (s.last_frame_allocs == 0)
+				break;
+			Format::append(ret, "{:9}{:13}  {}\n", s.last_frame_allocs, s.last_frame_bytes, s.name);
+		}
+	}
+
+	// sites sorted by the bytes allocated since the start or the last reset
+	static void getSessionReport(String &ret, int max_sites = 32)
+	{
+		Sites sites;
+		get_sites(sites);
+		quickSort(sites.get(), sites.size(), [](const MemoryTracker::Site &s0, const MemoryTracker::Site &s1)
+		{
+			return s0.bytes > s1.bytes;
+		});
+
+		long long frames = MemoryTracker::getFrame();
+		ret.append("   allocs  allocs/frame        bytes   bytes/frame  lifetime  same frame  scope\n");
+		for (int i = 0; i < sites.size() && i < max_sites; i++)
+		{
+			const MemoryTracker::Site &s = sites[i];
+			if (s.allocs == 0)
+				break;
+			double lifetime = s.frees ? double(s.lifetime_frames) / double(s.frees) : 0.0;
+			double same_frame = s.frees ? double(s.frame_lifetime_allocs) * 100.0 / double(s.frees) : 0.0;
+			Format::append(ret, "{:9}{:14.1}{:13}{:14.1}{:10.1}{:11.1}%  {}\n", s.allocs, double(s.allocs) / double(frames > 0 ? frames : 1),
+				s.bytes, double(s.bytes) / double(frames > 0 ? frames : 1), lifetime, same_frame, s.name);
+		}
+	}
+
+	// live allocations per site, call at shutdown to list the leaks
+	static void getLeakReport(String &ret)
+	{
+		Sites sites;
+		get_sites(sites);
+		quickSort(sites.get(), sites.size(), [](const MemoryTracker::Site &s0, const MemoryTracker::Site &s1)
+		{
+			return s0.live_bytes > s1.live_bytes;
+		});
+
+		ret.append("   allocs        bytes  scope\n");
+		for (int i = 0; i < sites.size(); i++)
+		{
+			const MemoryTracker::Site &s = sites[i];
+			if (s.live_allocs == 0)
+				continue;
+			Format::append(ret, "{:9}{:13}  {}\n", s.live_allocs, s.live_bytes, s.name);
+		}
+	}
+
+	static void getReport(String &ret)
+	{
+		const MemoryStats &stats = Memory::getStats();
+		size_t interval = MemoryTracker::getSampleInterval();
+
+		ret.clear();
+		if (interval)
+			Format::append(ret, "sampled every {} bytes, counts are estimates\n", (unsigned long long)interval);
+		Format::append(ret, "heap: {} used of {} reserved bytes, fragmentation {:.1}%, system: {} bytes\n\n",
+			stats.heap_used_bytes, stats.total_bytes - stats.system_bytes, getFragmentation() * 100.0f, stats.system_bytes);
+		getFrameReport(ret);
+		ret.append("\nsession:\n");
+		getSessionReport(ret);
+		ret.append("\nlive allocations:\n");
+		getLeakReport(ret);
+	}
+
+	static bool saveReport(const char *path)
+	{
+		String report;
+		getReport(report);
+		FilePtr file = File::create(path, "wb");
+		if (!file || !file->isOpened())
+		{
+			Log::error("MemoryReport::saveReport(): can't create \"%s\" file\n", path);
+			return false;
+		}
+		return file->write(report.get(), report.size()) == size_t(report.size());
+	}
+
+	// memory_tracker [0|1], memory_tracker_report [file]
+	static void addConsoleCommands()
+	{
+		Console::addCommand("memory_tracker", "toggles the allocation tracker", MakeCallback(&MemoryReport::console_tracker));
+		Console::addCommand("memory_tracker_report", "prints or saves the allocation tracker report", MakeCallback(&MemoryReport::console_report));
+	}
+
+	static void removeConsoleCommands()
+	{
+		Console::removeCommand("memory_tracker");
+		Console::removeCommand("memory_tracker_report");
+	}
+
+private:
+	// the report must not show up in the live allocations
+	struct UntrackedAllocator
+	{
+		static char *allocate(size_t size) { return (char *)Memory::allocate(size); }
+		static void deallocate(char *ptr) { Memory::deallocate(ptr); }
+	};
+	using Sites = Vector<MemoryTracker::Site, int, UntrackedAllocator>;
+
+	static void get_sites(Sites &sites)
+	{
+		int num = MemoryTracker::getNumSites();
+		sites.resize(num);
+		for (int i = 0; i < num; i++)
+			sites[i] = MemoryTracker::getSite(i);
+	}
+
+	static void console_tracker(int argc, char **argv)
+	{
+		if (argc > 1)
+			MemoryTracker::setEnabled(atoi(argv[1]) != 0);
+		Log::message("memory_tracker: %d\n", MemoryTracker::isEnabled() ? 1 : 0);
+	}
+
+	static void console_report(int argc, char **argv)
+	{
+		if (argc > 1)
+		{
+			if (saveReport(argv[1]))
+				Log::message("memory report saved to \"%s\"\n", argv[1]);
+			return;
+		}
+		String report;
+		getFrameReport(report);
+		Log::message("%s", report.get());
+	}
+};
+
+} // namespace Unigine
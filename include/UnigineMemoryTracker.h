@@ -0,0 +1,470 @@
+/* Copyright (C) 2005-2020, UNIGINE. All rights reserved.
+ *
+ * This file is a part of the UNIGINE 2 SDK.
+ *
+ * Your use and / or redistribution of this software in source and / or
+ * binary form, with or without modification, is subject to: (i) your
+ * ongoing acceptance of and compliance with the terms and conditions of
+ * the UNIGINE License Agreement; and (ii) your inclusion of this notice
+ * in any version of this software that you use or redistribute.
+ * A copy of the UNIGINE License Agreement is available by contacting
+ * UNIGINE. at http://unigine.com/
+ */
+
+
+#pragma once
+
+// included from UnigineMemory.h when UNIGINE_MEMORY_TRACKER is defined,
+// only UnigineBase.h definitions are available here, see UnigineMemoryReport.h for reports
+
+#include <atomic>
+#include <thread>
+
+namespace Unigine
+{
+
+//////////////////////////////////////////////////////////////////////////
+/// Allocation tracker.
+///
+/// Tracks the allocations made through the UNIGINE_MEMORY_* hooks, that is
+/// by header containers (Vector, Map, Set, HashMap, HashSet) and classes
+/// with UNIGINE_DECLARE_USE_MEMORY compiled into the application. The
+/// allocations made inside the engine are not visible. UNIGINE_MEMORY_TRACKER
+/// must be defined for the whole project.
+///
+/// Allocations are attributed to the innermost UNIGINE_MEMORY_SCOPE or
+/// UNIGINE_PROFILER_SCOPED scope of the allocating thread. With a zero
+/// sample interval every allocation is recorded (the default in debug
+/// builds). Otherwise one allocation per sample interval bytes is recorded
+/// and weighted, so counts and bytes are estimates.
+//////////////////////////////////////////////////////////////////////////
+
+class MemoryTracker
+{
+public:
+	enum
+	{
+		MAX_SITES = 4096,
+		MAX_SCOPE_DEPTH = 64,
+		FILTER_SIZE = 64 * 1024,
+		#ifdef NDEBUG
+			DEFAULT_SAMPLE_INTERVAL = 512 * 1024,
+		#else
+			DEFAULT_SAMPLE_INTERVAL = 0,
+		#endif
+	};
+
+	// statistics per scope name, estimates when sampling
+	struct Site
+	{
+		const char *name;
+
+		long long allocs;
+		long long bytes;
+		long long frees;
+		long long freed_bytes;
+		long long live_allocs;
+		long long live_bytes;
+
+		// lifetimes of freed allocations, in frames
+		long long lifetime_frames;
+		long long frame_lifetime_allocs; // freed in the frame of allocation
+
+		// the current and the last frame
+		long long frame_allocs;
+		long long frame_bytes;
+		long long last_frame_allocs;
+		long long last_frame_bytes;
+	};
+
+	//////////////////////////////////////////////////////////////////////////
+	// hooks
+	//////////////////////////////////////////////////////////////////////////
+
+	static UNIGINE_INLINE void *allocate(size_t size)
+	{
+		void *ptr = Memory::allocate(size);
+		if (ptr && isEnabled())
+			track_allocate(ptr, size);
+		return ptr;
+	}
+
+	static UNIGINE_INLINE void deallocate(void *ptr)
+	{
+		if (ptr && isEnabled())
+			track_deallocate(ptr);
+		Memory::deallocate(ptr);
+	}
+
+	static UNIGINE_INLINE void deallocate(void *ptr, size_t size)
+	{
+		if (ptr && isEnabled())
+			track_deallocate(ptr);
+		Memory::deallocate(ptr, size);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// attribution
+	//////////////////////////////////////////////////////////////////////////
+
+	static UNIGINE_INLINE void pushScope(const char *name)
+	{
+		ThreadState &thread = get_thread_state();
+		if (thread.depth < MAX_SCOPE_DEPTH)
+			thread.scopes[thread.depth] = name;
+		thread.depth++;
+	}
+
+	static UNIGINE_INLINE void popScope()
+	{
+		get_thread_state().depth--;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// settings
+	//////////////////////////////////////////////////////////////////////////
+
+	static UNIGINE_INLINE bool isEnabled() { return get_state().enabled.load(std::memory_order_relaxed); }
+
+	// disabling drops the live allocations, they can't be matched with deallocations any more
+	static void setEnabled(bool enabled)
+	{
+		State &state = get_state();
+		ScopedSpinLock lock(state);
+		if (enabled == state.enabled.load(std::memory_order_relaxed))
+			return;
+		if (!enabled)
+			clear_live(state);
+		state.enabled.store(enabled, std::memory_order_relaxed);
+	}
+
+	// zero records every allocation
+	static UNIGINE_INLINE void setSampleInterval(size_t bytes) { get_state().sample_interval.store((long long)bytes, std::memory_order_relaxed); }
+	static UNIGINE_INLINE size_t getSampleInterval() { return (size_t)get_state().sample_interval.load(std::memory_order_relaxed); }
+
+	//////////////////////////////////////////////////////////////////////////
+	// statistics
+	//////////////////////////////////////////////////////////////////////////
+
+	// call once per frame
+	static void update()
+	{
+		State &state = get_state();
+		ScopedSpinLock lock(state);
+		for (int i = 0; i < state.num_sites; i++)
+		{
+			Site &site = state.sites[i];
+			site.last_frame_allocs = site.frame_allocs;
+			site.last_frame_bytes = site.frame_bytes;
+			site.frame_allocs = 0;
+			site.frame_bytes = 0;
+		}
+		state.frame++;
+	}
+
+	// clears the statistics, live allocations are kept
+	static void reset()
+	{
+		State &state = get_state();
+		ScopedSpinLock lock(state);
+		for (int i = 0; i < state.num_sites; i++)
+		{
+			Site &site = state.sites[i];
+			long long live_allocs = site.live_allocs;
+			long long live_bytes = site.live_bytes;
+			const char *name = site.name;
+			memset(&site, 0, sizeof(Site));
+			site.name = name;
+			site.live_allocs = live_allocs;
+			site.live_bytes = live_bytes;
+		}
+	}
+
+	static UNIGINE_INLINE long long getFrame() { return get_state().frame; }
+	static UNIGINE_INLINE int getNumSites() { return get_state().num_sites; }
+
+	// a consistent copy
+	static Site getSite(int num)
+	{
+		State &state = get_state();
+		ScopedSpinLock lock(state);
+		return state.sites[num];
+	}
+
+	static UNIGINE_INLINE long long getNumLiveAllocations() { return get_state().num_live; }
+
+private:
+	struct Entry
+	{
+		void *ptr; // nullptr for empty entries
+		int site;
+		long long frame;
+		long long count; // weights
+		long long bytes;
+	};
+
+	struct ThreadState
+	{
+		const char *scopes[MAX_SCOPE_DEPTH];
+		int depth;
+		long long bytes_until_sample;
+	};
+
+	struct State
+	{
+		State()
+		{
+			memset(sites, 0, sizeof(sites));
+			memset(site_table, 0xff, sizeof(site_table));
+			for (int i = 0; i < FILTER_SIZE; i++)
+				filter[i].store(0, std::memory_order_relaxed);
+			sites[0].name = "<unscoped>";
+			num_sites = 1;
+		}
+		~State()
+		{
+			Memory::deallocate(live);
+		}
+
+		std::atomic<bool> enabled{false};
+		std::atomic<long long> sample_interval{DEFAULT_SAMPLE_INTERVAL};
+		std::atomic<int> lock{0};
+		long long frame{0};
+
+		// site names are compared by pointer
+		Site sites[MAX_SITES];
+		int site_table[MAX_SITES * 2];
+		int num_sites;
+
+		// live tracked allocations, open addressing
+		Entry *live{nullptr};
+		int live_capacity{0};
+		long long num_live{0};
+
+		// counts of live allocations per pointer hash, checked without the lock on deallocation,
+		// 32 bits as a bucket may hold every live entry
+		std::atomic<unsigned int> filter[FILTER_SIZE];
+	};
+
+	class ScopedSpinLock
+	{
+	public:
+		ScopedSpinLock(State &s) : state(s)
+		{
+			while (state.lock.exchange(1, std::memory_order_acquire))
+			{
+				while (state.lock.load(std::memory_order_relaxed))
+					std::this_thread::yield();
+			}
+		}
+		~ScopedSpinLock() { state.lock.store(0, std::memory_order_release); }
+
+	private:
+		State &state;
+	};
+
+	static UNIGINE_INLINE State &get_state()
+	{
+		static State state;
+		return state;
+	}
+
+	static UNIGINE_INLINE ThreadState &get_thread_state()
+	{
+		static thread_local ThreadState thread = {};
+		return thread;
+	}
+
+	static UNIGINE_INLINE unsigned int hash(const void *ptr)
+	{
+		unsigned long long h = (unsigned long long)(uintptr_t)ptr;
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdULL;
+		h ^= h >> 33;
+		return (unsigned int)h;
+	}
+
+	static void track_allocate(void *ptr, size_t size)
+	{
+		State &state = get_state();
+		ThreadState &thread = get_thread_state();
+
+		long long count = 1;
+		long long bytes = (long long)size;
+		long long interval = state.sample_interval.load(std::memory_order_relaxed);
+		if (interval > 0)
+		{
+			thread.bytes_until_sample -= (long long)size;
+			if (thread.bytes_until_sample > 0)
+				return;
+			thread.bytes_until_sample += interval;
+			if (thread.bytes_until_sample <= 0)
+				thread.bytes_until_sample = interval;
+
+			// a sample stands for the interval
+			if (bytes < interval)
+			{
+				count = interval / (bytes > 0 ? bytes : 1);
+				bytes = count * (long long)size;
+			}
+		}
+
+		const char *name = nullptr;
+		if (thread.depth > 0)
+			name = thread.scopes[(thread.depth < MAX_SCOPE_DEPTH ? thread.depth : MAX_SCOPE_DEPTH) - 1];
+
+		ScopedSpinLock lock(state);
+		int site_index = find_site(state, name);
+		Site &site = state.sites[site_index];
+		site.allocs += count;
+		site.bytes += bytes;
+		site.live_allocs += count;
+		site.live_bytes += bytes;
+		site.frame_allocs += count;
+		site.frame_bytes += bytes;
+
+		if ((state.num_live + 1) * 2 > state.live_capacity)
+			grow_live(state);
+		bool found = false;
+		Entry *e = insert_live(state, ptr, found);
+		if (found)
+		{
+			// the previous block at this address was freed untracked, retire it from its site
+			Site &old_site = state.sites[e->site];
+			old_site.live_allocs -= e->count;
+			old_site.live_bytes -= e->bytes;
+		} else
+		{
+			state.num_live++;
+			state.filter[hash(ptr) & (FILTER_SIZE - 1)].fetch_add(1, std::memory_order_relaxed);
+		}
+		e->site = site_index;
+		e->frame = state.frame;
+		e->count = count;
+		e->bytes = bytes;
+	}
+
+	static void track_deallocate(void *ptr)
+	{
+		State &state = get_state();
+		unsigned int h = hash(ptr);
+		if (state.filter[h & (FILTER_SIZE - 1)].load(std::memory_order_relaxed) == 0)
+			return;
+
+		ScopedSpinLock lock(state);
+		if (state.live_capacity == 0)
+			return;
+		int mask = state.live_capacity - 1;
+		int index = int(h & mask);
+		while (state.live[index].ptr != ptr)
+		{
+			if (state.live[index].ptr == nullptr)
+				return;
+			index = (index + 1) & mask;
+		}
+
+		const Entry &e = state.live[index];
+		Site &site = state.sites[e.site];
+		long long lifetime = state.frame - e.frame;
+		site.frees += e.count;
+		site.freed_bytes += e.bytes;
+		site.live_allocs -= e.count;
+		site.live_bytes -= e.bytes;
+		site.lifetime_frames += lifetime * e.count;
+		if (lifetime == 0)
+			site.frame_lifetime_allocs += e.count;
+
+		remove_live(state, index);
+		state.num_live--;
+		state.filter[h & (FILTER_SIZE - 1)].fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	static int find_site(State &state, const char *name)
+	{
+		if (name == nullptr)
+			return 0;
+		const int mask = MAX_SITES * 2 - 1;
+		for (int i = int(hash(name) & mask);; i = (i + 1) & mask)
+		{
+			int index = state.site_table[i];
+			if (index == -1)
+			{
+				// the table is full, the rest goes to the unscoped site
+				if (state.num_sites == MAX_SITES)
+					return 0;
+				index = state.num_sites++;
+				state.sites[index].name = name;
+				state.site_table[i] = index;
+				return index;
+			}
+			if (state.sites[index].name == name)
+				return index;
+		}
+	}
+
+	static Entry *insert_live(State &state, void *ptr, bool &found)
+	{
+		int mask = state.live_capacity - 1;
+		int index = int(hash(ptr) & mask);
+		while (state.live[index].ptr != nullptr && state.live[index].ptr != ptr)
+			index = (index + 1) & mask;
+		found = state.live[index].ptr == ptr;
+		state.live[index].ptr = ptr;
+		return &state.live[index];
+	}
+
+	// backward shift deletion, keeps the probe sequences intact
+	static void remove_live(State &state, int index)
+	{
+		int mask = state.live_capacity - 1;
+		int hole = index;
+		for (int i = (index + 1) & mask; state.live[i].ptr != nullptr; i = (i + 1) & mask)
+		{
+			int ideal = int(hash(state.live[i].ptr) & mask);
+			if (((i - ideal) & mask) >= ((i - hole) & mask))
+			{
+				state.live[hole] = state.live[i];
+				hole = i;
+			}
+		}
+		state.live[hole].ptr = nullptr;
+	}
+
+	static void grow_live(State &state)
+	{
+		Entry *old_live = state.live;
+		int old_capacity = state.live_capacity;
+		state.live_capacity = old_capacity ? old_capacity * 2 : 4096;
+		state.live = (Entry *)Memory::allocate(sizeof(Entry) * state.live_capacity);
+		memset(state.live, 0, sizeof(Entry) * state.live_capacity);
+		bool found = false;
+		for (int i = 0; i < old_capacity; i++)
+			if (old_live[i].ptr)
+				*insert_live(state, old_live[i].ptr, found) = old_live[i];
+		Memory::deallocate(old_live);
+	}
+
+	static void clear_live(State &state)
+	{
+		for (int i = 0; i < state.num_sites; i++)
+		{
+			state.sites[i].live_allocs = 0;
+			state.sites[i].live_bytes = 0;
+		}
+		if (state.live)
+			memset(state.live, 0, sizeof(Entry) * state.live_capacity);
+		for (int i = 0; i < FILTER_SIZE; i++)
+			state.filter[i].store(0, std::memory_order_relaxed);
+		state.num_live = 0;
+	}
+};
+
+// attributes the allocations of the calling thread to NAME, which must be a string literal
+class MemoryTrackerScope
+{
+public:
+	UNIGINE_INLINE MemoryTrackerScope(const char *name) { MemoryTracker::pushScope(name); }
+	UNIGINE_INLINE ~MemoryTrackerScope() { MemoryTracker::popScope(); }
+};
+
+} // namespace Unigine
@@ -18,6 +18,7 @@
 #include "UnigineMathLib.h"
 #include "UnigineGui.h"
 #include "UnigineWidgets.h"
+#include "UnigineProfilerTrace.h"
 
 namespace Unigine
 {
@@ -46,11 +47,37 @@ public:
 	static Ptr<Gui> getGui();
 };
 
+// feeds the engine profiler, ProfilerTrace when it records and names the allocations for MemoryTracker
+// define UNIGINE_PROFILER_TRACE_ONLY to skip the engine profiler and keep the scopes cheap
 struct ScopedProfiler
 {
+#ifndef UNIGINE_PROFILER_TRACE_ONLY
 	int id;
-	ScopedProfiler(const char *name, bool gpu = false) { id = Profiler::beginMicro(name, gpu); }
-	~ScopedProfiler() { Profiler::endMicro(id); }
+#endif
+	bool traced;
+	ScopedProfiler(const char *name, bool gpu = false)
+	{
+#ifndef UNIGINE_PROFILER_TRACE_ONLY
+		id = Profiler::beginMicro(name, gpu);
+#else
+		UNIGINE_UNUSED(gpu);
+#endif
+		traced = ProfilerTrace::begin(name);
+#ifdef UNIGINE_MEMORY_TRACKER
+		MemoryTracker::pushScope(name);
+#endif
+	}
+	~ScopedProfiler()
+	{
+#ifdef UNIGINE_MEMORY_TRACKER
+		MemoryTracker::popScope();
+#endif
+		if (traced)
+			ProfilerTrace::end();
+#ifndef UNIGINE_PROFILER_TRACE_ONLY
+		Profiler::endMicro(id);
+#endif
+	}
 };
 #define UNIGINE_PROFILER_SCOPED(NAME) ScopedProfiler unigine_prof ## __LINE__(NAME)
 #define UNIGINE_PROFILER_SCOPED_GPU(NAME) ScopedProfiler unigine_prof ## __LINE__(NAME, true)
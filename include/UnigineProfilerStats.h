@@ -0,0 +1,474 @@
+/* Copyright (C) 2005-2020, UNIGINE. All rights reserved.
+ *
+ * This file is a part of the UNIGINE 2 SDK.
+ *
+ * Your use and / or redistribution of this software in source and / or
+ * binary form, with or without modification, is subject to: (i) your
+ * ongoing acceptance of and compliance with the terms and conditions of
+ * the UNIGINE License Agreement; and (ii) your inclusion of this notice
+ * in any version of this software that you use or redistribute.
+ * A copy of the UNIGINE License Agreement is available by contacting
+ * UNIGINE. at http://unigine.com/
+ */
+
+
+#pragma once
+
+#include "UnigineProfilerTrace.h"
+#include "UnigineConsole.h"
+#include "UnigineCallback.h"
+
+// Profiler statistics example
+/*
+	// AppSystemLogic::init(), scopes are recorded after "profiler_trace 1"
+	// or with -console_command "profiler_trace 1" on the command line
+	Unigine::ProfilerStats::setBudget(33.3f);
+	Unigine::ProfilerStats::addConsoleCommands();
+
+	// AppSystemLogic::update(), replaces ProfilerTrace::update()
+	Unigine::ProfilerStats::update();
+
+	// AppSystemLogic::shutdown()
+	Unigine::ProfilerStats::saveReport("profiler_stats.txt");
+	Unigine::ProfilerStats::removeConsoleCommands();
+*/
+
+namespace Unigine
+{
+
+//////////////////////////////////////////////////////////////////////////
+/// Log-linear histogram with a fixed relative error (HDR histogram).
+///
+/// Values below 128 are counted exactly. A larger value in [64 * 2^n,
+/// 128 * 2^n) falls into a bucket 2^n wide, and percentiles report the
+/// upper bound of the bucket, so they are never below the recorded value
+/// and at most 1/64 (1.56%) above it. Values up to 2^40 are recorded,
+/// larger are clamped.
+//////////////////////////////////////////////////////////////////////////
+
+class ProfilerHistogram
+{
+public:
+	enum
+	{
+		SUB_BUCKET_BITS = 7,
+		SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS,
+		SUB_BUCKET_HALF = SUB_BUCKET_COUNT / 2,
+		MAX_VALUE_BITS = 40,
+		NUM_BUCKETS = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 2) * SUB_BUCKET_HALF,
+	};
+
+	ProfilerHistogram()
+	{
+		counts.resize(NUM_BUCKETS);
+		reset();
+	}
+
+	void reset()
+	{
+		memset(counts.get(), 0, sizeof(unsigned int) * NUM_BUCKETS);
+		count = 0;
+		sum = 0;
+		min = 0;
+		max = 0;
+	}
+
+	UNIGINE_INLINE void record(long long value, unsigned int num = 1)
+	{
+		if (value < 0)
+			value = 0;
+		else if (value >= (1LL << MAX_VALUE_BITS))
+			value = (1LL << MAX_VALUE_BITS) - 1;
+		counts[get_index(value)] += num;
+		if (count == 0 || value < min)
+			min = value;
+		if (count == 0 || value > max)
+			max = value;
+		count += num;
+		sum += value * num;
+	}
+
+	void merge(const ProfilerHistogram &h)
+	{
+		if (h.count == 0)
+			return;
+		for (int i = 0; i < NUM_BUCKETS; i++)
+			counts[i] += h.counts[i];
+		if (count == 0 || h.min < min)
+			min = h.min;
+		if (count == 0 || h.max > max)
+			max = h.max;
+		count += h.count;
+		sum += h.sum;
+	}
+
+	UNIGINE_INLINE long long getCount() const { return count; }
+	UNIGINE_INLINE long long getMin() const { return min; }
+	UNIGINE_INLINE long long getMax() const { return max; }
+	UNIGINE_INLINE double getMean() const { return count ? double(sum) / double(count) : 0.0; }
+
+	// percentile in the [0, 100] range, returns the upper bound of the bucket
+	long long getPercentile(double percentile) const
+	{
+		if (count == 0)
+			return 0;
+		long long rank = (long long)(percentile * 0.01 * double(count) + 0.5);
+		if (rank < 1)
+			rank = 1;
+		long long total = 0;
+		for (int i = 0; i < NUM_BUCKETS; i++)
+		{
+			total += counts[i];
+			if (total >= rank)
+			{
+				long long value = get_upper_value(i);
+				return value < max ? (value > min ? value : min) : max;
+			}
+		}
+		return max;
+	}
+
+private:
+	static UNIGINE_INLINE int get_msb(unsigned long long value)
+	{
+		int ret = 0;
+		for (int shift = 32; shift; shift >>= 1)
+		{
+			if (value >> shift)
+			{
+				value >>= shift;
+				ret += shift;
+			}
+		}
+		return ret;
+	}
+
+	static UNIGINE_INLINE int get_index(long long value)
+	{
+		if (value < SUB_BUCKET_COUNT)
+			return int(value);
+		int shift = get_msb((unsigned long long)value) - SUB_BUCKET_BITS + 1;
+		return shift * SUB_BUCKET_HALF + int(value >> shift);
+	}
+
+	static UNIGINE_INLINE long long get_upper_value(int index)
+	{
+		if (index < SUB_BUCKET_COUNT)
+			return index;
+		int shift = index / SUB_BUCKET_HALF - 1;
+		long long mantissa = index - shift * SUB_BUCKET_HALF;
+		return ((mantissa + 1) << shift) - 1;
+	}
+
+	Vector<unsigned int> counts; // 32-bit, one sample per frame is expected
+	long long count;
+	long long sum;
+	long long min;
+	long long max;
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// Frame time distributions and a frame budget watchdog.
+///
+/// update() drains ProfilerTrace and records the frame time and the time
+/// of every scope (summed per frame) into histograms, so p50/p95/p99/max
+/// are available over the whole session. Frames longer than the budget
+/// keep a copy of their scope tree. The report is plain text.
+//////////////////////////////////////////////////////////////////////////
+
+class ProfilerStats
+{
+public:
+	enum
+	{
+		DEFAULT_MAX_HITCHES = 64,
+	};
+
+	// hitch frame scope, in the depth-first order of the scope tree
+	struct HitchScope
+	{
+		const char *name;	// nullptr for thread roots
+		int thread;
+		int depth;
+		int count;
+		long long time;		// in ticks
+		long long self_time;
+	};
+
+	struct Hitch
+	{
+		long long frame;
+		long long time;		// in ticks
+		Vector<HitchScope> scopes;
+	};
+
+	// call once per frame instead of ProfilerTrace::update()
+	static void update()
+	{
+		ProfilerTrace::update();
+
+		// calibrating the tick rate may take a few milliseconds on the first call, keep it out of the frame time
+		State &state = get_state();
+		long long budget = (long long)(state.budget * 1e-3 * ProfilerTrace::getTicksPerSecond());
+		unsigned long long timestamp = ProfilerTrace::getTimestamp();
+		if (state.frame != 0)
+		{
+			long long time = (long long)(timestamp - state.timestamp);
+			state.frame_histogram.record(time);
+
+			int num_nodes = ProfilerTrace::getNumNodes();
+			while (state.histograms.size() < num_nodes)
+				state.histograms.append(nullptr);
+			for (int i = 0; i < num_nodes; i++)
+			{
+				const ProfilerTraceNode &node = ProfilerTrace::getNode(i);
+				if (node.frame_count == 0)
+					continue;
+				if (state.histograms[i] == nullptr)
+					state.histograms[i] = new ProfilerHistogram();
+				state.histograms[i]->record(node.frame_time);
+			}
+
+			if (budget > 0 && time > budget)
+				capture_hitch(state, time);
+		}
+		state.timestamp = timestamp;
+		state.frame++;
+	}
+
+	static void reset()
+	{
+		State &state = get_state();
+		state.frame_histogram.reset();
+		for (int i = 0; i < state.histograms.size(); i++)
+			if (state.histograms[i])
+				state.histograms[i]->reset();
+		for (int i = 0; i < state.hitches.size(); i++)
+			delete state.hitches[i];
+		state.hitches.clear();
+		state.num_hitches = 0;
+	}
+
+	// watchdog, zero disables it
+	static UNIGINE_INLINE void setBudget(float milliseconds) { get_state().budget = milliseconds; }
+	static UNIGINE_INLINE float getBudget() { return get_state().budget; }
+	static UNIGINE_INLINE void setMaxHitches(int num) { get_state().max_hitches = num; }
+	static UNIGINE_INLINE int getMaxHitches() { return get_state().max_hitches; }
+
+	// statistics, times are in ticks of ProfilerTrace::getTimestamp()
+	static UNIGINE_INLINE long long getNumFrames() { return get_state().frame_histogram.getCount(); }
+	static UNIGINE_INLINE const ProfilerHistogram &getFrameHistogram() { return get_state().frame_histogram; }
+
+	// indexed by ProfilerTrace nodes, nullptr if the scope has never completed
+	static UNIGINE_INLINE const ProfilerHistogram *getScopeHistogram(int node)
+	{
+		State &state = get_state();
+		return node < state.histograms.size() ? state.histograms[node] : nullptr;
+	}
+
+	// the last getMaxHitches() frames over the budget
+	static UNIGINE_INLINE long long getNumHitches() { return get_state().num_hitches; }
+	static UNIGINE_INLINE int getNumStoredHitches() { return get_state().hitches.size(); }
+	static UNIGINE_INLINE const Hitch &getHitch(int num) { return *get_state().hitches[num]; }
+
+	//////////////////////////////////////////////////////////////////////////
+	// report
+	//////////////////////////////////////////////////////////////////////////
+
+	static void getReport(String &ret)
+	{
+		State &state = get_state();
+		double ms_per_tick = 1e3 / ProfilerTrace::getTicksPerSecond();
+		const ProfilerHistogram &frames = state.frame_histogram;
+
+		ret.clear();
+		Format::append(ret, "frames: {}, mean {:.3} ms, p50 {:.3} ms, p95 {:.3} ms, p99 {:.3} ms, max {:.3} ms\n",
+			frames.getCount(), frames.getMean() * ms_per_tick,
+			double(frames.getPercentile(50.0)) * ms_per_tick, double(frames.getPercentile(95.0)) * ms_per_tick,
+			double(frames.getPercentile(99.0)) * ms_per_tick, double(frames.getMax()) * ms_per_tick);
+		Format::append(ret, "hitches: {} over {:.3} ms budget, dropped scopes: {}\n\n",
+			state.num_hitches, state.budget, ProfilerTrace::getNumDroppedScopes());
+
+		if (!ProfilerTrace::isEnabled())
+			ret.append("scope recording is off, the scopes and hitch trees are filled after \"profiler_trace 1\"\n\n");
+		ret.append("scope time per frame, ms\n");
+		ret.append("   frames      p50      p95      p99      max  scope\n");
+		for (int i = 0; i < ProfilerTrace::getNumThreads(); i++)
+			append_scope(ret, state, ProfilerTrace::getThreadRoot(i), 0, ms_per_tick);
+
+		for (int i = 0; i < state.hitches.size(); i++)
+		{
+			const Hitch &hitch = *state.hitches[i];
+			Format::append(ret, "\nhitch at frame {}: {:.3} ms\n", hitch.frame, double(hitch.time) * ms_per_tick);
+			ret.append("     time     self  calls  scope\n");
+			for (int j = 0; j < hitch.scopes.size(); j++)
+			{
+				const HitchScope &s = hitch.scopes[j];
+				if (s.name == nullptr)
+				{
+					Format::append(ret, "                         {}\n", ProfilerTrace::getThreadName(s.thread));
+					continue;
+				}
+				Format::append(ret, "{:9.3}{:9.3}{:7}  ", double(s.time) * ms_per_tick, double(s.self_time) * ms_per_tick, s.count);
+				append_indent(ret, s.depth);
+				ret.append(s.name);
+				ret.append('\n');
+			}
+		}
+	}
+
+	static bool saveReport(const char *path)
+	{
+		String report;
+		getReport(report);
+		FilePtr file = File::create(path, "wb");
+		if (!file || !file->isOpened())
+		{
+			Log::error("ProfilerStats::saveReport(): can't create \"%s\" file\n", path);
+			return false;
+		}
+		return file->write(report.get(), report.size()) == size_t(report.size());
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// console
+	//////////////////////////////////////////////////////////////////////////
+
+	// profiler_trace [0|1]
+	// profiler_stats_save [file], profiler_stats_budget [ms], profiler_stats_reset
+	static void addConsoleCommands()
+	{
+		Console::addCommand("profiler_trace", "enables ProfilerTrace scope recording", MakeCallback(&ProfilerStats::console_trace));
+		Console::addCommand("profiler_stats_save", "saves the profiler statistics report", MakeCallback(&ProfilerStats::console_save));
+		Console::addCommand("profiler_stats_budget", "sets the frame budget in milliseconds", MakeCallback(&ProfilerStats::console_budget));
+		Console::addCommand("profiler_stats_reset", "clears the profiler statistics", MakeCallback(&ProfilerStats::console_reset));
+	}
+
+	static void removeConsoleCommands()
+	{
+		Console::removeCommand("profiler_trace");
+		Console::removeCommand("profiler_stats_save");
+		Console::removeCommand("profiler_stats_budget");
+		Console::removeCommand("profiler_stats_reset");
+	}
+
+private:
+	struct State
+	{
+		~State()
+		{
+			for (int i = 0; i < histograms.size(); i++)
+				delete histograms[i];
+			for (int i = 0; i < hitches.size(); i++)
+				delete hitches[i];
+		}
+
+		long long frame{0};
+		unsigned long long timestamp{0};
+		float budget{0.0f};
+		int max_hitches{DEFAULT_MAX_HITCHES};
+		long long num_hitches{0};
+
+		ProfilerHistogram frame_histogram;
+		Vector<ProfilerHistogram *> histograms;
+		Vector<Hitch *> hitches;
+	};
+
+	static UNIGINE_INLINE State &get_state()
+	{
+		static State state;
+		return state;
+	}
+
+	static void capture_hitch(State &state, long long time)
+	{
+		state.num_hitches++;
+		if (state.max_hitches <= 0)
+			return;
+
+		Hitch *hitch;
+		if (state.hitches.size() >= state.max_hitches)
+		{
+			hitch = state.hitches[0];
+			state.hitches.remove(0);
+			hitch->scopes.clear();
+		} else
+			hitch = new Hitch();
+		hitch->frame = state.frame;
+		hitch->time = time;
+		for (int i = 0; i < ProfilerTrace::getNumThreads(); i++)
+			capture_scope(hitch->scopes, ProfilerTrace::getThreadRoot(i), 0);
+		state.hitches.append(hitch);
+	}
+
+	static void capture_scope(Vector<HitchScope> &scopes, int index, int depth)
+	{
+		const ProfilerTraceNode &node = ProfilerTrace::getNode(index);
+		if (node.parent != -1 && node.frame_count == 0)
+			return;
+		HitchScope &s = scopes.append();
+		s.name = node.name;
+		s.thread = node.thread;
+		s.depth = depth;
+		s.count = node.frame_count;
+		s.time = node.frame_time;
+		s.self_time = node.frame_self_time;
+		for (int i = node.first_child; i != -1; i = ProfilerTrace::getNode(i).next_sibling)
+			capture_scope(scopes, i, depth + 1);
+	}
+
+	static void append_scope(String &ret, State &state, int index, int depth, double ms_per_tick)
+	{
+		const ProfilerTraceNode &node = ProfilerTrace::getNode(index);
+		if (node.parent == -1)
+			Format::append(ret, "                                               {}\n", ProfilerTrace::getThreadName(node.thread));
+		else
+		{
+			const ProfilerHistogram *h = index < state.histograms.size() ? state.histograms[index] : nullptr;
+			if (h == nullptr || h->getCount() == 0)
+				return;
+			Format::append(ret, "{:9}{:9.3}{:9.3}{:9.3}{:9.3}  ", h->getCount(),
+				double(h->getPercentile(50.0)) * ms_per_tick, double(h->getPercentile(95.0)) * ms_per_tick,
+				double(h->getPercentile(99.0)) * ms_per_tick, double(h->getMax()) * ms_per_tick);
+			append_indent(ret, depth);
+			ret.append(node.name);
+			ret.append('\n');
+		}
+		for (int i = node.first_child; i != -1; i = ProfilerTrace::getNode(i).next_sibling)
+			append_scope(ret, state, i, depth + 1, ms_per_tick);
+	}
+
+	static UNIGINE_INLINE void append_indent(String &ret, int depth)
+	{
+		for (int i = 1; i < depth; i++)
+			ret.append("  ");
+	}
+
+	static void console_trace(int argc, char **argv)
+	{
+		if (argc > 1)
+			ProfilerTrace::setEnabled(atoi(argv[1]) != 0);
+		Log::message("profiler_trace: %d\n", int(ProfilerTrace::isEnabled()));
+	}
+
+	static void console_save(int argc, char **argv)
+	{
+		const char *path = argc > 1 ? argv[1] : "profiler_stats.txt";
+		if (saveReport(path))
+			Log::message("profiler statistics saved to \"%s\"\n", path);
+	}
+
+	static void console_budget(int argc, char **argv)
+	{
+		if (argc > 1)
+			setBudget(float(atof(argv[1])));
+		Log::message("profiler_stats_budget: %g ms\n", getBudget());
+	}
+
+	static void console_reset(int, char **)
+	{
+		reset();
+	}
+};
+
+} // namespace Unigine
@@ -0,0 +1,549 @@
+/* Copyright (C) 2005-2020, UNIGINE. All rights reserved.
+ *
+ * This file is a part of the UNIGINE 2 SDK.
+ *
+ * Your use and / or redistribution of this software in source and / or
+ * binary form, with or without modification, is subject to: (i) your
+ * ongoing acceptance of and compliance with the terms and conditions of
+ * the UNIGINE License Agreement; and (ii) your inclusion of this notice
+ * in any version of this software that you use or redistribute.
+ * A copy of the UNIGINE License Agreement is available by contacting
+ * UNIGINE. at http://unigine.com/
+ */
+
+
+#pragma once
+
+#include "UnigineBase.h"
+#include "UnigineVector.h"
+#include "UnigineString.h"
+#include "UnigineThread.h"
+#include "UnigineStreams.h"
+#include "UnigineFormat.h"
+#include "UnigineLog.h"
+#include <atomic>
+#include <chrono>
+
+#if defined(_M_X64) || defined(_M_IX86)
+	#include <intrin.h>
+	#define UNIGINE_PROFILER_TRACE_RDTSC
+#elif defined(__x86_64__) || defined(__i386__)
+	#include <x86intrin.h>
+	#define UNIGINE_PROFILER_TRACE_RDTSC
+#endif
+
+// Profiler trace example
+/*
+	// AppSystemLogic::init()
+	Unigine::ProfilerTrace::setEnabled(true);
+	Unigine::ProfilerTrace::startCapture();
+
+	// AppSystemLogic::update(), once per frame
+	Unigine::ProfilerTrace::update();
+
+	// anywhere, on any thread, names must be string literals or outlive the profiler
+	UNIGINE_PROFILER_SCOPED("Tank::update");
+
+	// AppSystemLogic::shutdown()
+	Unigine::ProfilerTrace::saveChromeTrace("trace.json"); // chrome://tracing or ui.perfetto.dev
+*/
+
+namespace Unigine
+{
+
+// aggregated scope, one per unique call path and thread
+struct ProfilerTraceNode
+{
+	const char *name;		// nullptr for thread roots
+	int parent;				// -1 for thread roots
+	int first_child;
+	int next_sibling;
+	int thread;
+
+	// all time, in ticks
+	long long count;
+	long long total_time;
+	long long self_time;
+	long long max_time;
+
+	// last update() only
+	int frame_count;
+	long long frame_time;
+	long long frame_self_time;
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// Hierarchical CPU profiler.
+///
+/// Scope enter and exit events are written with a raw timestamp (TSC on
+/// x86) into a ring buffer owned by the calling thread, so begin() and
+/// end() take no locks and touch no shared cache lines. update() drains
+/// all rings, builds the aggregated scope tree per thread and optionally
+/// keeps completed scopes for a Chrome trace / Perfetto JSON export.
+/// Call update() from one thread, at least once per frame.
+///
+/// When a ring is full, new scopes are dropped together with all their
+/// nested scopes, the tree stays consistent. Use setBufferSize() before
+/// the threads start profiling to change the ring size.
+//////////////////////////////////////////////////////////////////////////
+
+class ProfilerTrace
+{
+public:
+	enum
+	{
+		DEFAULT_BUFFER_SIZE = 64 * 1024,		// events per thread, rounded up to a power of two
+		DEFAULT_CAPTURE_SIZE = 1024 * 1024,		// completed scopes
+	};
+
+	// raw timestamp in ticks
+	static UNIGINE_INLINE unsigned long long getTimestamp()
+	{
+		#ifdef UNIGINE_PROFILER_TRACE_RDTSC
+			return __rdtsc();
+		#else
+			return (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		#endif
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// hot path
+	//////////////////////////////////////////////////////////////////////////
+
+	static UNIGINE_INLINE bool isEnabled() { return get_state().enabled.load(std::memory_order_relaxed); }
+
+	// returns true if the scope was recorded, end() must be called only in this case
+	static UNIGINE_INLINE bool begin(const char *name)
+	{
+		if (!isEnabled())
+			return false;
+		ThreadBuffer *buffer = get_thread_buffer();
+		if (buffer->skip_depth)
+		{
+			buffer->skip_depth++;
+			return true;
+		}
+
+		// leave room for the exit events of all open scopes
+		unsigned long long head = buffer->head.load(std::memory_order_relaxed);
+		unsigned long long required = head + buffer->depth + 2;
+		if (required - buffer->cached_tail > buffer->capacity)
+		{
+			buffer->cached_tail = buffer->tail.load(std::memory_order_acquire);
+			if (required - buffer->cached_tail > buffer->capacity)
+			{
+				buffer->skip_depth = 1;
+				buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+
+		Event &e = buffer->events[head & buffer->mask];
+		e.name = name;
+		e.timestamp = getTimestamp();
+		buffer->depth++;
+		buffer->head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	static UNIGINE_INLINE void end()
+	{
+		unsigned long long timestamp = getTimestamp();
+		ThreadBuffer *buffer = get_thread_buffer();
+		if (buffer->skip_depth)
+		{
+			buffer->skip_depth--;
+			return;
+		}
+		unsigned long long head = buffer->head.load(std::memory_order_relaxed);
+		Event &e = buffer->events[head & buffer->mask];
+		e.name = nullptr;
+		e.timestamp = timestamp;
+		buffer->depth--;
+		buffer->head.store(head + 1, std::memory_order_release);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// settings
+	//////////////////////////////////////////////////////////////////////////
+
+	// recording is off by default, a disabled scope costs one relaxed load
+	static UNIGINE_INLINE void setEnabled(bool enabled) { get_state().enabled.store(enabled, std::memory_order_relaxed); }
+
+	// ring size for threads that have not profiled yet
+	static void setBufferSize(int size)
+	{
+		State &state = get_state();
+		ScopedLock lock(state.mutex);
+		int capacity = 64;
+		while (capacity < size)
+			capacity *= 2;
+		state.buffer_size = capacity;
+	}
+
+	// name of the calling thread in the trace
+	static void setThreadName(const char *name)
+	{
+		ThreadBuffer *buffer = get_thread_buffer();
+		State &state = get_state();
+		ScopedLock lock(state.mutex);
+		buffer->name = name;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// collection
+	//////////////////////////////////////////////////////////////////////////
+
+	// drains the ring buffers of all threads
+	static void update()
+	{
+		State &state = get_state();
+		ScopedLock lock(state.mutex);
+
+		for (int i = 0; i < state.nodes.size(); i++)
+		{
+			ProfilerTraceNode &node = state.nodes[i];
+			node.frame_count = 0;
+			node.frame_time = 0;
+			node.frame_self_time = 0;
+		}
+
+		for (int i = 0; i < state.buffers.size(); i++)
+		{
+			ThreadBuffer *buffer = state.buffers[i];
+			unsigned long long tail = buffer->tail.load(std::memory_order_relaxed);
+			unsigned long long head = buffer->head.load(std::memory_order_acquire);
+			for (; tail != head; tail++)
+			{
+				const Event &e = buffer->events[tail & buffer->mask];
+				if (e.name)
+					enter_scope(state, buffer, e);
+				else
+					exit_scope(state, buffer, e);
+			}
+			buffer->tail.store(head, std::memory_order_release);
+		}
+	}
+
+	// clears the aggregated tree, open scopes are kept
+	static void reset()
+	{
+		State &state = get_state();
+		ScopedLock lock(state.mutex);
+		for (int i = 0; i < state.nodes.size(); i++)
+		{
+			ProfilerTraceNode &node = state.nodes[i];
+			node.count = 0;
+			node.total_time = 0;
+			node.self_time = 0;
+			node.max_time = 0;
+		}
+	}
+
+	// the aggregated tree, use it from the thread that calls update()
+	static UNIGINE_INLINE int getNumNodes() { return get_state().nodes.size(); }
+	static UNIGINE_INLINE const ProfilerTraceNode &getNode(int index) { return get_state().nodes[index]; }
+	static UNIGINE_INLINE int getNumThreads() { return get_state().buffers.size(); }
+	static UNIGINE_INLINE int getThreadRoot(int thread) { return get_state().buffers[thread]->root; }
+	static UNIGINE_INLINE const char *getThreadName(int thread) { return get_state().buffers[thread]->name.get(); }
+
+	static long long getNumDroppedScopes()
+	{
+		State &state = get_state();
+		ScopedLock lock(state.mutex);
+		long long ret = 0;
+		for (int i = 0; i < state.buffers.size(); i++)
+			ret += state.buffers[i]->dropped.load(std::memory_order_relaxed);
+		return ret;
+	}
+
+	// tick rate, measured against the steady clock since the first profiled scope
+	static double getTicksPerSecond()
+	{
+		#ifdef UNIGINE_PROFILER_TRACE_RDTSC
+			State &state = get_state();
+			using namespace std::chrono;
+			for (;;)
+			{
+				unsigned long long ticks = getTimestamp();
+				long long ns = duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+				if (ns - state.origin_ns >= 10000000)
+					return double(ticks - state.origin_ticks) * 1e9 / double(ns - state.origin_ns);
+			}
+		#else
+			return 1e9;
+		#endif
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// trace capture
+	//////////////////////////////////////////////////////////////////////////
+
+	// keeps completed scopes for the export, the oldest scopes are dropped when the limit is reached
+	static void startCapture(int max_scopes = DEFAULT_CAPTURE_SIZE)
+	{
+		State &state = get_state();
+		ScopedLock lock(state.mutex);
+		state.capture.clear();
+		state.capture_size = max_scopes;
+		state.capture_begin = 0;
+		state.capturing = 1;
+	}
+
+	static void stopCapture()
+	{
+		State &state = get_state();
+		ScopedLock lock(state.mutex);
+		state.capturing = 0;
+	}
+
+	static UNIGINE_INLINE bool isCapturing() { return get_state().capturing != 0; }
+
+	// Chrome trace event format, loads in chrome://tracing and ui.perfetto.dev
+	static void getChromeTrace(String &ret)
+	{
+		double us_per_tick = 1e6 / getTicksPerSecond();
+		State &state = get_state();
+		ScopedLock lock(state.mutex);
+
+		ret.clear();
+		ret.append("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+		for (int i = 0; i < state.buffers.size(); i++)
+		{
+			Format::append(ret, "{{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":{},\"args\":{{\"name\":", i);
+			append_json_string(ret, state.buffers[i]->name.get());
+			ret.append("}},\n");
+		}
+
+		int num = state.capture.size();
+		for (int i = 0; i < num; i++)
+		{
+			const CapturedScope &s = state.capture[(state.capture_begin + i) % num];
+			ret.append("{\"ph\":\"X\",\"pid\":1,\"name\":");
+			append_json_string(ret, s.name);
+			Format::append(ret, ",\"tid\":{},\"ts\":{:.3},\"dur\":{:.3}}}", s.thread,
+				double(s.begin - state.origin_ticks) * us_per_tick, double(s.end - s.begin) * us_per_tick);
+			if (i + 1 < num)
+				ret.append(',');
+			ret.append('\n');
+		}
+		ret.append("]}\n");
+	}
+
+	static bool saveChromeTrace(const char *path)
+	{
+		String trace;
+		getChromeTrace(trace);
+		FilePtr file = File::create(path, "wb");
+		if (!file || !file->isOpened())
+		{
+			Log::error("ProfilerTrace::saveChromeTrace(): can't create \"%s\" file\n", path);
+			return false;
+		}
+		return file->write(trace.get(), trace.size()) == size_t(trace.size());
+	}
+
+private:
+	struct Event
+	{
+		const char *name; // nullptr for exit events
+		unsigned long long timestamp;
+	};
+
+	struct OpenScope
+	{
+		int node;
+		unsigned long long begin;
+		unsigned long long children; // time of nested scopes
+	};
+
+	struct CapturedScope
+	{
+		const char *name;
+		int thread;
+		unsigned long long begin;
+		unsigned long long end;
+	};
+
+	struct ThreadBuffer
+	{
+		// owner thread
+		Event *events;
+		unsigned long long capacity;
+		unsigned long long mask;
+		unsigned long long cached_tail;
+		int depth;			// recorded open scopes
+		int skip_depth;		// dropped open scopes
+		std::atomic<unsigned long long> head;
+		char pad_0[64];
+
+		// update()
+		std::atomic<unsigned long long> tail;
+		std::atomic<long long> dropped;
+		char pad_1[64];
+
+		int index;
+		int root;
+		String name;
+		Vector<OpenScope> stack;
+	};
+
+	struct State
+	{
+		State()
+		{
+			origin_ticks = getTimestamp();
+			origin_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+		~State()
+		{
+			for (int i = 0; i < buffers.size(); i++)
+			{
+				Memory::deallocate(buffers[i]->events);
+				delete buffers[i];
+			}
+		}
+
+		std::atomic<bool> enabled{false};
+		Mutex mutex;
+		int buffer_size{DEFAULT_BUFFER_SIZE};
+		Vector<ThreadBuffer *> buffers;
+		Vector<ProfilerTraceNode> nodes;
+
+		int capturing{0};
+		int capture_size{0};
+		int capture_begin{0};	// the oldest scope when the capture has wrapped
+		Vector<CapturedScope> capture;
+
+		unsigned long long origin_ticks;
+		long long origin_ns;
+	};
+
+	static UNIGINE_INLINE State &get_state()
+	{
+		static State state;
+		return state;
+	}
+
+	static UNIGINE_INLINE ThreadBuffer *get_thread_buffer()
+	{
+		static thread_local ThreadBuffer *buffer = nullptr;
+		if (buffer == nullptr)
+			buffer = create_thread_buffer();
+		return buffer;
+	}
+
+	static ThreadBuffer *create_thread_buffer()
+	{
+		State &state = get_state();
+		ScopedLock lock(state.mutex);
+
+		ThreadBuffer *buffer = new ThreadBuffer();
+		buffer->capacity = (unsigned long long)state.buffer_size;
+		buffer->mask = buffer->capacity - 1;
+		buffer->events = (Event *)Memory::allocate(sizeof(Event) * state.buffer_size);
+		buffer->cached_tail = 0;
+		buffer->depth = 0;
+		buffer->skip_depth = 0;
+		buffer->head.store(0, std::memory_order_relaxed);
+		buffer->tail.store(0, std::memory_order_relaxed);
+		buffer->dropped.store(0, std::memory_order_relaxed);
+		buffer->index = state.buffers.size();
+		Format::assign(buffer->name, "Thread {}", buffer->index);
+		buffer->root = create_node(state, nullptr, -1, buffer->index);
+		state.buffers.append(buffer);
+		return buffer;
+	}
+
+	static int create_node(State &state, const char *name, int parent, int thread)
+	{
+		int index = state.nodes.size();
+		ProfilerTraceNode &node = state.nodes.append();
+		memset(&node, 0, sizeof(node));
+		node.name = name;
+		node.parent = parent;
+		node.first_child = -1;
+		node.next_sibling = -1;
+		node.thread = thread;
+		if (parent != -1)
+		{
+			node.next_sibling = state.nodes[parent].first_child;
+			state.nodes[parent].first_child = index;
+		}
+		return index;
+	}
+
+	static UNIGINE_INLINE int find_child(State &state, int parent, const char *name)
+	{
+		for (int i = state.nodes[parent].first_child; i != -1; i = state.nodes[i].next_sibling)
+			if (state.nodes[i].name == name || strcmp(state.nodes[i].name, name) == 0)
+				return i;
+		return create_node(state, name, parent, state.nodes[parent].thread);
+	}
+
+	static UNIGINE_INLINE void enter_scope(State &state, ThreadBuffer *buffer, const Event &e)
+	{
+		int parent = buffer->stack.size() ? buffer->stack.last().node : buffer->root;
+		OpenScope &scope = buffer->stack.append();
+		scope.node = find_child(state, parent, e.name);
+		scope.begin = e.timestamp;
+		scope.children = 0;
+	}
+
+	static UNIGINE_INLINE void exit_scope(State &state, ThreadBuffer *buffer, const Event &e)
+	{
+		OpenScope scope = buffer->stack.last();
+		buffer->stack.removeLast();
+
+		long long time = (long long)(e.timestamp - scope.begin);
+		long long self_time = time - (long long)scope.children;
+		if (buffer->stack.size())
+			buffer->stack.last().children += (unsigned long long)time;
+
+		ProfilerTraceNode &node = state.nodes[scope.node];
+		node.count++;
+		node.total_time += time;
+		node.self_time += self_time;
+		if (time > node.max_time)
+			node.max_time = time;
+		node.frame_count++;
+		node.frame_time += time;
+		node.frame_self_time += self_time;
+
+		if (state.capturing && state.capture_size > 0)
+		{
+			CapturedScope *s;
+			if (state.capture.size() < state.capture_size)
+				s = &state.capture.append();
+			else
+			{
+				s = &state.capture[state.capture_begin];
+				state.capture_begin = (state.capture_begin + 1) % state.capture_size;
+			}
+			s->name = node.name;
+			s->thread = buffer->index;
+			s->begin = scope.begin;
+			s->end = e.timestamp;
+		}
+	}
+
+	static void append_json_string(String &ret, const char *str)
+	{
+		ret.append('"');
+		for (const char *s = str; s && *s; s++)
+		{
+			unsigned char c = (unsigned char)*s;
+			if (c == '"' || c == '\\')
+			{
+				ret.append('\\');
+				ret.append(char(c));
+			} else if (c < 0x20)
+				Format::append(ret, "\\u{:04x}", int(c));
+			else
+				ret.append(char(c));
+		}
+		ret.append('"');
+	}
+};
+
+} // namespace Unigine
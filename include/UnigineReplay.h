@@ -0,0 +1,759 @@
+/* Copyright (C) 2005-2020, UNIGINE. All rights reserved.
+ *
+ * This file is a part of the UNIGINE 2 SDK.
+ *
+ * Your use and / or redistribution of this software in source and / or
+ * binary form, with or without modification, is subject to: (i) your
+ * ongoing acceptance of and compliance with the terms and conditions of
+ * the UNIGINE License Agreement; and (ii) your inclusion of this notice
+ * in any version of this software that you use or redistribute.
+ * A copy of the UNIGINE License Agreement is available by contacting
+ * UNIGINE. at http://unigine.com/
+ */
+
+
+#pragma once
+
+#include "UnigineStreamBuffer.h"
+#include "UnigineChecksumEngine.h"
+#include "UnigineEngine.h"
+#include "UnigineInput.h"
+#include "UnigineGame.h"
+#include "UniginePhysics.h"
+#include "UnigineFileSystem.h"
+#include "UnigineConsole.h"
+#include "UnigineLogic.h"
+#include <chrono>
+
+// Replay example
+/*
+	int AppWorldLogic::update()
+	{
+		Replay::update();
+
+		// input and random draws of the simulation go through Replay
+		if (Replay::isKeyPressed(Input::KEY_W))
+			tank->accelerate(Replay::getIFps());
+		float spread = Replay::getRandomFloat(-1.0f, 1.0f);
+		...
+
+		// nothing is drawn in the headless playback, visual-only work can be skipped
+		if (!Replay::isHeadless())
+			updateEffects();
+	}
+
+	int AppWorldLogic::updatePhysics()
+	{
+		Replay::updatePhysics();
+		...
+		// state that must not diverge, the playback reports the first frame that differs
+		Replay::check(tank->getWorldPosition());
+	}
+
+	replay_record match.urpl
+	replay_stop
+	replay_play match.urpl
+
+	// without rendering, as fast as the simulation runs:
+	main -video_app null -replay_headless match.urpl
+*/
+
+namespace Unigine
+{
+
+//////////////////////////////////////////////////////////////////////////
+/// Deterministic input and event recorder.
+///
+/// The recording holds the game seed and physics step size, and per frame
+/// the frame duration, key and mouse state, the number of physics steps
+/// and a checksum of the values passed to check() and of the random draws
+/// made through Replay. Only the changes from the previous frame are
+/// written, an idle frame with the same duration takes one byte. The file
+/// is written through a stream buffer while the game runs.
+///
+/// The playback forces the recorded frame durations with Game::setIFps()
+/// and the recorded seed, so the engine steps the physics the same number
+/// of times per frame. Frames whose physics step count or checksum
+/// differ are reported as desynced.
+//////////////////////////////////////////////////////////////////////////
+
+class Replay
+{
+public:
+	enum MODE
+	{
+		MODE_DISABLED = 0,
+		MODE_RECORD,
+		MODE_PLAY,
+	};
+
+	enum
+	{
+		VERSION = 1,
+		HEADER_SIZE = 16,
+	};
+
+	// per frame flags of the file
+	enum
+	{
+		FLAG_IFPS = 1 << 0,
+		FLAG_KEYS = 1 << 1,
+		FLAG_BUTTONS = 1 << 2,
+		FLAG_COORD = 1 << 3,
+		FLAG_DELTA = 1 << 4,
+		FLAG_WHEEL = 1 << 5,
+		FLAG_STEPS = 1 << 6,
+		FLAG_CHECKSUM = 1 << 7,
+	};
+
+	static bool startRecording(const char *path)
+	{
+		stop();
+		State &s = get_state();
+		s.file = File::create(path, "wb");
+		if (!s.file || !s.file->isOpened())
+		{
+			Log::error("Replay::startRecording(): can't create \"%s\" file\n", path);
+			s.file.clear();
+			return false;
+		}
+		s.seed = Game::getSeed();
+		s.physics_ifps = Physics::getIFps();
+
+		s.writer.open(s.file);
+		s.writer.write("URPL", 4);
+		s.writer.writeUChar(VERSION);
+		s.writer.writeUChar(0);
+		s.writer.writeUChar(0);
+		s.writer.writeUChar(0);
+		s.writer.writeInt(s.seed);
+		s.writer.writeFloat(s.physics_ifps);
+
+		begin(MODE_RECORD, path);
+		return true;
+	}
+
+	// headless playback is started by runHeadless()
+	static bool startPlayback(const char *path, bool headless = false)
+	{
+		stop();
+		State &s = get_state();
+		s.file = File::create(path, "rb");
+		if (!s.file || !s.file->isOpened())
+		{
+			Log::error("Replay::startPlayback(): can't open \"%s\" file\n", path);
+			s.file.clear();
+			return false;
+		}
+		s.reader.open(s.file);
+		char magic[4] = {};
+		s.reader.read(magic, 4);
+		int version = s.reader.readUChar();
+		s.reader.readUChar();
+		s.reader.readUChar();
+		s.reader.readUChar();
+		s.seed = s.reader.readInt();
+		s.physics_ifps = s.reader.readFloat();
+		if (s.reader.isFailed() || memcmp(magic, "URPL", 4) != 0 || version != VERSION)
+		{
+			Log::error("Replay::startPlayback(): \"%s\" is not a replay of version %d\n", path, int(VERSION));
+			s.reader.close();
+			s.file.clear();
+			return false;
+		}
+
+		// frames are decoded against the current one
+		s.current = Frame();
+		s.has_next = read_frame(s.next);
+		s.saved_physics_ifps = Physics::getIFps();
+		Physics::setIFps(s.physics_ifps);
+		if (s.has_next)
+			Game::setIFps(s.next.ifps);
+		s.headless = headless;
+
+		begin(MODE_PLAY, path);
+		return true;
+	}
+
+	// finishes the recording or the playback
+	static void stop()
+	{
+		State &s = get_state();
+		if (s.mode == MODE_RECORD)
+		{
+			if (s.frame_open)
+				write_frame();
+			s.writer.close();
+			s.bytes = s.file->getSize();
+			Log::message("Replay::stop(): %d frames, %llu bytes written to \"%s\"\n", s.frame, (unsigned long long)s.bytes, s.path.get());
+		} else if (s.mode == MODE_PLAY)
+		{
+			if (s.frame_open)
+				verify_frame();
+			s.reader.close();
+			Game::setIFps(-1.0f);
+			Physics::setIFps(s.saved_physics_ifps);
+			String report;
+			getReport(report);
+			Log::message("%s", report.get());
+		}
+		s.file.clear();
+		s.mode = MODE_DISABLED;
+		s.headless = false;
+		s.frame_open = false;
+	}
+
+	UNIGINE_INLINE static MODE getMode() { return get_state().mode; }
+	// true during the playback started by runHeadless(), the frames are not rendered
+	UNIGINE_INLINE static bool isHeadless() { return get_state().headless; }
+
+	// frames recorded or played since the start
+	UNIGINE_INLINE static int getFrame() { return get_state().frame; }
+	// first frame that differs from the recording, -1 if none
+	UNIGINE_INLINE static int getDesyncFrame() { return get_state().desync_frame; }
+
+	// frame and physics steps per second of wall time and the ratio of simulated to wall time
+	static void getReport(String &ret)
+	{
+		State &s = get_state();
+		using Clock = std::chrono::steady_clock;
+		double seconds = std::chrono::duration<double>(Clock::now() - s.start_time).count();
+		if (seconds <= 0.0)
+			seconds = 1e-9;
+		ret.clear();
+		Format::append(ret, "Replay \"{}\": {} frames, {} physics steps, {:.1} s simulated in {:.2} s\n",
+			s.path.get(), s.frame, (unsigned long long)s.physics_steps_total, s.simulated_time, seconds);
+		Format::append(ret, "{:.1} frames/s, {:.1} physics steps/s, {:.1}x real time\n",
+			s.frame / seconds, double(s.physics_steps_total) / seconds, s.simulated_time / seconds);
+		if (s.desync_frame != -1)
+			Format::append(ret, "desync at frame {}\n", s.desync_frame);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// main loop hooks
+	//////////////////////////////////////////////////////////////////////////
+
+	// the first call of AppWorldLogic::update(), begins the frame
+	static void update()
+	{
+		State &s = get_state();
+		if (s.mode == MODE_DISABLED)
+			return;
+
+		if (s.mode == MODE_RECORD)
+		{
+			if (s.frame_open)
+				write_frame();
+			else
+				Game::setSeed(s.seed);
+			s.previous = s.current;
+			capture(s.current);
+		} else
+		{
+			if (s.frame_open)
+				verify_frame();
+			else
+				Game::setSeed(s.seed);
+			if (!s.has_next)
+			{
+				stop();
+				return;
+			}
+			s.previous = s.current;
+			s.current = s.next;
+			s.has_next = read_frame(s.next);
+
+			// the engine takes the duration at the beginning of the frame
+			if (s.has_next)
+				Game::setIFps(s.next.ifps);
+		}
+
+		s.simulated_time += s.current.ifps;
+		s.checksum.reset();
+		s.num_checks = 0;
+		s.physics_steps = 0;
+		s.frame_open = true;
+	}
+
+	// the first call of AppWorldLogic::updatePhysics()
+	UNIGINE_INLINE static void updatePhysics()
+	{
+		State &s = get_state();
+		if (s.frame_open)
+			s.physics_steps++;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// input, recorded state in the playback and live state otherwise
+	//////////////////////////////////////////////////////////////////////////
+
+	static bool isKeyPressed(Input::KEY key)
+	{
+		const State &s = get_state();
+		if (!s.frame_open)
+			return Input::isKeyPressed(key);
+		return get_bit(s.current.keys, key);
+	}
+
+	static bool isKeyDown(Input::KEY key)
+	{
+		const State &s = get_state();
+		if (!s.frame_open)
+			return Input::isKeyDown(key);
+		return get_bit(s.current.keys, key) && !get_bit(s.previous.keys, key);
+	}
+
+	static bool isKeyUp(Input::KEY key)
+	{
+		const State &s = get_state();
+		if (!s.frame_open)
+			return Input::isKeyUp(key);
+		return !get_bit(s.current.keys, key) && get_bit(s.previous.keys, key);
+	}
+
+	static bool isMouseButtonPressed(Input::MOUSE_BUTTON button)
+	{
+		const State &s = get_state();
+		if (!s.frame_open)
+			return Input::isMouseButtonPressed(button);
+		return (s.current.buttons >> button) & 1;
+	}
+
+	static bool isMouseButtonDown(Input::MOUSE_BUTTON button)
+	{
+		const State &s = get_state();
+		if (!s.frame_open)
+			return Input::isMouseButtonDown(button);
+		return ((s.current.buttons & ~s.previous.buttons) >> button) & 1;
+	}
+
+	static bool isMouseButtonUp(Input::MOUSE_BUTTON button)
+	{
+		const State &s = get_state();
+		if (!s.frame_open)
+			return Input::isMouseButtonUp(button);
+		return ((~s.current.buttons & s.previous.buttons) >> button) & 1;
+	}
+
+	static Math::ivec2 getMouseCoord()
+	{
+		const State &s = get_state();
+		return s.frame_open ? s.current.mouse_coord : Input::getMouseCoord();
+	}
+
+	static Math::vec2 getMouseDelta()
+	{
+		const State &s = get_state();
+		return s.frame_open ? s.current.mouse_delta : Input::getMouseDelta();
+	}
+
+	static int getMouseWheel()
+	{
+		const State &s = get_state();
+		return s.frame_open ? s.current.mouse_wheel : Input::getMouseWheel();
+	}
+
+	static int getMouseWheelHorizontal()
+	{
+		const State &s = get_state();
+		return s.frame_open ? s.current.mouse_wheel_horizontal : Input::getMouseWheelHorizontal();
+	}
+
+	// duration of the frame, equal to Game::getIFps() once the engine took the recorded one
+	static float getIFps()
+	{
+		const State &s = get_state();
+		return s.frame_open ? s.current.ifps : Game::getIFps();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// random draws and checked state
+	//////////////////////////////////////////////////////////////////////////
+
+	static int getRandomInt(int from, int to)
+	{
+		int value = Game::getRandomInt(from, to);
+		check(value);
+		return value;
+	}
+
+	static float getRandomFloat(float from, float to)
+	{
+		float value = Game::getRandomFloat(from, to);
+		check(value);
+		return value;
+	}
+
+	static double getRandomDouble(double from, double to)
+	{
+		double value = Game::getRandomDouble(from, to);
+		check(value);
+		return value;
+	}
+
+	// adds the bytes to the checksum of the frame
+	static void check(const void *data, size_t size)
+	{
+		State &s = get_state();
+		if (!s.frame_open)
+			return;
+		s.checksum.update(data, size);
+		s.num_checks++;
+	}
+
+	template <class Type>
+	UNIGINE_INLINE static void check(const Type &value)
+	{
+		static_assert(std::is_trivially_copyable<Type>::value, "Replay::check(): the type must be trivially copyable");
+		check(&value, sizeof(Type));
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// headless playback
+	//////////////////////////////////////////////////////////////////////////
+
+	// replays the file of the -replay_headless argument with the logics and quits,
+	// returns false without the argument, the engine must run with -video_app null
+	static bool runHeadless(SystemLogic *system, WorldLogic *world, EditorLogic *editor)
+	{
+		Engine *engine = Engine::get();
+		const char *path = nullptr;
+		for (int i = 0; i + 1 < engine->getNumArgs(); i++)
+		{
+			if (strcmp(engine->getArg(i), "-replay_headless") == 0)
+				path = engine->getArg(i + 1);
+		}
+		if (!path)
+			return false;
+		const char *video_app = engine->getVideoApp();
+		if (!video_app || strcmp(video_app, "null") != 0)
+		{
+			Log::error("Replay::runHeadless(): -replay_headless needs -video_app null, the video app is \"%s\"\n", video_app ? video_app : "");
+			return true;
+		}
+
+		engine->addSystemLogic(system);
+		engine->addWorldLogic(world);
+		engine->addEditorLogic(editor);
+
+		// frame durations come from the file, nothing waits for the wall clock
+		if (startPlayback(path, true))
+		{
+			// nothing is drawn, swap() still synchronizes the physics and ends the frame
+			while (!engine->isDone() && getMode() == MODE_PLAY)
+			{
+				engine->update();
+				engine->swap();
+			}
+			stop();
+		}
+
+		engine->removeEditorLogic(editor);
+		engine->removeWorldLogic(world);
+		engine->removeSystemLogic(system);
+		return true;
+	}
+
+	static void addConsoleCommands()
+	{
+		Console::addCommand("replay_record", "starts recording input and random draws to a file", MakeCallback(&Replay::console_record));
+		Console::addCommand("replay_play", "plays a recording back", MakeCallback(&Replay::console_play));
+		Console::addCommand("replay_stop", "stops the recording or the playback", MakeCallback(&Replay::console_stop));
+	}
+
+	static void removeConsoleCommands()
+	{
+		Console::removeCommand("replay_record");
+		Console::removeCommand("replay_play");
+		Console::removeCommand("replay_stop");
+	}
+
+private:
+	enum
+	{
+		NUM_KEY_BYTES = (Input::NUM_KEYS + 7) / 8,
+	};
+
+	struct Frame
+	{
+		unsigned char keys[NUM_KEY_BYTES]{};
+		unsigned char buttons{0};
+		Math::ivec2 mouse_coord{0, 0};
+		Math::vec2 mouse_delta{0.0f, 0.0f};
+		int mouse_wheel{0};
+		int mouse_wheel_horizontal{0};
+		float ifps{0.0f};
+		int physics_steps{1};
+		int has_checksum{0};
+		unsigned int checksum{0};
+	};
+
+	struct State
+	{
+		MODE mode{MODE_DISABLED};
+		bool headless{false};
+		String path;
+		FilePtr file;
+		StreamBufferWriter writer;
+		StreamBufferReader reader;
+
+		int seed{0};
+		float physics_ifps{0.0f};
+		float saved_physics_ifps{0.0f};
+
+		Frame previous;
+		Frame current;
+		Frame next;
+		bool has_next{false};
+		bool frame_open{false};
+
+		CRC32C checksum;
+		int num_checks{0};
+		int physics_steps{0};
+
+		int frame{0};
+		int desync_frame{-1};
+		double simulated_time{0.0};
+		unsigned long long physics_steps_total{0};
+		size_t bytes{0};
+		std::chrono::steady_clock::time_point start_time;
+	};
+
+	static State &get_state()
+	{
+		static State state;
+		return state;
+	}
+
+	UNIGINE_INLINE static bool get_bit(const unsigned char *bits, int num) { return (bits[num >> 3] >> (num & 7)) & 1; }
+
+	static void begin(MODE mode, const char *path)
+	{
+		State &s = get_state();
+		s.mode = mode;
+		s.path = path;
+		s.previous = Frame();
+		s.current = Frame();
+		s.frame_open = false;
+		s.frame = 0;
+		s.desync_frame = -1;
+		s.simulated_time = 0.0;
+		s.physics_steps_total = 0;
+		s.bytes = 0;
+		s.start_time = std::chrono::steady_clock::now();
+	}
+
+	static void capture(Frame &frame)
+	{
+		memset(frame.keys, 0, sizeof(frame.keys));
+		for (int i = 0; i < Input::NUM_KEYS; i++)
+		{
+			if (Input::isKeyPressed(Input::KEY(i)))
+				frame.keys[i >> 3] |= (unsigned char)(1 << (i & 7));
+		}
+		frame.buttons = 0;
+		for (int i = 0; i < Input::MOUSE_NUM_BUTTONS; i++)
+		{
+			if (Input::isMouseButtonPressed(Input::MOUSE_BUTTON(i)))
+				frame.buttons |= (unsigned char)(1 << i);
+		}
+		frame.mouse_coord = Input::getMouseCoord();
+		frame.mouse_delta = Input::getMouseDelta();
+		frame.mouse_wheel = Input::getMouseWheel();
+		frame.mouse_wheel_horizontal = Input::getMouseWheelHorizontal();
+		frame.ifps = Game::getIFps();
+	}
+
+	static void write_varint(StreamBufferWriter &writer, unsigned int value)
+	{
+		while (value >= 0x80)
+		{
+			writer.writeUChar((unsigned char)(value | 0x80));
+			value >>= 7;
+		}
+		writer.writeUChar((unsigned char)value);
+	}
+
+	static unsigned int read_varint(StreamBufferReader &reader)
+	{
+		unsigned int value = 0;
+		for (int shift = 0; shift < 35; shift += 7)
+		{
+			unsigned char c = reader.readUChar();
+			value |= (unsigned int)(c & 0x7f) << shift;
+			if (!(c & 0x80))
+				break;
+		}
+		return value;
+	}
+
+	UNIGINE_INLINE static unsigned int zigzag(int value) { return ((unsigned int)value << 1) ^ (unsigned int)(value >> 31); }
+	UNIGINE_INLINE static int unzigzag(unsigned int value) { return int(value >> 1) ^ -int(value & 1); }
+
+	// the current frame with the physics steps and the checksum of the frame
+	static void write_frame()
+	{
+		State &s = get_state();
+		Frame &f = s.current;
+		const Frame &p = s.previous;
+		f.physics_steps = s.physics_steps;
+		f.has_checksum = s.num_checks != 0;
+		f.checksum = s.checksum.final();
+
+		int num_keys = 0;
+		for (int i = 0; i < NUM_KEY_BYTES; i++)
+		{
+			for (unsigned char changed = f.keys[i] ^ p.keys[i]; changed; changed &= changed - 1)
+				num_keys++;
+		}
+
+		unsigned char flags = 0;
+		if (f.ifps != p.ifps)
+			flags |= FLAG_IFPS;
+		if (num_keys)
+			flags |= FLAG_KEYS;
+		if (f.buttons != p.buttons)
+			flags |= FLAG_BUTTONS;
+		if (f.mouse_coord.x != p.mouse_coord.x || f.mouse_coord.y != p.mouse_coord.y)
+			flags |= FLAG_COORD;
+		if (f.mouse_delta.x != 0.0f || f.mouse_delta.y != 0.0f)
+			flags |= FLAG_DELTA;
+		if (f.mouse_wheel || f.mouse_wheel_horizontal)
+			flags |= FLAG_WHEEL;
+		if (f.physics_steps != 1)
+			flags |= FLAG_STEPS;
+		if (f.has_checksum)
+			flags |= FLAG_CHECKSUM;
+
+		StreamBufferWriter &w = s.writer;
+		w.writeUChar(flags);
+		if (flags & FLAG_IFPS)
+			w.writeFloat(f.ifps);
+		if (flags & FLAG_KEYS)
+		{
+			write_varint(w, num_keys);
+			for (int i = 0; i < Input::NUM_KEYS; i++)
+			{
+				if (get_bit(f.keys, i) != get_bit(p.keys, i))
+					write_varint(w, i);
+			}
+		}
+		if (flags & FLAG_BUTTONS)
+			w.writeUChar(f.buttons);
+		if (flags & FLAG_COORD)
+		{
+			write_varint(w, zigzag(f.mouse_coord.x - p.mouse_coord.x));
+			write_varint(w, zigzag(f.mouse_coord.y - p.mouse_coord.y));
+		}
+		if (flags & FLAG_DELTA)
+			w.writeVec2(f.mouse_delta);
+		if (flags & FLAG_WHEEL)
+		{
+			write_varint(w, zigzag(f.mouse_wheel));
+			write_varint(w, zigzag(f.mouse_wheel_horizontal));
+		}
+		if (flags & FLAG_STEPS)
+			write_varint(w, f.physics_steps);
+		if (flags & FLAG_CHECKSUM)
+			w.writeUInt(f.checksum);
+
+		s.frame++;
+		s.physics_steps_total += s.physics_steps;
+		s.frame_open = false;
+	}
+
+	// the frame after s.current, false at the end of the file
+	static bool read_frame(Frame &f)
+	{
+		State &s = get_state();
+		StreamBufferReader &r = s.reader;
+		if (r.isEnd())
+			return false;
+
+		const Frame &p = s.current;
+		unsigned char flags = r.readUChar();
+		memcpy(f.keys, p.keys, sizeof(f.keys));
+		f.ifps = (flags & FLAG_IFPS) ? r.readFloat() : p.ifps;
+		if (flags & FLAG_KEYS)
+		{
+			unsigned int num = read_varint(r);
+			for (unsigned int i = 0; i < num && !r.isFailed(); i++)
+			{
+				unsigned int key = read_varint(r);
+				if (key < Input::NUM_KEYS)
+					f.keys[key >> 3] ^= (unsigned char)(1 << (key & 7));
+			}
+		}
+		f.buttons = (flags & FLAG_BUTTONS) ? r.readUChar() : p.buttons;
+		f.mouse_coord = p.mouse_coord;
+		if (flags & FLAG_COORD)
+		{
+			f.mouse_coord.x += unzigzag(read_varint(r));
+			f.mouse_coord.y += unzigzag(read_varint(r));
+		}
+		f.mouse_delta = (flags & FLAG_DELTA) ? r.readVec2() : Math::vec2(0.0f, 0.0f);
+		f.mouse_wheel = 0;
+		f.mouse_wheel_horizontal = 0;
+		if (flags & FLAG_WHEEL)
+		{
+			f.mouse_wheel = unzigzag(read_varint(r));
+			f.mouse_wheel_horizontal = unzigzag(read_varint(r));
+		}
+		f.physics_steps = (flags & FLAG_STEPS) ? int(read_varint(r)) : 1;
+		f.has_checksum = (flags & FLAG_CHECKSUM) != 0;
+		f.checksum = f.has_checksum ? r.readUInt() : 0;
+
+		if (r.isFailed())
+		{
+			Log::warning("Replay::read_frame(): \"%s\" is truncated\n", s.path.get());
+			return false;
+		}
+		return true;
+	}
+
+	// compares the played frame with the recording
+	static void verify_frame()
+	{
+		State &s = get_state();
+		const Frame &f = s.current;
+		bool checksum = (s.num_checks != 0) == (f.has_checksum != 0) && (!f.has_checksum || s.checksum.final() == f.checksum);
+		if ((s.physics_steps != f.physics_steps || !checksum) && s.desync_frame == -1)
+		{
+			s.desync_frame = s.frame;
+			Log::warning("Replay: desync at frame %d, %d physics steps of %d recorded, checksum %s\n",
+				s.frame, s.physics_steps, f.physics_steps, checksum ? "matches" : "differs");
+		}
+		s.frame++;
+		s.physics_steps_total += s.physics_steps;
+		s.frame_open = false;
+	}
+
+	static void console_record(int argc, char **argv)
+	{
+		if (argc < 2)
+		{
+			Log::message("replay_record <file>\n");
+			return;
+		}
+		startRecording(argv[1]);
+	}
+
+	static void console_play(int argc, char **argv)
+	{
+		if (argc < 2)
+		{
+			Log::message("replay_play <file>\n");
+			return;
+		}
+		startPlayback(argv[1]);
+	}
+
+	static void console_stop(int argc, char **argv)
+	{
+		UNIGINE_UNUSED(argc);
+		UNIGINE_UNUSED(argv);
+		stop();
+	}
+};
+
+} // namespace Unigine
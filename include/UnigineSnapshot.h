@@ -0,0 +1,1638 @@
+/* Copyright (C) 2005-2020, UNIGINE. All rights reserved.
+ *
+ * This file is a part of the UNIGINE 2 SDK.
+ *
+ * Your use and / or redistribution of this software in source and / or
+ * binary form, with or without modification, is subject to: (i) your
+ * ongoing acceptance of and compliance with the terms and conditions of
+ * the UNIGINE License Agreement; and (ii) your inclusion of this notice
+ * in any version of this software that you use or redistribute.
+ * A copy of the UNIGINE License Agreement is available by contacting
+ * UNIGINE. at http://unigine.com/
+ */
+
+
+#pragma once
+
+#include "UnigineChecksumEngine.h"
+#include "UnigineStreamBuffer.h"
+#include "UnigineCompress.h"
+#include "UnigineComponentSystem.h"
+#include "UnigineStreams.h"
+#include "UnigineHashMap.h"
+#include "UnigineVector.h"
+#include "UnigineString.h"
+#include "UnigineMathLib.h"
+#include "UnigineConsole.h"
+#include "UnigineFormat.h"
+#include "UnigineLog.h"
+#include <type_traits>
+#include <climits>
+#include <chrono>
+
+// Snapshot example
+/*
+	// save, columns are gathered by the functions at once
+	SnapshotWriter writer(SCHEMA_VERSION);
+	SnapshotWriter::Section &tanks = writer.addSection("tanks", num_tanks, Snapshot::CODEC_LZ4);
+	tanks.add("id", [&](int i) { return tanks_data[i].id; });
+	tanks.add("transform", [&](int i) { return tanks_data[i].transform; });
+	tanks.addString("name", [&](int i) { return tanks_data[i].name.get(); });
+	writer.save(stream);
+
+	// restore, unknown columns are skipped, missing ones keep their values
+	SnapshotReader reader;
+	if (!reader.load(stream))
+		return 0;
+	if (SnapshotReader::Section *section = reader.findSection("tanks"))
+	{
+		tanks_data.resize(section->getNumRows());
+		section->read<int>("id", [&](int i, int id) { tanks_data[i].id = id; });
+		section->read<Math::mat4>("transform", [&](int i, const Math::mat4 &t) { tanks_data[i].transform = t; });
+		section->readString("name", [&](int i, const char *name) { tanks_data[i].name = name; });
+	}
+
+	// component variables and node transforms of the registered classes
+	SnapshotComponents::add<Tank>();
+	SnapshotComponents::save(stream);
+	SnapshotComponents::restore(stream);
+*/
+
+namespace Unigine
+{
+
+//////////////////////////////////////////////////////////////////////////
+/// Binary world state snapshot.
+///
+/// A snapshot is a set of named sections, each section is a table of rows
+/// stored column by column. Columns are found by the hash of the name, so
+/// columns can be added and removed between versions of the game without
+/// breaking old files. Integers are stored as varints of the values or of
+/// the deltas to the previous row, whichever is smaller; floats are stored
+/// as planes of components and, in compressed sections, as byte planes
+/// that compress well. Each section is compressed and checksummed alone,
+/// the section table in the header gives O(1) access to any section. All
+/// integers are little-endian.
+///
+///   header   "USNP", u16 version, u16 0, u32 schema version, u32 number of sections, u64 data size
+///   table    u32 name hash, u32 rows, u32 codec, u32 packed size, u32 raw size, u32 CRC-32C of the packed data, u64 offset
+///   data     packed sections
+///   section  u32 number of columns, columns
+///   column   u32 name hash, u8 type, u8 encoding, u8 components, u8 flags, u32 size, data
+//////////////////////////////////////////////////////////////////////////
+
+class Snapshot
+{
+public:
+	enum CODEC
+	{
+		CODEC_NONE = 0,
+		CODEC_LZ4,
+		CODEC_ZLIB,
+		NUM_CODECS,
+	};
+
+	enum TYPE
+	{
+		TYPE_INT = 0,	// int and long long
+		TYPE_FLOAT,
+		TYPE_DOUBLE,
+		TYPE_STRING,
+		NUM_TYPES,
+	};
+
+	enum ENCODING
+	{
+		ENCODING_RAW = 0,	// ints as 32-bit values, floats as they are
+		ENCODING_VARINT,	// zigzag varints of the values
+		ENCODING_DELTA,	// zigzag varints of the differences to the previous row
+		ENCODING_SHUFFLE,	// floats split into byte planes
+		NUM_ENCODINGS,
+	};
+
+	enum
+	{
+		VERSION = 1,
+		HEADER_SIZE = 24,
+		TABLE_ENTRY_SIZE = 32,
+		COLUMN_HEADER_SIZE = 12,
+		MAX_SIZE = 0x7fffffff,	// section table, data and unpacked sections, Vector sizes are int
+	};
+
+	// column flags
+	enum
+	{
+		FLAG_KEY = 1 << 0,	// identifies the rows between snapshots
+	};
+
+	// FNV-1a of the section and column names
+	static UNIGINE_INLINE unsigned int getNameHash(const char *name)
+	{
+		unsigned int hash = 2166136261u;
+		for (const unsigned char *s = reinterpret_cast<const unsigned char *>(name); *s; s++)
+			hash = (hash ^ *s) * 16777619u;
+		return hash;
+	}
+
+	// little-endian integers
+	static UNIGINE_INLINE void setU32(unsigned char *d, unsigned int v)
+	{
+		for (int i = 0; i < 4; i++)
+			d[i] = (unsigned char)(v >> (i * 8));
+	}
+	static UNIGINE_INLINE void setU64(unsigned char *d, unsigned long long v)
+	{
+		for (int i = 0; i < 8; i++)
+			d[i] = (unsigned char)(v >> (i * 8));
+	}
+	static UNIGINE_INLINE unsigned int getU32(const unsigned char *s)
+	{
+		return s[0] | (s[1] << 8) | (s[2] << 16) | ((unsigned int)s[3] << 24);
+	}
+	static UNIGINE_INLINE unsigned long long getU64(const unsigned char *s)
+	{
+		return getU32(s) | ((unsigned long long)getU32(s + 4) << 32);
+	}
+
+	// varints, 10 bytes at most
+	static UNIGINE_INLINE unsigned long long zigzag(long long v) { return ((unsigned long long)v << 1) ^ (unsigned long long)(v >> 63); }
+	static UNIGINE_INLINE long long unzigzag(unsigned long long v) { return (long long)(v >> 1) ^ -(long long)(v & 1); }
+	// deltas wrap around like unsigned integers
+	static UNIGINE_INLINE long long add(long long a, long long b) { return (long long)((unsigned long long)a + (unsigned long long)b); }
+	static UNIGINE_INLINE long long subtract(long long a, long long b) { return (long long)((unsigned long long)a - (unsigned long long)b); }
+	static UNIGINE_INLINE int getVarintSize(unsigned long long v)
+	{
+		int size = 1;
+		while (v >= 0x80)
+		{
+			v >>= 7;
+			size++;
+		}
+		return size;
+	}
+	static UNIGINE_INLINE unsigned char *putVarint(unsigned char *d, unsigned long long v)
+	{
+		while (v >= 0x80)
+		{
+			*d++ = (unsigned char)(v | 0x80);
+			v >>= 7;
+		}
+		*d++ = (unsigned char)v;
+		return d;
+	}
+	// returns nullptr at the end of the data or for a broken varint
+	static UNIGINE_INLINE const unsigned char *getVarint(const unsigned char *s, const unsigned char *end, unsigned long long &v)
+	{
+		v = 0;
+		for (int shift = 0; s < end && shift < 64; shift += 7)
+		{
+			unsigned char b = *s++;
+			v |= (unsigned long long)(b & 0x7f) << shift;
+			if ((b & 0x80) == 0)
+				return s;
+		}
+		return nullptr;
+	}
+
+	// column layout of the value types: TYPE, number of components and
+	// conversion to and from component planes with the stride of the rows
+	template <class T, class Enable = void>
+	struct Traits;
+
+	// save and restore time of a synthetic state with tanks and projectiles
+	static void getBenchmarkReport(String &ret, int num_tanks = 10000);
+
+	// snapshot_benchmark [number of tanks]
+	static void addConsoleCommands()
+	{
+		Console::addCommand("snapshot_benchmark", "prints the save and restore time of a world state snapshot", MakeCallback(&Snapshot::console_benchmark));
+	}
+	static void removeConsoleCommands() { Console::removeCommand("snapshot_benchmark"); }
+
+private:
+	static void console_benchmark(int argc, char **argv)
+	{
+		int num = 10000;
+		if (argc > 1 && atoi(argv[1]) > 0)
+			num = atoi(argv[1]);
+		String report;
+		getBenchmarkReport(report, num);
+		Log::message("%s", report.get());
+	}
+};
+
+template <class T>
+struct Snapshot::Traits<T, typename std::enable_if<std::is_integral<T>::value>::type>
+{
+	using Value = long long;
+	enum { TYPE = TYPE_INT, COMPONENTS = 1 };
+	static UNIGINE_INLINE void get(const T &v, Value *d, int) { d[0] = (Value)v; }
+	static UNIGINE_INLINE T make(const Value *s, int) { return (T)s[0]; }
+};
+
+template <>
+struct Snapshot::Traits<float>
+{
+	using Value = float;
+	enum { TYPE = TYPE_FLOAT, COMPONENTS = 1 };
+	static UNIGINE_INLINE void get(const float &v, Value *d, int) { d[0] = v; }
+	static UNIGINE_INLINE float make(const Value *s, int) { return s[0]; }
+};
+
+template <>
+struct Snapshot::Traits<double>
+{
+	using Value = double;
+	enum { TYPE = TYPE_DOUBLE, COMPONENTS = 1 };
+	static UNIGINE_INLINE void get(const double &v, Value *d, int) { d[0] = v; }
+	static UNIGINE_INLINE double make(const Value *s, int) { return s[0]; }
+};
+
+#define UNIGINE_SNAPSHOT_VECTOR_TRAITS(VECTOR, VALUE, TYPE_ID, NUM)									\
+template <>																							\
+struct Snapshot::Traits<VECTOR>																		\
+{																									\
+	using Value = VALUE;																			\
+	enum { TYPE = TYPE_ID, COMPONENTS = NUM };														\
+	static UNIGINE_INLINE void get(const VECTOR &v, Value *d, int stride)							\
+	{																								\
+		for (int i = 0; i < NUM; i++)																\
+			d[i * stride] = (Value)v[i];															\
+	}																								\
+	static UNIGINE_INLINE VECTOR make(const Value *s, int stride)									\
+	{																								\
+		VECTOR v;																					\
+		for (int i = 0; i < NUM; i++)																\
+			v[i] = s[i * stride];																	\
+		return v;																					\
+	}																								\
+};
+
+UNIGINE_SNAPSHOT_VECTOR_TRAITS(Math::vec2, float, TYPE_FLOAT, 2)
+UNIGINE_SNAPSHOT_VECTOR_TRAITS(Math::vec3, float, TYPE_FLOAT, 3)
+UNIGINE_SNAPSHOT_VECTOR_TRAITS(Math::vec4, float, TYPE_FLOAT, 4)
+UNIGINE_SNAPSHOT_VECTOR_TRAITS(Math::dvec2, double, TYPE_DOUBLE, 2)
+UNIGINE_SNAPSHOT_VECTOR_TRAITS(Math::dvec3, double, TYPE_DOUBLE, 3)
+UNIGINE_SNAPSHOT_VECTOR_TRAITS(Math::dvec4, double, TYPE_DOUBLE, 4)
+UNIGINE_SNAPSHOT_VECTOR_TRAITS(Math::ivec2, long long, TYPE_INT, 2)
+UNIGINE_SNAPSHOT_VECTOR_TRAITS(Math::ivec3, long long, TYPE_INT, 3)
+UNIGINE_SNAPSHOT_VECTOR_TRAITS(Math::ivec4, long long, TYPE_INT, 4)
+
+#undef UNIGINE_SNAPSHOT_VECTOR_TRAITS
+
+template <>
+struct Snapshot::Traits<Math::quat>
+{
+	using Value = float;
+	enum { TYPE = TYPE_FLOAT, COMPONENTS = 4 };
+	static UNIGINE_INLINE void get(const Math::quat &q, Value *d, int stride)
+	{
+		d[0] = q.x;
+		d[stride] = q.y;
+		d[stride * 2] = q.z;
+		d[stride * 3] = q.w;
+	}
+	static UNIGINE_INLINE Math::quat make(const Value *s, int stride) { return Math::quat(s[0], s[stride], s[stride * 2], s[stride * 3]); }
+};
+
+// matrices as three rows of each column, like dmat4::mat
+template <>
+struct Snapshot::Traits<Math::mat4>
+{
+	using Value = float;
+	enum { TYPE = TYPE_FLOAT, COMPONENTS = 12 };
+	static UNIGINE_INLINE void get(const Math::mat4 &m, Value *d, int stride)
+	{
+		for (int i = 0; i < 12; i++)
+			d[i * stride] = m.mat[(i / 3) * 4 + i % 3];
+	}
+	static UNIGINE_INLINE Math::mat4 make(const Value *s, int stride)
+	{
+		Math::mat4 m = Math::mat4_identity;
+		for (int i = 0; i < 12; i++)
+			m.mat[(i / 3) * 4 + i % 3] = s[i * stride];
+		return m;
+	}
+};
+
+template <>
+struct Snapshot::Traits<Math::dmat4>
+{
+	using Value = double;
+	enum { TYPE = TYPE_DOUBLE, COMPONENTS = 12 };
+	static UNIGINE_INLINE void get(const Math::dmat4 &m, Value *d, int stride)
+	{
+		for (int i = 0; i < 12; i++)
+			d[i * stride] = m.mat[i];
+	}
+	static UNIGINE_INLINE Math::dmat4 make(const Value *s, int stride)
+	{
+		Math::dmat4 m;
+		for (int i = 0; i < 12; i++)
+			m.mat[i] = s[i * stride];
+		return m;
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// Snapshot writer.
+///
+/// Adding a column only copies the values, the state may change right
+/// after that. save() encodes and compresses the sections on
+/// PoolCPUShaders threads and writes the whole snapshot at once, so it
+/// may run on another thread than the one that captured the columns.
+//////////////////////////////////////////////////////////////////////////
+
+class SnapshotWriter
+{
+public:
+	// captured values, components are stored in planes of rows
+	struct Column
+	{
+		unsigned int hash{0};
+		int type{Snapshot::TYPE_INT};
+		int components{1};
+		int flags{0};
+		Vector<long long> ints;
+		Vector<float> floats;
+		Vector<double> doubles;
+		Vector<char> chars;	// zero terminated strings
+		Vector<int> offsets;	// of the strings in chars
+
+		UNIGINE_INLINE const char *getString(int row) const { return chars.get() + offsets[row]; }
+		UNIGINE_INLINE long long getInt(int row) const { return ints[row]; }
+
+		UNIGINE_INLINE Vector<long long> &getValues(long long *) { return ints; }
+		UNIGINE_INLINE Vector<float> &getValues(float *) { return floats; }
+		UNIGINE_INLINE Vector<double> &getValues(double *) { return doubles; }
+
+		// bitwise comparison with a row of a column of the same layout
+		bool isEqual(int row, int rows, const Column &c, int c_row, int c_rows) const
+		{
+			switch (type)
+			{
+				case Snapshot::TYPE_INT: return is_equal(ints.get(), row, rows, c.ints.get(), c_row, c_rows);
+				case Snapshot::TYPE_FLOAT: return is_equal(floats.get(), row, rows, c.floats.get(), c_row, c_rows);
+				case Snapshot::TYPE_DOUBLE: return is_equal(doubles.get(), row, rows, c.doubles.get(), c_row, c_rows);
+				default: return strcmp(getString(row), c.getString(c_row)) == 0;
+			}
+		}
+
+		// copies the row of a column of the same layout, the planes must
+		// hold all rows, strings are appended so the rows go in order
+		void copyRow(int row, int rows, const Column &c, int c_row, int c_rows)
+		{
+			switch (type)
+			{
+				case Snapshot::TYPE_INT: copy_row(ints.get(), row, rows, c.ints.get(), c_row, c_rows); break;
+				case Snapshot::TYPE_FLOAT: copy_row(floats.get(), row, rows, c.floats.get(), c_row, c_rows); break;
+				case Snapshot::TYPE_DOUBLE: copy_row(doubles.get(), row, rows, c.doubles.get(), c_row, c_rows); break;
+				default: appendString(c.getString(c_row)); break;
+			}
+		}
+
+		void appendString(const char *str)
+		{
+			offsets.append(chars.size());
+			chars.append(str, strlen(str) + 1);
+		}
+
+	private:
+		template <class Type>
+		bool is_equal(const Type *s, int row, int rows, const Type *c, int c_row, int c_rows) const
+		{
+			for (int i = 0; i < components; i++)
+			{
+				if (memcmp(s + size_t(i) * rows + row, c + size_t(i) * c_rows + c_row, sizeof(Type)) != 0)
+					return false;
+			}
+			return true;
+		}
+		template <class Type>
+		void copy_row(Type *d, int row, int rows, const Type *s, int s_row, int s_rows)
+		{
+			for (int i = 0; i < components; i++)
+				d[size_t(i) * rows + row] = s[size_t(i) * s_rows + s_row];
+		}
+	};
+
+	class Section
+	{
+	public:
+		~Section()
+		{
+			for (int i = 0; i < columns.size(); i++)
+				delete columns[i];
+		}
+
+		UNIGINE_INLINE const char *getName() const { return name.get(); }
+		UNIGINE_INLINE unsigned int getHash() const { return hash; }
+		UNIGINE_INLINE int getNumRows() const { return rows; }
+		UNIGINE_INLINE Snapshot::CODEC getCodec() const { return Snapshot::CODEC(codec); }
+
+		UNIGINE_INLINE int getNumColumns() const { return columns.size(); }
+		UNIGINE_INLINE const Column &getColumn(int num) const { return *columns[num]; }
+		UNIGINE_INLINE int findColumn(unsigned int column_hash) const { return column_index.value(column_hash, -1); }
+		// column with Snapshot::FLAG_KEY or -1
+		int getKeyColumn() const
+		{
+			for (int i = 0; i < columns.size(); i++)
+			{
+				if (columns[i]->flags & Snapshot::FLAG_KEY)
+					return i;
+			}
+			return -1;
+		}
+
+		// func(row) returns a scalar, a vector, a quaternion or a matrix
+		template <class Func>
+		Section &add(const char *name, const Func &func)
+		{
+			using Type = typename std::decay<decltype(func(0))>::type;
+			using Traits = Snapshot::Traits<Type>;
+			using Value = typename Traits::Value;
+
+			Column *column = addColumn(name, Snapshot::getNameHash(name), Traits::TYPE, Traits::COMPONENTS);
+			if (!column)
+				return *this;
+			Vector<Value> &values = column->getValues(static_cast<Value *>(nullptr));
+			values.resize(size_t(rows) * Traits::COMPONENTS);
+			for (int i = 0; i < rows; i++)
+				Traits::get(func(i), values.get() + i, rows);
+			return *this;
+		}
+
+		// integer that identifies the rows between snapshots, see SnapshotDelta
+		template <class Func>
+		Section &addKey(const char *name, const Func &func)
+		{
+			int num = columns.size();
+			add(name, [&](int i) { return (long long)func(i); });
+			if (columns.size() > num)
+				columns.last()->flags |= Snapshot::FLAG_KEY;
+			return *this;
+		}
+
+		// func(row) returns a const char * or a String
+		template <class Func>
+		Section &addString(const char *name, const Func &func)
+		{
+			Column *column = addColumn(name, Snapshot::getNameHash(name), Snapshot::TYPE_STRING, 1);
+			if (!column)
+				return *this;
+			column->offsets.reserve(rows);
+			for (int i = 0; i < rows; i++)
+			{
+				// a returned String must outlive the append
+				auto &&value = func(i);
+				const char *str = get_string(value);
+				column->appendString(str ? str : "");
+			}
+			return *this;
+		}
+
+		// empty column, the caller fills the values of all rows
+		Column *addColumn(const char *name, unsigned int column_hash, int type, int components)
+		{
+			if (column_index.contains(column_hash))
+			{
+				Log::error("SnapshotWriter::Section::addColumn(): column \"%s\" is already added or its name hash collides\n", name);
+				return nullptr;
+			}
+			Column *column = new Column();
+			column->hash = column_hash;
+			column->type = type;
+			column->components = components;
+			column_index.append(column_hash) = columns.size();
+			columns.append(column);
+			return column;
+		}
+
+	private:
+		friend class SnapshotWriter;
+
+		static UNIGINE_INLINE const char *get_string(const char *str) { return str; }
+		static UNIGINE_INLINE const char *get_string(const String &str) { return str.get(); }
+
+		// resize() allocates the exact size, appends need the capacity to grow geometrically
+		static void grow(Vector<unsigned char> &data, size_t size)
+		{
+			data.reserve(size);
+			data.resize(size);
+		}
+
+		void encode(Vector<unsigned char> &data) const
+		{
+			data.clear();
+			grow(data, 4);
+			Snapshot::setU32(data.get(), (unsigned int)columns.size());
+			for (int i = 0; i < columns.size(); i++)
+			{
+				const Column &column = *columns[i];
+				size_t begin = data.size();
+				grow(data, begin + Snapshot::COLUMN_HEADER_SIZE);
+				switch (column.type)
+				{
+					case Snapshot::TYPE_INT: encode_ints(data, column); break;
+					case Snapshot::TYPE_FLOAT: encode_floats(data, column, column.floats); break;
+					case Snapshot::TYPE_DOUBLE: encode_floats(data, column, column.doubles); break;
+					default: encode_strings(data, column); break;
+				}
+				unsigned char *d = data.get() + begin;
+				Snapshot::setU32(d, column.hash);
+				d[4] = (unsigned char)column.type;
+				d[6] = (unsigned char)column.components;
+				d[7] = (unsigned char)column.flags;
+				Snapshot::setU32(d + 8, (unsigned int)(data.size() - begin - Snapshot::COLUMN_HEADER_SIZE));
+			}
+		}
+
+		// ints, the smallest of the raw values, the varints and the deltas,
+		// planes are delta encoded separately
+		void encode_ints(Vector<unsigned char> &data, const Column &column) const
+		{
+			const Vector<long long> &values = column.ints;
+			size_t num = values.size();
+			bool fits = true;
+			size_t varint_size = 0;
+			size_t delta_size = 0;
+			for (size_t c = 0; c < size_t(column.components); c++)
+			{
+				const long long *s = values.get() + c * rows;
+				long long prev = 0;
+				for (int i = 0; i < rows; i++)
+				{
+					fits &= s[i] >= INT_MIN && s[i] <= INT_MAX;
+					varint_size += Snapshot::getVarintSize(Snapshot::zigzag(s[i]));
+					delta_size += Snapshot::getVarintSize(Snapshot::zigzag(Snapshot::subtract(s[i], prev)));
+					prev = s[i];
+				}
+			}
+
+			int encoding = delta_size < varint_size ? Snapshot::ENCODING_DELTA : Snapshot::ENCODING_VARINT;
+			size_t size = encoding == Snapshot::ENCODING_DELTA ? delta_size : varint_size;
+			if (fits && num * 4 <= size)
+			{
+				encoding = Snapshot::ENCODING_RAW;
+				size = num * 4;
+			}
+
+			size_t begin = data.size();
+			data[begin - Snapshot::COLUMN_HEADER_SIZE + 5] = (unsigned char)encoding;
+			grow(data, begin + size);
+			unsigned char *d = data.get() + begin;
+			if (encoding == Snapshot::ENCODING_RAW)
+			{
+				for (size_t i = 0; i < num; i++, d += 4)
+					Snapshot::setU32(d, (unsigned int)values[i]);
+			} else
+			{
+				for (size_t c = 0; c < size_t(column.components); c++)
+				{
+					const long long *s = values.get() + c * rows;
+					long long prev = 0;
+					for (int i = 0; i < rows; i++)
+					{
+						d = Snapshot::putVarint(d, Snapshot::zigzag(encoding == Snapshot::ENCODING_DELTA ? Snapshot::subtract(s[i], prev) : s[i]));
+						prev = s[i];
+					}
+				}
+			}
+		}
+
+		// floats, byte planes in compressed sections
+		template <class Type>
+		void encode_floats(Vector<unsigned char> &data, const Column &column, const Vector<Type> &values) const
+		{
+			const int encoding = codec != Snapshot::CODEC_NONE ? Snapshot::ENCODING_SHUFFLE : Snapshot::ENCODING_RAW;
+
+			size_t num = values.size();
+			size_t begin = data.size();
+			data[begin - Snapshot::COLUMN_HEADER_SIZE + 5] = (unsigned char)encoding;
+			grow(data, begin + num * sizeof(Type));
+			unsigned char *d = data.get() + begin;
+			const bool lsb = StreamBuffer::getHostOrder() == STREAM_LSB;
+			if (encoding == Snapshot::ENCODING_RAW)
+			{
+				if (lsb)
+					memcpy(d, values.get(), num * sizeof(Type));
+				else
+					StreamBuffer::swapBytes(d, values.get(), num, sizeof(Type));
+			} else
+			{
+				// plane b holds the byte b of all values
+				const unsigned char *src = reinterpret_cast<const unsigned char *>(values.get());
+				for (size_t b = 0; b < sizeof(Type); b++)
+				{
+					const unsigned char *s = src + (lsb ? b : sizeof(Type) - 1 - b);
+					unsigned char *plane = d + b * num;
+					for (size_t i = 0; i < num; i++)
+						plane[i] = s[i * sizeof(Type)];
+				}
+			}
+			UNIGINE_UNUSED(column);
+		}
+
+		// strings, varint lengths and the characters
+		void encode_strings(Vector<unsigned char> &data, const Column &column) const
+		{
+			data[data.size() - Snapshot::COLUMN_HEADER_SIZE + 5] = (unsigned char)Snapshot::ENCODING_RAW;
+			for (int i = 0; i < rows; i++)
+			{
+				const char *str = column.getString(i);
+				size_t length = strlen(str);
+				size_t offset = data.size();
+				grow(data, offset + 10 + length);
+				unsigned char *d = Snapshot::putVarint(data.get() + offset, length);
+				memcpy(d, str, length);
+				data.resize(size_t(d - data.get()) + length);
+			}
+		}
+
+		String name;
+		unsigned int hash{0};
+		int rows{0};
+		int codec{Snapshot::CODEC_NONE};
+		Vector<Column *> columns;
+		HashMap<unsigned int, int> column_index;
+	};
+
+	SnapshotWriter(unsigned int schema_version = 0)
+		: schema_version(schema_version)
+	{}
+	~SnapshotWriter() { clear(); }
+
+	SnapshotWriter(const SnapshotWriter &) = delete;
+	SnapshotWriter &operator=(const SnapshotWriter &) = delete;
+
+	UNIGINE_INLINE unsigned int getSchemaVersion() const { return schema_version; }
+	UNIGINE_INLINE void setSchemaVersion(unsigned int version) { schema_version = version; }
+
+	void clear()
+	{
+		for (int i = 0; i < sections.size(); i++)
+			delete sections[i];
+		sections.clear();
+		section_index.clear();
+	}
+
+	// the reference is valid until clear()
+	Section &addSection(const char *name, int rows, Snapshot::CODEC codec = Snapshot::CODEC_LZ4)
+	{
+		return add_section(name, Snapshot::getNameHash(name), rows, codec);
+	}
+	// section known by the hash of the name only, for rebuilt snapshots
+	Section &addSection(unsigned int hash, int rows, Snapshot::CODEC codec = Snapshot::CODEC_LZ4)
+	{
+		return add_section("", hash, rows, codec);
+	}
+
+	UNIGINE_INLINE int getNumSections() const { return sections.size(); }
+	UNIGINE_INLINE Section &getSection(int num) const { return *sections[num]; }
+	UNIGINE_INLINE int findSection(unsigned int hash) const { return section_index.value(hash, -1); }
+
+	// sections are encoded on PoolCPUShaders threads when parallel is set
+	bool save(const StreamPtr &stream, bool parallel = true) const
+	{
+		if (!stream || !stream->isOpened())
+		{
+			Log::error("SnapshotWriter::save(): stream is not opened\n");
+			return false;
+		}
+
+		struct Packed
+		{
+			Vector<unsigned char> data;
+			size_t raw_size;
+			int codec;
+			unsigned int crc;
+		};
+		Vector<Packed> packed;
+		packed.resize(sections.size());
+		auto pack = [&](int i)
+		{
+			const Section *section = sections[i];
+			Packed &p = packed[i];
+			Vector<unsigned char> raw;
+			section->encode(raw);
+
+			p.codec = Snapshot::CODEC_NONE;
+			p.raw_size = raw.size();
+			if (section->codec != Snapshot::CODEC_NONE)
+			{
+				size_t size = section->codec == Snapshot::CODEC_ZLIB ? Compress::zlibSize(p.raw_size) : Compress::lz4Size(p.raw_size);
+				p.data.resize(size);
+				bool ret = section->codec == Snapshot::CODEC_ZLIB
+					? Compress::zlibCompress(p.data.get(), size, raw.get(), p.raw_size, false)
+					: Compress::lz4Compress(p.data.get(), size, raw.get(), p.raw_size, false);
+				// kept only when it pays off
+				if (ret && size < p.raw_size)
+				{
+					p.data.resize(size);
+					p.codec = section->codec;
+				}
+			}
+			if (p.codec == Snapshot::CODEC_NONE)
+				p.data = std::move(raw);
+			p.crc = CRC32C::hash(p.data.get(), p.data.size());
+		};
+		if (parallel)
+			ChecksumEngine::parallelFor(sections.size(), pack);
+		else
+		{
+			for (int i = 0; i < sections.size(); i++)
+				pack(i);
+		}
+
+		Vector<unsigned char> header;
+		header.resize(Snapshot::HEADER_SIZE + size_t(sections.size()) * Snapshot::TABLE_ENTRY_SIZE);
+		unsigned char *d = header.get();
+		unsigned long long offset = 0;
+		for (int i = 0; i < sections.size(); i++)
+		{
+			unsigned char *entry = d + Snapshot::HEADER_SIZE + i * Snapshot::TABLE_ENTRY_SIZE;
+			Snapshot::setU32(entry, sections[i]->hash);
+			Snapshot::setU32(entry + 4, (unsigned int)sections[i]->rows);
+			Snapshot::setU32(entry + 8, (unsigned int)packed[i].codec);
+			Snapshot::setU32(entry + 12, (unsigned int)packed[i].data.size());
+			Snapshot::setU32(entry + 16, (unsigned int)packed[i].raw_size);
+			Snapshot::setU32(entry + 20, packed[i].crc);
+			Snapshot::setU64(entry + 24, offset);
+			offset += packed[i].data.size();
+		}
+		memcpy(d, "USNP", 4);
+		d[4] = (unsigned char)Snapshot::VERSION;
+		d[5] = d[6] = d[7] = 0;
+		Snapshot::setU32(d + 8, schema_version);
+		Snapshot::setU32(d + 12, (unsigned int)sections.size());
+		Snapshot::setU64(d + 16, offset);
+
+		bool ret = stream->write(header.get(), header.size()) == size_t(header.size());
+		for (int i = 0; ret && i < packed.size(); i++)
+			ret = stream->write(packed[i].data.get(), packed[i].data.size()) == size_t(packed[i].data.size());
+		if (!ret)
+			Log::error("SnapshotWriter::save(): can't write snapshot\n");
+		return ret;
+	}
+
+private:
+	Section &add_section(const char *name, unsigned int hash, int rows, Snapshot::CODEC codec)
+	{
+		Section *section = new Section();
+		section->name = name;
+		section->hash = hash;
+		section->rows = rows < 0 ? 0 : rows;
+		section->codec = codec;
+		int index = findSection(hash);
+		if (index != -1)
+			Log::error("SnapshotWriter::addSection(): section \"%s\" has the same hash as \"%s\" section\n", name, sections[index]->name.get());
+		else
+			section_index.append(hash) = sections.size();
+		sections.append(section);
+		return *section;
+	}
+
+	unsigned int schema_version{0};
+	Vector<Section *> sections;
+	HashMap<unsigned int, int> section_index;
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// Snapshot reader.
+///
+/// load() reads the snapshot into memory, sections are checked and
+/// decompressed on the first findSection() call. Columns are converted
+/// between int and long long and between float and double, other type
+/// mismatches are reported and the column is skipped.
+//////////////////////////////////////////////////////////////////////////
+
+class SnapshotReader
+{
+public:
+	class Section
+	{
+	public:
+		UNIGINE_INLINE unsigned int getHash() const { return hash; }
+		UNIGINE_INLINE int getNumRows() const { return rows; }
+		UNIGINE_INLINE int getNumColumns() const { return columns.size(); }
+		UNIGINE_INLINE bool hasColumn(const char *name) const { return find_column(name) != -1; }
+		UNIGINE_INLINE bool hasKeyColumn() const { return key_column != -1; }
+
+		// decodes all columns into a section with the same number of rows
+		bool copyTo(SnapshotWriter::Section &section)
+		{
+			for (int i = 0; i < columns.size(); i++)
+			{
+				const Column &column = columns[i];
+				SnapshotWriter::Column *dest = section.addColumn("", column.hash, column.type, column.components);
+				if (!dest)
+					return false;
+				dest->flags = column.flags;
+				bool ret = false;
+				switch (column.type)
+				{
+					case Snapshot::TYPE_INT: ret = decode(column, dest->ints); break;
+					case Snapshot::TYPE_FLOAT: ret = decode(column, dest->floats); break;
+					case Snapshot::TYPE_DOUBLE: ret = decode(column, dest->doubles); break;
+					default:
+						ret = decode_strings(column, [&](int, const char *str, size_t length)
+						{
+							dest->offsets.append(dest->chars.size());
+							dest->chars.append(str, length);
+							dest->chars.append('\0');
+						});
+						break;
+				}
+				if (!ret)
+				{
+					Log::error("SnapshotReader::Section::copyTo(): column is corrupted\n");
+					return false;
+				}
+			}
+			return true;
+		}
+
+		// calls func(row, value) for all rows, returns false if there is no such column
+		template <class Type, class Func>
+		bool read(const char *name, const Func &func)
+		{
+			using Traits = Snapshot::Traits<Type>;
+			using Value = typename Traits::Value;
+
+			int index = find_column(name);
+			if (index == -1)
+				return false;
+			const Column &column = columns[index];
+			if (column.components != Traits::COMPONENTS || !is_compatible(column.type, Traits::TYPE))
+			{
+				Log::error("SnapshotReader::Section::read(): column \"%s\" has a different type\n", name);
+				return false;
+			}
+
+			Vector<Value> &values = get_buffer(static_cast<Value *>(nullptr));
+			if (!decode(column, values))
+			{
+				Log::error("SnapshotReader::Section::read(): column \"%s\" is corrupted\n", name);
+				return false;
+			}
+			for (int i = 0; i < rows; i++)
+				func(i, Traits::make(values.get() + i, rows));
+			return true;
+		}
+
+		// calls func(row, const char *) for all rows
+		template <class Func>
+		bool readString(const char *name, const Func &func)
+		{
+			int index = find_column(name);
+			if (index == -1)
+				return false;
+			const Column &column = columns[index];
+			if (column.type != Snapshot::TYPE_STRING)
+			{
+				Log::error("SnapshotReader::Section::readString(): column \"%s\" has a different type\n", name);
+				return false;
+			}
+
+			String str;
+			bool ret = decode_strings(column, [&](int i, const char *s, size_t length)
+			{
+				str.copy(s, int(length));
+				func(i, str.get());
+			});
+			if (!ret)
+				Log::error("SnapshotReader::Section::readString(): column \"%s\" is corrupted\n", name);
+			return ret;
+		}
+
+	private:
+		friend class SnapshotReader;
+
+		struct Column
+		{
+			unsigned int hash;
+			int type;
+			int encoding;
+			int components;
+			int flags;
+			const unsigned char *data;
+			size_t size;
+		};
+
+		int find_column(const char *name) const { return column_index.value(Snapshot::getNameHash(name), -1); }
+
+		static bool is_compatible(int stored, int requested)
+		{
+			if (stored == requested)
+				return true;
+			return (stored == Snapshot::TYPE_FLOAT || stored == Snapshot::TYPE_DOUBLE) &&
+				(requested == Snapshot::TYPE_FLOAT || requested == Snapshot::TYPE_DOUBLE);
+		}
+
+		Vector<long long> &get_buffer(long long *) { return int_values; }
+		Vector<float> &get_buffer(float *) { return float_values; }
+		Vector<double> &get_buffer(double *) { return double_values; }
+
+		bool parse()
+		{
+			const unsigned char *s = data;
+			const unsigned char *end = data + size;
+			if (size < 4)
+				return false;
+			unsigned int num = Snapshot::getU32(s);
+			s += 4;
+			columns.clear();
+			column_index.clear();
+			key_column = -1;
+			for (unsigned int i = 0; i < num; i++)
+			{
+				if (size_t(end - s) < Snapshot::COLUMN_HEADER_SIZE)
+					return false;
+				Column column;
+				column.hash = Snapshot::getU32(s);
+				column.type = s[4];
+				column.encoding = s[5];
+				column.components = s[6];
+				column.flags = s[7];
+				column.size = Snapshot::getU32(s + 8);
+				column.data = s + Snapshot::COLUMN_HEADER_SIZE;
+				if (column.size > size_t(end - column.data) || column.type >= Snapshot::NUM_TYPES || column.encoding >= Snapshot::NUM_ENCODINGS)
+					return false;
+				s = column.data + column.size;
+				if ((column.flags & Snapshot::FLAG_KEY) && key_column == -1 && column.type == Snapshot::TYPE_INT && column.components == 1)
+					key_column = columns.size();
+				column_index.append(column.hash) = columns.size();
+				columns.append(column);
+			}
+			return true;
+		}
+
+		template <class Func>
+		bool decode_strings(const Column &column, const Func &func) const
+		{
+			const unsigned char *s = column.data;
+			const unsigned char *end = column.data + column.size;
+			for (int i = 0; i < rows; i++)
+			{
+				unsigned long long length = 0;
+				s = Snapshot::getVarint(s, end, length);
+				if (!s || length > (unsigned long long)(end - s))
+					return false;
+				func(i, reinterpret_cast<const char *>(s), size_t(length));
+				s += length;
+			}
+			return true;
+		}
+
+		bool decode(const Column &column, Vector<long long> &values)
+		{
+			size_t num = size_t(rows) * column.components;
+			values.resize(num);
+			const unsigned char *s = column.data;
+			const unsigned char *end = column.data + column.size;
+			if (column.encoding == Snapshot::ENCODING_RAW)
+			{
+				if (column.size != num * 4)
+					return false;
+				for (size_t i = 0; i < num; i++, s += 4)
+					values[i] = (int)Snapshot::getU32(s);
+				return true;
+			}
+			if (column.encoding != Snapshot::ENCODING_VARINT && column.encoding != Snapshot::ENCODING_DELTA)
+				return false;
+			for (int c = 0; c < column.components; c++)
+			{
+				long long *d = values.get() + size_t(c) * rows;
+				long long prev = 0;
+				for (int i = 0; i < rows; i++)
+				{
+					unsigned long long v = 0;
+					s = Snapshot::getVarint(s, end, v);
+					if (!s)
+						return false;
+					d[i] = Snapshot::unzigzag(v);
+					if (column.encoding == Snapshot::ENCODING_DELTA)
+						d[i] = Snapshot::add(d[i], prev);
+					prev = d[i];
+				}
+			}
+			return true;
+		}
+
+		template <class Type>
+		bool decode(const Column &column, Vector<Type> &values)
+		{
+			size_t num = size_t(rows) * column.components;
+			values.resize(num);
+			if (column.type == Snapshot::TYPE_FLOAT)
+				return decode_planes(column, values.get(), float_values, num);
+			return decode_planes(column, values.get(), double_values, num);
+		}
+
+		// values of the stored type are decoded in place, others through the buffer
+		template <class Type, class Stored>
+		static bool decode_planes(const Column &column, Type *values, Vector<Stored> &buffer, size_t num)
+		{
+			if (column.size != num * sizeof(Stored))
+				return false;
+			if (column.encoding != Snapshot::ENCODING_RAW && column.encoding != Snapshot::ENCODING_SHUFFLE)
+				return false;
+
+			Stored *d = reinterpret_cast<Stored *>(values);
+			if (!std::is_same<Type, Stored>::value)
+			{
+				buffer.resize(num);
+				d = buffer.get();
+			}
+
+			const bool lsb = StreamBuffer::getHostOrder() == STREAM_LSB;
+			if (column.encoding == Snapshot::ENCODING_RAW)
+			{
+				if (lsb)
+					memcpy(d, column.data, num * sizeof(Stored));
+				else
+					StreamBuffer::swapBytes(d, column.data, num, sizeof(Stored));
+			} else
+			{
+				unsigned char *dest = reinterpret_cast<unsigned char *>(d);
+				for (size_t b = 0; b < sizeof(Stored); b++)
+				{
+					unsigned char *s = dest + (lsb ? b : sizeof(Stored) - 1 - b);
+					const unsigned char *plane = column.data + b * num;
+					for (size_t i = 0; i < num; i++)
+						s[i * sizeof(Stored)] = plane[i];
+				}
+			}
+
+			if (!std::is_same<Type, Stored>::value)
+			{
+				for (size_t i = 0; i < num; i++)
+					values[i] = (Type)d[i];
+			}
+			return true;
+		}
+
+		unsigned int hash{0};
+		int rows{0};
+		int codec{Snapshot::CODEC_NONE};
+		size_t packed_size{0};
+		size_t raw_size{0};
+		unsigned int crc{0};
+		unsigned long long offset{0};
+
+		// -1 broken, 0 not decoded, 1 decoded
+		int state{0};
+		const unsigned char *data{nullptr};
+		size_t size{0};
+		Vector<unsigned char> unpacked;
+
+		Vector<Column> columns;
+		HashMap<unsigned int, int> column_index;
+		int key_column{-1};
+
+		// decode buffers reused by the columns
+		Vector<long long> int_values;
+		Vector<float> float_values;
+		Vector<double> double_values;
+	};
+
+	SnapshotReader() = default;
+	SnapshotReader(const SnapshotReader &) = delete;
+	SnapshotReader &operator=(const SnapshotReader &) = delete;
+
+	void clear()
+	{
+		schema_version = 0;
+		sections.clear();
+		section_index.clear();
+		data.clear();
+	}
+
+	bool load(const StreamPtr &stream)
+	{
+		clear();
+		if (!stream || !stream->isOpened())
+		{
+			Log::error("SnapshotReader::load(): stream is not opened\n");
+			return false;
+		}
+
+		unsigned char header[Snapshot::HEADER_SIZE];
+		if (stream->read(header, Snapshot::HEADER_SIZE) != Snapshot::HEADER_SIZE || memcmp(header, "USNP", 4) != 0)
+		{
+			Log::error("SnapshotReader::load(): bad snapshot header\n");
+			return false;
+		}
+		if (header[4] > Snapshot::VERSION)
+		{
+			Log::error("SnapshotReader::load(): unknown snapshot version %d\n", header[4]);
+			return false;
+		}
+		schema_version = Snapshot::getU32(header + 8);
+		unsigned int num = Snapshot::getU32(header + 12);
+		unsigned long long data_size = Snapshot::getU64(header + 16);
+
+		// the sizes are checked before the allocation, a corrupted header must not exhaust the memory
+		unsigned long long size = (unsigned long long)num * Snapshot::TABLE_ENTRY_SIZE + data_size;
+		if (data_size > Snapshot::MAX_SIZE || size > Snapshot::MAX_SIZE || size > get_remaining_size(stream))
+		{
+			Log::error("SnapshotReader::load(): snapshot is truncated\n");
+			return false;
+		}
+
+		Vector<unsigned char> table;
+		table.resize(size_t(num) * Snapshot::TABLE_ENTRY_SIZE);
+		data.resize(size_t(data_size));
+		if (stream->read(table.get(), table.size()) != size_t(table.size()) || stream->read(data.get(), data.size()) != size_t(data.size()))
+		{
+			Log::error("SnapshotReader::load(): snapshot is truncated\n");
+			clear();
+			return false;
+		}
+
+		sections.resize(num);
+		for (unsigned int i = 0; i < num; i++)
+		{
+			const unsigned char *entry = table.get() + size_t(i) * Snapshot::TABLE_ENTRY_SIZE;
+			Section &section = sections[i];
+			section.hash = Snapshot::getU32(entry);
+			section.rows = int(Snapshot::getU32(entry + 4));
+			section.codec = int(Snapshot::getU32(entry + 8));
+			section.packed_size = Snapshot::getU32(entry + 12);
+			section.raw_size = Snapshot::getU32(entry + 16);
+			section.crc = Snapshot::getU32(entry + 20);
+			section.offset = Snapshot::getU64(entry + 24);
+			if (section.offset > data_size || section.packed_size > data_size - section.offset || section.rows < 0 ||
+				section.raw_size > Snapshot::MAX_SIZE)
+			{
+				Log::error("SnapshotReader::load(): section table is corrupted\n");
+				clear();
+				return false;
+			}
+			section_index.append(section.hash) = int(i);
+		}
+		return true;
+	}
+
+	UNIGINE_INLINE unsigned int getSchemaVersion() const { return schema_version; }
+	UNIGINE_INLINE int getNumSections() const { return sections.size(); }
+	UNIGINE_INLINE bool hasSection(const char *name) const { return section_index.contains(Snapshot::getNameHash(name)); }
+
+	// nullptr if there is no such section or it is corrupted, valid until clear()
+	Section *findSection(const char *name) { return get_section(section_index.value(Snapshot::getNameHash(name), -1)); }
+	Section *findSection(unsigned int hash) { return get_section(section_index.value(hash, -1)); }
+	Section *getSection(int num) { return get_section(num); }
+
+private:
+	// bytes left in File and Blob streams, other streams can't tell
+	static unsigned long long get_remaining_size(const StreamPtr &stream)
+	{
+		Stream *s = stream.get();
+		if (File::convertible(s))
+		{
+			FilePtr file = static_ptr_cast<File>(stream);
+			return file->getSize() - file->tell();
+		}
+		if (Blob::convertible(s))
+		{
+			BlobPtr blob = static_ptr_cast<Blob>(stream);
+			return blob->getSize() - blob->tell();
+		}
+		return ~0ULL;
+	}
+
+	Section *get_section(int index)
+	{
+		if (index < 0 || index >= sections.size())
+			return nullptr;
+		Section &section = sections[index];
+		if (section.state == 0)
+		{
+			section.state = unpack(section) && section.parse() ? 1 : -1;
+			if (section.state == -1)
+				Log::error("SnapshotReader::findSection(): section %08x is corrupted\n", section.hash);
+		}
+		return section.state == 1 ? &section : nullptr;
+	}
+
+	bool unpack(Section &section)
+	{
+		const unsigned char *packed = data.get() + section.offset;
+		if (CRC32C::hash(packed, section.packed_size) != section.crc)
+			return false;
+		if (section.codec == Snapshot::CODEC_NONE)
+		{
+			section.data = packed;
+			section.size = section.packed_size;
+			return section.raw_size == section.packed_size;
+		}
+		section.unpacked.resize(section.raw_size);
+		bool ret = false;
+		if (section.codec == Snapshot::CODEC_LZ4)
+			ret = Compress::lz4Decompress(section.unpacked.get(), section.raw_size, packed, section.packed_size);
+		else if (section.codec == Snapshot::CODEC_ZLIB)
+			ret = Compress::zlibDecompress(section.unpacked.get(), section.raw_size, packed, section.packed_size);
+		section.data = section.unpacked.get();
+		section.size = section.raw_size;
+		return ret;
+	}
+
+	unsigned int schema_version{0};
+	Vector<Section> sections;
+	HashMap<unsigned int, int> section_index;
+	Vector<unsigned char> data;
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// Component state in snapshots.
+///
+/// Each registered class is saved as a section named by its property: the
+/// row key made of the node ID and the index among the node's components
+/// of the class, both also as columns, the world transform of the node and
+/// a column per component variable. Restore matches the rows to the live
+/// components by node ID and index, rows of removed nodes are skipped and
+/// components created after the save keep their values. Struct and array
+/// variables are not saved. The class must keep a ComponentStorage (see
+/// UnigineComponentStorage.h).
+//////////////////////////////////////////////////////////////////////////
+
+class SnapshotComponents
+{
+public:
+	template <class C>
+	static void add(Snapshot::CODEC codec = Snapshot::CODEC_LZ4)
+	{
+		Vector<Entry> &entries = get_entries();
+		for (int i = 0; i < entries.size(); i++)
+		{
+			if (entries[i].save == &save_class<C>)
+				return;
+		}
+		Entry &entry = entries.append();
+		entry.save = &save_class<C>;
+		entry.restore = &restore_class<C>;
+		entry.codec = codec;
+	}
+
+	template <class C>
+	static void remove()
+	{
+		Vector<Entry> &entries = get_entries();
+		for (int i = 0; i < entries.size(); i++)
+		{
+			if (entries[i].save == &save_class<C>)
+			{
+				entries.remove(i);
+				return;
+			}
+		}
+	}
+
+	static void clear() { get_entries().clear(); }
+
+	// the registered classes into the writer or into a new snapshot
+	static void save(SnapshotWriter &writer)
+	{
+		const Vector<Entry> &entries = get_entries();
+		for (int i = 0; i < entries.size(); i++)
+			entries[i].save(writer, entries[i].codec);
+	}
+	static bool save(const StreamPtr &stream, unsigned int schema_version = 0)
+	{
+		SnapshotWriter writer(schema_version);
+		save(writer);
+		return writer.save(stream);
+	}
+
+	// the registered classes from the reader or from the stream
+	static void restore(SnapshotReader &reader)
+	{
+		const Vector<Entry> &entries = get_entries();
+		for (int i = 0; i < entries.size(); i++)
+			entries[i].restore(reader);
+	}
+	static bool restore(const StreamPtr &stream)
+	{
+		SnapshotReader reader;
+		if (!reader.load(stream))
+			return false;
+		restore(reader);
+		return true;
+	}
+
+	template <class C>
+	static void save_class(SnapshotWriter &writer, int codec)
+	{
+		const ComponentStorage<C> &storage = ComponentStorage<C>::get();
+		SnapshotWriter::Section &section = writer.addSection(C::getPropertyName(), storage.size(), Snapshot::CODEC(codec));
+		// a node may hold several components of the class, the row key must be unique for SnapshotDelta
+		section.addKey("__node_key", [&](int i) { return (long long)((unsigned long long)(unsigned int)storage.getNodeID(i) << 32 | (unsigned int)storage.getNodeIndex(i)); });
+		section.add("__node_id", [&](int i) { return storage.getNodeID(i); });
+		section.add("__node_index", [&](int i) { return storage.getNodeIndex(i); });
+		section.add("__transform", [&](int i) { return storage.getComponent(i)->getNode()->getWorldTransform(); });
+		if (storage.size() == 0)
+			return;
+
+		const Vector<ComponentVariable *> &variables = storage.getComponent(0)->variables;
+		for (int j = 0; j < variables.size(); j++)
+		{
+			const char *name = variables[j]->getName();
+			auto variable = [&](int i) { return storage.getComponent(i)->variables[j]; };
+			switch (variables[j]->getType())
+			{
+				case Property::PARAMETER_INT: section.add(name, [&](int i) { return static_cast<ComponentVariableInt *>(variable(i))->get(); }); break;
+				case Property::PARAMETER_TOGGLE: section.add(name, [&](int i) { return static_cast<ComponentVariableToggle *>(variable(i))->get(); }); break;
+				case Property::PARAMETER_SWITCH: section.add(name, [&](int i) { return static_cast<ComponentVariableSwitch *>(variable(i))->get(); }); break;
+				case Property::PARAMETER_MASK: section.add(name, [&](int i) { return static_cast<ComponentVariableMask *>(variable(i))->get(); }); break;
+				case Property::PARAMETER_FLOAT: section.add(name, [&](int i) { return static_cast<ComponentVariableFloat *>(variable(i))->get(); }); break;
+				case Property::PARAMETER_DOUBLE: section.add(name, [&](int i) { return static_cast<ComponentVariableDouble *>(variable(i))->get(); }); break;
+				case Property::PARAMETER_VEC2: section.add(name, [&](int i) { return static_cast<ComponentVariableVec2 *>(variable(i))->get(); }); break;
+				case Property::PARAMETER_VEC3: section.add(name, [&](int i) { return static_cast<ComponentVariableVec3 *>(variable(i))->get(); }); break;
+				case Property::PARAMETER_VEC4: section.add(name, [&](int i) { return static_cast<ComponentVariableVec4 *>(variable(i))->get(); }); break;
+				case Property::PARAMETER_DVEC2: section.add(name, [&](int i) { return static_cast<ComponentVariableDVec2 *>(variable(i))->get(); }); break;
+				case Property::PARAMETER_DVEC3: section.add(name, [&](int i) { return static_cast<ComponentVariableDVec3 *>(variable(i))->get(); }); break;
+				case Property::PARAMETER_DVEC4: section.add(name, [&](int i) { return static_cast<ComponentVariableDVec4 *>(variable(i))->get(); }); break;
+				case Property::PARAMETER_IVEC2: section.add(name, [&](int i) { return static_cast<ComponentVariableIVec2 *>(variable(i))->get(); }); break;
+				case Property::PARAMETER_IVEC3: section.add(name, [&](int i) { return static_cast<ComponentVariableIVec3 *>(variable(i))->get(); }); break;
+				case Property::PARAMETER_IVEC4: section.add(name, [&](int i) { return static_cast<ComponentVariableIVec4 *>(variable(i))->get(); }); break;
+				case Property::PARAMETER_COLOR: section.add(name, [&](int i) { return static_cast<ComponentVariableColor *>(variable(i))->get(); }); break;
+				case Property::PARAMETER_NODE: section.add(name, [&](int i) { return int(*static_cast<ComponentVariableNode *>(variable(i))); }); break;
+				case Property::PARAMETER_STRING: section.addString(name, [&](int i) { return static_cast<ComponentVariableString *>(variable(i))->get(); }); break;
+				case Property::PARAMETER_FILE: section.addString(name, [&](int i) { return static_cast<ComponentVariableFile *>(variable(i))->getRaw(); }); break;
+				// assets by GUID
+				case Property::PARAMETER_PROPERTY:
+				case Property::PARAMETER_MATERIAL: section.addString(name, [&](int i) { return variable(i)->getValueAsString(); }); break;
+				default: break;
+			}
+		}
+	}
+
+	template <class C>
+	static bool restore_class(SnapshotReader &reader)
+	{
+		SnapshotReader::Section *section = reader.findSection(C::getPropertyName());
+		if (!section)
+			return false;
+
+		const ComponentStorage<C> &storage = ComponentStorage<C>::get();
+		// snapshots without __node_index restore the first component of each node
+		Vector<int> node_ids;
+		Vector<int> node_indices;
+		node_ids.resize(section->getNumRows());
+		node_indices.resize(0, section->getNumRows());
+		if (!section->read<int>("__node_id", [&](int i, int id) { node_ids[i] = id; }))
+			return false;
+		section->read<int>("__node_index", [&](int i, int index) { node_indices[i] = index; });
+
+		// a node with several components of the class gets them back in creation order
+		Vector<C *> components;
+		components.resize(section->getNumRows());
+		C *first = nullptr;
+		for (int i = 0; i < components.size(); i++)
+		{
+			components[i] = storage.getNth(node_ids[i], node_indices[i]);
+			first = first ? first : components[i];
+		}
+		if (!first)
+			return true;
+		section->read<Math::Mat4>("__transform", [&](int i, const Math::Mat4 &transform)
+		{
+			if (components[i])
+				components[i]->getNode()->setWorldTransform(transform);
+		});
+
+		const Vector<ComponentVariable *> &variables = first->variables;
+		for (int j = 0; j < variables.size(); j++)
+		{
+			const char *name = variables[j]->getName();
+			auto variable = [&](int i) { return components[i] ? components[i]->variables[j] : nullptr; };
+			switch (variables[j]->getType())
+			{
+				case Property::PARAMETER_INT: restore_variable<ComponentVariableInt, int>(section, name, variable); break;
+				case Property::PARAMETER_TOGGLE: restore_variable<ComponentVariableToggle, int>(section, name, variable); break;
+				case Property::PARAMETER_SWITCH: restore_variable<ComponentVariableSwitch, int>(section, name, variable); break;
+				case Property::PARAMETER_MASK: restore_variable<ComponentVariableMask, int>(section, name, variable); break;
+				case Property::PARAMETER_FLOAT: restore_variable<ComponentVariableFloat, float>(section, name, variable); break;
+				case Property::PARAMETER_DOUBLE: restore_variable<ComponentVariableDouble, double>(section, name, variable); break;
+				case Property::PARAMETER_VEC2: restore_variable<ComponentVariableVec2, Math::vec2>(section, name, variable); break;
+				case Property::PARAMETER_VEC3: restore_variable<ComponentVariableVec3, Math::vec3>(section, name, variable); break;
+				case Property::PARAMETER_VEC4: restore_variable<ComponentVariableVec4, Math::vec4>(section, name, variable); break;
+				case Property::PARAMETER_DVEC2: restore_variable<ComponentVariableDVec2, Math::dvec2>(section, name, variable); break;
+				case Property::PARAMETER_DVEC3: restore_variable<ComponentVariableDVec3, Math::dvec3>(section, name, variable); break;
+				case Property::PARAMETER_DVEC4: restore_variable<ComponentVariableDVec4, Math::dvec4>(section, name, variable); break;
+				case Property::PARAMETER_IVEC2: restore_variable<ComponentVariableIVec2, Math::ivec2>(section, name, variable); break;
+				case Property::PARAMETER_IVEC3: restore_variable<ComponentVariableIVec3, Math::ivec3>(section, name, variable); break;
+				case Property::PARAMETER_IVEC4: restore_variable<ComponentVariableIVec4, Math::ivec4>(section, name, variable); break;
+				case Property::PARAMETER_COLOR: restore_variable<ComponentVariableColor, Math::vec4>(section, name, variable); break;
+				case Property::PARAMETER_NODE: restore_variable<ComponentVariableNode, int>(section, name, variable); break;
+				case Property::PARAMETER_STRING: restore_string<ComponentVariableString>(section, name, variable); break;
+				case Property::PARAMETER_FILE: restore_string<ComponentVariableFile>(section, name, variable); break;
+				case Property::PARAMETER_PROPERTY:
+					section->readString(name, [&](int i, const char *guid)
+					{
+						if (ComponentVariable *v = variable(i))
+							*static_cast<ComponentVariableProperty *>(v) = UGUID(guid);
+					});
+					break;
+				case Property::PARAMETER_MATERIAL:
+					section->readString(name, [&](int i, const char *guid)
+					{
+						if (ComponentVariable *v = variable(i))
+							*static_cast<ComponentVariableMaterial *>(v) = UGUID(guid);
+					});
+					break;
+				default: break;
+			}
+		}
+		return true;
+	}
+
+private:
+	struct Entry
+	{
+		void (*save)(SnapshotWriter &writer, int codec);
+		bool (*restore)(SnapshotReader &reader);
+		int codec;
+	};
+
+	static Vector<Entry> &get_entries()
+	{
+		static Vector<Entry> entries;
+		return entries;
+	}
+
+	template <class Variable, class Type, class Func>
+	static void restore_variable(SnapshotReader::Section *section, const char *name, const Func &variable)
+	{
+		section->read<Type>(name, [&](int i, const Type &value)
+		{
+			if (ComponentVariable *v = variable(i))
+				*static_cast<Variable *>(v) = value;
+		});
+	}
+
+	template <class Variable, class Func>
+	static void restore_string(SnapshotReader::Section *section, const char *name, const Func &variable)
+	{
+		section->readString(name, [&](int i, const char *value)
+		{
+			if (ComponentVariable *v = variable(i))
+				*static_cast<Variable *>(v) = value;
+		});
+	}
+};
+
+inline void Snapshot::getBenchmarkReport(String &ret, int num_tanks)
+{
+	struct Tank
+	{
+		int id;
+		int team;
+		int ammo;
+		float health;
+		Math::mat4 transform;
+		Math::vec3 velocity;
+		Math::quat turret;
+		String name;
+	};
+	struct Projectile
+	{
+		int owner;
+		Math::dvec3 position;
+		Math::vec3 velocity;
+		float lifetime;
+	};
+
+	const int num_projectiles = num_tanks * 4;
+	Vector<Tank> tanks;
+	tanks.resize(num_tanks);
+	for (int i = 0; i < num_tanks; i++)
+	{
+		Tank &t = tanks[i];
+		t.id = 1000 + i * 3;
+		t.team = i % 4;
+		t.ammo = 40 - i % 40;
+		t.health = 100.0f - float(i % 100) * 0.5f;
+		t.transform = Math::mat4_identity;
+		t.transform.setColumn3(3, Math::vec3(float(i % 100) * 10.0f, float(i / 100) * 10.0f, 0.0f));
+		t.velocity = Math::vec3(float(i % 7), float(i % 5), 0.0f);
+		t.turret = Math::quat(0.0f, 0.0f, float(i % 360) / 360.0f, 1.0f);
+		t.name = String::format("tank_%d", i);
+	}
+	Vector<Projectile> projectiles;
+	projectiles.resize(num_projectiles);
+	for (int i = 0; i < num_projectiles; i++)
+	{
+		Projectile &p = projectiles[i];
+		p.owner = tanks[i / 4].id;
+		p.position = Math::dvec3(double(i) * 1.5, double(i % 13), 2.0);
+		p.velocity = Math::vec3(100.0f, float(i % 3), -1.0f);
+		p.lifetime = float(i % 50) * 0.1f;
+	}
+	Vector<Tank> restored_tanks;
+	Vector<Projectile> restored_projectiles;
+
+	auto save = [&](const StreamPtr &stream, CODEC codec)
+	{
+		SnapshotWriter writer(1);
+		SnapshotWriter::Section &t = writer.addSection("tanks", tanks.size(), codec);
+		t.add("id", [&](int i) { return tanks[i].id; });
+		t.add("team", [&](int i) { return tanks[i].team; });
+		t.add("ammo", [&](int i) { return tanks[i].ammo; });
+		t.add("health", [&](int i) { return tanks[i].health; });
+		t.add("transform", [&](int i) { return tanks[i].transform; });
+		t.add("velocity", [&](int i) { return tanks[i].velocity; });
+		t.add("turret", [&](int i) { return tanks[i].turret; });
+		t.addString("name", [&](int i) { return tanks[i].name.get(); });
+		SnapshotWriter::Section &p = writer.addSection("projectiles", projectiles.size(), codec);
+		p.add("owner", [&](int i) { return projectiles[i].owner; });
+		p.add("position", [&](int i) { return projectiles[i].position; });
+		p.add("velocity", [&](int i) { return projectiles[i].velocity; });
+		p.add("lifetime", [&](int i) { return projectiles[i].lifetime; });
+		writer.save(stream);
+	};
+	auto restore = [&](const StreamPtr &stream)
+	{
+		SnapshotReader reader;
+		if (!reader.load(stream))
+			return;
+		if (SnapshotReader::Section *t = reader.findSection("tanks"))
+		{
+			restored_tanks.resize(t->getNumRows());
+			t->read<int>("id", [&](int i, int v) { restored_tanks[i].id = v; });
+			t->read<int>("team", [&](int i, int v) { restored_tanks[i].team = v; });
+			t->read<int>("ammo", [&](int i, int v) { restored_tanks[i].ammo = v; });
+			t->read<float>("health", [&](int i, float v) { restored_tanks[i].health = v; });
+			t->read<Math::mat4>("transform", [&](int i, const Math::mat4 &v) { restored_tanks[i].transform = v; });
+			t->read<Math::vec3>("velocity", [&](int i, const Math::vec3 &v) { restored_tanks[i].velocity = v; });
+			t->read<Math::quat>("turret", [&](int i, const Math::quat &v) { restored_tanks[i].turret = v; });
+			t->readString("name", [&](int i, const char *v) { restored_tanks[i].name = v; });
+		}
+		if (SnapshotReader::Section *p = reader.findSection("projectiles"))
+		{
+			restored_projectiles.resize(p->getNumRows());
+			p->read<int>("owner", [&](int i, int v) { restored_projectiles[i].owner = v; });
+			p->read<Math::dvec3>("position", [&](int i, const Math::dvec3 &v) { restored_projectiles[i].position = v; });
+			p->read<Math::vec3>("velocity", [&](int i, const Math::vec3 &v) { restored_projectiles[i].velocity = v; });
+			p->read<float>("lifetime", [&](int i, float v) { restored_projectiles[i].lifetime = v; });
+		}
+	};
+	auto equal = [&]()
+	{
+		if (restored_tanks.size() != tanks.size() || restored_projectiles.size() != projectiles.size())
+			return false;
+		for (int i = 0; i < tanks.size(); i++)
+		{
+			const Tank &a = tanks[i];
+			const Tank &b = restored_tanks[i];
+			if (a.id != b.id || a.team != b.team || a.ammo != b.ammo || a.health != b.health || a.velocity != b.velocity ||
+				a.turret.x != b.turret.x || a.turret.w != b.turret.w || a.transform != b.transform || a.name != b.name)
+				return false;
+		}
+		for (int i = 0; i < projectiles.size(); i++)
+		{
+			const Projectile &a = projectiles[i];
+			const Projectile &b = restored_projectiles[i];
+			if (a.owner != b.owner || a.position != b.position || a.velocity != b.velocity || a.lifetime != b.lifetime)
+				return false;
+		}
+		return true;
+	};
+
+	using Clock = std::chrono::steady_clock;
+	auto milliseconds = [](Clock::time_point begin) { return std::chrono::duration<double, std::milli>(Clock::now() - begin).count(); };
+
+	auto run = [&](const char *name, CODEC codec)
+	{
+		double best_save = 1e30;
+		double best_restore = 1e30;
+		size_t size = 0;
+		BlobPtr blob = Blob::create();
+		for (int i = 0; i < 4; i++)
+		{
+			blob->seekSet(0);
+			Clock::time_point begin = Clock::now();
+			save(blob, codec);
+			double t = milliseconds(begin);
+			best_save = t < best_save ? t : best_save;
+			size = blob->tell();
+
+			restored_tanks.clear();
+			restored_projectiles.clear();
+			blob->seekSet(0);
+			begin = Clock::now();
+			restore(blob);
+			t = milliseconds(begin);
+			best_restore = t < best_restore ? t : best_restore;
+		}
+		Format::append(ret, "{:<12}{:10.2} ms {:10.2} ms {:12} bytes{}\n", name, best_save, best_restore, (unsigned long long)size, equal() ? "" : "  mismatch");
+	};
+
+	ret.clear();
+	Format::append(ret, "{} tanks, {} projectiles   save    restore\n", num_tanks, num_projectiles);
+	run("none", CODEC_NONE);
+	run("lz4", CODEC_LZ4);
+	run("zlib", CODEC_ZLIB);
+}
+
+} // namespace Unigine
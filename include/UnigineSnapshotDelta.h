@@ -0,0 +1,726 @@
+/* Copyright (C) 2005-2020, UNIGINE. All rights reserved.
+ *
+ * This file is a part of the UNIGINE 2 SDK.
+ *
+ * Your use and / or redistribution of this software in source and / or
+ * binary form, with or without modification, is subject to: (i) your
+ * ongoing acceptance of and compliance with the terms and conditions of
+ * the UNIGINE License Agreement; and (ii) your inclusion of this notice
+ * in any version of this software that you use or redistribute.
+ * A copy of the UNIGINE License Agreement is available by contacting
+ * UNIGINE. at http://unigine.com/
+ */
+
+
+#pragma once
+
+#include "UnigineSnapshot.h"
+#include "UnigineThread.h"
+#include "UnigineCallback.h"
+
+// Snapshot delta example
+/*
+	// every few seconds on the server, the state is copied on the main
+	// thread and compared with the keyframe on a background thread
+	SnapshotRecorder recorder;
+	recorder.setKeyframeInterval(30);
+	...
+	recorder.capture();
+
+	// quicksave of the last point as a full snapshot
+	recorder.saveFrame(recorder.getNumFrames() - 1, File::create("quicksave.usnp", "wb"));
+
+	// back to any recorded point
+	recorder.restoreFrame(frame);
+*/
+
+namespace Unigine
+{
+
+//////////////////////////////////////////////////////////////////////////
+/// Delta snapshots.
+///
+/// A delta holds the rows of the sections that differ from the keyframe
+/// and only the columns that changed in any of them. Rows are matched by
+/// the key column of the section (see SnapshotWriter::Section::addKey())
+/// or by their index, so the keys must be unique. Values are compared
+/// bitwise, the state is compared instead of tracked, so any change
+/// is found no matter what made it. Deltas are snapshots themselves:
+///
+///   __delta       hashes of all sections of the captured state
+///   section       the key column, the changed columns and __removed
+///                 marking the rows of the keyframe that are gone
+///
+/// Sections that did not change are not written. A keyframe and any of
+/// its deltas give the full state at the point of the delta.
+//////////////////////////////////////////////////////////////////////////
+
+class SnapshotDelta
+{
+public:
+	// writes the difference of current to keyframe into delta
+	static void create(const SnapshotWriter &keyframe, const SnapshotWriter &current, SnapshotWriter &delta)
+	{
+		const unsigned int removed_hash = Snapshot::getNameHash("__removed");
+		const unsigned int row_hash = Snapshot::getNameHash("__row");
+
+		SnapshotWriter::Section &info = delta.addSection("__delta", current.getNumSections(), Snapshot::CODEC_NONE);
+		info.add("section", [&](int i) { return (long long)current.getSection(i).getHash(); });
+
+		Vector<int> changed;
+		Vector<int> removed;
+		Vector<char> changed_columns;
+		Vector<int> key_columns;
+		Vector<char> seen;
+		HashMap<long long, int> keyframe_rows;
+
+		for (int s = 0; s < current.getNumSections(); s++)
+		{
+			const SnapshotWriter::Section &section = current.getSection(s);
+			int index = keyframe.findSection(section.getHash());
+			const SnapshotWriter::Section *base = index != -1 ? &keyframe.getSection(index) : nullptr;
+			int rows = section.getNumRows();
+			int base_rows = base ? base->getNumRows() : 0;
+
+			int key = section.getKeyColumn();
+			int base_key = base ? base->getKeyColumn() : -1;
+			auto get_key = [&](int row) { return key != -1 ? section.getColumn(key).getInt(row) : (long long)row; };
+			auto get_base_key = [&](int row) { return base_key != -1 ? base->getColumn(base_key).getInt(row) : (long long)row; };
+
+			keyframe_rows.clear();
+			for (int i = 0; i < base_rows; i++)
+				keyframe_rows.append(get_base_key(i)) = i;
+
+			// matching columns of the keyframe, -1 for new or changed layouts
+			int num_columns = section.getNumColumns();
+			key_columns.resize(num_columns);
+			changed_columns.resize(num_columns);
+			for (int j = 0; j < num_columns; j++)
+			{
+				const SnapshotWriter::Column &column = section.getColumn(j);
+				int k = base ? base->findColumn(column.hash) : -1;
+				if (k != -1 && (base->getColumn(k).type != column.type || base->getColumn(k).components != column.components))
+					k = -1;
+				key_columns[j] = k;
+				changed_columns[j] = k == -1 || j == key;
+			}
+
+			changed.clear();
+			removed.clear();
+			seen.resize(base_rows);
+			if (base_rows)
+				memset(seen.get(), 0, base_rows);
+			for (int i = 0; i < rows; i++)
+			{
+				int row = keyframe_rows.value(get_key(i), -1);
+				if (row == -1)
+				{
+					// new rows carry all columns
+					for (int j = 0; j < num_columns; j++)
+						changed_columns[j] = 1;
+					changed.append(i);
+					continue;
+				}
+				seen[row] = 1;
+				bool differs = false;
+				for (int j = 0; j < num_columns; j++)
+				{
+					int k = key_columns[j];
+					if (k == -1 || !section.getColumn(j).isEqual(i, rows, base->getColumn(k), row, base_rows))
+					{
+						differs = true;
+						changed_columns[j] = 1;
+					}
+				}
+				if (differs)
+					changed.append(i);
+			}
+			for (int i = 0; i < base_rows; i++)
+			{
+				if (!seen[i])
+					removed.append(i);
+			}
+			if (base && changed.size() == 0 && removed.size() == 0)
+				continue;
+
+			int delta_rows = changed.size() + removed.size();
+			SnapshotWriter::Section &dest = delta.addSection(section.getHash(), delta_rows, section.getCodec());
+
+			// key of the changed and removed rows
+			SnapshotWriter::Column *keys = dest.addColumn("__row", key != -1 ? section.getColumn(key).hash : row_hash, Snapshot::TYPE_INT, 1);
+			keys->flags |= Snapshot::FLAG_KEY;
+			keys->ints.resize(delta_rows);
+			for (int i = 0; i < changed.size(); i++)
+				keys->ints[i] = get_key(changed[i]);
+			for (int i = 0; i < removed.size(); i++)
+				keys->ints[changed.size() + i] = get_base_key(removed[i]);
+
+			for (int j = 0; j < num_columns; j++)
+			{
+				if (!changed_columns[j] || j == key)
+					continue;
+				const SnapshotWriter::Column &column = section.getColumn(j);
+				SnapshotWriter::Column *d = dest.addColumn("", column.hash, column.type, column.components);
+				if (!d)
+					continue;
+				resize_column(*d, delta_rows);
+				for (int i = 0; i < changed.size(); i++)
+					d->copyRow(i, delta_rows, column, changed[i], rows);
+				if (column.type == Snapshot::TYPE_STRING)
+				{
+					for (int i = 0; i < removed.size(); i++)
+						d->appendString("");
+				}
+			}
+
+			if (removed.size())
+			{
+				SnapshotWriter::Column *d = dest.addColumn("__removed", removed_hash, Snapshot::TYPE_INT, 1);
+				resize_column(*d, delta_rows);
+				for (int i = changed.size(); i < delta_rows; i++)
+					d->ints[i] = 1;
+			}
+		}
+	}
+
+	// writes the full state at the point of the delta into out
+	static bool merge(SnapshotReader &keyframe, SnapshotReader &delta, SnapshotWriter &out)
+	{
+		const unsigned int removed_hash = Snapshot::getNameHash("__removed");
+		const unsigned int row_hash = Snapshot::getNameHash("__row");
+
+		SnapshotReader::Section *info = delta.findSection("__delta");
+		if (!info)
+		{
+			Log::error("SnapshotDelta::merge(): snapshot is not a delta\n");
+			return false;
+		}
+		Vector<unsigned int> hashes;
+		info->read<long long>("section", [&](int, long long hash) { hashes.append((unsigned int)hash); });
+		out.setSchemaVersion(delta.getSchemaVersion());
+
+		Vector<int> sources;
+		Vector<int> changes;
+		HashMap<long long, int> keyframe_rows;
+
+		for (int s = 0; s < hashes.size(); s++)
+		{
+			SnapshotReader::Section *base = keyframe.findSection(hashes[s]);
+			SnapshotReader::Section *changed = delta.findSection(hashes[s]);
+			if (!changed)
+			{
+				if (!base)
+				{
+					Log::error("SnapshotDelta::merge(): section %08x is not in the keyframe\n", hashes[s]);
+					return false;
+				}
+				if (!base->copyTo(out.addSection(hashes[s], base->getNumRows())))
+					return false;
+				continue;
+			}
+
+			// both sections decoded into columns
+			SnapshotWriter temp;
+			SnapshotWriter::Section &base_section = temp.addSection(0u, base ? base->getNumRows() : 0);
+			SnapshotWriter::Section &delta_section = temp.addSection(1u, changed->getNumRows());
+			if ((base && !base->copyTo(base_section)) || !changed->copyTo(delta_section))
+				return false;
+
+			int base_rows = base_section.getNumRows();
+			int delta_rows = delta_section.getNumRows();
+			int base_key = base_section.getKeyColumn();
+			int delta_key = delta_section.getKeyColumn();
+			if (delta_key == -1)
+			{
+				Log::error("SnapshotDelta::merge(): section %08x has no key\n", hashes[s]);
+				return false;
+			}
+			const SnapshotWriter::Column &keys = delta_section.getColumn(delta_key);
+			int removed_column = delta_section.findColumn(removed_hash);
+
+			keyframe_rows.clear();
+			for (int i = 0; i < base_rows; i++)
+				keyframe_rows.append(base_key != -1 ? base_section.getColumn(base_key).getInt(i) : (long long)i) = i;
+
+			// rows of the keyframe that remain, followed by the new rows,
+			// with the rows of the delta that override them
+			sources.resize(base_rows);
+			changes.resize(base_rows);
+			for (int i = 0; i < base_rows; i++)
+			{
+				sources[i] = i;
+				changes[i] = -1;
+			}
+			for (int i = 0; i < delta_rows; i++)
+			{
+				int row = keyframe_rows.value(keys.getInt(i), -1);
+				bool is_removed = removed_column != -1 && delta_section.getColumn(removed_column).getInt(i) != 0;
+				if (row != -1)
+				{
+					if (is_removed)
+						sources[row] = -1;
+					else
+						changes[row] = i;
+				} else if (!is_removed)
+				{
+					sources.append(-1);
+					changes.append(i);
+				}
+			}
+			int rows = 0;
+			for (int i = 0; i < sources.size(); i++)
+			{
+				if (sources[i] != -1 || changes[i] != -1)
+				{
+					sources[rows] = sources[i];
+					changes[rows] = changes[i];
+					rows++;
+				}
+			}
+			sources.resize(rows);
+			changes.resize(rows);
+
+			SnapshotWriter::Section &dest = out.addSection(hashes[s], rows);
+
+			// columns of the keyframe, then the new ones
+			for (int j = 0; j < base_section.getNumColumns() + delta_section.getNumColumns(); j++)
+			{
+				bool from_base = j < base_section.getNumColumns();
+				const SnapshotWriter::Column &column = from_base ? base_section.getColumn(j) : delta_section.getColumn(j - base_section.getNumColumns());
+				if (!from_base && (column.hash == removed_hash || base_section.findColumn(column.hash) != -1))
+					continue;
+				if (!from_base && column.hash == row_hash && base_key == -1)
+					continue;
+
+				int k = from_base ? delta_section.findColumn(column.hash) : j - base_section.getNumColumns();
+				const SnapshotWriter::Column *override_column = k != -1 ? &delta_section.getColumn(k) : nullptr;
+				if (override_column && (override_column->type != column.type || override_column->components != column.components))
+					override_column = nullptr;
+
+				SnapshotWriter::Column *d = dest.addColumn("", column.hash, column.type, column.components);
+				if (!d)
+					continue;
+				d->flags = column.flags;
+				resize_column(*d, rows);
+				for (int i = 0; i < rows; i++)
+				{
+					if (override_column && changes[i] != -1)
+						d->copyRow(i, rows, *override_column, changes[i], delta_rows);
+					else if (from_base && sources[i] != -1)
+						d->copyRow(i, rows, column, sources[i], base_rows);
+					else if (column.type == Snapshot::TYPE_STRING)
+						d->appendString("");
+				}
+			}
+		}
+		return true;
+	}
+
+private:
+	// planes of zeros for rows, strings are appended
+	static void resize_column(SnapshotWriter::Column &column, int rows)
+	{
+		size_t num = size_t(rows) * column.components;
+		switch (column.type)
+		{
+			case Snapshot::TYPE_INT: column.ints.resize(num); memset(column.ints.get(), 0, num * sizeof(long long)); break;
+			case Snapshot::TYPE_FLOAT: column.floats.resize(num); memset(column.floats.get(), 0, num * sizeof(float)); break;
+			case Snapshot::TYPE_DOUBLE: column.doubles.resize(num); memset(column.doubles.get(), 0, num * sizeof(double)); break;
+			default: column.offsets.reserve(rows); break;
+		}
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// Keyframe and delta recorder.
+///
+/// capture() copies the state into a SnapshotWriter on the calling thread
+/// and hands it to a background CPUShader, which compares it with the
+/// keyframe, writes the delta and compresses it. The calling thread only
+/// pays for the copy. A new keyframe is taken after the set number of
+/// deltas or when a delta grows past half of its keyframe.
+///
+/// The recording is unbounded by default. With setMaxFrames() or
+/// setMaxBytes() the oldest keyframe together with its deltas is dropped
+/// once the window is exceeded, frames are numbered from the oldest kept
+/// one. The newest keyframe group is always kept, a new keyframe is forced
+/// when it alone exceeds the window.
+//////////////////////////////////////////////////////////////////////////
+
+class SnapshotRecorder
+{
+public:
+	enum
+	{
+		DEFAULT_KEYFRAME_INTERVAL = 30,
+	};
+
+	SnapshotRecorder()
+	{
+		job.recorder = this;
+		capture_func = [](SnapshotWriter &writer) { SnapshotComponents::save(writer); };
+		restore_func = [](SnapshotReader &reader) { SnapshotComponents::restore(reader); };
+	}
+	~SnapshotRecorder() { clear(); }
+
+	SnapshotRecorder(const SnapshotRecorder &) = delete;
+	SnapshotRecorder &operator=(const SnapshotRecorder &) = delete;
+
+	// fills the writer with the state, SnapshotComponents by default
+	UNIGINE_INLINE void setCaptureFunction(Function<void(SnapshotWriter &)> &&func) { wait(); capture_func = std::move(func); }
+	UNIGINE_INLINE void setRestoreFunction(Function<void(SnapshotReader &)> &&func) { restore_func = std::move(func); }
+
+	UNIGINE_INLINE void setKeyframeInterval(int interval) { keyframe_interval = interval < 0 ? 0 : interval; }
+	UNIGINE_INLINE int getKeyframeInterval() const { return keyframe_interval; }
+
+	// recording window, zero means unlimited
+	UNIGINE_INLINE void setMaxFrames(int num) { wait(); max_frames = num < 0 ? 0 : num; }
+	UNIGINE_INLINE int getMaxFrames() const { return max_frames; }
+	UNIGINE_INLINE void setMaxBytes(size_t size) { wait(); max_bytes = size; }
+	UNIGINE_INLINE size_t getMaxBytes() const { return max_bytes; }
+
+	// starts the encoding of the current state, waits for the previous one
+	void capture()
+	{
+		using Clock = std::chrono::steady_clock;
+		Clock::time_point begin = Clock::now();
+		wait();
+		pending = new SnapshotWriter();
+		capture_func(*pending);
+		capture_time = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+		job.runAsync(1);
+	}
+
+	void wait()
+	{
+		if (job.isRunning())
+			job.wait();
+	}
+
+	void clear()
+	{
+		wait();
+		delete pending;
+		delete keyframe;
+		pending = nullptr;
+		keyframe = nullptr;
+		frames.clear();
+		frames_bytes = 0;
+		num_dropped = 0;
+		next_keyframe = true;
+	}
+
+	UNIGINE_INLINE bool isRunning() const { return job.isRunning() != 0; }
+
+	// time spent in the last capture() and in the last background job, in milliseconds
+	UNIGINE_INLINE double getCaptureTime() const { return capture_time; }
+	UNIGINE_INLINE double getEncodeTime() { wait(); return encode_time; }
+
+	int getNumFrames() { wait(); return frames.size(); }
+	bool isKeyframe(int frame) { wait(); return frame >= 0 && frame < frames.size() && frames[frame].keyframe == frame; }
+	size_t getFrameSize(int frame) { wait(); return frame >= 0 && frame < frames.size() ? frames[frame].blob->getSize() : 0; }
+
+	// encoded size of the kept frames and the number of frames dropped by the window
+	UNIGINE_INLINE size_t getFramesSize() { wait(); return frames_bytes; }
+	UNIGINE_INLINE long long getNumDroppedFrames() { wait(); return num_dropped; }
+
+	// full snapshot of the frame
+	bool saveFrame(int frame, const StreamPtr &stream)
+	{
+		wait();
+		if (frame < 0 || frame >= frames.size())
+			return false;
+		const Frame &f = frames[frame];
+		if (f.keyframe == frame)
+			return stream->write(f.blob->getData(), f.blob->getSize()) == f.blob->getSize();
+		SnapshotWriter writer;
+		return merge(frame, writer) && writer.save(stream);
+	}
+
+	// restores the state of the frame with the restore function
+	bool restoreFrame(int frame)
+	{
+		wait();
+		if (frame < 0 || frame >= frames.size())
+			return false;
+		BlobPtr blob = frames[frame].blob;
+		if (frames[frame].keyframe != frame)
+		{
+			SnapshotWriter writer;
+			blob = Blob::create();
+			if (!merge(frame, writer) || !writer.save(blob))
+				return false;
+		}
+		blob->seekSet(0);
+		SnapshotReader reader;
+		if (!reader.load(blob))
+			return false;
+		restore_func(reader);
+		return true;
+	}
+
+	// delta_benchmark [number of tanks]
+	static void getBenchmarkReport(String &ret, int num_tanks = 10000);
+
+	static void addConsoleCommands()
+	{
+		Console::addCommand("snapshot_delta_benchmark", "prints the capture time and the size of keyframes and deltas", MakeCallback(&SnapshotRecorder::console_benchmark));
+	}
+	static void removeConsoleCommands() { Console::removeCommand("snapshot_delta_benchmark"); }
+
+private:
+	struct Frame
+	{
+		int keyframe;
+		BlobPtr blob;
+	};
+
+	class Job : public CPUShader
+	{
+	public:
+		void process(int thread_num, int threads_count) override
+		{
+			UNIGINE_UNUSED(thread_num);
+			UNIGINE_UNUSED(threads_count);
+			recorder->encode();
+		}
+
+		SnapshotRecorder *recorder{nullptr};
+	};
+
+	// background thread
+	void encode()
+	{
+		using Clock = std::chrono::steady_clock;
+		Clock::time_point begin = Clock::now();
+
+		Frame &frame = frames.append();
+		frame.blob = Blob::create();
+		if (next_keyframe || !keyframe)
+		{
+			pending->save(frame.blob, false);
+			frame.keyframe = frames.size() - 1;
+			delete keyframe;
+			keyframe = pending;
+			keyframe_size = frame.blob->getSize();
+			next_keyframe = false;
+		} else
+		{
+			SnapshotWriter delta(pending->getSchemaVersion());
+			SnapshotDelta::create(*keyframe, *pending, delta);
+			delta.save(frame.blob, false);
+			frame.keyframe = frames[frames.size() - 2].keyframe;
+			delete pending;
+			next_keyframe = frames.size() - 1 - frame.keyframe >= keyframe_interval || frame.blob->getSize() * 2 > keyframe_size;
+		}
+		pending = nullptr;
+		frames_bytes += frame.blob->getSize();
+		drop_frames();
+
+		encode_time = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+	}
+
+	// drops the oldest keyframe groups outside of the window
+	void drop_frames()
+	{
+		while ((max_frames && frames.size() > max_frames) || (max_bytes && frames_bytes > max_bytes))
+		{
+			int num = 1;
+			while (num < frames.size() && frames[num].keyframe != num)
+				num++;
+			if (num == frames.size())
+			{
+				// the newest group can't be dropped, the next frame starts a new one
+				next_keyframe = true;
+				return;
+			}
+
+			for (int i = 0; i < num; i++)
+				frames_bytes -= frames[i].blob->getSize();
+			frames.remove(0, num);
+			for (int i = 0; i < frames.size(); i++)
+				frames[i].keyframe -= num;
+			num_dropped += num;
+		}
+	}
+
+	bool merge(int frame, SnapshotWriter &writer)
+	{
+		const Frame &f = frames[frame];
+		BlobPtr keyframe_blob = frames[f.keyframe].blob;
+		keyframe_blob->seekSet(0);
+		f.blob->seekSet(0);
+		SnapshotReader keyframe_reader;
+		SnapshotReader delta_reader;
+		return keyframe_reader.load(keyframe_blob) && delta_reader.load(f.blob) &&
+			SnapshotDelta::merge(keyframe_reader, delta_reader, writer);
+	}
+
+	static void console_benchmark(int argc, char **argv)
+	{
+		int num = 10000;
+		if (argc > 1 && atoi(argv[1]) > 0)
+			num = atoi(argv[1]);
+		String report;
+		getBenchmarkReport(report, num);
+		Log::message("%s", report.get());
+	}
+
+	Job job;
+	Function<void(SnapshotWriter &)> capture_func;
+	Function<void(SnapshotReader &)> restore_func;
+
+	int keyframe_interval{DEFAULT_KEYFRAME_INTERVAL};
+	int max_frames{0};
+	size_t max_bytes{0};
+	bool next_keyframe{true};
+	size_t keyframe_size{0};
+	double capture_time{0.0};
+	double encode_time{0.0};
+
+	SnapshotWriter *pending{nullptr};
+	SnapshotWriter *keyframe{nullptr};
+	Vector<Frame> frames;
+	size_t frames_bytes{0};
+	long long num_dropped{0};
+};
+
+inline void SnapshotRecorder::getBenchmarkReport(String &ret, int num_tanks)
+{
+	struct Tank
+	{
+		int id;
+		int ammo;
+		float health;
+		Math::mat4 transform;
+		Math::vec3 velocity;
+		String name;
+	};
+
+	Vector<Tank> tanks;
+	tanks.resize(num_tanks);
+	int next_id = 0;
+	for (int i = 0; i < num_tanks; i++)
+	{
+		Tank &t = tanks[i];
+		t.id = next_id++;
+		t.ammo = 40;
+		t.health = 100.0f;
+		t.transform = Math::mat4_identity;
+		t.transform.setColumn3(3, Math::vec3(float(i % 100) * 10.0f, float(i / 100) * 10.0f, 0.0f));
+		t.velocity = Math::vec3_zero;
+		t.name = String::format("tank_%d", t.id);
+	}
+
+	// a twentieth of the tanks move, one in a thousand is replaced
+	unsigned int seed = 1;
+	auto random = [&](int range) { seed = seed * 1664525u + 1013904223u; return int((seed >> 8) % unsigned(range)); };
+	auto simulate = [&]()
+	{
+		for (int i = 0; i < num_tanks / 20; i++)
+		{
+			Tank &t = tanks[random(num_tanks)];
+			t.transform.setColumn3(3, t.transform.getColumn3(3) + Math::vec3(1.0f, 0.5f, 0.0f));
+			t.velocity = Math::vec3(1.0f, 0.5f, 0.0f);
+			t.health -= 1.0f;
+		}
+		for (int i = 0; i < num_tanks / 1000; i++)
+		{
+			Tank &t = tanks[random(num_tanks)];
+			t.id = next_id++;
+			t.ammo = 40;
+			t.health = 100.0f;
+			t.name = String::format("tank_%d", t.id);
+		}
+	};
+
+	auto save = [&](SnapshotWriter &writer)
+	{
+		SnapshotWriter::Section &section = writer.addSection("tanks", tanks.size());
+		section.addKey("id", [&](int i) { return tanks[i].id; });
+		section.add("ammo", [&](int i) { return tanks[i].ammo; });
+		section.add("health", [&](int i) { return tanks[i].health; });
+		section.add("transform", [&](int i) { return tanks[i].transform; });
+		section.add("velocity", [&](int i) { return tanks[i].velocity; });
+		section.addString("name", [&](int i) { return tanks[i].name.get(); });
+	};
+
+	// the expected state of every frame, compared with the restored one
+	struct State
+	{
+		HashMap<int, Tank> tanks;
+	};
+	Vector<State> states;
+	bool equal = true;
+
+	SnapshotRecorder recorder;
+	recorder.setCaptureFunction([&](SnapshotWriter &writer) { save(writer); });
+	recorder.setRestoreFunction([&](SnapshotReader &reader)
+	{
+		const State &state = states[states.size() - 1];
+		SnapshotReader::Section *section = reader.findSection("tanks");
+		if (!section || section->getNumRows() != int(state.tanks.size()))
+		{
+			equal = false;
+			return;
+		}
+		Vector<int> ids;
+		section->read<int>("id", [&](int, int id) { ids.append(id); });
+		section->read<float>("health", [&](int i, float health)
+		{
+			auto it = state.tanks.find(ids[i]);
+			equal &= it != state.tanks.end() && it->data.health == health;
+		});
+		section->readString("name", [&](int i, const char *name)
+		{
+			auto it = state.tanks.find(ids[i]);
+			equal &= it != state.tanks.end() && it->data.name == name;
+		});
+		section->read<Math::mat4>("transform", [&](int i, const Math::mat4 &transform)
+		{
+			auto it = state.tanks.find(ids[i]);
+			equal &= it != state.tanks.end() && memcmp(it->data.transform.mat, transform.mat, sizeof(transform.mat)) == 0;
+		});
+	});
+
+	const int num_frames = 64;
+	double capture_max = 0.0;
+	double capture_sum = 0.0;
+	double encode_sum = 0.0;
+	size_t keyframe_bytes = 0;
+	size_t delta_bytes = 0;
+	int num_keyframes = 0;
+	for (int i = 0; i < num_frames; i++)
+	{
+		simulate();
+		recorder.capture();
+		capture_sum += recorder.getCaptureTime();
+		capture_max = recorder.getCaptureTime() > capture_max ? recorder.getCaptureTime() : capture_max;
+		encode_sum += recorder.getEncodeTime();
+		if (recorder.isKeyframe(i))
+		{
+			keyframe_bytes += recorder.getFrameSize(i);
+			num_keyframes++;
+		} else
+			delta_bytes += recorder.getFrameSize(i);
+	}
+
+	// the last state restored from its keyframe and delta
+	State &state = states.append();
+	for (int i = 0; i < tanks.size(); i++)
+		state.tanks.append(tanks[i].id) = tanks[i];
+	using Clock = std::chrono::steady_clock;
+	Clock::time_point begin = Clock::now();
+	bool restored = recorder.restoreFrame(num_frames - 1);
+	double restore_time = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+
+	ret.clear();
+	Format::append(ret, "{} tanks, {} captures, a twentieth of the tanks changes between them\n", num_tanks, num_frames);
+	Format::append(ret, "capture       {:10.3} ms average {:10.3} ms max (calling thread)\n", capture_sum / num_frames, capture_max);
+	Format::append(ret, "encode        {:10.3} ms average (background)\n", encode_sum / num_frames);
+	Format::append(ret, "keyframes     {:10} {:12} bytes average\n", num_keyframes, (unsigned long long)(num_keyframes ? keyframe_bytes / num_keyframes : 0));
+	Format::append(ret, "deltas        {:10} {:12} bytes average\n", num_frames - num_keyframes, (unsigned long long)(num_frames > num_keyframes ? delta_bytes / (num_frames - num_keyframes) : 0));
+	Format::append(ret, "restore       {:10.3} ms{}\n", restore_time, restored && equal ? "" : "  mismatch");
+}
+
+} // namespace Unigine
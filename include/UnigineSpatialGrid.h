@@ -0,0 +1,470 @@
+/* Copyright (C) 2005-2020, UNIGINE. All rights reserved.
+ *
+ * This file is a part of the UNIGINE 2 SDK.
+ *
+ * Your use and / or redistribution of this software in source and / or
+ * binary form, with or without modification, is subject to: (i) your
+ * ongoing acceptance of and compliance with the terms and conditions of
+ * the UNIGINE License Agreement; and (ii) your inclusion of this notice
+ * in any version of this software that you use or redistribute.
+ * A copy of the UNIGINE License Agreement is available by contacting
+ * UNIGINE. at http://unigine.com/
+ */
+
+
+#pragma once
+
+#include "UnigineBase.h"
+#include "UnigineVector.h"
+#include "UnigineHashMap.h"
+#include "UnigineBounds.h"
+#include "UnigineThread.h"
+#include "UnigineString.h"
+#include "UnigineFormat.h"
+#include "UnigineConsole.h"
+#include "UnigineCallback.h"
+#include "UnigineLog.h"
+#include <chrono>
+#include <stdlib.h>
+
+namespace Unigine
+{
+
+struct SpatialGridCell
+{
+	int x, y, z;
+
+	UNIGINE_INLINE bool operator==(const SpatialGridCell &c) const { return x == c.x && y == c.y && z == c.z; }
+	UNIGINE_INLINE bool operator!=(const SpatialGridCell &c) const { return !(*this == c); }
+};
+
+template<>
+struct Hasher<SpatialGridCell>
+{
+	using HashType = unsigned int;
+	UNIGINE_INLINE static HashType create(const SpatialGridCell &c)
+	{
+		// the hash table masks the low bits, so neighbouring cells must be well mixed
+		unsigned int h = (unsigned int)c.x * 73856093u ^ (unsigned int)c.y * 19349663u ^ (unsigned int)c.z * 83492791u;
+		h ^= h >> 16;
+		h *= 0x85ebca6bu;
+		h ^= h >> 13;
+		return h;
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// Loose uniform grid for dynamic entities.
+///
+/// Every entity is stored in the single cell that contains its position,
+/// queries are expanded by the largest entity radius, so moving an entity
+/// costs at most one swap-remove and one append. Cells are kept in a hash
+/// map keyed on cell coordinates, the grid is unbounded. With zero cell
+/// height the grid is flat (XY only) and Z is checked per entity.
+///
+/// Queries are const and take a reader lock, modifications take a writer
+/// lock, so queries may run concurrently from updateAsyncThread() methods.
+//////////////////////////////////////////////////////////////////////////
+
+class SpatialGrid
+{
+public:
+	SpatialGrid(float cell_size = 16.0f, float cell_height = 0.0f)
+	{
+		setCellSize(cell_size, cell_height);
+	}
+
+	// the grid must be empty or rebuild() must be called after changing the cell size
+	UNIGINE_INLINE void setCellSize(float size, float height = 0.0f)
+	{
+		assert(size > 0.0f && "SpatialGrid::setCellSize(): bad cell size");
+		cell_size = size;
+		cell_height = height;
+		icell_size = 1.0f / size;
+		icell_height = height > 0.0f ? 1.0f / height : 0.0f;
+	}
+	UNIGINE_INLINE float getCellSize() const { return cell_size; }
+	UNIGINE_INLINE float getCellHeight() const { return cell_height; }
+
+	// entities
+	UNIGINE_INLINE int add(const Math::vec3 &position, float radius = 0.0f, int data = -1)
+	{
+		ScopedWriterLock lock(mutex);
+		int id;
+		if (free_entities.size())
+			id = free_entities.takeLast();
+		else
+		{
+			id = entities.size();
+			entities.append();
+		}
+		Entity &e = entities[id];
+		e.position = position;
+		e.radius = radius;
+		e.data = data;
+		insert_entity(id, get_cell(position));
+		if (radius > max_radius)
+			max_radius = radius;
+		num_entities++;
+		return id;
+	}
+
+	UNIGINE_INLINE void remove(int id)
+	{
+		ScopedWriterLock lock(mutex);
+		assert(isValid(id) && "SpatialGrid::remove(): bad entity");
+		remove_entity(id);
+		entities[id].cell = -1;
+		free_entities.append(id);
+		num_entities--;
+	}
+
+	UNIGINE_INLINE void move(int id, const Math::vec3 &position)
+	{
+		ScopedWriterLock lock(mutex);
+		move_entity(id, position);
+	}
+
+	UNIGINE_INLINE void move(int id, const Math::vec3 &position, float radius)
+	{
+		ScopedWriterLock lock(mutex);
+		assert(isValid(id) && "SpatialGrid::move(): bad entity");
+		entities[id].radius = radius;
+		if (radius > max_radius)
+			max_radius = radius;
+		move_entity(id, position);
+	}
+
+	// batched move, a single lock for all entities
+	UNIGINE_INLINE void move(const int *ids, const Math::vec3 *positions, int num)
+	{
+		ScopedWriterLock lock(mutex);
+		for (int i = 0; i < num; i++)
+			move_entity(ids[i], positions[i]);
+	}
+
+	// reinserts all entities, drops empty cells and recomputes the largest radius
+	// use it after massive teleports or to reclaim memory after entities have left an area
+	void rebuild()
+	{
+		ScopedWriterLock lock(mutex);
+		rebuild_cells();
+	}
+
+	// batched rebuild from new positions of all entities (indexed by entity ID),
+	// positions and cells are updated under one lock, so readers never see them out of sync
+	void rebuild(const Math::vec3 *positions, int num)
+	{
+		ScopedWriterLock lock(mutex);
+		assert(num == entities.size() && "SpatialGrid::rebuild(): bad number of entities");
+		for (int i = 0; i < num; i++)
+			entities[i].position = positions[i];
+		rebuild_cells();
+	}
+
+	UNIGINE_INLINE void clear()
+	{
+		ScopedWriterLock lock(mutex);
+		entities.clear();
+		free_entities.clear();
+		cells.clear();
+		cell_map.clear();
+		num_entities = 0;
+		max_radius = 0.0f;
+	}
+
+	UNIGINE_INLINE bool isValid(int id) const { return id >= 0 && id < entities.size() && entities[id].cell != -1; }
+	UNIGINE_INLINE const Math::vec3 &getPosition(int id) const { return entities[id].position; }
+	UNIGINE_INLINE float getRadius(int id) const { return entities[id].radius; }
+	UNIGINE_INLINE int getData(int id) const { return entities[id].data; }
+	UNIGINE_INLINE void setData(int id, int data) { entities[id].data = data; }
+
+	// statistics
+	UNIGINE_INLINE int getNumEntities() const { return num_entities; }
+	UNIGINE_INLINE int getNumCells() const { return cells.size(); }
+	UNIGINE_INLINE float getMaxRadius() const { return max_radius; }
+
+	// queries, found entity IDs are appended to the result vector
+	UNIGINE_INLINE int getEntities(const Math::vec3 &point, float radius, Vector<int> &result) const
+	{
+		int num = result.size();
+		forEach(point, radius, [&result](int id) { result.append(id); });
+		return result.size() - num;
+	}
+
+	UNIGINE_INLINE int getEntities(const BoundSphere &bs, Vector<int> &result) const
+	{
+		return getEntities(bs.getCenter(), bs.getRadius(), result);
+	}
+
+	UNIGINE_INLINE int getEntities(const BoundBox &bb, Vector<int> &result) const
+	{
+		int num = result.size();
+		forEach(bb, [&result](int id) { result.append(id); });
+		return result.size() - num;
+	}
+
+	// visitor is "void (int id)"
+	template <typename Visitor>
+	void forEach(const Math::vec3 &point, float radius, Visitor visitor) const
+	{
+		ScopedReaderLock lock(mutex);
+		float expand = radius + max_radius;
+		Math::vec3 min(point.x - expand, point.y - expand, point.z - expand);
+		Math::vec3 max(point.x + expand, point.y + expand, point.z + expand);
+		visit_cells(min, max, [this, &point, radius, &visitor](int id)
+		{
+			const Entity &e = entities[id];
+			float distance = radius + e.radius;
+			if (Math::length2(e.position - point) <= distance * distance)
+				visitor(id);
+		});
+	}
+
+	template <typename Visitor>
+	void forEach(const BoundBox &bb, Visitor visitor) const
+	{
+		ScopedReaderLock lock(mutex);
+		const Math::vec3 &bmin = bb.getMin();
+		const Math::vec3 &bmax = bb.getMax();
+		Math::vec3 min(bmin.x - max_radius, bmin.y - max_radius, bmin.z - max_radius);
+		Math::vec3 max(bmax.x + max_radius, bmax.y + max_radius, bmax.z + max_radius);
+		visit_cells(min, max, [this, &bmin, &bmax, &visitor](int id)
+		{
+			const Entity &e = entities[id];
+			const Math::vec3 &p = e.position;
+			float r = e.radius;
+			if (p.x + r >= bmin.x && p.x - r <= bmax.x &&
+				p.y + r >= bmin.y && p.y - r <= bmax.y &&
+				p.z + r >= bmin.z && p.z - r <= bmax.z)
+				visitor(id);
+		});
+	}
+
+	// spatial_grid_benchmark [entities], moves and 30 unit radius queries in 16 unit cells
+	// for 1k, 10k and 100k entities, or for the given number only
+	static void getBenchmarkReport(String &ret);
+	static void getBenchmarkReport(String &ret, int num);
+
+	static void addConsoleCommands()
+	{
+		Console::addCommand("spatial_grid_benchmark", "prints the SpatialGrid move and query times", MakeCallback(&SpatialGrid::console_benchmark));
+	}
+	static void removeConsoleCommands() { Console::removeCommand("spatial_grid_benchmark"); }
+
+private:
+	struct Entity
+	{
+		Math::vec3 position;
+		float radius;
+		int data;
+		int cell; // index in the cells vector, -1 for free entities
+		int slot; // index in the cell's entity list
+	};
+
+	struct Cell
+	{
+		SpatialGridCell key;
+		Vector<int> entities;
+	};
+
+	UNIGINE_INLINE SpatialGridCell get_cell(const Math::vec3 &p) const
+	{
+		SpatialGridCell c;
+		c.x = get_coordinate(p.x, icell_size);
+		c.y = get_coordinate(p.y, icell_size);
+		c.z = icell_height > 0.0f ? get_coordinate(p.z, icell_height) : 0;
+		return c;
+	}
+
+	static UNIGINE_INLINE int get_coordinate(float v, float iscale)
+	{
+		float c = Math::floor(v * iscale);
+		return c < -1e9f ? -1000000000 : (c > 1e9f ? 1000000000 : int(c));
+	}
+
+	UNIGINE_INLINE void insert_entity(int id, const SpatialGridCell &key)
+	{
+		int cell;
+		auto it = cell_map.find(key);
+		if (it != cell_map.end())
+			cell = it->data;
+		else
+		{
+			cell = cells.size();
+			cells.append().key = key;
+			cell_map.append(key, cell);
+		}
+		Entity &e = entities[id];
+		e.cell = cell;
+		e.slot = cells[cell].entities.size();
+		cells[cell].entities.append(id);
+	}
+
+	// the writer lock is held by the caller
+	void rebuild_cells()
+	{
+		cells.clear();
+		cell_map.clear();
+		max_radius = 0.0f;
+		for (int i = 0; i < entities.size(); i++)
+		{
+			Entity &e = entities[i];
+			if (e.cell == -1)
+				continue;
+			insert_entity(i, get_cell(e.position));
+			if (e.radius > max_radius)
+				max_radius = e.radius;
+		}
+	}
+
+	UNIGINE_INLINE void remove_entity(int id)
+	{
+		Entity &e = entities[id];
+		Vector<int> &list = cells[e.cell].entities;
+		int last = list.last();
+		list[e.slot] = last;
+		entities[last].slot = e.slot;
+		list.removeLast();
+	}
+
+	UNIGINE_INLINE void move_entity(int id, const Math::vec3 &position)
+	{
+		assert(isValid(id) && "SpatialGrid::move(): bad entity");
+		Entity &e = entities[id];
+		e.position = position;
+		SpatialGridCell key = get_cell(position);
+		if (cells[e.cell].key == key)
+			return;
+		remove_entity(id);
+		insert_entity(id, key);
+	}
+
+	template <typename Func>
+	UNIGINE_INLINE void visit_cells(const Math::vec3 &min, const Math::vec3 &max, Func func) const
+	{
+		SpatialGridCell c0 = get_cell(min);
+		SpatialGridCell c1 = get_cell(max);
+		// coordinates are clamped to +-1e9, so the spans fit in long long but their product needs a double
+		double num_cells = double((long long)c1.x - c0.x + 1) * double((long long)c1.y - c0.y + 1) * double((long long)c1.z - c0.z + 1);
+
+		// large query areas are cheaper to resolve by scanning the occupied cells
+		if (num_cells > double(cells.size()))
+		{
+			for (int i = 0; i < cells.size(); i++)
+			{
+				const Cell &cell = cells[i];
+				if (cell.key.x < c0.x || cell.key.x > c1.x ||
+					cell.key.y < c0.y || cell.key.y > c1.y ||
+					cell.key.z < c0.z || cell.key.z > c1.z)
+					continue;
+				for (int j = 0; j < cell.entities.size(); j++)
+					func(cell.entities[j]);
+			}
+			return;
+		}
+
+		SpatialGridCell key;
+		for (key.z = c0.z; key.z <= c1.z; key.z++)
+		{
+			for (key.y = c0.y; key.y <= c1.y; key.y++)
+			{
+				for (key.x = c0.x; key.x <= c1.x; key.x++)
+				{
+					auto it = cell_map.find(key);
+					if (it == cell_map.end())
+						continue;
+					const Vector<int> &list = cells[it->data].entities;
+					for (int j = 0; j < list.size(); j++)
+						func(list[j]);
+				}
+			}
+		}
+	}
+
+	static void console_benchmark(int argc, char **argv)
+	{
+		String report;
+		if (argc > 1)
+			getBenchmarkReport(report, Math::max(atoi(argv[1]), 1));
+		else
+			getBenchmarkReport(report);
+		Log::message("%s", report.get());
+	}
+
+	static void append_benchmark_report(String &ret, int num);
+
+	float cell_size{16.0f};
+	float cell_height{0.0f};
+	float icell_size{1.0f / 16.0f};
+	float icell_height{0.0f};
+	float max_radius{0.0f};
+	int num_entities{0};
+
+	Vector<Entity> entities;
+	Vector<int> free_entities;
+	Vector<Cell> cells;
+	HashMap<SpatialGridCell, int> cell_map;
+
+	mutable RWMutex mutex;
+};
+
+inline void SpatialGrid::getBenchmarkReport(String &ret)
+{
+	ret.clear();
+	append_benchmark_report(ret, 1000);
+	append_benchmark_report(ret, 10000);
+	append_benchmark_report(ret, 100000);
+}
+
+inline void SpatialGrid::getBenchmarkReport(String &ret, int num)
+{
+	ret.clear();
+	append_benchmark_report(ret, num);
+}
+
+inline void SpatialGrid::append_benchmark_report(String &ret, int num)
+{
+	unsigned int state = 1;
+	auto random = [&state](float scale) { state = state * 1664525u + 1013904223u; return float(state >> 8) * (1.0f / 16777216.0f) * scale; };
+
+	// about 8 entities in a query
+	float world = Math::fsqrt(float(num)) * 20.0f;
+	SpatialGrid grid(16.0f);
+	Vector<Math::vec3> positions(num);
+	Vector<int> ids(num);
+	for (int i = 0; i < num; i++)
+	{
+		positions[i] = Math::vec3(random(world), random(world), 0.0f);
+		ids[i] = grid.add(positions[i], 2.0f);
+	}
+
+	auto begin = std::chrono::steady_clock::now();
+	for (int i = 0; i < num; i++)
+	{
+		positions[i] += Math::vec3(random(2.0f) - 1.0f, random(2.0f) - 1.0f, 0.0f);
+		grid.move(ids[i], positions[i]);
+	}
+	double move_time = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / num;
+
+	Vector<int> result;
+	long long num_found = 0;
+	begin = std::chrono::steady_clock::now();
+	for (int i = 0; i < num; i++)
+	{
+		result.clear();
+		num_found += grid.getEntities(positions[i], 30.0f, result);
+	}
+	double query_time = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / num;
+
+	begin = std::chrono::steady_clock::now();
+	grid.rebuild(positions.get(), num);
+	double rebuild_time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+	Format::append(ret, "{} entities, {} cells\n", num, grid.getNumCells());
+	Format::append(ret, "{:<10}{:8.1} ns\n", "move", move_time);
+	Format::append(ret, "{:<10}{:8.1} ns, {} found\n", "query", query_time, (long long)(num_found / num));
+	Format::append(ret, "{:<10}{:8.2} ms\n", "rebuild", rebuild_time);
+}
+
+} // namespace Unigine
@@ -0,0 +1,800 @@
+/* Copyright (C) 2005-2020, UNIGINE. All rights reserved.
+ *
+ * This file is a part of the UNIGINE 2 SDK.
+ *
+ * Your use and / or redistribution of this software in source and / or
+ * binary form, with or without modification, is subject to: (i) your
+ * ongoing acceptance of and compliance with the terms and conditions of
+ * the UNIGINE License Agreement; and (ii) your inclusion of this notice
+ * in any version of this software that you use or redistribute.
+ * A copy of the UNIGINE License Agreement is available by contacting
+ * UNIGINE. at http://unigine.com/
+ */
+
+
+#pragma once
+
+#include "UnigineBase.h"
+#include "UnigineStreams.h"
+#include "UnigineMathLib.h"
+#include "UnigineVector.h"
+#include "UnigineString.h"
+#include "UnigineFormat.h"
+#include "UnigineConsole.h"
+#include "UnigineCallback.h"
+#include "UnigineLog.h"
+#include <type_traits>
+#include <chrono>
+
+// Stream buffer example
+/*
+	int AppWorldLogic::save(const StreamPtr &stream)
+	{
+		StreamBufferWriter writer(stream);
+		writer.writeInt(positions.size());
+		writer.writeSpan(positions.get(), positions.size());	// POD array
+		writer.writeFloatArray(health.get(), health.size());
+		return writer.close();
+	}
+
+	int AppWorldLogic::restore(const StreamPtr &stream)
+	{
+		StreamBufferReader reader(stream);
+		positions.resize(reader.readInt());
+		reader.readSpan(positions.get(), positions.size());
+		...
+		return reader.close();	// File and Blob streams are moved back to the last read byte
+	}
+*/
+
+namespace Unigine
+{
+
+//////////////////////////////////////////////////////////////////////////
+/// Byte order helpers of the stream buffers.
+//////////////////////////////////////////////////////////////////////////
+
+class StreamBuffer
+{
+public:
+	enum
+	{
+		DEFAULT_CAPACITY = 64 * 1024,
+		MIN_CAPACITY = 256,
+	};
+
+	static constexpr int getHostOrder()
+	{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+		return STREAM_MSB;
+#else
+		return STREAM_LSB;
+#endif
+	}
+
+	// reverses the bytes of num elements of element_size (1, 2, 4 or 8) bytes, dest may be equal to src
+	static void swapBytes(void *dest, const void *src, size_t num, size_t element_size)
+	{
+		unsigned char *d = static_cast<unsigned char *>(dest);
+		const unsigned char *s = static_cast<const unsigned char *>(src);
+		if (element_size == 1)
+		{
+			if (d != s)
+				memmove(d, s, num);
+			return;
+		}
+
+		size_t size = num * element_size;
+		size_t i = 0;
+#ifdef USE_SSE2
+		for (; i + 16 <= size; i += 16)
+		{
+			__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+			if (element_size == 4)
+			{
+				v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+				v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+			} else if (element_size == 8)
+			{
+				v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+				v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+			}
+			v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(d + i), v);
+		}
+#endif
+		for (; i < size; i += element_size)
+		{
+			unsigned char element[8];
+			for (size_t j = 0; j < element_size; j++)
+				element[j] = s[i + element_size - 1 - j];
+			memcpy(d + i, element, element_size);
+		}
+	}
+
+	template <class Type>
+	static UNIGINE_INLINE Type swapValue(Type value)
+	{
+		static_assert(std::is_arithmetic<Type>::value, "StreamBuffer::swapValue(): arithmetic type is expected");
+		unsigned char bytes[sizeof(Type)];
+		memcpy(bytes, &value, sizeof(Type));
+		for (size_t i = 0; i < sizeof(Type) / 2; i++)
+		{
+			unsigned char b = bytes[i];
+			bytes[i] = bytes[sizeof(Type) - 1 - i];
+			bytes[sizeof(Type) - 1 - i] = b;
+		}
+		memcpy(&value, bytes, sizeof(Type));
+		return value;
+	}
+
+	// round trip time of a synthetic world state through the stream calls and through the buffers
+	static void getBenchmarkReport(String &ret, int num_objects = 100000);
+
+	// stream_buffer_benchmark [number of objects]
+	static void addConsoleCommands()
+	{
+		Console::addCommand("stream_buffer_benchmark", "prints the save and restore time of direct and buffered stream calls", MakeCallback(&StreamBuffer::console_benchmark));
+	}
+	static void removeConsoleCommands() { Console::removeCommand("stream_buffer_benchmark"); }
+
+private:
+	static void console_benchmark(int argc, char **argv)
+	{
+		int num = 100000;
+		if (argc > 1 && atoi(argv[1]) > 0)
+			num = atoi(argv[1]);
+		String report;
+		getBenchmarkReport(report, num);
+		Log::message("%s", report.get());
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// Buffered writer over any stream.
+///
+/// Values are written in the format of the Stream::write*() functions:
+/// scalars, vectors, quaternions and arrays in the selected byte order,
+/// matrices as 12 elements (three rows of each column, like dmat4::mat).
+/// The stream receives whole buffers only, so per-value calls cost a
+/// bounds check and a copy. The order is STREAM_LSB for the engine format.
+//////////////////////////////////////////////////////////////////////////
+
+class StreamBufferWriter
+{
+public:
+	StreamBufferWriter() = default;
+	StreamBufferWriter(const StreamPtr &stream, int order = STREAM_LSB, size_t capacity = StreamBuffer::DEFAULT_CAPACITY) { open(stream, order, capacity); }
+	~StreamBufferWriter() { close(); }
+
+	StreamBufferWriter(const StreamBufferWriter &) = delete;
+	StreamBufferWriter &operator=(const StreamBufferWriter &) = delete;
+
+	bool open(const StreamPtr &s, int order = STREAM_LSB, size_t capacity = StreamBuffer::DEFAULT_CAPACITY)
+	{
+		close();
+		if (!s || !s->isOpened())
+		{
+			Log::error("StreamBufferWriter::open(): stream is not opened\n");
+			return false;
+		}
+		if (capacity < StreamBuffer::MIN_CAPACITY)
+			capacity = StreamBuffer::MIN_CAPACITY;
+		stream = s;
+		swap = order != StreamBuffer::getHostOrder();
+		buffer.resize(int(capacity));
+		begin = buffer.get();
+		pos = begin;
+		end = begin + capacity;
+		written = 0;
+		failed = false;
+		return true;
+	}
+
+	// flushes the buffer and releases the stream
+	bool close()
+	{
+		if (!stream)
+			return !failed;
+		flush();
+		stream.clear();
+		buffer.destroy();
+		begin = pos = end = nullptr;
+		return !failed;
+	}
+
+	bool flush()
+	{
+		if (failed || pos == begin)
+			return !failed;
+		size_t size = size_t(pos - begin);
+		written += size;
+		if (stream->write(begin, size) != size)
+		{
+			Log::error("StreamBufferWriter::flush(): can't write %llu bytes\n", (unsigned long long)size);
+			failed = true;
+		}
+		pos = begin;
+		return !failed;
+	}
+
+	UNIGINE_INLINE bool isOpened() const { return stream.isValid(); }
+	UNIGINE_INLINE bool isFailed() const { return failed; }
+	UNIGINE_INLINE bool isSwapped() const { return swap; }
+	UNIGINE_INLINE size_t tell() const { return written + size_t(pos - begin); }
+
+	bool write(const void *data, size_t size)
+	{
+		if (size <= size_t(end - pos))
+		{
+			memcpy(pos, data, size);
+			pos += size;
+			return true;
+		}
+		if (!flush())
+			return false;
+		if (size < size_t(end - begin))
+		{
+			memcpy(pos, data, size);
+			pos += size;
+			return true;
+		}
+		// large blocks bypass the buffer
+		written += size;
+		if (stream->write(data, size) != size)
+		{
+			Log::error("StreamBufferWriter::write(): can't write %llu bytes\n", (unsigned long long)size);
+			failed = true;
+		}
+		return !failed;
+	}
+
+	UNIGINE_INLINE bool writeChar(char value) { return put(value); }
+	UNIGINE_INLINE bool writeUChar(unsigned char value) { return put(value); }
+	UNIGINE_INLINE bool writeBool(bool value) { return put((unsigned char)(value ? 1 : 0)); }
+	UNIGINE_INLINE bool writeShort(short value) { return put(value); }
+	UNIGINE_INLINE bool writeUShort(unsigned short value) { return put(value); }
+	UNIGINE_INLINE bool writeInt(int value) { return put(value); }
+	UNIGINE_INLINE bool writeUInt(unsigned int value) { return put(value); }
+	UNIGINE_INLINE bool writeLong(long long value) { return put(value); }
+	UNIGINE_INLINE bool writeFloat(float value) { return put(value); }
+	UNIGINE_INLINE bool writeDouble(double value) { return put(value); }
+
+	UNIGINE_INLINE bool writeVec2(const Math::vec2 &v) { const float f[2] = {v.x, v.y}; return put(f, 2); }
+	UNIGINE_INLINE bool writeVec3(const Math::vec3 &v) { const float f[3] = {v.x, v.y, v.z}; return put(f, 3); }
+	UNIGINE_INLINE bool writeVec4(const Math::vec4 &v) { const float f[4] = {v.x, v.y, v.z, v.w}; return put(f, 4); }
+	UNIGINE_INLINE bool writeDVec2(const Math::dvec2 &v) { const double f[2] = {v.x, v.y}; return put(f, 2); }
+	UNIGINE_INLINE bool writeDVec3(const Math::dvec3 &v) { const double f[3] = {v.x, v.y, v.z}; return put(f, 3); }
+	UNIGINE_INLINE bool writeDVec4(const Math::dvec4 &v) { const double f[4] = {v.x, v.y, v.z, v.w}; return put(f, 4); }
+	UNIGINE_INLINE bool writeIVec2(const Math::ivec2 &v) { const int f[2] = {v.x, v.y}; return put(f, 2); }
+	UNIGINE_INLINE bool writeIVec3(const Math::ivec3 &v) { const int f[3] = {v.x, v.y, v.z}; return put(f, 3); }
+	UNIGINE_INLINE bool writeIVec4(const Math::ivec4 &v) { const int f[4] = {v.x, v.y, v.z, v.w}; return put(f, 4); }
+	UNIGINE_INLINE bool writeQuat(const Math::quat &v) { const float f[4] = {v.x, v.y, v.z, v.w}; return put(f, 4); }
+
+	UNIGINE_INLINE bool writeMat4(const Math::mat4 &m)
+	{
+		const float f[12] = {m.m00, m.m10, m.m20, m.m01, m.m11, m.m21, m.m02, m.m12, m.m22, m.m03, m.m13, m.m23};
+		return put(f, 12);
+	}
+	UNIGINE_INLINE bool writeDMat4(const Math::dmat4 &m) { return put(m.mat, 12); }
+
+	// the engine format of strings, the buffer is flushed first
+	bool writeString(const char *str)
+	{
+		if (!flush())
+			return false;
+		size_t offset = stream_tell();
+		if (!stream->writeString(str))
+		{
+			Log::error("StreamBufferWriter::writeString(): can't write string\n");
+			failed = true;
+			return false;
+		}
+		written += offset != size_t(-1) ? stream_tell() - offset : strlen(str) + 4;
+		return true;
+	}
+
+	// arrays are swapped in bulk while copied to the buffer
+	UNIGINE_INLINE bool writeShortArray(const short *src, size_t num) { return write_array(src, num); }
+	UNIGINE_INLINE bool writeUShortArray(const unsigned short *src, size_t num) { return write_array(src, num); }
+	UNIGINE_INLINE bool writeIntArray(const int *src, size_t num) { return write_array(src, num); }
+	UNIGINE_INLINE bool writeUIntArray(const unsigned int *src, size_t num) { return write_array(src, num); }
+	UNIGINE_INLINE bool writeLongArray(const long long *src, size_t num) { return write_array(src, num); }
+	UNIGINE_INLINE bool writeFloatArray(const float *src, size_t num) { return write_array(src, num); }
+	UNIGINE_INLINE bool writeDoubleArray(const double *src, size_t num) { return write_array(src, num); }
+
+	// POD arrays, arithmetic types are swapped, structures are written as they are in memory
+	template <class Type>
+	bool writeSpan(const Type *src, size_t num)
+	{
+		static_assert(std::is_trivially_copyable<Type>::value, "StreamBufferWriter::writeSpan(): trivially copyable type is expected");
+		if (std::is_arithmetic<Type>::value)
+			return write_array(src, num);
+		return write(src, sizeof(Type) * num);
+	}
+
+private:
+	template <class Type>
+	UNIGINE_INLINE bool put(Type value)
+	{
+		if (size_t(end - pos) < sizeof(Type) && !flush())
+			return false;
+		if (swap)
+			value = StreamBuffer::swapValue(value);
+		memcpy(pos, &value, sizeof(Type));
+		pos += sizeof(Type);
+		return !failed;
+	}
+
+	template <class Type>
+	UNIGINE_INLINE bool put(const Type *values, size_t num)
+	{
+		if (size_t(end - pos) < sizeof(Type) * num && !flush())
+			return false;
+		if (swap)
+			StreamBuffer::swapBytes(pos, values, num, sizeof(Type));
+		else
+			memcpy(pos, values, sizeof(Type) * num);
+		pos += sizeof(Type) * num;
+		return !failed;
+	}
+
+	template <class Type>
+	bool write_array(const Type *src, size_t num)
+	{
+		if (!swap || sizeof(Type) == 1)
+			return write(src, sizeof(Type) * num);
+		while (num)
+		{
+			size_t count = size_t(end - pos) / sizeof(Type);
+			if (count == 0)
+			{
+				if (!flush())
+					return false;
+				continue;
+			}
+			if (count > num)
+				count = num;
+			StreamBuffer::swapBytes(pos, src, count, sizeof(Type));
+			pos += sizeof(Type) * count;
+			src += count;
+			num -= count;
+		}
+		return !failed;
+	}
+
+	size_t stream_tell() const
+	{
+		if (File::convertible(stream.get()))
+			return static_ptr_cast<File>(stream)->tell();
+		if (Blob::convertible(stream.get()))
+			return static_ptr_cast<Blob>(stream)->tell();
+		return size_t(-1);
+	}
+
+	StreamPtr stream;
+	Vector<unsigned char> buffer;
+	unsigned char *begin{nullptr};
+	unsigned char *pos{nullptr};
+	unsigned char *end{nullptr};
+	size_t written{0};
+	bool swap{false};
+	bool failed{false};
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// Buffered reader over any stream, the counterpart of StreamBufferWriter.
+///
+/// The stream is read ahead in whole buffers. close() moves File and
+/// Blob streams back to the first unread byte; other streams lose the
+/// read-ahead data, so keep the reader until the end of the data. A read
+/// past the end returns zeros and sets the failed flag.
+//////////////////////////////////////////////////////////////////////////
+
+class StreamBufferReader
+{
+public:
+	StreamBufferReader() = default;
+	StreamBufferReader(const StreamPtr &stream, int order = STREAM_LSB, size_t capacity = StreamBuffer::DEFAULT_CAPACITY) { open(stream, order, capacity); }
+	~StreamBufferReader() { close(); }
+
+	StreamBufferReader(const StreamBufferReader &) = delete;
+	StreamBufferReader &operator=(const StreamBufferReader &) = delete;
+
+	bool open(const StreamPtr &s, int order = STREAM_LSB, size_t capacity = StreamBuffer::DEFAULT_CAPACITY)
+	{
+		close();
+		if (!s || !s->isOpened())
+		{
+			Log::error("StreamBufferReader::open(): stream is not opened\n");
+			return false;
+		}
+		if (capacity < StreamBuffer::MIN_CAPACITY)
+			capacity = StreamBuffer::MIN_CAPACITY;
+		stream = s;
+		swap = order != StreamBuffer::getHostOrder();
+		buffer.resize(int(capacity));
+		begin = buffer.get();
+		pos = begin;
+		end = begin;
+		consumed = 0;
+		failed = false;
+		eof = false;
+		return true;
+	}
+
+	// returns the unread bytes to File and Blob streams and releases the stream
+	bool close()
+	{
+		if (!stream)
+			return !failed;
+		unread();
+		stream.clear();
+		buffer.destroy();
+		begin = pos = end = nullptr;
+		return !failed;
+	}
+
+	UNIGINE_INLINE bool isOpened() const { return stream.isValid(); }
+	UNIGINE_INLINE bool isFailed() const { return failed; }
+	UNIGINE_INLINE bool isSwapped() const { return swap; }
+	UNIGINE_INLINE size_t tell() const { return consumed - size_t(end - pos); }
+	bool isEnd()
+	{
+		return pos == end && !fill(1);
+	}
+
+	size_t read(void *data, size_t size)
+	{
+		unsigned char *dest = static_cast<unsigned char *>(data);
+		size_t ret = 0;
+		while (size)
+		{
+			size_t available = size_t(end - pos);
+			if (available)
+			{
+				size_t n = available < size ? available : size;
+				memcpy(dest, pos, n);
+				pos += n;
+				dest += n;
+				size -= n;
+				ret += n;
+				continue;
+			}
+			if (eof || failed)
+				break;
+			if (size >= size_t(buffer.size()))
+			{
+				// large blocks bypass the buffer
+				size_t n = stream->read(dest, size);
+				consumed += n;
+				ret += n;
+				if (n < size)
+					eof = true;
+				size -= n;
+				break;
+			}
+			if (!fill(1))
+				break;
+		}
+		if (size)
+			failed = true;
+		return ret;
+	}
+
+	UNIGINE_INLINE char readChar() { return get<char>(); }
+	UNIGINE_INLINE unsigned char readUChar() { return get<unsigned char>(); }
+	UNIGINE_INLINE bool readBool() { return get<unsigned char>() != 0; }
+	UNIGINE_INLINE short readShort() { return get<short>(); }
+	UNIGINE_INLINE unsigned short readUShort() { return get<unsigned short>(); }
+	UNIGINE_INLINE int readInt() { return get<int>(); }
+	UNIGINE_INLINE unsigned int readUInt() { return get<unsigned int>(); }
+	UNIGINE_INLINE long long readLong() { return get<long long>(); }
+	UNIGINE_INLINE float readFloat() { return get<float>(); }
+	UNIGINE_INLINE double readDouble() { return get<double>(); }
+
+	UNIGINE_INLINE Math::vec2 readVec2() { float f[2]; get(f, 2); return Math::vec2(f[0], f[1]); }
+	UNIGINE_INLINE Math::vec3 readVec3() { float f[3]; get(f, 3); return Math::vec3(f[0], f[1], f[2]); }
+	UNIGINE_INLINE Math::vec4 readVec4() { float f[4]; get(f, 4); return Math::vec4(f[0], f[1], f[2], f[3]); }
+	UNIGINE_INLINE Math::dvec2 readDVec2() { double f[2]; get(f, 2); return Math::dvec2(f[0], f[1]); }
+	UNIGINE_INLINE Math::dvec3 readDVec3() { double f[3]; get(f, 3); return Math::dvec3(f[0], f[1], f[2]); }
+	UNIGINE_INLINE Math::dvec4 readDVec4() { double f[4]; get(f, 4); return Math::dvec4(f[0], f[1], f[2], f[3]); }
+	UNIGINE_INLINE Math::ivec2 readIVec2() { int f[2]; get(f, 2); return Math::ivec2(f[0], f[1]); }
+	UNIGINE_INLINE Math::ivec3 readIVec3() { int f[3]; get(f, 3); return Math::ivec3(f[0], f[1], f[2]); }
+	UNIGINE_INLINE Math::ivec4 readIVec4() { int f[4]; get(f, 4); return Math::ivec4(f[0], f[1], f[2], f[3]); }
+	UNIGINE_INLINE Math::quat readQuat() { float f[4]; get(f, 4); return Math::quat(f[0], f[1], f[2], f[3]); }
+
+	UNIGINE_INLINE Math::mat4 readMat4()
+	{
+		float f[12];
+		get(f, 12);
+		Math::mat4 m;
+		m.m00 = f[0]; m.m10 = f[1]; m.m20 = f[2]; m.m30 = 0.0f;
+		m.m01 = f[3]; m.m11 = f[4]; m.m21 = f[5]; m.m31 = 0.0f;
+		m.m02 = f[6]; m.m12 = f[7]; m.m22 = f[8]; m.m32 = 0.0f;
+		m.m03 = f[9]; m.m13 = f[10]; m.m23 = f[11]; m.m33 = 1.0f;
+		return m;
+	}
+	UNIGINE_INLINE Math::dmat4 readDMat4()
+	{
+		Math::dmat4 m;
+		get(m.mat, 12);
+		return m;
+	}
+
+	// the engine format of strings, File and Blob streams only
+	String readString()
+	{
+		if (failed || !unread())
+		{
+			failed = true;
+			return String();
+		}
+		size_t offset = stream_tell();
+		String ret = stream->readString();
+		consumed += stream_tell() - offset;
+		return ret;
+	}
+
+	UNIGINE_INLINE bool readShortArray(short *dest, size_t num) { return read_array(dest, num); }
+	UNIGINE_INLINE bool readUShortArray(unsigned short *dest, size_t num) { return read_array(dest, num); }
+	UNIGINE_INLINE bool readIntArray(int *dest, size_t num) { return read_array(dest, num); }
+	UNIGINE_INLINE bool readUIntArray(unsigned int *dest, size_t num) { return read_array(dest, num); }
+	UNIGINE_INLINE bool readLongArray(long long *dest, size_t num) { return read_array(dest, num); }
+	UNIGINE_INLINE bool readFloatArray(float *dest, size_t num) { return read_array(dest, num); }
+	UNIGINE_INLINE bool readDoubleArray(double *dest, size_t num) { return read_array(dest, num); }
+
+	template <class Type>
+	bool readSpan(Type *dest, size_t num)
+	{
+		static_assert(std::is_trivially_copyable<Type>::value, "StreamBufferReader::readSpan(): trivially copyable type is expected");
+		if (std::is_arithmetic<Type>::value)
+			return read_array(dest, num);
+		return read(dest, sizeof(Type) * num) == sizeof(Type) * num;
+	}
+
+private:
+	// at least size bytes in the buffer
+	bool fill(size_t size)
+	{
+		size_t available = size_t(end - pos);
+		if (available >= size)
+			return true;
+		if (eof || failed)
+			return false;
+		memmove(begin, pos, available);
+		pos = begin;
+		end = begin + available;
+		size_t capacity = size_t(buffer.size());
+		while (size_t(end - begin) < size)
+		{
+			size_t n = stream->read(end, capacity - size_t(end - begin));
+			if (n == 0)
+			{
+				eof = true;
+				return false;
+			}
+			end += n;
+			consumed += n;
+		}
+		return true;
+	}
+
+	template <class Type>
+	UNIGINE_INLINE Type get()
+	{
+		if (size_t(end - pos) < sizeof(Type) && !fill(sizeof(Type)))
+		{
+			failed = true;
+			pos = end;
+			return Type();
+		}
+		Type value;
+		memcpy(&value, pos, sizeof(Type));
+		pos += sizeof(Type);
+		return swap ? StreamBuffer::swapValue(value) : value;
+	}
+
+	template <class Type>
+	UNIGINE_INLINE void get(Type *values, size_t num)
+	{
+		if (size_t(end - pos) < sizeof(Type) * num && !fill(sizeof(Type) * num))
+		{
+			failed = true;
+			pos = end;
+			memset(values, 0, sizeof(Type) * num);
+			return;
+		}
+		if (swap)
+			StreamBuffer::swapBytes(values, pos, num, sizeof(Type));
+		else
+			memcpy(values, pos, sizeof(Type) * num);
+		pos += sizeof(Type) * num;
+	}
+
+	template <class Type>
+	bool read_array(Type *dest, size_t num)
+	{
+		size_t size = sizeof(Type) * num;
+		if (read(dest, size) != size)
+			return false;
+		if (swap && sizeof(Type) > 1)
+			StreamBuffer::swapBytes(dest, dest, num, sizeof(Type));
+		return true;
+	}
+
+	size_t stream_tell() const
+	{
+		if (File::convertible(stream.get()))
+			return static_ptr_cast<File>(stream)->tell();
+		if (Blob::convertible(stream.get()))
+			return static_ptr_cast<Blob>(stream)->tell();
+		return size_t(-1);
+	}
+
+	// moves the stream back to the first unread byte and drops the buffer
+	bool unread()
+	{
+		size_t available = size_t(end - pos);
+		pos = end = begin;
+		eof = false;
+		if (available == 0)
+			return true;
+		size_t offset = stream_tell();
+		bool ret = false;
+		if (offset != size_t(-1))
+		{
+			if (File::convertible(stream.get()))
+				ret = static_ptr_cast<File>(stream)->seekSet(offset - available) != 0;
+			else
+				ret = static_ptr_cast<Blob>(stream)->seekSet(offset - available) != 0;
+		}
+		if (!ret)
+			Log::error("StreamBufferReader::unread(): can't return %llu bytes to the stream\n", (unsigned long long)available);
+		consumed -= available;
+		return ret;
+	}
+
+	StreamPtr stream;
+	Vector<unsigned char> buffer;
+	unsigned char *begin{nullptr};
+	unsigned char *pos{nullptr};
+	unsigned char *end{nullptr};
+	size_t consumed{0};
+	bool swap{false};
+	bool failed{false};
+	bool eof{false};
+};
+
+inline void StreamBuffer::getBenchmarkReport(String &ret, int num_objects)
+{
+	// a typical per object state
+	struct Object
+	{
+		int id;
+		Math::mat4 transform;
+		Math::vec3 velocity;
+		Math::quat rotation;
+		float health;
+		short flags;
+		float weights[16];
+	};
+
+	Vector<Object> objects;
+	objects.resize(num_objects);
+	for (int i = 0; i < num_objects; i++)
+	{
+		Object &o = objects[i];
+		o.id = i;
+		o.transform = Math::mat4_identity;
+		o.transform.setColumn3(3, Math::vec3(float(i), 1.0f, 2.0f));
+		o.velocity = Math::vec3(float(i) * 0.5f, 0.0f, -1.0f);
+		o.rotation = Math::quat(0.0f, 0.0f, 0.0f, 1.0f);
+		o.health = 100.0f - float(i % 100);
+		o.flags = short(i & 0x7fff);
+		for (int j = 0; j < 16; j++)
+			o.weights[j] = float(i + j);
+	}
+	Vector<Object> restored;
+	restored.resize(num_objects);
+
+	using Clock = std::chrono::steady_clock;
+	auto milliseconds = [](Clock::time_point begin) { return std::chrono::duration<double, std::milli>(Clock::now() - begin).count(); };
+
+	auto save_direct = [&](const StreamPtr &stream)
+	{
+		stream->writeInt(num_objects);
+		for (const Object &o : objects)
+		{
+			stream->writeInt(o.id);
+			stream->writeMat4(o.transform);
+			stream->writeVec3(o.velocity);
+			stream->writeQuat(o.rotation);
+			stream->writeFloat(o.health);
+			stream->writeShort(o.flags);
+			stream->writeFloatArray(o.weights, 16);
+		}
+	};
+	auto restore_direct = [&](const StreamPtr &stream)
+	{
+		int num = stream->readInt();
+		for (int i = 0; i < num && i < restored.size(); i++)
+		{
+			Object &o = restored[i];
+			o.id = stream->readInt();
+			o.transform = stream->readMat4();
+			o.velocity = stream->readVec3();
+			o.rotation = stream->readQuat();
+			o.health = stream->readFloat();
+			o.flags = stream->readShort();
+			stream->readFloatArray(o.weights, 16);
+		}
+	};
+	auto save_buffered = [&](const StreamPtr &stream, int order)
+	{
+		StreamBufferWriter writer(stream, order);
+		writer.writeInt(num_objects);
+		for (const Object &o : objects)
+		{
+			writer.writeInt(o.id);
+			writer.writeMat4(o.transform);
+			writer.writeVec3(o.velocity);
+			writer.writeQuat(o.rotation);
+			writer.writeFloat(o.health);
+			writer.writeShort(o.flags);
+			writer.writeFloatArray(o.weights, 16);
+		}
+		writer.close();
+	};
+	auto restore_buffered = [&](const StreamPtr &stream, int order)
+	{
+		StreamBufferReader reader(stream, order);
+		int num = reader.readInt();
+		for (int i = 0; i < num && i < restored.size(); i++)
+		{
+			Object &o = restored[i];
+			o.id = reader.readInt();
+			o.transform = reader.readMat4();
+			o.velocity = reader.readVec3();
+			o.rotation = reader.readQuat();
+			o.health = reader.readFloat();
+			o.flags = reader.readShort();
+			reader.readFloatArray(o.weights, 16);
+		}
+		reader.close();
+	};
+
+	auto run = [&](const char *name, const Function<void(const StreamPtr &)> &save, const Function<void(const StreamPtr &)> &restore)
+	{
+		double best_save = 1e30;
+		double best_restore = 1e30;
+		size_t size = 0;
+		// the first run grows the blob, the best time excludes the allocation
+		BlobPtr blob = Blob::create();
+		for (int i = 0; i < 4; i++)
+		{
+			blob->seekSet(0);
+			Clock::time_point begin = Clock::now();
+			save(blob);
+			double t = milliseconds(begin);
+			best_save = t < best_save ? t : best_save;
+			size = blob->getSize();
+
+			blob->seekSet(0);
+			begin = Clock::now();
+			restore(blob);
+			t = milliseconds(begin);
+			best_restore = t < best_restore ? t : best_restore;
+		}
+		bool equal = restored.size() == objects.size() && restored.last().id == objects.last().id && restored.last().health == objects.last().health;
+		Format::append(ret, "{:<20}{:10.2} ms {:10.2} ms {:12} bytes{}\n", name, best_save, best_restore, (unsigned long long)size, equal ? "" : "  mismatch");
+	};
+
+	ret.clear();
+	Format::append(ret, "{} objects                save    restore\n", num_objects);
+	run("Stream", save_direct, restore_direct);
+	run("StreamBuffer", [&](const StreamPtr &s) { save_buffered(s, STREAM_LSB); }, [&](const StreamPtr &s) { restore_buffered(s, STREAM_LSB); });
+	run("StreamBuffer MSB", [&](const StreamPtr &s) { save_buffered(s, STREAM_MSB); }, [&](const StreamPtr &s) { restore_buffered(s, STREAM_MSB); });
+}
+
+} // namespace Unigine
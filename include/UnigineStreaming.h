@@ -0,0 +1,788 @@
+/* Copyright (C) 2005-2020, UNIGINE. All rights reserved.
+ *
+ * This file is a part of the UNIGINE 2 SDK.
+ *
+ * Your use and / or redistribution of this software in source and / or
+ * binary form, with or without modification, is subject to: (i) your
+ * ongoing acceptance of and compliance with the terms and conditions of
+ * the UNIGINE License Agreement; and (ii) your inclusion of this notice
+ * in any version of this software that you use or redistribute.
+ * A copy of the UNIGINE License Agreement is available by contacting
+ * UNIGINE. at http://unigine.com/
+ */
+
+
+#pragma once
+
+#include "UnigineAsyncQueue.h"
+#include "UnigineCallback.h"
+#include "UnigineHashMap.h"
+#include "UnigineSort.h"
+#include "UnigineImage.h"
+#include "UnigineMesh.h"
+#include "UnigineNode.h"
+#include "UnigineStreams.h"
+#include "UnigineStringId.h"
+
+// Streaming example
+/*
+	// AppSystemLogic::init()
+	Unigine::StreamingManager::setMemoryBudget(512 * 1024 * 1024);
+
+	// AppSystemLogic::update()
+	Unigine::StreamingManager::update();
+
+	// the node is queued after its meshes are loaded
+	int meshes[2] = {
+		StreamingManager::request(StreamingManager::TYPE_MESH, "tank/hull.mesh", StreamingManager::PRIORITY_HIGH),
+		StreamingManager::request(StreamingManager::TYPE_MESH, "tank/turret.mesh", StreamingManager::PRIORITY_HIGH),
+	};
+	tank_id = StreamingManager::request(StreamingManager::TYPE_NODE, "tank/tank.node", StreamingManager::PRIORITY_HIGH, meshes, 2);
+	StreamingManager::release(meshes[0]);	// the tank holds them now
+	StreamingManager::release(meshes[1]);
+	StreamingManager::addCallback(tank_id, [this](int id, StreamingManager::STATE state)
+	{
+		if (state == StreamingManager::STATE_LOADED)
+			tank = StreamingManager::takeNode(id);
+	});
+
+	// the tank came close
+	StreamingManager::setPriority(tank_id, StreamingManager::PRIORITY_CRITICAL);
+
+	// the tank is not needed anymore, its meshes may be evicted
+	StreamingManager::release(tank_id);
+*/
+
+namespace Unigine
+{
+
+//////////////////////////////////////////////////////////////////////////
+/// Prioritized streaming over AsyncQueue.
+///
+/// AsyncQueue fixes the order of a request when it is submitted, so the
+/// manager holds requests in its own queue and hands at most
+/// getMaxLoading() of them to AsyncQueue at a time, highest priority
+/// first. Priorities can change until the request is submitted; raising a
+/// request to PRIORITY_CRITICAL forces an already submitted one.
+///
+/// Requests are reference counted by type and name: requesting the same
+/// resource again returns the same id. Names are interned as StringId and
+/// stay in its table after the request is gone. Released loaded resources
+/// stay cached until the memory budget needs their space, least recently
+/// released first. A request with dependencies holds references on them
+/// and is submitted after all of them are loaded, it fails when one of
+/// them fails.
+///
+/// Callbacks are called from update() on the main thread. All functions
+/// must be called from the main thread.
+//////////////////////////////////////////////////////////////////////////
+
+class StreamingManager
+{
+public:
+	enum TYPE
+	{
+		TYPE_FILE = 0,
+		TYPE_IMAGE,
+		TYPE_MESH,
+		TYPE_NODE,
+		NUM_TYPES,
+	};
+
+	enum PRIORITY
+	{
+		PRIORITY_CRITICAL = 0,	// ignores the memory budget
+		PRIORITY_HIGH,
+		PRIORITY_NORMAL,
+		PRIORITY_LOW,
+		PRIORITY_PREFETCH,
+		NUM_PRIORITIES,
+	};
+
+	enum STATE
+	{
+		STATE_NONE = 0,	// unknown id
+		STATE_WAITING,	// waits for dependencies
+		STATE_QUEUED,	// waits for a free loading slot or memory
+		STATE_LOADING,	// submitted to AsyncQueue
+		STATE_LOADED,
+		STATE_FAILED,
+		STATE_CANCELED,
+	};
+
+	using Callback = Function<void(int id, STATE state)>;
+
+	// returns the request id with a new reference, size_hint is the expected size in bytes,
+	// files and nodes without a hint are costed at their file size
+	static int request(TYPE type, const char *name, PRIORITY priority = PRIORITY_NORMAL,
+		const int *dependencies = nullptr, int num_dependencies = 0, size_t size_hint = 0)
+	{
+		State &state = get_state();
+
+		StringId key(name);
+		auto it = state.names[type].find(key);
+		if (it != state.names[type].end())
+		{
+			Request *r = it->data;
+			if (r->refcount++ == 0 && r->state == STATE_LOADED)
+				lru_remove(r);
+			if (r->state == STATE_FAILED || r->state == STATE_CANCELED)
+				restart(r);
+			for (int i = 0; i < num_dependencies; i++)
+				addDependency(r->id, dependencies[i]);
+			raise_priority(r, priority);
+			return r->id;
+		}
+
+		Request *r = new Request();
+		r->id = ++state.last_id;
+		r->type = type;
+		r->name = key;
+		r->priority = priority;
+		r->size_hint = size_hint;
+		if (size_hint == 0 && (type == TYPE_FILE || type == TYPE_NODE))
+			r->size_hint = get_file_size(name);
+		r->refcount = 1;
+		state.requests.append(r->id, r);
+		state.names[type].append(key, r);
+
+		for (int i = 0; i < num_dependencies; i++)
+			add_dependency(r, dependencies[i]);
+		enqueue(r);
+		return r->id;
+	}
+
+	// the request is submitted after the dependency is loaded
+	static bool addDependency(int id, int dependency)
+	{
+		Request *r = find(id);
+		if (r == nullptr || (r->state != STATE_WAITING && r->state != STATE_QUEUED))
+			return false;
+		if (!add_dependency(r, dependency))
+			return false;
+		if (r->state == STATE_QUEUED)
+		{
+			dequeue(r);
+			enqueue(r);
+		}
+		return true;
+	}
+
+	static void addReference(int id)
+	{
+		Request *r = find(id);
+		if (r && r->refcount++ == 0 && r->state == STATE_LOADED)
+			lru_remove(r);
+	}
+
+	// a loaded resource without references may be evicted, an unloaded one is canceled
+	static void release(int id)
+	{
+		Request *r = find(id);
+		if (r == nullptr || r->refcount == 0)
+			return;
+		if (--r->refcount > 0)
+			return;
+		if (r->state == STATE_LOADED)
+			lru_append(r);
+		else
+			destroy(r);
+	}
+
+	// cancels the loading and the requests depending on it, references stay valid
+	static void cancel(int id)
+	{
+		Request *r = find(id);
+		if (r && (r->state == STATE_WAITING || r->state == STATE_QUEUED || r->state == STATE_LOADING))
+			finish(r, STATE_CANCELED);
+	}
+
+	static void setPriority(int id, PRIORITY priority)
+	{
+		Request *r = find(id);
+		if (r == nullptr)
+			return;
+		// lowering affects requests not submitted yet
+		if (priority > r->priority)
+		{
+			if (r->state == STATE_WAITING || r->state == STATE_QUEUED)
+				r->priority = priority;
+			if (r->state == STATE_QUEUED)
+				state_changed();
+		} else
+			raise_priority(r, priority);
+	}
+	static PRIORITY getPriority(int id)
+	{
+		Request *r = find(id);
+		return r ? r->priority : PRIORITY_NORMAL;
+	}
+
+	static STATE getState(int id)
+	{
+		Request *r = find(id);
+		return r ? r->state : STATE_NONE;
+	}
+	static bool isReady(int id) { return getState(id) == STATE_LOADED; }
+	static bool isDone(int id)
+	{
+		STATE s = getState(id);
+		return s == STATE_LOADED || s == STATE_FAILED || s == STATE_CANCELED || s == STATE_NONE;
+	}
+
+	// measured size of a loaded resource or the size hint
+	static size_t getSize(int id)
+	{
+		Request *r = find(id);
+		return r ? (r->state == STATE_LOADED ? r->size : r->size_hint) : 0;
+	}
+
+	// called once from update() when the request is loaded, fails or is canceled,
+	// immediately on the next update() if it is already done
+	static void addCallback(int id, Callback &&callback)
+	{
+		Request *r = find(id);
+		if (r == nullptr)
+			return;
+		r->callbacks.append(std::move(callback));
+		if (r->state == STATE_LOADED || r->state == STATE_FAILED || r->state == STATE_CANCELED)
+			notify(r);
+	}
+
+	// resources stay owned by AsyncQueue
+	static Ptr<Image> getImage(int id)
+	{
+		Request *r = find(id);
+		return r && r->type == TYPE_IMAGE && r->state == STATE_LOADED ? AsyncQueue::getImage(r->async_id) : Ptr<Image>();
+	}
+	static Ptr<Mesh> getMesh(int id)
+	{
+		Request *r = find(id);
+		return r && r->type == TYPE_MESH && r->state == STATE_LOADED ? AsyncQueue::getMesh(r->async_id) : Ptr<Mesh>();
+	}
+	static Ptr<Node> getNode(int id)
+	{
+		Request *r = find(id);
+		return r && r->type == TYPE_NODE && r->state == STATE_LOADED && !r->taken ? AsyncQueue::getNode(r->async_id) : Ptr<Node>();
+	}
+
+	// moves the node to the caller, it is not counted in the budget anymore
+	static Ptr<Node> takeNode(int id)
+	{
+		Request *r = find(id);
+		if (r == nullptr || r->type != TYPE_NODE || r->state != STATE_LOADED || r->taken)
+			return Ptr<Node>();
+		State &state = get_state();
+		r->taken = 1;
+		state.loaded_bytes -= r->size;
+		r->size = 0;
+		return AsyncQueue::takeNode(r->async_id);
+	}
+
+	// settings
+	static void setMemoryBudget(size_t bytes) { get_state().budget = bytes; }	// 0 is unlimited
+	static size_t getMemoryBudget() { return get_state().budget; }
+	static void setMaxLoading(int num) { get_state().max_loading = num > 1 ? num : 1; }
+	static int getMaxLoading() { return get_state().max_loading; }
+	static void setGroup(int group) { get_state().group = group; }	// AsyncQueue group of new submissions
+	static int getGroup() { return get_state().group; }
+
+	// statistics
+	static size_t getLoadedBytes() { return get_state().loaded_bytes; }
+	static size_t getLoadingBytes() { return get_state().loading_bytes; }
+	static int getNumRequests() { return get_state().requests.size(); }
+	static int getNumQueued() { return get_state().queue.size(); }
+	static int getNumLoading() { return get_state().loading.size(); }
+	static int getNumEvictable() { return get_state().num_evictable; }
+
+	// call once per frame
+	static void update()
+	{
+		State &state = get_state();
+
+		// completed loads
+		for (int i = state.loading.size() - 1; i >= 0; i--)
+		{
+			Request *r = state.loading[i];
+			if (check(r))
+				complete(r);
+		}
+
+		// callbacks can request and release, the list is swapped first
+		while (state.notify.size())
+		{
+			Vector<int> notify;
+			notify.swap(state.notify);
+			for (int i = 0; i < notify.size(); i++)
+			{
+				Request *r = find(notify[i]);
+				if (r == nullptr)
+					continue;
+				r->notify = 0;
+				Vector<Callback> callbacks;
+				callbacks.swap(r->callbacks);
+				STATE s = r->state;
+				for (int j = 0; j < callbacks.size(); j++)
+					callbacks[j](notify[i], s);
+			}
+		}
+
+		if (state.budget && state.loaded_bytes > state.budget)
+			evict(state.loaded_bytes - state.budget);
+
+		submit();
+	}
+
+	// cancels and frees everything, ids become invalid
+	static void clear()
+	{
+		State &state = get_state();
+		for (auto it = state.requests.begin(); it != state.requests.end(); ++it)
+		{
+			Request *r = it->data;
+			if (r->state == STATE_LOADING || r->state == STATE_LOADED)
+				remove_async(r);
+			delete r;
+		}
+		state.requests.clear();
+		for (int i = 0; i < NUM_TYPES; i++)
+			state.names[i].clear();
+		state.queue.clear();
+		state.loading.clear();
+		state.notify.clear();
+		state.lru_head = nullptr;
+		state.lru_tail = nullptr;
+		state.num_evictable = 0;
+		state.loaded_bytes = 0;
+		state.loading_bytes = 0;
+	}
+
+private:
+	struct Request
+	{
+		int id{0};
+		TYPE type{TYPE_FILE};
+		PRIORITY priority{PRIORITY_NORMAL};
+		STATE state{STATE_NONE};
+		StringId name;
+
+		int refcount{0};
+		int async_id{-1};
+		int order{0};			// submission order inside a priority
+		int taken{0};
+		int notify{0};
+		int waiting{0};			// dependencies not loaded yet
+		size_t size{0};
+		size_t size_hint{0};
+
+		Vector<int> dependencies;	// referenced by this request
+		Vector<int> dependents;
+		Vector<Callback> callbacks;
+
+		Request *lru_prev{nullptr};	// released loaded requests
+		Request *lru_next{nullptr};
+	};
+
+	struct State
+	{
+		~State()
+		{
+			for (auto it = requests.begin(); it != requests.end(); ++it)
+				delete it->data;
+		}
+
+		HashMap<int, Request *> requests;
+		HashMap<StringId, Request *> names[NUM_TYPES]; // interned, a lookup hashes the name once
+		Vector<Request *> queue;	// STATE_QUEUED
+		Vector<Request *> loading;	// STATE_LOADING
+		Vector<int> notify;
+		int queue_sorted{1};
+
+		Request *lru_head{nullptr};
+		Request *lru_tail{nullptr};
+		int num_evictable{0};
+
+		size_t budget{0};
+		size_t loaded_bytes{0};
+		size_t loading_bytes{0};
+		int max_loading{4};
+		int group{0};
+		int last_id{0};
+		int last_order{0};
+	};
+
+	static State &get_state()
+	{
+		static State state;
+		return state;
+	}
+
+	// 0 if the file can't be opened
+	static size_t get_file_size(const char *name)
+	{
+		FilePtr file = File::create(name, "rb");
+		if (!file || !file->isOpened())
+			return 0;
+		return file->getSize();
+	}
+
+	static Request *find(int id)
+	{
+		State &state = get_state();
+		auto it = state.requests.find(id);
+		return it != state.requests.end() ? it->data : nullptr;
+	}
+
+	static void state_changed() { get_state().queue_sorted = 0; }
+
+	static bool add_dependency(Request *r, int dependency)
+	{
+		Request *d = find(dependency);
+		if (d == nullptr || d == r || r->dependencies.contains(dependency))
+			return false;
+		if (d->refcount++ == 0 && d->state == STATE_LOADED)
+			lru_remove(d);
+		r->dependencies.append(dependency);
+		d->dependents.append(r->id);
+		raise_priority(d, r->priority);
+		if (d->state == STATE_FAILED || d->state == STATE_CANCELED)
+			restart(d);
+		if (d->state != STATE_LOADED)
+			r->waiting++;
+		return true;
+	}
+
+	// dependencies load at least with the priority of their dependents
+	static void raise_priority(Request *r, PRIORITY priority)
+	{
+		if (priority >= r->priority)
+			return;
+		r->priority = priority;
+		if (r->state == STATE_QUEUED)
+			state_changed();
+		else if (r->state == STATE_LOADING && priority == PRIORITY_CRITICAL)
+			force_async(r);
+		for (int i = 0; i < r->dependencies.size(); i++)
+		{
+			Request *d = find(r->dependencies[i]);
+			if (d)
+				raise_priority(d, priority);
+		}
+	}
+
+	static void enqueue(Request *r)
+	{
+		State &state = get_state();
+		if (r->waiting)
+		{
+			r->state = STATE_WAITING;
+			return;
+		}
+		r->state = STATE_QUEUED;
+		r->order = ++state.last_order;
+		state.queue.append(r);
+		state_changed();
+	}
+
+	static void dequeue(Request *r)
+	{
+		State &state = get_state();
+		if (r->state == STATE_QUEUED)
+		{
+			int index = state.queue.findIndex(r);
+			if (index != -1)
+				state.queue.remove(index);
+		} else if (r->state == STATE_LOADING)
+		{
+			int index = state.loading.findIndex(r);
+			if (index != -1)
+				state.loading.removeFast(index);
+			state.loading_bytes -= r->size_hint;
+			remove_async(r);
+		}
+	}
+
+	static void restart(Request *r)
+	{
+		r->waiting = 0;
+		for (int i = 0; i < r->dependencies.size(); i++)
+		{
+			Request *d = find(r->dependencies[i]);
+			if (d && (d->state == STATE_FAILED || d->state == STATE_CANCELED))
+				restart(d);
+			if (d && d->state != STATE_LOADED)
+				r->waiting++;
+		}
+		enqueue(r);
+	}
+
+	static void notify(Request *r)
+	{
+		if (r->notify || r->callbacks.empty())
+			return;
+		r->notify = 1;
+		get_state().notify.append(r->id);
+	}
+
+	// loaded, failed or canceled
+	static void finish(Request *r, STATE s)
+	{
+		dequeue(r);
+		r->state = s;
+		notify(r);
+
+		for (int i = 0; i < r->dependents.size(); i++)
+		{
+			Request *d = find(r->dependents[i]);
+			if (d == nullptr || d->state != STATE_WAITING)
+				continue;
+			if (s == STATE_LOADED)
+			{
+				if (--d->waiting == 0)
+					enqueue(d);
+			} else
+				finish(d, STATE_FAILED);
+		}
+	}
+
+	static void destroy(Request *r)
+	{
+		State &state = get_state();
+		if (r->state == STATE_LOADED)
+		{
+			state.loaded_bytes -= r->size;
+			remove_async(r);
+		} else
+			dequeue(r);
+
+		for (int i = 0; i < r->dependents.size(); i++)
+		{
+			Request *d = find(r->dependents[i]);
+			if (d)
+				d->dependencies.removeOne(r->id);
+		}
+
+		state.requests.remove(r->id);
+		state.names[r->type].remove(r->name);
+
+		// references held by the request
+		Vector<int> dependencies;
+		dependencies.swap(r->dependencies);
+		int id = r->id;
+		delete r;
+		for (int i = 0; i < dependencies.size(); i++)
+		{
+			Request *d = find(dependencies[i]);
+			if (d)
+				d->dependents.removeOne(id);
+			release(dependencies[i]);
+		}
+	}
+
+	// LRU of released loaded requests
+	static void lru_append(Request *r)
+	{
+		State &state = get_state();
+		r->lru_prev = state.lru_tail;
+		r->lru_next = nullptr;
+		if (state.lru_tail)
+			state.lru_tail->lru_next = r;
+		else
+			state.lru_head = r;
+		state.lru_tail = r;
+		state.num_evictable++;
+	}
+
+	static void lru_remove(Request *r)
+	{
+		State &state = get_state();
+		if (r->lru_prev)
+			r->lru_prev->lru_next = r->lru_next;
+		else
+			state.lru_head = r->lru_next;
+		if (r->lru_next)
+			r->lru_next->lru_prev = r->lru_prev;
+		else
+			state.lru_tail = r->lru_prev;
+		r->lru_prev = nullptr;
+		r->lru_next = nullptr;
+		state.num_evictable--;
+	}
+
+	// frees at least the given number of bytes if possible, returns the freed size
+	static size_t evict(size_t bytes)
+	{
+		State &state = get_state();
+		size_t freed = 0;
+		while (freed < bytes && state.lru_head)
+		{
+			Request *r = state.lru_head;
+			lru_remove(r);
+			freed += r->size;
+			destroy(r);
+		}
+		return freed;
+	}
+
+	static void submit()
+	{
+		State &state = get_state();
+		if (state.queue.empty() || state.loading.size() >= state.max_loading)
+			return;
+
+		if (!state.queue_sorted)
+		{
+			quickSort(state.queue.get(), state.queue.size(), [](const Request *r0, const Request *r1)
+			{
+				if (r0->priority != r1->priority)
+					return r0->priority < r1->priority;
+				return r0->order < r1->order;
+			});
+			state.queue_sorted = 1;
+		}
+
+		int num = 0;
+		while (num < state.queue.size() && state.loading.size() < state.max_loading)
+		{
+			Request *r = state.queue[num];
+			size_t required = state.loaded_bytes + state.loading_bytes + r->size_hint;
+			if (state.budget && r->priority != PRIORITY_CRITICAL && required > state.budget)
+			{
+				evict(required - state.budget);
+				// lower priorities don't overtake, an oversized request is loaded alone
+				if (state.loaded_bytes + state.loading_bytes + r->size_hint > state.budget &&
+					state.loaded_bytes + state.loading_bytes > 0)
+					break;
+			}
+
+			num++;
+			if (!load_async(r))
+			{
+				r->state = STATE_NONE;
+				finish(r, STATE_FAILED);
+				continue;
+			}
+			r->state = STATE_LOADING;
+			state.loading.append(r);
+			state.loading_bytes += r->size_hint;
+		}
+		if (num)
+			state.queue.remove(0, num);
+	}
+
+	static void complete(Request *r)
+	{
+		State &state = get_state();
+		int index = state.loading.findIndex(r);
+		state.loading.removeFast(index);
+		state.loading_bytes -= r->size_hint;
+		r->state = STATE_NONE;
+
+		size_t size = get_loaded_size(r);
+		if (size == size_t(-1))
+		{
+			remove_async(r);
+			finish(r, STATE_FAILED);
+			return;
+		}
+		r->size = size;
+		state.loaded_bytes += size;
+		finish(r, STATE_LOADED);
+		if (r->refcount == 0)
+			lru_append(r);
+	}
+
+	// AsyncQueue wrappers
+	static bool load_async(Request *r)
+	{
+		State &state = get_state();
+		// AsyncQueue loads heavier requests first
+		float weight = float(NUM_PRIORITIES - r->priority);
+		switch (r->type)
+		{
+			case TYPE_FILE: r->async_id = AsyncQueue::loadFile(r->name.get(), state.group, weight); break;
+			case TYPE_IMAGE: r->async_id = AsyncQueue::loadImage(r->name.get(), state.group, weight); break;
+			case TYPE_MESH: r->async_id = AsyncQueue::loadMesh(r->name.get(), state.group, weight); break;
+			case TYPE_NODE: r->async_id = AsyncQueue::loadNode(r->name.get(), state.group, weight); break;
+			default: r->async_id = -1; break;
+		}
+		if (r->async_id == -1)
+			return false;
+		if (r->priority == PRIORITY_CRITICAL)
+			force_async(r);
+		return true;
+	}
+
+	static void force_async(Request *r)
+	{
+		switch (r->type)
+		{
+			case TYPE_FILE: AsyncQueue::forceFile(r->async_id); break;
+			case TYPE_IMAGE: AsyncQueue::forceImage(r->async_id); break;
+			case TYPE_MESH: AsyncQueue::forceMesh(r->async_id); break;
+			case TYPE_NODE: AsyncQueue::forceNode(r->async_id); break;
+			default: break;
+		}
+	}
+
+	static void remove_async(Request *r)
+	{
+		if (r->async_id == -1)
+			return;
+		switch (r->type)
+		{
+			case TYPE_FILE: AsyncQueue::removeFile(r->async_id); break;
+			case TYPE_IMAGE: AsyncQueue::removeImage(r->async_id); break;
+			case TYPE_MESH: AsyncQueue::removeMesh(r->async_id); break;
+			case TYPE_NODE:
+				if (!r->taken)
+					AsyncQueue::removeNode(r->async_id);
+				break;
+			default: break;
+		}
+		r->async_id = -1;
+	}
+
+	static bool check(Request *r)
+	{
+		switch (r->type)
+		{
+			case TYPE_FILE: return AsyncQueue::checkFile(r->async_id) != 0;
+			case TYPE_IMAGE: return AsyncQueue::checkImage(r->async_id) != 0;
+			case TYPE_MESH: return AsyncQueue::checkMesh(r->async_id) != 0;
+			case TYPE_NODE: return AsyncQueue::checkNode(r->async_id) != 0;
+			default: return true;
+		}
+	}
+
+	// -1 if the resource failed to load
+	static size_t get_loaded_size(Request *r)
+	{
+		switch (r->type)
+		{
+			case TYPE_IMAGE:
+			{
+				Ptr<Image> image = AsyncQueue::getImage(r->async_id);
+				return image ? image->getSize() : size_t(-1);
+			}
+			case TYPE_MESH:
+			{
+				Ptr<Mesh> mesh = AsyncQueue::getMesh(r->async_id);
+				if (!mesh)
+					return size_t(-1);
+				// positions, vertex attributes and indices as stored by Mesh
+				size_t size = 0;
+				for (int i = 0; i < mesh->getNumSurfaces(); i++)
+					size += size_t(mesh->getNumCVertex(i)) * 12 + size_t(mesh->getNumTVertex(i)) * 24 + size_t(mesh->getNumIndices(i)) * 4;
+				return size;
+			}
+			case TYPE_NODE:
+				// the node itself is small, its meshes and textures are dependencies
+				return AsyncQueue::getNode(r->async_id) ? r->size_hint : size_t(-1);
+			default:
+				return r->size_hint;
+		}
+	}
+};
+
+} // namespace Unigine
@@ -22,6 +22,7 @@ namespace Unigine
 {
 
 class String;
+class Format;
 
 template <int Capacity = 256>
 class StringStack;
@@ -679,6 +680,318 @@ private:
 	int stack_indices[Capacity];
 };
 
+//////////////////////////////////////////////////////////////////////////
+/// Non-owning view of a character range.
+///
+/// The view is not zero-terminated, get() must not be passed to C string
+/// functions. The viewed string must outlive the view. Search functions
+/// return -1 when nothing is found, like the String ones.
+//////////////////////////////////////////////////////////////////////////
+
+template <bool SkipEmpty>
+class StringViewSplitter;
+
+class StringView
+{
+public:
+	UNIGINE_INLINE StringView() : data(""), length(0) {}
+	UNIGINE_INLINE StringView(const char *s) : data(s ? s : ""), length(s ? int(strlen(s)) : 0) {}
+	UNIGINE_INLINE StringView(const char *s, int size) : data(s), length(size) { assert(size >= 0 && "StringView::StringView(): bad size"); }
+	UNIGINE_INLINE StringView(const String &s) : data(s.get()), length(s.size()) {}
+
+	UNIGINE_INLINE const char *get() const { return data; }
+	UNIGINE_INLINE char get(int index) const
+	{
+		assert(index < length && index >= 0 && "StringView::get(): bad index");
+		return data[index];
+	}
+	UNIGINE_INLINE char operator[](int index) const { return get(index); }
+	UNIGINE_INLINE char first() const { return get(0); }
+	UNIGINE_INLINE char last() const { return get(length - 1); }
+
+	UNIGINE_INLINE const char *begin() const { return data; }
+	UNIGINE_INLINE const char *end() const { return data + length; }
+
+	UNIGINE_INLINE int size() const { return length; }
+	UNIGINE_INLINE int empty() const { return length == 0; }
+
+	UNIGINE_INLINE StringStack<> getString() const { return StringStack<>(data, length); }
+	UNIGINE_INLINE unsigned int hash() const { return String::hash(data, length); }
+
+	// search
+	UNIGINE_INLINE int find(char c, int case_sensitive = 1) const
+	{
+		if (case_sensitive)
+		{
+			const char *s = length ? (const char *)memchr(data, c, length) : nullptr;
+			return s ? int(s - data) : -1;
+		}
+		c = String::toLower(c);
+		for (int i = 0; i < length; i++)
+			if (String::toLower(data[i]) == c)
+				return i;
+		return -1;
+	}
+	UNIGINE_INLINE int find(const StringView &s, int case_sensitive = 1) const
+	{
+		for (int i = 0; i + s.length <= length; i++)
+			if (equal_chars(data + i, s.data, s.length, case_sensitive))
+				return i;
+		return -1;
+	}
+	UNIGINE_INLINE int rfind(char c, int case_sensitive = 1) const
+	{
+		if (!case_sensitive)
+			c = String::toLower(c);
+		for (int i = length - 1; i >= 0; i--)
+			if ((case_sensitive ? data[i] : String::toLower(data[i])) == c)
+				return i;
+		return -1;
+	}
+	UNIGINE_INLINE int rfind(const StringView &s, int case_sensitive = 1) const
+	{
+		for (int i = length - s.length; i >= 0; i--)
+			if (equal_chars(data + i, s.data, s.length, case_sensitive))
+				return i;
+		return -1;
+	}
+	UNIGINE_INLINE int findFirstOf(const StringView &symbols, int pos = 0) const
+	{
+		for (int i = pos; i < length; i++)
+			if (symbols.find(data[i]) != -1)
+				return i;
+		return -1;
+	}
+	UNIGINE_INLINE int findFirstNotOf(const StringView &symbols, int pos = 0) const
+	{
+		for (int i = pos; i < length; i++)
+			if (symbols.find(data[i]) == -1)
+				return i;
+		return -1;
+	}
+
+	UNIGINE_INLINE int contains(char c, int case_sensitive = 1) const { return find(c, case_sensitive) != -1; }
+	UNIGINE_INLINE int contains(const StringView &s, int case_sensitive = 1) const { return find(s, case_sensitive) != -1; }
+
+	UNIGINE_INLINE int startsWith(const StringView &s, int case_sensitive = 1) const
+	{
+		return s.length <= length && equal_chars(data, s.data, s.length, case_sensitive);
+	}
+	UNIGINE_INLINE int endsWith(const StringView &s, int case_sensitive = 1) const
+	{
+		return s.length <= length && equal_chars(data + length - s.length, s.data, s.length, case_sensitive);
+	}
+
+	// compare, returns <0, 0 or >0 like strcmp()
+	UNIGINE_INLINE int compare(const StringView &s, int case_sensitive = 1) const
+	{
+		int size = length < s.length ? length : s.length;
+		for (int i = 0; i < size; i++)
+		{
+			unsigned char c0 = (unsigned char)(case_sensitive ? data[i] : String::toLower(data[i]));
+			unsigned char c1 = (unsigned char)(case_sensitive ? s.data[i] : String::toLower(s.data[i]));
+			if (c0 != c1)
+				return c0 < c1 ? -1 : 1;
+		}
+		return length == s.length ? 0 : (length < s.length ? -1 : 1);
+	}
+	UNIGINE_INLINE int equal(const StringView &s, int case_sensitive = 1) const
+	{
+		return length == s.length && equal_chars(data, s.data, length, case_sensitive);
+	}
+
+	// substrings
+	UNIGINE_INLINE StringView substr(int pos, int size = -1) const
+	{
+		assert(pos >= 0 && pos <= length && "StringView::substr(): bad position");
+		if (size < 0 || pos + size > length)
+			size = length - pos;
+		return StringView(data + pos, size);
+	}
+	UNIGINE_INLINE StringView left(int size) const { return substr(0, size < length ? size : length); }
+	UNIGINE_INLINE StringView right(int size) const { return size < length ? substr(length - size) : *this; }
+
+	UNIGINE_INLINE StringView trimFirst(const char *symbols = nullptr) const
+	{
+		int i = 0;
+		while (i < length && is_trim_symbol(data[i], symbols))
+			i++;
+		return StringView(data + i, length - i);
+	}
+	UNIGINE_INLINE StringView trimLast(const char *symbols = nullptr) const
+	{
+		int i = length;
+		while (i > 0 && is_trim_symbol(data[i - 1], symbols))
+			i--;
+		return StringView(data, i);
+	}
+	UNIGINE_INLINE StringView trim(const char *symbols = nullptr) const { return trimFirst(symbols).trimLast(symbols); }
+
+	// paths, both slash types are separators
+	// "data/tanks/tank.node": dirname "data/tanks/", basename "tank.node", filename "tank", extension "node"
+	UNIGINE_INLINE StringView dirname() const { return StringView(data, find_separator() + 1); }
+	UNIGINE_INLINE StringView basename() const { return substr(find_separator() + 1); }
+	UNIGINE_INLINE StringView filename() const
+	{
+		StringView name = basename();
+		int dot = name.rfind('.');
+		return dot > 0 ? name.left(dot) : name;
+	}
+	UNIGINE_INLINE StringView extension() const
+	{
+		StringView name = basename();
+		int dot = name.rfind('.');
+		return dot > 0 ? name.substr(dot + 1) : StringView();
+	}
+	UNIGINE_INLINE StringView removeExtension() const
+	{
+		StringView ext = extension();
+		return ext.empty() ? *this : StringView(data, length - ext.length - 1);
+	}
+
+	// normalization rewrites the path, the result goes into a caller-provided string (a StringStack avoids the heap)
+	UNIGINE_INLINE String &normalizePath(String &ret) const { return String::normalizePath(ret, data, length); }
+	UNIGINE_INLINE String &normalizeDirPath(String &ret) const { return String::normalizeDirPath(ret, data, length); }
+
+	// numbers are parsed in place by Format without a terminating zero, 0 if the view does not start with one
+	// templates, so UnigineFormat.h is only needed where they are called
+	template <typename F = Format> UNIGINE_INLINE int getInt() const { int ret = 0; F::atoi(data, ret, length); return ret; }
+	template <typename F = Format> UNIGINE_INLINE long long getLong() const { long long ret = 0; F::atol(data, ret, length); return ret; }
+	template <typename F = Format> UNIGINE_INLINE float getFloat() const { float ret = 0.0f; F::atof(data, ret, length); return ret; }
+	template <typename F = Format> UNIGINE_INLINE double getDouble() const { double ret = 0.0; F::atod(data, ret, length); return ret; }
+
+	// lazy splitting, see StringViewSplitter
+	// split() keeps empty fields between adjacent delimiters, tokenize() skips them
+	UNIGINE_INLINE StringViewSplitter<false> split(const StringView &delimiters) const;
+	UNIGINE_INLINE StringViewSplitter<true> tokenize(const StringView &delimiters = StringView(" \t\r\n", 4)) const;
+
+private:
+	static UNIGINE_INLINE int equal_chars(const char *s0, const char *s1, int size, int case_sensitive)
+	{
+		if (case_sensitive)
+			return memcmp(s0, s1, size) == 0;
+		for (int i = 0; i < size; i++)
+			if (String::toLower(s0[i]) != String::toLower(s1[i]))
+				return 0;
+		return 1;
+	}
+
+	static UNIGINE_INLINE bool is_trim_symbol(char c, const char *symbols)
+	{
+		if (symbols == nullptr)
+			return String::isspace((unsigned char)c);
+		return strchr(symbols, c) != nullptr && c != '\0';
+	}
+
+	UNIGINE_INLINE int find_separator() const
+	{
+		for (int i = length - 1; i >= 0; i--)
+			if (data[i] == '/' || data[i] == '\\')
+				return i;
+		return -1;
+	}
+
+	const char *data;
+	int length;
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// Lazy splitter over a StringView, tokens are views into the source.
+///
+/// Usable with range-based for or with next():
+///   for (StringView token : line.tokenize()) ...
+///   StringView token; while (splitter.next(token)) ...
+//////////////////////////////////////////////////////////////////////////
+
+template <bool SkipEmpty>
+class StringViewSplitter
+{
+public:
+	UNIGINE_INLINE StringViewSplitter(const StringView &str, const StringView &delimiters)
+		: rest(str)
+		, delimiters(delimiters)
+		, finished(SkipEmpty && str.empty())
+	{
+	}
+
+	UNIGINE_INLINE bool next(StringView &token)
+	{
+		for (;;)
+		{
+			if (finished)
+				return false;
+			int pos = rest.findFirstOf(delimiters);
+			if (pos == -1)
+			{
+				token = rest;
+				finished = true;
+			} else
+			{
+				token = rest.left(pos);
+				rest = rest.substr(pos + 1);
+			}
+			if (!SkipEmpty || !token.empty())
+				return true;
+		}
+	}
+
+	// the rest of the source after the last returned token
+	UNIGINE_INLINE StringView getRest() const { return finished ? StringView() : rest; }
+
+	class Iterator
+	{
+	public:
+		UNIGINE_INLINE Iterator() : splitter(nullptr) {}
+		UNIGINE_INLINE explicit Iterator(StringViewSplitter *s) : splitter(s) { advance(); }
+
+		UNIGINE_INLINE const StringView &operator*() const { return token; }
+		UNIGINE_INLINE const StringView *operator->() const { return &token; }
+		UNIGINE_INLINE Iterator &operator++()
+		{
+			advance();
+			return *this;
+		}
+		UNIGINE_INLINE bool operator==(const Iterator &it) const { return splitter == it.splitter; }
+		UNIGINE_INLINE bool operator!=(const Iterator &it) const { return splitter != it.splitter; }
+
+	private:
+		UNIGINE_INLINE void advance()
+		{
+			if (splitter && !splitter->next(token))
+				splitter = nullptr;
+		}
+
+		StringViewSplitter *splitter;
+		StringView token;
+	};
+
+	// single pass, begin() consumes the splitter
+	UNIGINE_INLINE Iterator begin() { return Iterator(this); }
+	UNIGINE_INLINE Iterator end() { return Iterator(); }
+
+private:
+	StringView rest;
+	StringView delimiters;
+	bool finished;
+};
+
+UNIGINE_INLINE StringViewSplitter<false> StringView::split(const StringView &delimiters) const
+{
+	return StringViewSplitter<false>(*this, delimiters);
+}
+
+UNIGINE_INLINE StringViewSplitter<true> StringView::tokenize(const StringView &delimiters) const
+{
+	return StringViewSplitter<true>(*this, delimiters);
+}
+
+UNIGINE_INLINE bool operator==(const StringView &s0, const StringView &s1) { return s0.equal(s1) != 0; }
+UNIGINE_INLINE bool operator!=(const StringView &s0, const StringView &s1) { return s0.equal(s1) == 0; }
+UNIGINE_INLINE bool operator<(const StringView &s0, const StringView &s1) { return s0.compare(s1) < 0; }
+UNIGINE_INLINE bool operator>(const StringView &s0, const StringView &s1) { return s0.compare(s1) > 0; }
+UNIGINE_INLINE bool operator<=(const StringView &s0, const StringView &s1) { return s0.compare(s1) <= 0; }
+UNIGINE_INLINE bool operator>=(const StringView &s0, const StringView &s1) { return s0.compare(s1) >= 0; }
+
 UNIGINE_API StringStack<> operator+(String &&s0, String &&s1);
 UNIGINE_API StringStack<> operator+(String &&s0, const String &s1);
 UNIGINE_API StringStack<> operator+(const String &s0, String &&s1);
@@ -741,6 +1054,13 @@ struct Hasher<StringStack<size>>
 	UNIGINE_INLINE static HashType create(const StringStack<size> &v) { return String::hash(v.get(), v.size()); }
 };
 
+template<>
+struct Hasher<StringView>
+{
+	using HashType = unsigned int;
+	UNIGINE_INLINE static HashType create(const StringView &v) { return v.hash(); }
+};
+
 
 template <typename Type, typename Counter = unsigned int>
 class StringMap: public HashMap<String, Type, Counter>
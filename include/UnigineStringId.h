@@ -0,0 +1,273 @@
+/* Copyright (C) 2005-2020, UNIGINE. All rights reserved.
+ *
+ * This file is a part of the UNIGINE 2 SDK.
+ *
+ * Your use and / or redistribution of this software in source and / or
+ * binary form, with or without modification, is subject to: (i) your
+ * ongoing acceptance of and compliance with the terms and conditions of
+ * the UNIGINE License Agreement; and (ii) your inclusion of this notice
+ * in any version of this software that you use or redistribute.
+ * A copy of the UNIGINE License Agreement is available by contacting
+ * UNIGINE. at http://unigine.com/
+ */
+
+
+#pragma once
+
+#include "UnigineBase.h"
+#include "UnigineString.h"
+#include "UnigineHash.h"
+#include "UnigineThread.h"
+
+namespace Unigine
+{
+
+//////////////////////////////////////////////////////////////////////////
+/// Interned strings.
+///
+/// Every distinct string is stored once in a global table and never freed,
+/// a StringId is a pointer to that copy with a precomputed hash, so copies
+/// and comparisons are integer operations. Creating a StringId from text
+/// costs one hash and one table lookup, keep them in static or member
+/// variables for hot paths. The table is thread-safe.
+//////////////////////////////////////////////////////////////////////////
+
+class StringIdTable
+{
+public:
+	struct Entry
+	{
+		unsigned int hash;
+		int size;
+		int id;
+		char str[1]; // zero-terminated, allocated to fit
+	};
+
+	static StringIdTable &get()
+	{
+		// never destroyed, StringIds held by static objects stay valid during exit
+		static StringIdTable *table = new StringIdTable();
+		return *table;
+	}
+
+	static UNIGINE_INLINE unsigned int hash(const char *str, int size)
+	{
+		// FNV-1a
+		unsigned int ret = 2166136261u;
+		for (int i = 0; i < size; i++)
+			ret = (ret ^ (unsigned char)str[i]) * 16777619u;
+		return ret;
+	}
+
+	// returns the interned copy, inserts the string if it is new
+	const Entry *intern(const char *str, int size)
+	{
+		unsigned int h = hash(str, size);
+		{
+			ScopedReaderLock lock(mutex);
+			const Entry *e = find_entry(str, size, h);
+			if (e)
+				return e;
+		}
+
+		ScopedWriterLock lock(mutex);
+		const Entry *e = find_entry(str, size, h);
+		if (e)
+			return e;
+		if ((num_entries + 1) * 4 > capacity * 3)
+			rehash(capacity ? capacity * 2 : 1024);
+
+		Entry *entry = allocate_entry(size);
+		entry->hash = h;
+		entry->size = size;
+		entry->id = num_entries;
+		memcpy(entry->str, str, size);
+		entry->str[size] = '\0';
+		insert_entry(entry);
+		entries.append(entry);
+		num_entries++;
+		return entry;
+	}
+
+	// returns nullptr if the string has never been interned
+	const Entry *find(const char *str, int size) const
+	{
+		ScopedReaderLock lock(mutex);
+		return find_entry(str, size, hash(str, size));
+	}
+
+	const Entry *getEntry(int id) const
+	{
+		ScopedReaderLock lock(mutex);
+		return (id >= 0 && id < entries.size()) ? entries[id] : nullptr;
+	}
+
+	int getNumEntries() const
+	{
+		ScopedReaderLock lock(mutex);
+		return num_entries;
+	}
+
+	size_t getMemoryUsage() const
+	{
+		ScopedReaderLock lock(mutex);
+		return blocks.size() * BLOCK_SIZE + capacity * sizeof(Entry *) + entries.getMemoryUsage();
+	}
+
+private:
+	enum
+	{
+		BLOCK_SIZE = 64 * 1024,
+	};
+
+	StringIdTable() = default;
+	~StringIdTable() = delete;
+	StringIdTable(const StringIdTable &) = delete;
+	StringIdTable &operator=(const StringIdTable &) = delete;
+
+	const Entry *find_entry(const char *str, int size, unsigned int h) const
+	{
+		if (capacity == 0)
+			return nullptr;
+		unsigned int mask = capacity - 1;
+		for (unsigned int i = h & mask;; i = (i + 1) & mask)
+		{
+			const Entry *e = table[i];
+			if (e == nullptr)
+				return nullptr;
+			if (e->hash == h && e->size == size && memcmp(e->str, str, size) == 0)
+				return e;
+		}
+	}
+
+	void insert_entry(Entry *entry)
+	{
+		unsigned int mask = capacity - 1;
+		unsigned int i = entry->hash & mask;
+		while (table[i])
+			i = (i + 1) & mask;
+		table[i] = entry;
+	}
+
+	void rehash(int new_capacity)
+	{
+		Entry **old_table = table;
+		int old_capacity = capacity;
+		table = (Entry **)Memory::allocate(new_capacity * sizeof(Entry *));
+		memset(table, 0, new_capacity * sizeof(Entry *));
+		capacity = new_capacity;
+		for (int i = 0; i < old_capacity; i++)
+			if (old_table[i])
+				insert_entry(old_table[i]);
+		Memory::deallocate(old_table);
+	}
+
+	Entry *allocate_entry(int size)
+	{
+		size_t bytes = (offsetof(Entry, str) + size + 1 + 7) & ~size_t(7);
+		if (bytes > BLOCK_SIZE / 4)
+		{
+			// long strings get their own block
+			char *block = (char *)Memory::allocate(bytes);
+			blocks.append(block);
+			return (Entry *)block;
+		}
+		if (block_used + bytes > BLOCK_SIZE || blocks.empty())
+		{
+			block_current = (char *)Memory::allocate(BLOCK_SIZE);
+			blocks.append(block_current);
+			block_used = 0;
+		}
+		Entry *ret = (Entry *)(block_current + block_used);
+		block_used += bytes;
+		return ret;
+	}
+
+	Entry **table{nullptr};
+	int capacity{0};
+	int num_entries{0};
+	Vector<Entry *> entries; // by ID
+	Vector<char *> blocks;
+	char *block_current{nullptr};
+	size_t block_used{0};
+	mutable RWMutex mutex;
+};
+
+class StringId
+{
+public:
+	UNIGINE_INLINE StringId() : entry(get_empty()) {}
+	UNIGINE_INLINE explicit StringId(const char *str) : entry(intern(str, str ? int(strlen(str)) : 0)) {}
+	UNIGINE_INLINE StringId(const char *str, int size) : entry(intern(str, size)) {}
+	UNIGINE_INLINE explicit StringId(const String &str) : entry(intern(str.get(), str.size())) {}
+
+	// lookup without interning, returns the empty StringId if the string is unknown
+	static UNIGINE_INLINE StringId find(const char *str, int size = -1)
+	{
+		if (str == nullptr)
+			return StringId();
+		const StringIdTable::Entry *e = StringIdTable::get().find(str, size < 0 ? int(strlen(str)) : size);
+		return e ? StringId(e) : StringId();
+	}
+	static UNIGINE_INLINE StringId find(const String &str) { return find(str.get(), str.size()); }
+
+	static UNIGINE_INLINE StringId getByID(int id)
+	{
+		const StringIdTable::Entry *e = StringIdTable::get().getEntry(id);
+		return e ? StringId(e) : StringId();
+	}
+
+	UNIGINE_INLINE const char *get() const { return entry->str; }
+	UNIGINE_INLINE int size() const { return entry->size; }
+	UNIGINE_INLINE bool empty() const { return entry->size == 0; }
+	UNIGINE_INLINE unsigned int getHash() const { return entry->hash; }
+	UNIGINE_INLINE int getID() const { return entry->id; }
+
+	UNIGINE_INLINE StringStack<> getString() const { return StringStack<>(entry->str, entry->size); }
+	UNIGINE_INLINE operator const char *() const { return entry->str; }
+
+	UNIGINE_INLINE bool operator==(const StringId &id) const { return entry == id.entry; }
+	UNIGINE_INLINE bool operator!=(const StringId &id) const { return entry != id.entry; }
+
+	// compares the text, otherwise id == "name" would compare pointers through operator const char *
+	UNIGINE_INLINE bool operator==(const char *str) const
+	{
+		if (str == nullptr)
+			return entry->size == 0;
+		return strncmp(entry->str, str, size_t(entry->size)) == 0 && str[entry->size] == '\0';
+	}
+	UNIGINE_INLINE bool operator!=(const char *str) const { return !(*this == str); }
+
+	// interning order, not alphabetical
+	UNIGINE_INLINE bool operator<(const StringId &id) const { return entry->id < id.entry->id; }
+
+private:
+	UNIGINE_INLINE explicit StringId(const StringIdTable::Entry *e) : entry(e) {}
+
+	static UNIGINE_INLINE const StringIdTable::Entry *intern(const char *str, int size)
+	{
+		if (str == nullptr || size == 0)
+			return get_empty();
+		return StringIdTable::get().intern(str, size);
+	}
+
+	static UNIGINE_INLINE const StringIdTable::Entry *get_empty()
+	{
+		static const StringIdTable::Entry *empty = StringIdTable::get().intern("", 0);
+		return empty;
+	}
+
+	const StringIdTable::Entry *entry;
+};
+
+UNIGINE_INLINE bool operator==(const char *str, const StringId &id) { return id == str; }
+UNIGINE_INLINE bool operator!=(const char *str, const StringId &id) { return id != str; }
+
+template<>
+struct Hasher<StringId>
+{
+	using HashType = unsigned int;
+	UNIGINE_INLINE static HashType create(const StringId &v) { return v.getHash(); }
+};
+
+} // namespace Unigine
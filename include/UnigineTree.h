@@ -21,8 +21,8 @@ namespace Unigine
 
 struct TreeAllocator
 {
-	static void *allocate(size_t size) { return Memory::allocate(size); }
-	static void deallocate(void *ptr) { Memory::deallocate(ptr); }
+	static void *allocate(size_t size) { return UNIGINE_MEMORY_ALLOCATE(size); }
+	static void deallocate(void *ptr) { UNIGINE_MEMORY_DEALLOCATE(ptr); }
 };
 
 template <typename Key, typename Data, typename Allocator = TreeAllocator>
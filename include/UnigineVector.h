@@ -32,8 +32,8 @@ namespace Unigine {
 
 struct VectorAllocator
 {
-	static char *allocate(size_t size) { return (char *)Memory::allocate(size); }
-	static void deallocate(char *ptr) { Memory::deallocate(ptr); }
+	static char *allocate(size_t size) { return (char *)UNIGINE_MEMORY_ALLOCATE(size); }
+	static void deallocate(char *ptr) { UNIGINE_MEMORY_DEALLOCATE(ptr); }
 };
 
 template <typename Type, typename Counter = int, typename Allocator = VectorAllocator>
@@ -0,0 +1,1061 @@
+/* Copyright (C) 2005-2020, UNIGINE. All rights reserved.
+ *
+ * This file is a part of the UNIGINE 2 SDK.
+ *
+ * Your use and / or redistribution of this software in source and / or
+ * binary form, with or without modification, is subject to: (i) your
+ * ongoing acceptance of and compliance with the terms and conditions of
+ * the UNIGINE License Agreement; and (ii) your inclusion of this notice
+ * in any version of this software that you use or redistribute.
+ * A copy of the UNIGINE License Agreement is available by contacting
+ * UNIGINE. at http://unigine.com/
+ */
+
+
+#pragma once
+
+#include "UnigineXml.h"
+#include "UnigineMappedFile.h"
+#include "UnigineMemory.h"
+#include "UnigineVector.h"
+#include "UnigineString.h"
+#include "UnigineFormat.h"
+#include "UnigineConsole.h"
+#include "UnigineCallback.h"
+#include "UnigineLog.h"
+#include <chrono>
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+
+// Xml stream example
+/*
+	// pull parsing, views point into the mapped file and are valid until close()
+	XmlReader reader;
+	if (!reader.open("data/Models/Tank.node"))
+		return 0;
+	int event;
+	while ((event = reader.next()) > XmlReader::EVENT_END_DOCUMENT)
+	{
+		if (event != XmlReader::EVENT_START)
+			continue;
+		if (reader.getName().equal("node"))
+			Log::message("%s\n", reader.getArg("name").getString().get());
+		else if (reader.getName().equal("surface"))
+			reader.skip();
+	}
+
+	// or the whole tree on an arena
+	XmlDocument document;
+	if (!document.load("data/Models/Tank.node"))
+		return 0;
+	const XmlNode *transform = document.getRoot()->find("node/transform");
+	float matrix[16];
+	transform->getFloatArrayData(matrix, 16);
+
+	// code that needs the Xml API
+	XmlPtr xml = Xml::create();
+	document.copyTo(xml);
+*/
+
+namespace Unigine
+{
+
+//////////////////////////////////////////////////////////////////////////
+/// Pull Xml parser.
+///
+/// The document is parsed in place, names, attribute values and texts are
+/// views into the source buffer. Values are returned raw, the ones with
+/// entity references are decoded with unescape(). Comments, processing
+/// instructions and DOCTYPE are skipped, whitespace around texts is trimmed
+/// and whitespace-only texts are not reported.
+//////////////////////////////////////////////////////////////////////////
+
+class XmlReader
+{
+public:
+	enum EVENT
+	{
+		EVENT_ERROR = -1,
+		EVENT_NONE = 0,
+		EVENT_END_DOCUMENT,
+		EVENT_START,	// element start, its attributes are available
+		EVENT_END,	// element end, also follows the start of <empty/> elements
+		EVENT_TEXT,	// text or CDATA section inside an element
+	};
+
+	XmlReader() = default;
+	~XmlReader() { close(); }
+
+	XmlReader(const XmlReader &) = delete;
+	XmlReader &operator=(const XmlReader &) = delete;
+
+	// maps the file, views are valid until close()
+	bool open(const char *path)
+	{
+		close();
+		if (!file.open(path))
+			return false;
+		size_t file_size = file.getSize();
+		const char *file_data = file_size ? static_cast<const char *>(file.view(0, file_size)) : "";
+		if (file_data == nullptr)
+		{
+			file.close();
+			return false;
+		}
+		file.setAdvice(MappedFile::ADVICE_SEQUENTIAL);
+		begin(file_data, file_size);
+		return true;
+	}
+
+	// the data must outlive the reader
+	bool open(const char *data, size_t size)
+	{
+		close();
+		begin(data, size);
+		return true;
+	}
+
+	void close()
+	{
+		file.close();
+		begin("", 0);
+		event = EVENT_NONE;
+	}
+
+	UNIGINE_INLINE const char *getData() const { return data; }
+	UNIGINE_INLINE size_t getSize() const { return size; }
+
+	// advances to the next event, EVENT_END_DOCUMENT and EVENT_ERROR are final
+	int next()
+	{
+		if (event == EVENT_ERROR || event == EVENT_END_DOCUMENT)
+			return event;
+		args.clear();
+		cdata = false;
+
+		if (pending_end)
+		{
+			pending_end = false;
+			return end_element();
+		}
+
+		for (;;)
+		{
+			if (pos >= size)
+			{
+				if (stack.size())
+					return fail(pos, "unexpected end of document");
+				if (!root_closed)
+					return fail(pos, "no root element");
+				return event = EVENT_END_DOCUMENT;
+			}
+
+			if (data[pos] != '<')
+			{
+				const char *tag = static_cast<const char *>(memchr(data + pos, '<', size - pos));
+				size_t end = tag ? size_t(tag - data) : size;
+				size_t begin = pos;
+				pos = end;
+				while (begin < end && is_space(data[begin]))
+					begin++;
+				while (end > begin && is_space(data[end - 1]))
+					end--;
+				if (begin == end)
+					continue;
+				if (stack.size() == 0)
+					return fail(begin, "text outside of the root element");
+				text = StringView(data + begin, int(end - begin));
+				return event = EVENT_TEXT;
+			}
+
+			if (pos + 1 >= size)
+				return fail(pos, "unexpected end of document");
+			char c = data[pos + 1];
+			if (c == '/')
+				return parse_end_tag();
+			if (c == '?')
+			{
+				size_t end = find("?>", 2, pos + 2);
+				if (end == END)
+					return fail(pos, "unterminated processing instruction");
+				pos = end + 2;
+				continue;
+			}
+			if (c == '!')
+			{
+				if (starts_with("<!--", 4))
+				{
+					size_t end = find("-->", 3, pos + 4);
+					if (end == END)
+						return fail(pos, "unterminated comment");
+					pos = end + 3;
+					continue;
+				}
+				if (starts_with("<![CDATA[", 9))
+				{
+					if (stack.size() == 0)
+						return fail(pos, "CDATA outside of the root element");
+					size_t end = find("]]>", 3, pos + 9);
+					if (end == END)
+						return fail(pos, "unterminated CDATA section");
+					text = StringView(data + pos + 9, int(end - pos - 9));
+					cdata = true;
+					pos = end + 3;
+					return event = EVENT_TEXT;
+				}
+				if (starts_with("<!DOCTYPE", 9))
+				{
+					if (!skip_doctype())
+						return fail(pos, "unterminated DOCTYPE");
+					continue;
+				}
+				return fail(pos, "unknown markup");
+			}
+			return parse_start_tag();
+		}
+	}
+
+	// after EVENT_START skips the element with its children, the current
+	// event becomes its EVENT_END
+	bool skip()
+	{
+		if (event != EVENT_START)
+			return false;
+		int depth = stack.size() - 1;
+		while (next() > EVENT_END_DOCUMENT)
+		{
+			if (event == EVENT_END && stack.size() == depth)
+				return true;
+		}
+		return false;
+	}
+
+	// current event
+	UNIGINE_INLINE int getEvent() const { return event; }
+	// number of open elements, the current one included for EVENT_START and EVENT_TEXT
+	UNIGINE_INLINE int getDepth() const { return stack.size(); }
+	// offset of the parser in the source
+	UNIGINE_INLINE size_t tell() const { return pos; }
+
+	// element name for EVENT_START and EVENT_END
+	UNIGINE_INLINE const StringView &getName() const { return name; }
+	// <empty/> element, EVENT_END follows without texts
+	UNIGINE_INLINE bool isEmptyElement() const { return event == EVENT_START && pending_end; }
+
+	// attributes of EVENT_START
+	UNIGINE_INLINE int getNumArgs() const { return args.size(); }
+	UNIGINE_INLINE const StringView &getArgName(int num) const { return args[num].name; }
+	UNIGINE_INLINE const StringView &getArgValue(int num) const { return args[num].value; }
+	int findArg(const StringView &arg_name) const
+	{
+		for (int i = 0; i < args.size(); i++)
+			if (args[i].name.equal(arg_name))
+				return i;
+		return -1;
+	}
+	UNIGINE_INLINE bool isArg(const StringView &arg_name) const { return findArg(arg_name) != -1; }
+	// raw value, empty if there is no such attribute
+	StringView getArg(const StringView &arg_name) const
+	{
+		int num = findArg(arg_name);
+		return num != -1 ? args[num].value : StringView();
+	}
+
+	// text of EVENT_TEXT, CDATA sections are not escaped
+	UNIGINE_INLINE const StringView &getText() const { return text; }
+	UNIGINE_INLINE bool isCData() const { return cdata; }
+
+	UNIGINE_INLINE static bool isEscaped(const StringView &str) { return str.find('&') != -1; }
+
+	// decodes entity references into dest of at least str.size() bytes,
+	// returns the decoded size, unknown references are copied as they are
+	static int unescape(const StringView &str, char *dest)
+	{
+		const char *s = str.get();
+		const char *end = s + str.size();
+		char *d = dest;
+		while (s < end)
+		{
+			const char *amp = static_cast<const char *>(memchr(s, '&', size_t(end - s)));
+			if (amp == nullptr)
+				amp = end;
+			memmove(d, s, size_t(amp - s));
+			d += amp - s;
+			s = amp;
+			if (s == end)
+				break;
+
+			// the longest reference is "&#x10ffff;"
+			size_t max_length = size_t(end - s) < 12 ? size_t(end - s) : 12;
+			const char *semicolon = static_cast<const char *>(memchr(s, ';', max_length));
+			int length = semicolon ? int(semicolon - s) - 1 : -1;
+			const char *entity = s + 1;
+			unsigned int code = 0;
+			bool decoded = true;
+			if (length == 2 && entity[0] == 'l' && entity[1] == 't')
+				code = '<';
+			else if (length == 2 && entity[0] == 'g' && entity[1] == 't')
+				code = '>';
+			else if (length == 3 && !strncmp(entity, "amp", 3))
+				code = '&';
+			else if (length == 4 && !strncmp(entity, "quot", 4))
+				code = '"';
+			else if (length == 4 && !strncmp(entity, "apos", 4))
+				code = '\'';
+			else if (length > 1 && length < 10 && entity[0] == '#')
+			{
+				bool hex = entity[1] == 'x';
+				for (int i = hex ? 2 : 1; i < length && decoded; i++)
+				{
+					char c = entity[i];
+					unsigned int digit;
+					if (c >= '0' && c <= '9')
+						digit = unsigned(c - '0');
+					else if (hex && c >= 'a' && c <= 'f')
+						digit = unsigned(c - 'a' + 10);
+					else if (hex && c >= 'A' && c <= 'F')
+						digit = unsigned(c - 'A' + 10);
+					else
+						decoded = false;
+					if (decoded)
+						code = code * (hex ? 16 : 10) + digit;
+				}
+				decoded = decoded && length > (hex ? 2 : 1) && code != 0 && code <= 0x10ffff;
+			} else
+				decoded = false;
+
+			if (!decoded)
+			{
+				*d++ = *s++;
+				continue;
+			}
+			// the shortest reference "&#9;" is 4 bytes, so the encoding never outgrows the source
+			if (code < 0x80)
+				*d++ = char(code);
+			else if (code < 0x800)
+			{
+				*d++ = char(0xc0 | (code >> 6));
+				*d++ = char(0x80 | (code & 0x3f));
+			} else if (code < 0x10000)
+			{
+				*d++ = char(0xe0 | (code >> 12));
+				*d++ = char(0x80 | ((code >> 6) & 0x3f));
+				*d++ = char(0x80 | (code & 0x3f));
+			} else
+			{
+				*d++ = char(0xf0 | (code >> 18));
+				*d++ = char(0x80 | ((code >> 12) & 0x3f));
+				*d++ = char(0x80 | ((code >> 6) & 0x3f));
+				*d++ = char(0x80 | (code & 0x3f));
+			}
+			s = semicolon + 1;
+		}
+		return int(d - dest);
+	}
+
+	static void unescape(const StringView &str, String &dest)
+	{
+		dest.resize(str.size());
+		if (str.size())
+			dest.resize(unescape(str, &dest[0]));
+	}
+
+	UNIGINE_INLINE const char *getError() const { return error.get(); }
+	UNIGINE_INLINE size_t getErrorOffset() const { return error_offset; }
+	// 1-based line of the error
+	int getErrorLine() const
+	{
+		int line = 1;
+		for (size_t i = 0; i < error_offset && i < size; i++)
+			line += data[i] == '\n';
+		return line;
+	}
+
+	// xml_stream_benchmark [file]
+	static void getBenchmarkReport(String &ret, const char *path = nullptr);
+
+	static void addConsoleCommands()
+	{
+		Console::addCommand("xml_stream_benchmark", "prints the throughput of XmlReader, XmlDocument and Xml::parse()", MakeCallback(&XmlReader::console_benchmark));
+	}
+	static void removeConsoleCommands() { Console::removeCommand("xml_stream_benchmark"); }
+
+private:
+	static constexpr size_t END = ~size_t(0);
+
+	enum
+	{
+		MAX_DEPTH = 1024,
+	};
+
+	struct Arg
+	{
+		StringView name;
+		StringView value;
+	};
+
+	void begin(const char *d, size_t s)
+	{
+		data = d;
+		size = s;
+		pos = 0;
+		// UTF-8 byte order mark
+		if (size >= 3 && !memcmp(data, "\xef\xbb\xbf", 3))
+			pos = 3;
+		event = EVENT_NONE;
+		pending_end = false;
+		root_closed = false;
+		cdata = false;
+		name = StringView();
+		text = StringView();
+		args.clear();
+		stack.clear();
+		error.clear();
+		error_offset = 0;
+	}
+
+	static UNIGINE_INLINE bool is_space(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+	static UNIGINE_INLINE bool is_name_char(char c)
+	{
+		return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+			c == '_' || c == '-' || c == '.' || c == ':' || (unsigned char)c >= 0x80;
+	}
+
+	UNIGINE_INLINE bool starts_with(const char *str, size_t length) const
+	{
+		return size - pos >= length && !memcmp(data + pos, str, length);
+	}
+
+	size_t find(const char *str, size_t length, size_t from) const
+	{
+		while (from + length <= size)
+		{
+			const char *c = static_cast<const char *>(memchr(data + from, str[0], size - from - length + 1));
+			if (c == nullptr)
+				return END;
+			from = size_t(c - data);
+			if (!memcmp(c, str, length))
+				return from;
+			from++;
+		}
+		return END;
+	}
+
+	UNIGINE_INLINE size_t skip_spaces(size_t p) const
+	{
+		while (p < size && is_space(data[p]))
+			p++;
+		return p;
+	}
+
+	UNIGINE_INLINE size_t skip_name(size_t p) const
+	{
+		while (p < size && is_name_char(data[p]))
+			p++;
+		return p;
+	}
+
+	bool skip_doctype()
+	{
+		// the internal subset in brackets may contain '>'
+		int brackets = 0;
+		for (size_t p = pos + 9; p < size; p++)
+		{
+			char c = data[p];
+			if (c == '[')
+				brackets++;
+			else if (c == ']')
+				brackets--;
+			else if (c == '>' && brackets <= 0)
+			{
+				pos = p + 1;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	int parse_start_tag()
+	{
+		if (root_closed)
+			return fail(pos, "more than one root element");
+		if (stack.size() >= MAX_DEPTH)
+			return fail(pos, "too deep nesting");
+
+		size_t p = pos + 1;
+		size_t end = skip_name(p);
+		if (end == p)
+			return fail(p, "bad element name");
+		name = StringView(data + p, int(end - p));
+		p = end;
+
+		for (;;)
+		{
+			size_t arg_begin = skip_spaces(p);
+			if (arg_begin >= size)
+				return fail(pos, "unterminated element");
+			char c = data[arg_begin];
+			if (c == '>')
+			{
+				p = arg_begin + 1;
+				break;
+			}
+			if (c == '/')
+			{
+				if (arg_begin + 1 >= size || data[arg_begin + 1] != '>')
+					return fail(arg_begin, "expected '>'");
+				p = arg_begin + 2;
+				pending_end = true;
+				break;
+			}
+			if (arg_begin == p)
+				return fail(p, "expected whitespace before attribute");
+
+			end = skip_name(arg_begin);
+			if (end == arg_begin)
+				return fail(arg_begin, "bad attribute name");
+			Arg &arg = args.append();
+			arg.name = StringView(data + arg_begin, int(end - arg_begin));
+
+			p = skip_spaces(end);
+			if (p >= size || data[p] != '=')
+				return fail(p, "expected '='");
+			p = skip_spaces(p + 1);
+			if (p >= size || (data[p] != '"' && data[p] != '\''))
+				return fail(p, "expected quoted attribute value");
+			const char *quote = static_cast<const char *>(memchr(data + p + 1, data[p], size - p - 1));
+			if (quote == nullptr)
+				return fail(p, "unterminated attribute value");
+			arg.value = StringView(data + p + 1, int(quote - data - p - 1));
+			p = size_t(quote - data) + 1;
+		}
+
+		pos = p;
+		stack.append(name);
+		return event = EVENT_START;
+	}
+
+	int parse_end_tag()
+	{
+		size_t p = pos + 2;
+		size_t end = skip_name(p);
+		StringView end_name(data + p, int(end - p));
+		p = skip_spaces(end);
+		if (p >= size || data[p] != '>')
+			return fail(p, "expected '>'");
+		if (stack.size() == 0 || !stack.last().equal(end_name))
+			return fail(pos, "mismatched end tag");
+		pos = p + 1;
+		return end_element();
+	}
+
+	int end_element()
+	{
+		name = stack.last();
+		stack.removeLast();
+		if (stack.size() == 0)
+			root_closed = true;
+		return event = EVENT_END;
+	}
+
+	int fail(size_t offset, const char *message)
+	{
+		error = message;
+		error_offset = offset;
+		if (file.isOpened())
+			Log::error("XmlReader::next(): %s at line %d in \"%s\" file\n", message, getErrorLine(), file.getName());
+		else
+			Log::error("XmlReader::next(): %s at line %d\n", message, getErrorLine());
+		return event = EVENT_ERROR;
+	}
+
+	static void console_benchmark(int argc, char **argv)
+	{
+		String report;
+		getBenchmarkReport(report, argc > 1 ? argv[1] : nullptr);
+		Log::message("%s", report.get());
+	}
+
+	MappedFile file;
+	const char *data{""};
+	size_t size{0};
+	size_t pos{0};
+
+	int event{EVENT_NONE};
+	bool pending_end{false};
+	bool root_closed{false};
+	bool cdata{false};
+	StringView name;
+	StringView text;
+	Vector<Arg> args;
+	Vector<StringView> stack;
+
+	String error;
+	size_t error_offset{0};
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// Bump allocator, memory is released all at once.
+//////////////////////////////////////////////////////////////////////////
+
+class XmlArena
+{
+public:
+	XmlArena(size_t block_size = 64 * 1024)
+		: block_size(block_size)
+	{}
+	~XmlArena() { destroy(); }
+
+	XmlArena(const XmlArena &) = delete;
+	XmlArena &operator=(const XmlArena &) = delete;
+
+	void *allocate(size_t alloc_size, size_t alignment = sizeof(void *))
+	{
+		size_t offset = (used + alignment - 1) & ~(alignment - 1);
+		if (blocks.size() == 0 || offset + alloc_size > capacity)
+		{
+			// large allocations get a block of their own
+			size_t new_capacity = alloc_size + alignment > block_size ? alloc_size + alignment : block_size;
+			Block &block = blocks.append();
+			block.data = static_cast<unsigned char *>(Memory::allocate(new_capacity));
+			block.size = new_capacity;
+			capacity = new_capacity;
+			memory_usage += new_capacity;
+			// blocks are aligned for any type
+			offset = 0;
+		}
+		used = offset + alloc_size;
+		return blocks.last().data + offset;
+	}
+
+	template <class Type>
+	Type *allocate(int num)
+	{
+		Type *ret = static_cast<Type *>(allocate(sizeof(Type) * size_t(num), alignof(Type)));
+		for (int i = 0; i < num; i++)
+			new (ret + i) Type();
+		return ret;
+	}
+
+	// null-terminated copy
+	StringView allocateString(const char *str, int length)
+	{
+		char *ret = static_cast<char *>(allocate(size_t(length) + 1, 1));
+		memcpy(ret, str, size_t(length));
+		ret[length] = '\0';
+		return StringView(ret, length);
+	}
+
+	// keeps the first block for the next use
+	void clear()
+	{
+		for (int i = 1; i < blocks.size(); i++)
+			Memory::deallocate(blocks[i].data);
+		if (blocks.size())
+			blocks.resize(1);
+		capacity = blocks.size() ? blocks[0].size : 0;
+		memory_usage = capacity;
+		used = 0;
+	}
+
+	void destroy()
+	{
+		for (int i = 0; i < blocks.size(); i++)
+			Memory::deallocate(blocks[i].data);
+		blocks.destroy();
+		capacity = 0;
+		memory_usage = 0;
+		used = 0;
+	}
+
+	UNIGINE_INLINE size_t getMemoryUsage() const { return memory_usage; }
+
+private:
+	struct Block
+	{
+		unsigned char *data;
+		size_t size;
+	};
+
+	Vector<Block> blocks;
+	size_t block_size;
+	size_t capacity{0};
+	size_t used{0};
+	size_t memory_usage{0};
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// Element of XmlDocument.
+///
+/// Nodes live in the arena of the document. Names and values are views into
+/// the source, the ones with entity references are decoded into the arena.
+//////////////////////////////////////////////////////////////////////////
+
+class XmlNode
+{
+public:
+	UNIGINE_INLINE const StringView &getName() const { return name; }
+	UNIGINE_INLINE const XmlNode *getParent() const { return parent; }
+
+	UNIGINE_INLINE int getNumChildren() const { return num_children; }
+	UNIGINE_INLINE const XmlNode *getChild(int num) const { return children[num]; }
+	int findChild(const StringView &child_name) const
+	{
+		for (int i = 0; i < num_children; i++)
+			if (children[i]->name.equal(child_name))
+				return i;
+		return -1;
+	}
+	const XmlNode *getChild(const StringView &child_name) const
+	{
+		int num = findChild(child_name);
+		return num != -1 ? children[num] : nullptr;
+	}
+	// first match of a "child/child/child" path
+	const XmlNode *find(const StringView &path) const
+	{
+		const XmlNode *node = this;
+		StringView rest = path;
+		while (node && rest.size())
+		{
+			int slash = rest.find('/');
+			int length = slash != -1 ? slash : rest.size();
+			node = node->getChild(StringView(rest.get(), length));
+			rest = slash != -1 ? StringView(rest.get() + slash + 1, rest.size() - slash - 1) : StringView();
+		}
+		return node;
+	}
+
+	UNIGINE_INLINE int getNumArgs() const { return num_args; }
+	UNIGINE_INLINE const StringView &getArgName(int num) const { return args[num].name; }
+	UNIGINE_INLINE const StringView &getArgValue(int num) const { return args[num].value; }
+	int findArg(const StringView &arg_name) const
+	{
+		for (int i = 0; i < num_args; i++)
+			if (args[i].name.equal(arg_name))
+				return i;
+		return -1;
+	}
+	UNIGINE_INLINE bool isArg(const StringView &arg_name) const { return findArg(arg_name) != -1; }
+	StringView getArg(const StringView &arg_name) const
+	{
+		int num = findArg(arg_name);
+		return num != -1 ? args[num].value : StringView();
+	}
+
+	// typed values, the default is returned for missing and malformed ones
+	bool getBoolArg(const StringView &arg_name, bool value = false) const { return to_bool(getArg(arg_name), value); }
+	int getIntArg(const StringView &arg_name, int value = 0) const { return to_int(getArg(arg_name), value); }
+	float getFloatArg(const StringView &arg_name, float value = 0.0f) const { return to_float(getArg(arg_name), value); }
+	double getDoubleArg(const StringView &arg_name, double value = 0.0) const { return to_double(getArg(arg_name), value); }
+
+	// text of the element, texts split by children are concatenated
+	UNIGINE_INLINE const StringView &getData() const { return data; }
+	bool getBoolData(bool value = false) const { return to_bool(data, value); }
+	int getIntData(int value = 0) const { return to_int(data, value); }
+	float getFloatData(float value = 0.0f) const { return to_float(data, value); }
+	double getDoubleData(double value = 0.0) const { return to_double(data, value); }
+	// whitespace separated values, false if there are less than dest_size of them
+	bool getIntArrayData(int *dest, int dest_size) const { return to_array(data, dest, dest_size); }
+	bool getFloatArrayData(float *dest, int dest_size) const { return to_array(data, dest, dest_size); }
+	bool getDoubleArrayData(double *dest, int dest_size) const { return to_array(data, dest, dest_size); }
+
+private:
+	friend class XmlDocument;
+
+	struct Arg
+	{
+		StringView name;
+		StringView value;
+	};
+
+	// views are followed by a quote, a '<' or a terminator, so the number
+	// parsers never run past them
+	static bool to_bool(const StringView &str, bool value)
+	{
+		if (str.equal("true"))
+			return true;
+		if (str.equal("false"))
+			return false;
+		return to_int(str, value ? 1 : 0) != 0;
+	}
+	static int to_int(const StringView &str, int value)
+	{
+		if (str.empty())
+			return value;
+		char *end = nullptr;
+		long ret = strtol(str.get(), &end, 10);
+		return end == str.get() ? value : int(ret);
+	}
+	static float to_float(const StringView &str, float value)
+	{
+		if (str.empty())
+			return value;
+		char *end = nullptr;
+		float ret = strtof(str.get(), &end);
+		return end == str.get() ? value : ret;
+	}
+	static double to_double(const StringView &str, double value)
+	{
+		if (str.empty())
+			return value;
+		char *end = nullptr;
+		double ret = strtod(str.get(), &end);
+		return end == str.get() ? value : ret;
+	}
+
+	static UNIGINE_INLINE void parse_value(const char *s, char **end, int &value) { value = int(strtol(s, end, 10)); }
+	static UNIGINE_INLINE void parse_value(const char *s, char **end, float &value) { value = strtof(s, end); }
+	static UNIGINE_INLINE void parse_value(const char *s, char **end, double &value) { value = strtod(s, end); }
+
+	template <class Type>
+	static bool to_array(const StringView &str, Type *dest, int dest_size)
+	{
+		const char *s = str.get();
+		const char *end = s + str.size();
+		for (int i = 0; i < dest_size; i++)
+		{
+			if (s >= end)
+				return false;
+			char *next = nullptr;
+			parse_value(s, &next, dest[i]);
+			if (next == s || next > end)
+				return false;
+			s = next;
+		}
+		return true;
+	}
+
+	StringView name;
+	StringView data;
+	const XmlNode *parent{nullptr};
+	const XmlNode **children{nullptr};
+	Arg *args{nullptr};
+	int num_children{0};
+	int num_args{0};
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// Read-only Xml tree built by XmlReader in one pass.
+///
+/// Nodes, child and attribute arrays are bump-allocated from an arena, the
+/// source file stays mapped while the document is alive.
+//////////////////////////////////////////////////////////////////////////
+
+class XmlDocument
+{
+public:
+	XmlDocument() = default;
+
+	XmlDocument(const XmlDocument &) = delete;
+	XmlDocument &operator=(const XmlDocument &) = delete;
+
+	bool load(const char *path)
+	{
+		clear();
+		return reader.open(path) && build();
+	}
+
+	// the data must outlive the document
+	bool parse(const char *data, size_t size)
+	{
+		clear();
+		return reader.open(data, size) && build();
+	}
+
+	void clear()
+	{
+		reader.close();
+		arena.clear();
+		root = nullptr;
+	}
+
+	UNIGINE_INLINE const XmlNode *getRoot() const { return root; }
+	UNIGINE_INLINE const char *getError() const { return reader.getError(); }
+	UNIGINE_INLINE int getErrorLine() const { return reader.getErrorLine(); }
+	// arena memory, the mapped source is not included
+	UNIGINE_INLINE size_t getMemoryUsage() const { return arena.getMemoryUsage(); }
+
+	// fills the Xml with the tree for code that needs the Xml API
+	bool copyTo(const XmlPtr &xml) const
+	{
+		if (root == nullptr || !xml)
+			return false;
+		String name, value;
+		copy_node(root, xml, name, value);
+		return true;
+	}
+
+private:
+	bool build()
+	{
+		children.clear();
+		child_begins.clear();
+		XmlNode *current = nullptr;
+		for (;;)
+		{
+			switch (reader.next())
+			{
+				case XmlReader::EVENT_START:
+				{
+					XmlNode *node = arena.allocate<XmlNode>(1);
+					node->name = reader.getName();
+					node->parent = current;
+					node->num_args = reader.getNumArgs();
+					if (node->num_args)
+					{
+						node->args = arena.allocate<XmlNode::Arg>(node->num_args);
+						for (int i = 0; i < node->num_args; i++)
+						{
+							node->args[i].name = reader.getArgName(i);
+							node->args[i].value = decode(reader.getArgValue(i));
+						}
+					}
+					if (current)
+						children.append(node);
+					else
+						root = node;
+					child_begins.append(children.size());
+					current = node;
+					break;
+				}
+				case XmlReader::EVENT_END:
+				{
+					int begin = child_begins.last();
+					child_begins.removeLast();
+					current->num_children = children.size() - begin;
+					if (current->num_children)
+					{
+						current->children = static_cast<const XmlNode **>(arena.allocate(sizeof(XmlNode *) * size_t(current->num_children)));
+						memcpy(current->children, children.get() + begin, sizeof(XmlNode *) * size_t(current->num_children));
+					}
+					children.resize(begin);
+					current = const_cast<XmlNode *>(current->parent);
+					break;
+				}
+				case XmlReader::EVENT_TEXT:
+				{
+					StringView text = reader.isCData() ? reader.getText() : decode(reader.getText());
+					if (current->data.empty())
+					{
+						current->data = text;
+						break;
+					}
+					// mixed content
+					int length = current->data.size() + text.size();
+					char *data = static_cast<char *>(arena.allocate(size_t(length) + 1, 1));
+					memcpy(data, current->data.get(), size_t(current->data.size()));
+					memcpy(data + current->data.size(), text.get(), size_t(text.size()));
+					data[length] = '\0';
+					current->data = StringView(data, length);
+					break;
+				}
+				case XmlReader::EVENT_END_DOCUMENT: return true;
+				default: root = nullptr; return false;
+			}
+		}
+	}
+
+	StringView decode(const StringView &str)
+	{
+		if (!XmlReader::isEscaped(str))
+			return str;
+		char *dest = static_cast<char *>(arena.allocate(size_t(str.size()) + 1, 1));
+		int length = XmlReader::unescape(str, dest);
+		dest[length] = '\0';
+		return StringView(dest, length);
+	}
+
+	static void copy_node(const XmlNode *node, const XmlPtr &xml, String &name, String &value)
+	{
+		name.copy(node->name.get(), node->name.size());
+		xml->setName(name.get());
+		for (int i = 0; i < node->num_args; i++)
+		{
+			name.copy(node->args[i].name.get(), node->args[i].name.size());
+			value.copy(node->args[i].value.get(), node->args[i].value.size());
+			xml->setArg(name.get(), value.get());
+		}
+		if (node->data.size())
+		{
+			value.copy(node->data.get(), node->data.size());
+			xml->setData(value.get());
+		}
+		for (int i = 0; i < node->num_children; i++)
+		{
+			name.copy(node->children[i]->name.get(), node->children[i]->name.size());
+			copy_node(node->children[i], xml->addChild(name.get()), name, value);
+		}
+	}
+
+	XmlReader reader;
+	XmlArena arena;
+	XmlNode *root{nullptr};
+
+	Vector<const XmlNode *> children;
+	Vector<int> child_begins;
+};
+
+inline void XmlReader::getBenchmarkReport(String &ret, const char *path)
+{
+	BlobPtr source = Blob::create();
+	if (path)
+	{
+		MappedFile file;
+		if (!file.open(path))
+		{
+			ret = String::format("can't open \"%s\" file\n", path);
+			return;
+		}
+		const void *file_data = file.view(0, file.getSize());
+		if (file_data)
+			source->write(file_data, file.getSize());
+	} else
+	{
+		// node files like data/Models/Tank.node
+		unsigned int state = 1;
+		auto random = [&]() { state = state * 1664525u + 1013904223u; return state >> 8; };
+		String line;
+		source->puts("<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<nodes version=\"2.13.0.0\">\n");
+		for (int i = 0; source->getSize() < 8 * 1024 * 1024; i++)
+		{
+			line = String::format("\t<node type=\"NodeDummy\" id=\"%u\" name=\"Tank_%d\">\n"
+				"\t\t<transform>1 0 0 0.0 0 1 0 0.0 0 0 1 0.0 %u %u 0 1.0</transform>\n", random(), i, random() % 1000, random() % 1000);
+			source->puts(line.get());
+			for (int j = 0; j < 3; j++)
+			{
+				line = String::format("\t\t<node type=\"ObjectMeshStatic\" id=\"%u\" name=\"Part &amp; %d\">\n"
+					"\t\t\t<mesh_name>guid://%08x%08x%08x</mesh_name>\n"
+					"\t\t\t<surface name=\"box\" material=\"401e90ccd85f4f2bb97c19ab9e1351325c4012eb\"/>\n"
+					"\t\t\t<transform>1 0 0 0.0 0 1 0 0.0 0 0 1 0.0 0 0 0.%u 1.0</transform>\n"
+					"\t\t</node>\n", random(), j, random(), random(), random(), random() % 100);
+				source->puts(line.get());
+			}
+			source->puts("\t</node>\n");
+		}
+		source->puts("</nodes>\n");
+	}
+	source->writeUChar(0);
+	const char *data = reinterpret_cast<const char *>(source->getData());
+	size_t length = source->getSize() - 1;
+
+	ret.clear();
+	Format::append(ret, "{} KB of {}\n", (unsigned long long)(length >> 10), path ? path : "generated nodes");
+	XmlReader reader;
+	Format::appendThroughput(ret, "XmlReader", length, 4, [&]() {
+		reader.open(data, length);
+		int event;
+		while ((event = reader.next()) > EVENT_END_DOCUMENT)
+			;
+		return event == EVENT_END_DOCUMENT;
+	});
+	XmlDocument document;
+	Format::appendThroughput(ret, "XmlDocument", length, 4, [&]() { return document.parse(data, length); });
+	Format::append(ret, "{:<28}{:8} KB\n", "XmlDocument arena", (unsigned long long)(document.getMemoryUsage() >> 10));
+	Format::appendThroughput(ret, "XmlDocument -> Xml", length, 1, [&]() { XmlPtr xml = Xml::create(); return document.parse(data, length) && document.copyTo(xml); });
+	Format::appendThroughput(ret, "Xml::parse", length, 1, [&]() { XmlPtr xml = Xml::create(); return xml->parse(data); });
+}
+
+} // namespace Unigine
@@ -14,6 +14,24 @@
 
 #include "AppSystemLogic.h"
 #include "UnigineApp.h"
+#include "UnigineProfilerStats.h"
+#include "UnigineStreaming.h"
+#include "UnigineFormat.h"
+#include "UnigineSpatialGrid.h"
+#include "UnigineChecksumEngine.h"
+#include "UnigineStreamBuffer.h"
+#include "UnigineSnapshot.h"
+#include "UnigineSnapshotDelta.h"
+#include "UnigineReplay.h"
+#include "UnigineJsonStream.h"
+#include "UnigineXmlStream.h"
+#include "UnigineCompiledTree.h"
+#include "UnigineImageKernels.h"
+#include "UnigineFunctionBenchmark.h"
+#include "UnigineComponentBatch.h"
+#ifdef UNIGINE_MEMORY_TRACKER
+	#include "UnigineMemoryReport.h"
+#endif
 
 using namespace Unigine;
 
@@ -31,6 +49,44 @@ AppSystemLogic::~AppSystemLogic()
 int AppSystemLogic::init()
 {
 	// Write here code to be called on engine initialization.
+
+	// frame time percentiles and hitch reports, see profiler_stats_* console commands
+	// scope recording is opt-in, see profiler_trace console command
+	ProfilerStats::setBudget(33.3f);
+	ProfilerStats::addConsoleCommands();
+
+	// number conversion against String and snprintf, see format_benchmark console command
+	Format::addConsoleCommands();
+	// entity moves and radius queries, see spatial_grid_benchmark console command
+	SpatialGrid::addConsoleCommands();
+	// CRC32C and XXH3 throughput, see checksum_benchmark console command
+	ChecksumEngine::addConsoleCommands();
+	// direct and buffered stream calls, see stream_buffer_benchmark console command
+	StreamBuffer::addConsoleCommands();
+	// world state snapshot round trip, see snapshot_benchmark console command
+	Snapshot::addConsoleCommands();
+	// keyframes and deltas encoded in the background, see snapshot_delta_benchmark console command
+	SnapshotRecorder::addConsoleCommands();
+	// input recording and playback, see replay_record and replay_play console commands
+	Replay::addConsoleCommands();
+	// streaming and DOM Json parsing throughput, see json_stream_benchmark console command
+	JsonReader::addConsoleCommands();
+	// pull and arena Xml parsing throughput, see xml_stream_benchmark console command
+	XmlReader::addConsoleCommands();
+	// cached binary Xml and Ulon load times, see compiled_tree_benchmark console command
+	CompiledTree::addConsoleCommands();
+	// tiled Image kernels against the Image methods, see image_kernels_benchmark console command
+	ImageKernels::addConsoleCommands();
+	// MakeCallback against Function dispatch, see function_benchmark console command
+	FunctionBenchmark::addConsoleCommands();
+	// per-component and batched component updates, see component_batch_benchmark console command
+	ComponentBatchSystem::addConsoleCommands();
+
+#ifdef UNIGINE_MEMORY_TRACKER
+	// allocations per profiler scope, see memory_tracker_* console commands
+	MemoryTracker::setEnabled(true);
+	MemoryReport::addConsoleCommands();
+#endif
 	return 1;
 }
 
@@ -41,6 +97,11 @@ int AppSystemLogic::init()
 int AppSystemLogic::update()
 {
 	// Write here code to be called before updating each render frame.
+	ProfilerStats::update();
+	StreamingManager::update();
+#ifdef UNIGINE_MEMORY_TRACKER
+	MemoryTracker::update();
+#endif
 	return 1;
 }
 
@@ -57,5 +118,26 @@ int AppSystemLogic::postUpdate()
 int AppSystemLogic::shutdown()
 {
 	// Write here code to be called on engine shutdown.
+	StreamingManager::clear();
+	ProfilerStats::saveReport("profiler_stats.txt");
+	ProfilerStats::removeConsoleCommands();
+	Format::removeConsoleCommands();
+	SpatialGrid::removeConsoleCommands();
+	ChecksumEngine::removeConsoleCommands();
+	StreamBuffer::removeConsoleCommands();
+	Snapshot::removeConsoleCommands();
+	SnapshotRecorder::removeConsoleCommands();
+	Replay::stop();
+	Replay::removeConsoleCommands();
+	JsonReader::removeConsoleCommands();
+	XmlReader::removeConsoleCommands();
+	CompiledTree::removeConsoleCommands();
+	ImageKernels::removeConsoleCommands();
+	FunctionBenchmark::removeConsoleCommands();
+	ComponentBatchSystem::removeConsoleCommands();
+#ifdef UNIGINE_MEMORY_TRACKER
+	MemoryReport::saveReport("memory_report.txt");
+	MemoryReport::removeConsoleCommands();
+#endif
 	return 1;
 }
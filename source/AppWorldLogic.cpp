@@ -13,6 +13,8 @@
 
 
 #include "AppWorldLogic.h"
+#include "UnigineSnapshot.h"
+#include "UnigineReplay.h"
 
 // World logic, it takes effect only when the world is loaded.
 // These methods are called right after corresponding world script's (UnigineScript) methods.
@@ -38,6 +40,8 @@ int AppWorldLogic::init()
 int AppWorldLogic::update()
 {
 	// Write here code to be called before updating each render frame: specify all graphics-related functions you want to be called every frame while your application executes.
+	// records or plays back the input of the frame, query it with Replay::isKeyPressed() and alike
+	Unigine::Replay::update();
 	return 1;
 }
 
@@ -52,6 +56,7 @@ int AppWorldLogic::updatePhysics()
 	// Write here code to be called before updating each physics frame: control physics in your application and put non-rendering calculations.
 	// The engine calls updatePhysics() with the fixed rate (60 times per second by default) regardless of the FPS value.
 	// WARNING: do not create, delete or change transformations of nodes here, because rendering is already in progress.
+	Unigine::Replay::updatePhysics();
 	return 1;
 }
 
@@ -68,13 +73,12 @@ int AppWorldLogic::shutdown()
 int AppWorldLogic::save(const Unigine::StreamPtr &stream)
 {
 	// Write here code to be called when the world is saving its state (i.e. state_save is called): save custom user data to a file.
-	UNIGINE_UNUSED(stream);
-	return 1;
+	// component classes registered with SnapshotComponents::add<Class>() are saved as snapshot sections
+	return Unigine::SnapshotComponents::save(stream) ? 1 : 0;
 }
 
 int AppWorldLogic::restore(const Unigine::StreamPtr &stream)
 {
 	// Write here code to be called when the world is restoring its state (i.e. state_restore is called): restore custom user data to a file here.
-	UNIGINE_UNUSED(stream);
-	return 1;
+	return Unigine::SnapshotComponents::restore(stream) ? 1 : 0;
 }
@@ -13,6 +13,7 @@
 
 
 #include <UnigineEngine.h>
+#include <UnigineReplay.h>
 
 #include "AppEditorLogic.h"
 #include "AppSystemLogic.h"
@@ -32,6 +33,10 @@ int main(int argc, char *argv[])
 	// init engine
 	Unigine::EnginePtr engine(UNIGINE_VERSION, argc, argv);
 
+	// -video_app null -replay_headless <file> plays a recording back without rendering or waiting for the frame time and quits
+	if (Unigine::Replay::runHeadless(&system_logic, &world_logic, &editor_logic))
+		return 0;
+
 	// enter main loop
 	engine->main(&system_logic, &world_logic, &editor_logic);
 